@@ -3,7 +3,13 @@
 
 /** CANVAS MODULE
  *  - snl_canvas_create
+ *  - snl_canvas_create_ex
+ *  - snl_canvas_load
+ *  - snl_canvas_load_ex
+ *  - snl_canvas_append
  *  - snl_canvas_destroy
+ *  - snl_sink_file
+ *  - snl_sink_fd
  *  - snl_canvas_render_line
  *  - snl_canvas_render_circle
  *  - snl_canvas_render_ellipse
@@ -11,9 +17,11 @@
  *  - snl_canvas_render_polygon_begin
  *  - snl_canvas_render_polygon_point
  *  - snl_canvas_render_polygon_end
+ *  - snl_canvas_render_polygon_points
  *  - snl_canvas_render_polyline_begin
  *  - snl_canvas_render_polyline_point
  *  - snl_canvas_render_polyline_end
+ *  - snl_canvas_render_polyline_points
  *  - snl_canvas_render_curve
  *  - snl_canvas_render_curve_custom
  *  - snl_canvas_render_path_begin
@@ -22,14 +30,42 @@
  *  - snl_canvas_render_path_end
  *  - snl_canvas_render_text
  *  - snl_canvas_render_text_styled
+ *  - snl_canvas_render_circles
+ *  - snl_canvas_render_rectangles
+ *  - snl_canvas_render_lines
+ *  - snl_canvas_render_texts
+ *  - snl_canvas_symbol_begin
+ *  - snl_canvas_symbol_end
+ *  - snl_canvas_render_instance
+ *  - snl_canvas_push_group
+ *  - snl_canvas_pop_group
  *  - snl_canvas_undo
+ *  - snl_canvas_undo_n
+ *  - snl_canvas_mark
+ *  - snl_canvas_rollback
  *  - snl_canvas_clear
  *  - snl_canvas_translate
  *  - snl_canvas_reset_translation
  *  - snl_canvas_fill
  *  - snl_canvas_save
+ *  - snl_canvas_flush
+ *  - snl_canvas_finish
+ *  - snl_canvas_sync
+ *  - snl_canvas_element_count
+ *  - snl_canvas_swap_elements
+ *  - snl_canvas_remove_element
+ *  - snl_canvas_move_elements
+ *  - snl_canvas_query_point
+ *  - snl_canvas_query_rect
+ *  - snl_transform_multiply
+ *  - snl_transform_rotate
+ *  - snl_transform_apply
+ *
+ * @note snail has no global mutable state: distinct canvases can be rendered from different threads concurrently,
+ *       a single canvas must not be used by several threads at once without external locking
 */
 
+#include <stdio.h>
 #include <stdint.h>
 #include "vita/container/str.h"
 #include "vita/system/fileio.h"
@@ -158,11 +194,145 @@ typedef struct SnailPoint {
 // adjust point by value
 #define SNL_POINT_ADJUST(point, adjust_x, adjust_y) ((snl_point_t) {point.x + adjust_x, point.y + adjust_y})
 
+// 2D affine transform, same as svg matrix(a b c d e f): x' = a * x + c * y + e, y' = b * x + d * y + f
+typedef struct SnailTransform {
+    float a, b, c, d, e, f;
+} snl_transform_t;
+
+// a, b, c, d, e, f
+#define SNL_TRANSFORM(a, b, c, d, e, f) ((snl_transform_t) {a, b, c, d, e, f})
+#define SNL_TRANSFORM_IDENTITY SNL_TRANSFORM(1, 0, 0, 1, 0, 0)
+#define SNL_TRANSFORM_TRANSLATE(x, y) SNL_TRANSFORM(1, 0, 0, 1, x, y)
+#define SNL_TRANSFORM_SCALE(x, y) SNL_TRANSFORM(x, 0, 0, y, 0, 0)
+
+// path data encoder position, carried between the point calls of a point list (SNL_CANVAS_COMPACT)
+typedef struct SnailPathCursor {
+    int64_t x, y;       // previous point in units of the geometry precision
+    char command;       // command that a following number pair continues, 0 before the first point
+    bool dot;           // the last number written contains a decimal point
+    bool exact;         // the previous point is known exactly, so the next one may be relative
+    bool closed;        // polygon: close the path at the end
+} snl_path_cursor_t;
+
+// output sink: write(user, data, size) must return the number of bytes written
+typedef struct SnailSink {
+    size_t (*write)(void *user, const char *data, size_t size);
+    void *user;
+} snl_sink_t;
+
+// write_fn, user_data
+#define SNL_SINK(wf, ud) ((snl_sink_t) {wf, ud})
+
+// default amount of buffered bytes that triggers a flush to the sink
+#define SNL_STREAM_HIGH_WATER_DEFAULT (64 * 1024)
+
+// canvas flags
+#define SNL_CANVAS_RETAINED (1u << 0) // record shapes and serialize them on save/finish
+#define SNL_CANVAS_COMPACT (1u << 1)  // omit default attributes and the default filter, hex colors, trimmed numbers
+#define SNL_CANVAS_CLASSES (1u << 2)  // share repeated styles through css classes
+#define SNL_CANVAS_TRIM (1u << 3)     // drop trailing fractional zeros, so whole numbers are written as integers
+#define SNL_CANVAS_CULL (1u << 4)     // skip shapes outside the viewBox and collapse offscreen runs of point lists
+#define SNL_CANVAS_OCCLUDE (1u << 5)  // leave out shapes hidden under later opaque rectangles on save (retained only)
+
+// digits after the decimal point of coordinates and lengths
+#define SNL_PRECISION_DEFAULT 2
+#define SNL_PRECISION_INTEGER (-1)  // 0 digits, since 0 selects the default
+#define SNL_PRECISION_MAX 6
+
+// canvas configuration
+typedef struct SnailCanvasOptions {
+    // streaming: if sink.write is set, the canvas keeps at most ~high_water bytes in memory
+    snl_sink_t sink;
+    size_t high_water;
+
+    // SNL_CANVAS_* flags
+    uint32_t flags;
+
+    // digits after the decimal point of coordinates and lengths: 1..SNL_PRECISION_MAX,
+    // SNL_PRECISION_INTEGER, or 0 for SNL_PRECISION_DEFAULT
+    int32_t precision;
+
+    // if > 0, coordinates are rounded to multiples of grid; lengths such as radii, widths and heights are not
+    float grid;
+} snl_canvas_options_t;
+
+#define SNL_CANVAS_OPTIONS_DEFAULT ((snl_canvas_options_t) {0})
+
+// retained shapes
+struct SnailDisplayList;
+
+// css classes
+struct SnailStyleSheet;
+
+// filter and gradient definitions
+struct SnailDefs;
+
+// mapped svg file
+struct SnailLoad;
+
+// symbol being recorded
+struct SnailSymbol;
+
+// open group
+struct SnailGroup;
+
+// spatial index over the retained shapes
+struct SnailIndex;
+
 // svg draw canvas
 typedef struct SnailCanvas {
     const float width, height;
     float translateX, translateY;
     vt_str_t *surface;
+
+    // number output
+    int32_t precision;
+    float grid;
+
+    // rendering state
+    bool drawing;
+    snl_point_t path_prev_point;
+    snl_path_cursor_t path_cursor;
+
+    // undo stack: surface offset of each element
+    size_t *elements;
+    size_t nelements;
+    size_t elements_capacity;
+
+    // streaming
+    snl_sink_t sink;
+    size_t high_water;
+    size_t flushed;
+
+    // retained mode
+    uint32_t flags;
+    struct SnailDisplayList *list;
+
+    // css classes
+    struct SnailStyleSheet *sheet;
+
+    // definitions: a single <defs> element, written between the header and the body on save, flush and sync
+    struct SnailDefs *defs;
+    vt_str_t *definitions;  // content of the <defs> element, until it is written out
+    size_t defs_at;         // surface offset of the body, right after the header
+
+    // loaded file, kept mapped and written out ahead of the surface, or file appended to
+    struct SnailLoad *base;
+
+    // symbol recording: the canvas state is set aside while render calls are captured
+    struct SnailSymbol *symbol;
+
+    // group stack: <g> elements opened by <snl_canvas_push_group()> and not closed yet
+    struct SnailGroup *groups;
+    size_t ngroups;
+    size_t groups_capacity;
+
+    // viewport culling (SNL_CANVAS_CULL): shapes skipped and points dropped from point lists
+    size_t culled;
+    size_t culled_points;
+
+    // hit testing: built on the first query, rebuilt once the retained shapes change
+    struct SnailIndex *index;
 } snl_canvas_t;
 
 /**
@@ -174,6 +344,103 @@ typedef struct SnailCanvas {
  */
 extern snl_canvas_t snl_canvas_create(const float width, const float height);
 
+/**
+ * @brief Creates a new canvas with custom options
+ * 
+ * @param width canvas width
+ * @param height canvas height
+ * @param options canvas configuration
+ * @return snl_canvas_t
+ * 
+ * @note with a sink set, the document is written out incrementally and memory stays bounded;
+ *       undo and clear are not available, call <snl_canvas_finish()> instead of <snl_canvas_save()>
+ * @note with SNL_CANVAS_RETAINED, shapes are kept as records and serialized once on save/finish;
+ *       filters and gradients are still written immediately
+ * @note with SNL_CANVAS_COMPACT, attributes equal to their SVG defaults are omitted, shapes without a filter
+ *       skip the no-op __default__ filter, colors are written as #rgb/#rrggbb ('none' for zero alpha)
+ *       and numbers lose their trailing zeros; polygons, polylines and paths become <path> elements whose
+ *       data uses whichever of absolute or relative commands is shorter per point, H/V for axis-aligned
+ *       segments and no repeated command letters
+ * @note with SNL_CANVAS_TRIM, numbers lose their trailing zeros like in the compact profile, but nothing else changes
+ * @note options.precision applies to the coordinates and lengths of shapes, options.grid to their coordinates only,
+ *       so that a radius or a size smaller than the grid does not become 0; stroke widths, opacities, font sizes and
+ *       angles keep two digits; the rasterizer draws the unrounded shapes
+ * @note with SNL_CANVAS_CLASSES, each distinct style is defined once as a class and shapes refer to it with
+ *       class='aN'; polygons, polylines and paths keep inline attributes; the classes are written on save in a single
+ *       <style> element after the <defs>, a streaming canvas defines each one in a <style> element before its first use;
+ *       a style with a font or referenced id holding characters other than letters, digits, spaces, non-ascii
+ *       characters and '-_.,#%' keeps inline attributes, so that no value can end its declaration or rule
+ * @note filters, gradients and symbols are collected in one <defs> element after the header; they are not elements,
+ *       so undo, rollback and clear keep them; they are kept apart from the elements and only joined to them on
+ *       save, flush and sync, so adding one costs the same whatever was drawn before it; a definition identical to an existing one is not written again,
+ *       its id refers to the existing one instead; once a streaming canvas has flushed its header, definitions are
+ *       written in place
+ * @note ids of filters, gradients and symbols are escaped wherever they are written
+ * @note with SNL_CANVAS_CULL, shapes whose bounding box, grown by the stroke width and mapped through the open
+ *       groups, lies outside the viewBox are skipped and counted in canvas.culled; culled shapes are not elements,
+ *       so undo does not see them; text boxes are measured with <snl_text_measure()> and grown by
+ *       SNL_TEXT_MARGIN font sizes
+ * @note with SNL_CANVAS_CULL, polygons and polylines given as point arrays keep only the first and the last point
+ *       of each run of points that lie on the same outer side of the viewBox, which changes nothing visible;
+ *       the dropped points are counted in canvas.culled_points
+ * @note culling leaves alone shapes with a filter or inside a group with a filter, since filters draw outside the
+ *       shape, as well as symbol instances, point lists built point by point and everything inside symbols
+ * @note with SNL_CANVAS_OCCLUDE, which needs SNL_CANVAS_RETAINED, save and finish leave out the shapes whose box,
+ *       grown by the stroke width and clipped to the viewBox, lies inside a single rectangle drawn after them with
+ *       square corners, a fully opaque fill color, no gradient and no filter, like the background of
+ *       <snl_canvas_fill()>; neither the rectangles nor the hidden shapes may be inside a group, shapes with a filter
+ *       and symbol instances are always kept; the records stay, so that undo and the rasterizer still see them
+ */
+extern snl_canvas_t snl_canvas_create_ex(const float width, const float height, const snl_canvas_options_t options);
+
+/**
+ * @brief Opens an svg file to keep drawing on it
+ * 
+ * @param filename file name
+ * @return snl_canvas_t
+ * 
+ * @note the file is memory-mapped and scanned in place, so files larger than memory can be loaded
+ * @note the loaded content is opaque and append-only: it is not parsed into elements, but written out unchanged
+ *       ahead of the new elements on save; it cannot be undone, removed, moved, queried or rasterized, and
+ *       <snl_canvas_element_count()> only counts the new elements; use <snl_canvas_load_ex()> to edit them
+ * @note the canvas is an immediate canvas with the default output profile, i.e. no SNL_CANVAS_* flags
+ * @note filters and gradients of the file with single-quoted ids, as snail writes them, are registered, so that
+ *       identical definitions are not written again
+ * @note the file stays mapped until <snl_canvas_destroy()>; saving over it is allowed
+ * @note an append interrupted by a crash is completed or rolled back before the file is mapped, see <snl_canvas_sync()>
+ */
+extern snl_canvas_t snl_canvas_load(const char *const filename);
+
+/**
+ * @brief Opens an svg file written by snail and rebuilds its elements
+ * 
+ * @param filename file name
+ * @param options output profile, retained mode, sink and writer settings of the new canvas
+ * @return snl_canvas_t
+ * 
+ * @note the shapes, text, groups, symbols, filters, gradients and classes of the file are parsed and drawn again
+ *       through the render calls, so on a retained canvas they become records that can be undone, removed, moved,
+ *       queried and rasterized like the ones drawn after them
+ * @note other attributes are dropped; an element snail does not write stops with an error
+ * @note the file is read once and unmapped before returning; the rebuilt elements take as much memory as if they
+ *       had been drawn, so files larger than memory are opened with <snl_canvas_load()> instead
+ */
+extern snl_canvas_t snl_canvas_load_ex(const char *const filename, const snl_canvas_options_t options);
+
+/**
+ * @brief Opens an svg file to append new elements to it in place
+ * 
+ * @param filename file name
+ * @return snl_canvas_t
+ * 
+ * @note only the head and the end of the file are read; <snl_canvas_sync()> writes the new elements over
+ *       the closing </svg> and adds it back, so an update costs the size of the new elements, not of the file
+ * @note filters and gradients defined in the head of the file are registered, so that identical definitions
+ *       are not written again; other definitions of the file are not known
+ * @note an append interrupted by a crash is completed or rolled back here, see <snl_canvas_sync()>
+ */
+extern snl_canvas_t snl_canvas_append(const char *const filename);
+
 /**
  * @brief Release canvas memory
  * 
@@ -181,6 +448,22 @@ extern snl_canvas_t snl_canvas_create(const float width, const float height);
  */
 extern void snl_canvas_destroy(snl_canvas_t *canvas);
 
+/**
+ * @brief Creates a sink that writes to a FILE stream
+ * 
+ * @param fp file stream opened for writing
+ * @return snl_sink_t
+ */
+extern snl_sink_t snl_sink_file(FILE *const fp);
+
+/**
+ * @brief Creates a sink that writes to a file descriptor
+ * 
+ * @param fd file descriptor opened for writing
+ * @return snl_sink_t
+ */
+extern snl_sink_t snl_sink_fd(const int fd);
+
 /**
  * @brief Preallocates memory for fast rendering 
  * 
@@ -437,6 +720,24 @@ extern void snl_canvas_render_polygon_point(snl_canvas_t *const canvas, snl_poin
  */
 extern void snl_canvas_render_polygon_end(snl_canvas_t *const canvas, const snl_appearance_t appearance, const char *const fill_rule);
 
+/**
+ * @brief Render a polygon from an array of points
+ * 
+ * @param canvas canvas instance
+ * @param points polygon points
+ * @param n number of points
+ * @param appearance outlook
+ * @param fill_rule fill rule
+ * @return None
+ * 
+ * @note same output as <snl_canvas_render_polygon_begin()>, n x <snl_canvas_render_polygon_point()>, <snl_canvas_render_polygon_end()>
+ */
+extern void snl_canvas_render_polygon_points(
+    snl_canvas_t *const canvas, 
+    const snl_point_t *const points, const size_t n, 
+    const snl_appearance_t appearance, const char *const fill_rule
+);
+
 /**
  * @brief Start rendering a polyline to canvas surface
  * 
@@ -469,6 +770,23 @@ extern void snl_canvas_render_polyline_point(snl_canvas_t *const canvas, snl_poi
  */
 extern void snl_canvas_render_polyline_end(snl_canvas_t *const canvas, const snl_appearance_t appearance);
 
+/**
+ * @brief Render a polyline from an array of points
+ * 
+ * @param canvas canvas instance
+ * @param points polyline points
+ * @param n number of points
+ * @param appearance outlook
+ * @return None
+ * 
+ * @note same output as <snl_canvas_render_polyline_begin()>, n x <snl_canvas_render_polyline_point()>, <snl_canvas_render_polyline_end()>
+ */
+extern void snl_canvas_render_polyline_points(
+    snl_canvas_t *const canvas, 
+    const snl_point_t *const points, const size_t n, 
+    const snl_appearance_t appearance
+);
+
 /**
  * @brief Render a curve to canvas surface with equal curvature
 
@@ -556,6 +874,7 @@ extern void snl_canvas_render_path_end(snl_canvas_t *const canvas, const snl_app
  * @return None
  * 
  * @note see also <snl_canvas_render_text()> and <snl_canvas_render_text_styled()>
+ * @note the text is escaped, so it may contain '<', '&' or quotes; invalid utf-8 is replaced with U+FFFD
  */
 extern void snl_canvas_render_text(snl_canvas_t *const canvas, snl_point_t pos, const char* const text, const float font_size, const char *const font_family, const struct SnailColor color);
 
@@ -570,9 +889,155 @@ extern void snl_canvas_render_text(snl_canvas_t *const canvas, snl_point_t pos,
  * @return None
  * 
  * @note see also <snl_canvas_render_text()> and <snl_canvas_render_text()>
+ * @note the text and the font family, weight, style and decoration are escaped like in <snl_canvas_render_text()>
  */
 extern void snl_canvas_render_text_styled(snl_canvas_t *const canvas, snl_point_t pos, const char* const text, const snl_appearance_t appearance, snl_text_style_t text_style);
 
+/**
+ * @brief Render many circles sharing the same appearance
+ * 
+ * @param canvas canvas instance
+ * @param xs origin x of each circle
+ * @param ys origin y of each circle
+ * @param rs radius of each circle
+ * @param n number of circles
+ * @param appearance outlook
+ * @return None
+ * 
+ * @note same output as calling <snl_canvas_render_circle()> n times, each circle is a separate element
+ */
+extern void snl_canvas_render_circles(
+    snl_canvas_t *const canvas, 
+    const float *const xs, const float *const ys, const float *const rs, const size_t n, 
+    const snl_appearance_t appearance
+);
+
+/**
+ * @brief Render many rectangles sharing the same corner radius and appearance
+ * 
+ * @param canvas canvas instance
+ * @param xs position x of each rectangle
+ * @param ys position y of each rectangle
+ * @param widths width of each rectangle
+ * @param heights height of each rectangle
+ * @param n number of rectangles
+ * @param radius corner smoothness
+ * @param appearance outlook
+ * @return None
+ * 
+ * @note same output as calling <snl_canvas_render_rectangle()> n times, each rectangle is a separate element
+ */
+extern void snl_canvas_render_rectangles(
+    snl_canvas_t *const canvas, 
+    const float *const xs, const float *const ys, const float *const widths, const float *const heights, const size_t n, 
+    const float radius, const snl_appearance_t appearance
+);
+
+/**
+ * @brief Render many lines sharing the same appearance
+ * 
+ * @param canvas canvas instance
+ * @param x1s start x of each line
+ * @param y1s start y of each line
+ * @param x2s end x of each line
+ * @param y2s end y of each line
+ * @param n number of lines
+ * @param appearance outlook
+ * @return None
+ * 
+ * @note same output as calling <snl_canvas_render_line()> n times, each line is a separate element
+ */
+extern void snl_canvas_render_lines(
+    snl_canvas_t *const canvas, 
+    const float *const x1s, const float *const y1s, const float *const x2s, const float *const y2s, const size_t n, 
+    const snl_appearance_t appearance
+);
+
+/**
+ * @brief Render many text labels sharing the same appearance and style
+ * 
+ * @param canvas canvas instance
+ * @param xs position x of each label
+ * @param ys position y of each label
+ * @param texts text value of each label
+ * @param n number of labels
+ * @param appearance text appearance
+ * @param text_style text style settings
+ * @return None
+ * 
+ * @note same output as calling <snl_canvas_render_text_styled()> n times, each label is a separate element
+ */
+extern void snl_canvas_render_texts(
+    snl_canvas_t *const canvas, 
+    const float *const xs, const float *const ys, const char *const *const texts, const size_t n, 
+    const snl_appearance_t appearance, const snl_text_style_t text_style
+);
+
+/**
+ * @brief Start recording render calls into a symbol
+ * 
+ * @param canvas canvas instance
+ * @param id symbol id
+ * @return None
+ * 
+ * @note render calls up to <snl_canvas_symbol_end()> are written into the symbol, in its own coordinates:
+ *       translation is reset, and retained records, css classes and the sink are not used meanwhile;
+ *       undo applies to the symbol being recorded
+ * @note filters and gradients used by the symbol must be added before recording it
+ */
+extern void snl_canvas_symbol_begin(snl_canvas_t *const canvas, const char *const id);
+
+/**
+ * @brief Stop recording and define the symbol
+ * 
+ * @param canvas canvas instance
+ * @return None
+ * 
+ * @note the symbol is a definition like filters and gradients: it is not undone by undo/clear,
+ *       and a symbol identical to an existing one refers to it instead of being written again
+ */
+extern void snl_canvas_symbol_end(snl_canvas_t *const canvas);
+
+/**
+ * @brief Render a symbol instance
+ * 
+ * @param canvas canvas instance
+ * @param id symbol id
+ * @param pos position of the symbol origin
+ * @param scale scale factor
+ * @param rotation rotation in degrees around the symbol origin
+ * @return None
+ * 
+ * @note writes a single <use> element, however large the symbol is
+ */
+extern void snl_canvas_render_instance(snl_canvas_t *const canvas, const char *const id, snl_point_t pos, const float scale, const float rotation);
+
+/**
+ * @brief Open a group: elements rendered up to <snl_canvas_pop_group()> are placed by its transform
+ *        and inherit its style
+ * 
+ * @param canvas canvas instance
+ * @param transform group coordinates to the coordinates of the enclosing group (or canvas)
+ * @param appearance style inherited by the elements of the group, or NULL for a transform-only group
+ * @return None
+ * 
+ * @note writes a single <g transform='..'> element: the elements of the group are written in its own
+ *       coordinates and leave out the stroke and fill attributes equal to the inherited ones;
+ *       the filter of the appearance applies to the whole group
+ * @note groups nest; <snl_canvas_translate()> still offsets the coordinates of every element, inside groups too
+ * @note elements of a group do not use css classes
+ * @note once popped, a group is undone as a whole, like a single element
+ */
+extern void snl_canvas_push_group(snl_canvas_t *const canvas, const snl_transform_t transform, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Close the innermost group
+ * 
+ * @param canvas canvas instance
+ * @return None
+ */
+extern void snl_canvas_pop_group(snl_canvas_t *const canvas);
+
 /**
  * @brief Undo the last rendering operation
  * 
@@ -581,11 +1046,41 @@ extern void snl_canvas_render_text_styled(snl_canvas_t *const canvas, snl_point_
  */
 extern void snl_canvas_undo(snl_canvas_t *const canvas);
 
+/**
+ * @brief Undo the last n rendering operations
+ * 
+ * @param canvas canvas instance
+ * @param n number of operations
+ * @return None
+ */
+extern void snl_canvas_undo_n(snl_canvas_t *const canvas, const size_t n);
+
+/**
+ * @brief Create a savepoint
+ * 
+ * @param canvas canvas instance
+ * @return mark to pass to <snl_canvas_rollback()>
+ */
+extern size_t snl_canvas_mark(const snl_canvas_t *const canvas);
+
+/**
+ * @brief Undo all rendering operations done after the savepoint
+ * 
+ * @param canvas canvas instance
+ * @param mark value returned by <snl_canvas_mark()>
+ * @return None
+ * 
+ * @note marks taken after the savepoint become invalid
+ */
+extern void snl_canvas_rollback(snl_canvas_t *const canvas, const size_t mark);
+
 /**
  * @brief Clear canvas surface
  * 
  * @param canvas canvas instance
  * @return None
+ * 
+ * @note filters, gradients and symbols are kept
  */
 extern void snl_canvas_clear(snl_canvas_t *const canvas);
 
@@ -597,7 +1092,7 @@ extern void snl_canvas_clear(snl_canvas_t *const canvas);
  * @param y translate view along the vertical axis
  * @return None
  * 
- * @note does not effect previosly rendered shapes
+ * @note does not effect previosly rendered shapes, see <snl_canvas_move_elements()>
  */
 extern void snl_canvas_translate(snl_canvas_t *const canvas, const float x, const float y);
 
@@ -626,8 +1121,156 @@ extern void snl_canvas_fill(snl_canvas_t *const canvas, struct SnailColor color)
  * @param canvas canvas instance
  * @param filename name
  * @return None
+ * 
+ * @note the header, definitions, classes and elements are written straight to the file; retained shapes are
+ *       formatted in chunks of about high_water bytes, twice with SNL_CANVAS_CLASSES, since the classes they use
+ *       are written before them
+ * @note the surface is left as it is, so that rendering can continue; SNL_CANVAS_OCCLUDE marks the hidden shapes
+ *       again on each save
+ */
+extern void snl_canvas_save(snl_canvas_t *const canvas, const char *const filename);
+
+/**
+ * @brief Write buffered data to the sink
+ * 
+ * @param canvas canvas instance
+ * @return None
+ * 
+ * @note streaming canvas only
+ */
+extern void snl_canvas_flush(snl_canvas_t *const canvas);
+
+/**
+ * @brief Finalize the document and write all remaining data to the sink
+ * 
+ * @param canvas canvas instance
+ * @return None
+ * 
+ * @note streaming canvas only; replaces <snl_canvas_save()>
+ */
+extern void snl_canvas_finish(snl_canvas_t *const canvas);
+
+/**
+ * @brief Append the new elements to the file and start over with an empty surface
+ * 
+ * @param canvas canvas instance created with <snl_canvas_append()>
+ * @return None
+ * 
+ * @note the new end of the file is written to "<filename>.journal" and flushed to disk before the file is modified,
+ *       then the file is flushed and the journal removed; after a crash the file either ends as before or
+ *       the journal is replayed by the next <snl_canvas_append()> or <snl_canvas_load()>, so it is never left
+ *       without its </svg>
+ * @note the journal ends with a crc-32 of its content; a journal that was not completely flushed fails the check
+ *       and is dropped, since the file was not modified yet
+ * @note synced elements can no longer be undone
+ */
+extern void snl_canvas_sync(snl_canvas_t *const canvas);
+
+/**
+ * @brief Number of rendered elements
+ * 
+ * @param canvas canvas instance
+ * @return number of elements, including removed ones
+ * 
+ * @note filters, gradients and symbols are definitions, not elements, see <snl_canvas_create_ex()>
+ * @note a retained canvas counts the opening and the closing of a group as elements of their own
+ */
+extern size_t snl_canvas_element_count(const snl_canvas_t *const canvas);
+
+/**
+ * @brief Swap the drawing order of two elements
+ * 
+ * @param canvas canvas instance
+ * @param a element index
+ * @param b element index
+ * @return None
+ * 
+ * @note retained canvas only; group openings and closings cannot be swapped
+ */
+extern void snl_canvas_swap_elements(snl_canvas_t *const canvas, const size_t a, const size_t b);
+
+/**
+ * @brief Drop an element from the output; indices of other elements are not changed
+ * 
+ * @param canvas canvas instance
+ * @param index element index
+ * @return None
+ * 
+ * @note retained canvas only; removing the opening or the closing of a closed group removes the whole group
+ */
+extern void snl_canvas_remove_element(snl_canvas_t *const canvas, const size_t index);
+
+/**
+ * @brief Move already rendered elements
+ * 
+ * @param canvas canvas instance
+ * @param from first element index
+ * @param to one past the last element index
+ * @param x move along the horizontal axis
+ * @param y move along the vertical axis
+ * @return None
+ * 
+ * @note retained canvas only; a closed group in the range is moved through its transform
+ * @note the move is along the canvas axes: elements inside groups, those of a group cut by the range included,
+ *       move by the same distance on the canvas whatever the rotation or scale of their groups
+ */
+extern void snl_canvas_move_elements(snl_canvas_t *const canvas, const size_t from, const size_t to, const float x, const float y);
+
+/**
+ * @brief Find the elements under a point
+ * 
+ * @param canvas canvas instance
+ * @param point point in canvas units, translation is not applied
+ * @param indices element indices, the topmost first (set on return)
+ * @param max capacity of indices
+ * @return number of elements found, which may be more than max
+ * 
+ * @note retained canvas only; an element is found if the point lies in its bounding box grown by the stroke
+ *       and mapped through its groups; groups, symbol instances and removed elements are never found
+ * @note point lists are grown by twice the stroke for their miter joins, and text boxes by SNL_TEXT_MARGIN font
+ *       sizes, so text is also found a little outside its advance
+ */
+extern size_t snl_canvas_query_point(snl_canvas_t *const canvas, const snl_point_t point, size_t *const indices, const size_t max);
+
+/**
+ * @brief Find the elements overlapping a rectangle
+ * 
+ * @param canvas canvas instance
+ * @param pos top left corner of the rectangle in canvas units, translation is not applied
+ * @param size rectangle width and height
+ * @param indices element indices, the topmost first (set on return)
+ * @param max capacity of indices
+ * @return number of elements found, which may be more than max
+ * 
+ * @note see <snl_canvas_query_point()>
+ */
+extern size_t snl_canvas_query_rect(snl_canvas_t *const canvas, const snl_point_t pos, const snl_point_t size, size_t *const indices, const size_t max);
+
+/**
+ * @brief Compose two transforms
+ * 
+ * @param m outer transform
+ * @param n inner transform
+ * @return transform applying n first, then m
+ */
+extern snl_transform_t snl_transform_multiply(const snl_transform_t m, const snl_transform_t n);
+
+/**
+ * @brief Rotation around the origin
+ * 
+ * @param degrees angle in degrees, clockwise on screen
+ * @return snl_transform_t
+ */
+extern snl_transform_t snl_transform_rotate(const float degrees);
+
+/**
+ * @brief Transform a point
+ * 
+ * @param m transform
+ * @param point point
+ * @return transformed point
  */
-extern void snl_canvas_save(const snl_canvas_t *const canvas, const char *const filename);
+extern snl_point_t snl_transform_apply(const snl_transform_t m, const snl_point_t point);
 
 #endif // SNAIL_CANVAS_H
 
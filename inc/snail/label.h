@@ -0,0 +1,120 @@
+#ifndef SNAIL_LABEL_H
+#define SNAIL_LABEL_H
+
+/** LABEL MODULE
+ *  - snl_labels_create
+ *  - snl_labels_destroy
+ *  - snl_labels_clear
+ *  - snl_labels_add
+ *  - snl_labels_place
+ *
+ * @note labels are placed greedily by priority: each one takes the first of its anchor positions whose box,
+ *       measured with <snl_text_measure()>, does not overlap the labels placed before it; the others are dropped
+ * @note candidates are radix-sorted by priority and placed boxes are kept in a uniform grid with cells of the
+ *       average label size, so each collision test only looks at the few labels around the candidate
+*/
+
+#include "text.h"
+
+// anchor positions of a label around its point, tried in this order
+#define SNL_LABEL_TOP_RIGHT    (1u << 0)
+#define SNL_LABEL_BOTTOM_RIGHT (1u << 1)
+#define SNL_LABEL_TOP_LEFT     (1u << 2)
+#define SNL_LABEL_BOTTOM_LEFT  (1u << 3)
+#define SNL_LABEL_RIGHT        (1u << 4)
+#define SNL_LABEL_LEFT         (1u << 5)
+#define SNL_LABEL_TOP          (1u << 6)
+#define SNL_LABEL_BOTTOM       (1u << 7)
+#define SNL_LABEL_CENTER       (1u << 8)
+#define SNL_LABEL_AROUND       0xFFu       // all positions but the center
+
+// label layer configuration
+typedef struct SnailLabelOptions {
+    // SNL_LABEL_* positions to try, or 0 for SNL_LABEL_AROUND
+    uint32_t anchors;
+
+    // gap between a point and its label
+    float offset;
+
+    // minimum distance between two labels
+    float padding;
+} snl_label_options_t;
+
+#define SNL_LABEL_OPTIONS_DEFAULT ((snl_label_options_t) {0})
+
+// candidate label
+struct SnailLabel;
+
+// label layer: candidate labels waiting to be placed
+typedef struct SnailLabels {
+    snl_label_options_t options;
+
+    // candidates
+    struct SnailLabel *labels;
+    size_t count;
+    size_t capacity;
+
+    // label texts, NUL-separated
+    char *pool;
+    size_t pool_len;
+    size_t pool_capacity;
+} snl_labels_t;
+
+/**
+ * @brief Creates an empty label layer
+ *
+ * @param options placement settings
+ * @return snl_labels_t
+ */
+extern snl_labels_t snl_labels_create(const snl_label_options_t options);
+
+/**
+ * @brief Release label layer memory
+ *
+ * @param labels label layer instance
+ * @return None
+ */
+extern void snl_labels_destroy(snl_labels_t *const labels);
+
+/**
+ * @brief Remove all candidates, keeping the memory for the next ones
+ *
+ * @param labels label layer instance
+ * @return None
+ */
+extern void snl_labels_clear(snl_labels_t *const labels);
+
+/**
+ * @brief Add a candidate label
+ *
+ * @param labels label layer instance
+ * @param pos point the label belongs to
+ * @param text text value
+ * @param priority labels with a higher priority are placed first, equal priorities in the order they were added
+ * @param appearance appearance settings
+ * @param text_style text style settings
+ * @return None
+ *
+ * @note the text is copied and measured here; the strings of the appearance and of the text style are not copied,
+ *       they must stay valid until the labels are placed
+ * @note candidates with a non-finite position or priority are never placed
+ */
+extern void snl_labels_add(
+    snl_labels_t *const labels, const snl_point_t pos, const char *const text, const float priority,
+    const snl_appearance_t appearance, const snl_text_style_t text_style
+);
+
+/**
+ * @brief Place the candidates and render the ones that fit
+ *
+ * @param labels label layer instance
+ * @param canvas canvas instance
+ * @return number of labels rendered
+ *
+ * @note labels are rendered with <snl_canvas_render_text_styled()> in the order of their priority
+ * @note boxes are not rotated by text_rotation; the candidates are kept, so that they can be placed again
+ */
+extern size_t snl_labels_place(snl_labels_t *const labels, snl_canvas_t *const canvas);
+
+#endif // SNAIL_LABEL_H
+
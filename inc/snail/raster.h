@@ -0,0 +1,123 @@
+#ifndef SNAIL_RASTER_H
+#define SNAIL_RASTER_H
+
+/** RASTER MODULE
+ *  - snl_raster_create
+ *  - snl_raster_destroy
+ *  - snl_raster_clear
+ *  - snl_canvas_rasterize
+ *  - snl_canvas_rasterize_parallel
+ *  - snl_raster_write_ppm
+ *  - snl_raster_write_png
+ *  - snl_raster_save_ppm
+ *  - snl_raster_save_png
+ *
+ * @note shapes are filled and stroked with anti-aliasing, gradients included; text, filters and symbol instances
+ *       are not rasterized
+ * @note shapes inside groups are placed by the transforms of the groups
+*/
+
+#include "canvas.h"
+
+// tile edge in pixels used by the parallel rasterizer
+#define SNL_RASTER_TILE_SIZE 128
+
+// scanline rasterizer
+struct SnailScanner;
+
+// rgba pixel buffer
+typedef struct SnailRaster {
+    const uint32_t width, height;
+    uint8_t *pixels;                // premultiplied rgba, row by row
+    struct SnailScanner *scanner;
+} snl_raster_t;
+
+/**
+ * @brief Creates a transparent pixel buffer
+ *
+ * @param width width in pixels
+ * @param height height in pixels
+ * @return snl_raster_t
+ */
+extern snl_raster_t snl_raster_create(const uint32_t width, const uint32_t height);
+
+/**
+ * @brief Release pixel buffer memory
+ *
+ * @param raster raster instance
+ * @return None
+ */
+extern void snl_raster_destroy(snl_raster_t *const raster);
+
+/**
+ * @brief Fill all pixels with a color
+ *
+ * @param raster raster instance
+ * @param color color
+ * @return None
+ */
+extern void snl_raster_clear(snl_raster_t *const raster, const struct SnailColor color);
+
+/**
+ * @brief Draws the canvas shapes over the pixels
+ *
+ * @param canvas canvas instance created with SNL_CANVAS_RETAINED
+ * @param raster raster instance
+ * @return None
+ *
+ * @note the canvas is scaled to fit the raster keeping its aspect ratio and centered, like a viewBox
+ */
+extern void snl_canvas_rasterize(const snl_canvas_t *const canvas, snl_raster_t *const raster);
+
+/**
+ * @brief Draws the canvas shapes over the pixels on several threads
+ *
+ * @param canvas canvas instance created with SNL_CANVAS_RETAINED
+ * @param raster raster instance
+ * @param nthreads number of threads, 0 for one per processor
+ * @return None
+ *
+ * @note shapes are binned into SNL_RASTER_TILE_SIZE tiles that threads draw independently, stealing tiles
+ *       from each other; the pixels are identical to <snl_canvas_rasterize()>
+ * @note the canvas and the raster must not be used by other threads meanwhile
+ */
+extern void snl_canvas_rasterize_parallel(const snl_canvas_t *const canvas, snl_raster_t *const raster, size_t nthreads);
+
+/**
+ * @brief Writes the pixels as a binary PPM image composited over white
+ *
+ * @param raster raster instance
+ * @param sink output sink
+ * @return None
+ */
+extern void snl_raster_write_ppm(const snl_raster_t *const raster, const snl_sink_t sink);
+
+/**
+ * @brief Writes the pixels as an uncompressed RGBA PNG image
+ *
+ * @param raster raster instance
+ * @param sink output sink
+ * @return None
+ */
+extern void snl_raster_write_png(const snl_raster_t *const raster, const snl_sink_t sink);
+
+/**
+ * @brief Saves the pixels to a PPM file
+ *
+ * @param raster raster instance
+ * @param filename file name
+ * @return None
+ */
+extern void snl_raster_save_ppm(const snl_raster_t *const raster, const char *const filename);
+
+/**
+ * @brief Saves the pixels to a PNG file
+ *
+ * @param raster raster instance
+ * @param filename file name
+ * @return None
+ */
+extern void snl_raster_save_png(const snl_raster_t *const raster, const char *const filename);
+
+#endif // SNAIL_RASTER_H
+
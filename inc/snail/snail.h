@@ -3,6 +3,10 @@
 
 #include "version.h"
 #include "canvas.h"
+#include "raster.h"
+#include "text.h"
+#include "label.h"
+#include "tiles.h"
 
 #endif // SNAIL_H
 
@@ -0,0 +1,52 @@
+#ifndef SNAIL_TEXT_H
+#define SNAIL_TEXT_H
+
+/** TEXT MODULE
+ *  - snl_text_measure
+ *  - snl_text_measure_n
+ *
+ * @note text is measured with built-in advance tables, no font files are read: arial, hevetica, times new roman
+ *       and courier use the metrics of the standard PostScript fonts (Helvetica, Times, Courier), verdana has its
+ *       own table and the other SNL_FONT_* fonts are the closest of these scaled to their average width, which is
+ *       within a few percent of the real fonts for latin text
+ * @note kerning, ligatures and letter spacing are ignored; italic faces use the advances of the upright faces
+*/
+
+#include "canvas.h"
+
+// extent of a text relative to its position, i.e. the left end of its baseline; y points down
+typedef struct SnailTextBox {
+    float x, y;             // top-left corner: x is 0 and y is minus the ascent
+    float width, height;    // advance width and ascent plus descent
+} snl_text_box_t;
+
+// growth of measured boxes in font sizes, for glyphs drawn outside their advance and approximate metrics
+#define SNL_TEXT_MARGIN 0.5f
+
+/**
+ * @brief Measure the box of a text
+ *
+ * @param text utf-8 text
+ * @param text_style text style settings
+ * @return snl_text_box_t
+ *
+ * @note the first family of a font-family list is used: "georgia, serif" is measured as georgia; unknown families
+ *       fall back to arial, and the generic serif and monospace families map to times new roman and courier
+ * @note the face is bold for the weights bold, bolder and 600 to 900
+ * @note the box is not rotated by text_rotation; culling, occlusion and tiles grow it by SNL_TEXT_MARGIN font sizes
+ * @note characters outside ascii take an average advance, combining marks none and CJK and fullwidth characters a full em
+ */
+extern snl_text_box_t snl_text_measure(const char *const text, const snl_text_style_t text_style);
+
+/**
+ * @brief Measure the box of a text that is not NUL-terminated
+ *
+ * @param text utf-8 text
+ * @param len text length in bytes
+ * @param text_style text style settings
+ * @return snl_text_box_t
+ */
+extern snl_text_box_t snl_text_measure_n(const char *const text, const size_t len, const snl_text_style_t text_style);
+
+#endif // SNAIL_TEXT_H
+
@@ -0,0 +1,44 @@
+#ifndef SNAIL_TILES_H
+#define SNAIL_TILES_H
+
+/** TILES MODULE
+ *  - snl_canvas_save_tiles
+ *
+ * @note tiles form a pyramid: the last level cuts the canvas into tiles of tile_w x tile_h canvas units, each
+ *       level above covers twice the width and height with a tile of the same size in pixels, up to level 0;
+ *       a tile is saved as <dir>/<level>/<column>/<row>.svg and the pyramid is described by <dir>/tiles.json
+ * @note each tile holds the elements whose bounding box, grown by the stroke, overlaps it; text boxes are grown
+ *       by SNL_TEXT_MARGIN font sizes as well; the levels above the last leave out the elements smaller than
+ *       SNL_TILES_DETAIL pixels both ways at their scale
+ * @note symbol instances have no known extent and are written to every tile
+ * @note a tile holds the filters, gradients and symbols its elements refer to, and those the symbols refer to
+*/
+
+#include "canvas.h"
+
+// size in pixels below which elements are left out of the levels above the last
+#define SNL_TILES_DETAIL 0.5f
+
+// max number of levels
+#define SNL_TILES_LEVELS_MAX 24
+
+/**
+ * @brief Save a retained canvas as a pyramid of svg tiles
+ *
+ * @param canvas canvas instance
+ * @param dir output directory, created if missing
+ * @param tile_w tile width in pixels
+ * @param tile_h tile height in pixels
+ * @param levels number of levels, within [1; SNL_TILES_LEVELS_MAX]
+ * @return number of tiles written
+ *
+ * @note retained canvas only; the whole display list stays in memory, and an R-tree over it is built as well, so
+ *       memory grows with the number of elements; only the output is bounded: tiles are written by a thread per
+ *       processor, each holding a single tile in memory and flushing it to its file every
+ *       SNL_STREAM_HIGH_WATER_DEFAULT bytes
+ * @note tiles without elements are not written; edge tiles are cut at the canvas edge
+ */
+extern size_t snl_canvas_save_tiles(snl_canvas_t *const canvas, const char *const dir, const uint32_t tile_w, const uint32_t tile_h, const uint32_t levels);
+
+#endif // SNAIL_TILES_H
+
@@ -1,30 +1,182 @@
 #include "snail/canvas.h"
+#include "snail/text.h"
+#include "record.h"
+#include "style.h"
+#include "defs.h"
+#include "load.h"
+#include "occlude.h"
+#include "index.h"
 
 #include <math.h>
-
-// expand color
-#define SNL_FILTER_DEFAULT "__default__"
-#define SNL_COLOR_EXPAND(color) color.r, color.g, color.b, color.a
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+// symbol being recorded: the canvas state set aside meanwhile
+typedef struct SnailSymbol {
+    vt_str_t *id;
+    snl_canvas_t outer;
+} snl_symbol_t;
+
+// culling margin of point lists in stroke widths: a miter join reaches stroke-miterlimit (4) half stroke widths
+#define SNL_CULL_MITER 2.0f
+
+// open group
+typedef struct SnailGroup {
+    snl_appearance_t appearance;    // style of the group, its strings are owned copies
+    size_t inherit;                 // 1 + index of the group whose style the elements inherit, 0 for none
+    size_t start;                   // element opening the group (record when retained)
+    snl_transform_t transform;      // from the group to the canvas, through the enclosing groups
+    bool filtered;                  // the group or an enclosing one has a filter
+} snl_group_t;
 
 static bool snl_can_continue();
-static bool snl_color_cmp(const struct SnailColor a, const struct SnailColor b);
+static void snl_canvas_writer_init(const snl_canvas_t *const canvas, snl_writer_t *const w, vt_str_t *const target);
+static void snl_canvas_commit(snl_canvas_t *const canvas, snl_writer_t *const w);
+static void snl_canvas_define(snl_canvas_t *const canvas, snl_writer_t *const w, const char *const id, const snl_gradient_t *const gradient);
+static bool snl_canvas_write_head(const snl_canvas_t *const canvas, FILE *const fp);
+static bool snl_canvas_write_records(snl_canvas_t *const canvas, FILE *const fp);
+static void snl_canvas_push_element(snl_canvas_t *const canvas);
+static size_t *snl_canvas_push_elements(snl_canvas_t *const canvas, const size_t n);
+static void snl_canvas_truncate(snl_canvas_t *const canvas, const size_t nelements);
+static snl_symbol_t *snl_canvas_restore(snl_canvas_t *const canvas);
+static const snl_appearance_t *snl_canvas_inherited(const snl_canvas_t *const canvas);
+static void snl_canvas_drop_groups(snl_canvas_t *const canvas, const size_t ngroups);
+static size_t snl_canvas_groups_before(const snl_canvas_t *const canvas, const size_t nelements);
+static bool snl_canvas_culls(const snl_canvas_t *const canvas, const snl_appearance_t *const appearance);
+static snl_transform_t snl_canvas_transform(const snl_canvas_t *const canvas);
+static bool snl_canvas_box_visible(const snl_canvas_t *const canvas, const snl_transform_t *const local, const float *const box, const float margin);
+static bool snl_canvas_circle_visible(const snl_canvas_t *const canvas, const float x, const float y, const float radius, const float margin);
+static bool snl_canvas_rectangle_visible(const snl_canvas_t *const canvas, const float x, const float y, const float width, const float height, const float margin);
+static bool snl_canvas_line_visible(const snl_canvas_t *const canvas, const float x1, const float y1, const float x2, const float y2, const float margin);
+static bool snl_canvas_text_visible(const snl_canvas_t *const canvas, const snl_point_t pos, const char *const text, const snl_text_style_t *const text_style, const float margin);
+static size_t snl_canvas_clip_points(snl_canvas_t *const canvas, const snl_point_t *const points, const size_t n, const snl_point_t offset, const float margin, const snl_point_t **const clipped);
+static size_t snl_canvas_clip_pass(const snl_transform_t *const m, const float *const view, const snl_point_t *const points, const size_t n, snl_point_t *const out, uint32_t *const all);
+static size_t snl_canvas_query(snl_canvas_t *const canvas, const float *const box, size_t *const indices, const size_t max);
+static snl_transform_t *snl_canvas_push_transform(snl_transform_t *stack, size_t *const depth, size_t *const capacity, const snl_transform_t transform);
+static snl_point_t snl_canvas_local_offset(const snl_transform_t *const m, const float x, const float y);
+static char *snl_copy_string(const char *const z);
+static size_t snl_sink_write_file(void *user, const char *data, size_t size);
+static size_t snl_sink_write_fd(void *user, const char *data, size_t size);
 static void snl_rotate(const float angle, float *x1, float *y1, float *x2, float *y2);
 
 snl_canvas_t snl_canvas_create(const float width, const float height) {
+    return snl_canvas_create_ex(width, height, SNL_CANVAS_OPTIONS_DEFAULT);
+}
+
+snl_canvas_t snl_canvas_create_ex(const float width, const float height, const snl_canvas_options_t options) {
+    // check for invalid input
+    VT_ENFORCE(options.precision >= SNL_PRECISION_INTEGER && options.precision <= SNL_PRECISION_MAX, "Error: precision must be within [%d; %d]!\n", SNL_PRECISION_INTEGER, SNL_PRECISION_MAX);
+    VT_ENFORCE(options.grid >= 0, "Error: grid must not be negative!\n");
+    VT_ENFORCE(!(options.flags & SNL_CANVAS_OCCLUDE) || (options.flags & SNL_CANVAS_RETAINED), "Error: SNL_CANVAS_OCCLUDE needs SNL_CANVAS_RETAINED!\n");
+
+    // streaming buffer size
+    const size_t high_water = options.high_water ? options.high_water : SNL_STREAM_HIGH_WATER_DEFAULT;
+
     snl_canvas_t canvas = (snl_canvas_t) {
         .width = width, 
         .height = height,
-        .surface = vt_str_create_capacity(VT_STR_TMP_BUFFER_SIZE, NULL)
+        .surface = vt_str_create_capacity(options.sink.write ? high_water + SNL_WRITER_BUFFER_SIZE : VT_STR_TMP_BUFFER_SIZE, NULL),
+        .precision = options.precision == 0 ? SNL_PRECISION_DEFAULT : options.precision == SNL_PRECISION_INTEGER ? 0 : options.precision,
+        .grid = options.grid,
+        .sink = options.sink,
+        .high_water = high_water,
+        .flags = options.flags,
+        .list = (options.flags & SNL_CANVAS_RETAINED) ? snl_display_list_create() : NULL,
+        .sheet = (options.flags & SNL_CANVAS_CLASSES) ? snl_style_sheet_create() : NULL,
+        .defs = snl_defs_create(),
+        .definitions = vt_str_create_capacity(VT_STR_TMP_BUFFER_SIZE, NULL)
     };
 
     // initialize the canvas
-    vt_str_appendf(
-        canvas.surface,
-        "<svg width='%.2f' height='%.2f' viewBox='0 0 %.2f %.2f' xmlns='%s' version='%s' xmlns:xlink='%s'>\n",
-        width, height, width, height, "http://www.w3.org/2000/svg", "1.1", "http://www.w3.org/1999/xlink"
-    );
+    snl_writer_t w;
+    snl_canvas_writer_init(&canvas, &w, canvas.surface);
+    snl_writer_put_str(&w, "<svg width='");
+    snl_writer_put_float(&w, width, w.precision);
+    snl_writer_put_str(&w, "' height='");
+    snl_writer_put_float(&w, height, w.precision);
+    snl_writer_put_str(&w, "' viewBox='0 0 ");
+    snl_writer_put_float(&w, width, w.precision);
+    snl_writer_put_char(&w, ' ');
+    snl_writer_put_float(&w, height, w.precision);
+    snl_writer_put_str(&w, "' xmlns='http://www.w3.org/2000/svg' version='1.1' xmlns:xlink='http://www.w3.org/1999/xlink'>\n");
+    snl_writer_flush(&w);
+    canvas.defs_at = vt_str_len(canvas.surface);
+
+    // add the __default__ filter; the compact profile does not reference it
+    if (!(options.flags & SNL_CANVAS_COMPACT)) snl_canvas_add_filter_blur(&canvas, SNL_FILTER_DEFAULT, 0, 0);
+
+    return canvas;
+}
+
+snl_canvas_t snl_canvas_load(const char *const filename) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // map the file, registering its definitions
+    snl_defs_t *const defs = snl_defs_create();
+    snl_load_t *const base = snl_load_open(filename, defs);
+
+    // new definitions go to a <defs> element of their own in front of the new elements
+    snl_canvas_t canvas = (snl_canvas_t) {
+        .width = base->width,
+        .height = base->height,
+        .surface = vt_str_create_capacity(VT_STR_TMP_BUFFER_SIZE, NULL),
+        .precision = SNL_PRECISION_DEFAULT,
+        .high_water = SNL_STREAM_HIGH_WATER_DEFAULT,
+        .defs = defs,
+        .definitions = vt_str_create_capacity(VT_STR_TMP_BUFFER_SIZE, NULL),
+        .base = base
+    };
+
+    // add the __default__ filter unless the file has it
+    snl_canvas_add_filter_blur(&canvas, SNL_FILTER_DEFAULT, 0, 0);
+
+    return canvas;
+}
+
+snl_canvas_t snl_canvas_load_ex(const char *const filename, const snl_canvas_options_t options) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // map the file; its definitions are rebuilt along with the elements
+    snl_defs_t *const defs = snl_defs_create();
+    snl_load_t *const load = snl_load_open(filename, defs);
+    snl_defs_destroy(defs);
+
+    // draw everything again
+    snl_canvas_t canvas = snl_canvas_create_ex(load->width, load->height, options);
+    snl_load_replay(load, &canvas, filename);
+    snl_load_close(load);
+
+    return canvas;
+}
+
+snl_canvas_t snl_canvas_append(const char *const filename) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // find the end of the file, registering the definitions of its head
+    snl_defs_t *const defs = snl_defs_create();
+    snl_load_t *const base = snl_load_open_tail(filename, defs);
+
+    // new definitions go to a <defs> element of their own in front of the new elements
+    snl_canvas_t canvas = (snl_canvas_t) {
+        .width = base->width,
+        .height = base->height,
+        .surface = vt_str_create_capacity(VT_STR_TMP_BUFFER_SIZE, NULL),
+        .precision = SNL_PRECISION_DEFAULT,
+        .high_water = SNL_STREAM_HIGH_WATER_DEFAULT,
+        .defs = defs,
+        .definitions = vt_str_create_capacity(VT_STR_TMP_BUFFER_SIZE, NULL),
+        .base = base
+    };
 
-    // add the __default__ filter
+    // add the __default__ filter unless the file has it
     snl_canvas_add_filter_blur(&canvas, SNL_FILTER_DEFAULT, 0, 0);
 
     return canvas;
@@ -35,8 +187,43 @@ void snl_canvas_destroy(snl_canvas_t *canvas) {
     VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
 
+    // drop a symbol left recording
+    if (canvas->symbol) {
+        snl_symbol_t *const symbol = snl_canvas_restore(canvas);
+        vt_str_destroy(symbol->outer.surface);
+        vt_str_destroy(symbol->id);
+        free(symbol);
+    }
+
+    // drop groups left open
+    snl_canvas_drop_groups(canvas, 0);
+    free(canvas->groups);
+
     // free string
     vt_str_destroy(canvas->surface);
+
+    // free records
+    if (canvas->list) snl_display_list_destroy(canvas->list);
+    if (canvas->index) snl_index_destroy(canvas->index);
+    if (canvas->sheet) snl_style_sheet_destroy(canvas->sheet);
+    snl_defs_destroy(canvas->defs);
+    vt_str_destroy(canvas->definitions);
+    if (canvas->base) snl_load_close(canvas->base);
+    free(canvas->elements);
+}
+
+snl_sink_t snl_sink_file(FILE *const fp) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(fp != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    return SNL_SINK(snl_sink_write_file, fp);
+}
+
+snl_sink_t snl_sink_fd(const int fd) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(fd >= 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    return SNL_SINK(snl_sink_write_fd, (void*)(intptr_t)fd);
 }
 
 void snl_canvas_preallocate(snl_canvas_t *const canvas, float bytes) {
@@ -56,11 +243,10 @@ void snl_canvas_add_filter_blur(snl_canvas_t *const canvas, const char *const id
     VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
 
     // add filter
-    vt_str_appendf(
-        canvas->surface,
-        "<defs><filter id='%s'><feGaussianBlur stdDeviation='%d %d'/></filter></defs>\n",
-        id, blurnessHorizontal, blurnessVertical
-    );
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->defs->scratch);
+    snl_emit_filter_blur(&w, id, blurnessHorizontal, blurnessVertical, false);
+    snl_canvas_define(canvas, &w, id, NULL);
 }
 
 void snl_canvas_add_filter_blur_hard_edge(snl_canvas_t *const canvas, const char *const id, const int32_t blurnessHorizontal, const int32_t blurnessVertical) {
@@ -70,14 +256,10 @@ void snl_canvas_add_filter_blur_hard_edge(snl_canvas_t *const canvas, const char
     VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
 
     // add filter
-    vt_str_appendf(
-        canvas->surface,
-        "<defs><filter id='%s'>"
-        "<feGaussianBlur stdDeviation='%d %d'/>"
-        "<feComponentTransfer><feFuncA type='table' tableValues='1 1'/></feComponentTransfer>"
-        "</filter></defs>\n",
-        id, blurnessHorizontal, blurnessVertical
-    );
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->defs->scratch);
+    snl_emit_filter_blur(&w, id, blurnessHorizontal, blurnessVertical, true);
+    snl_canvas_define(canvas, &w, id, NULL);
 }
 
 void snl_canvas_add_filter_shadow(
@@ -94,15 +276,10 @@ void snl_canvas_add_filter_shadow(
     VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
 
     // add filter
-    vt_str_appendf(
-        canvas->surface,
-        "<defs><filter id='%s' x='0' y='0' width='200%%' height='200%%'>"
-        "<feOffset result='offOut' in='%s' dx='%d' dy='%d'/>"
-        "<feGaussianBlur result='blurOut' in='offOut' stdDeviation='%d'/>"
-        "<feBlend in='SourceGraphic' in2='blurOut' mode='normal'/>"
-        "</filter></defs>\n",
-        id, color_blend ? "SourceGraphic" : "SourceAlpha", offsetX, offsetY, blurness
-    );
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->defs->scratch);
+    snl_emit_filter_shadow(&w, id, offsetX, offsetY, blurness, color_blend);
+    snl_canvas_define(canvas, &w, id, NULL);
 }
 
 void snl_canvas_add_gradient_linear(
@@ -125,17 +302,16 @@ void snl_canvas_add_gradient_linear(
     float x1 = 0, y1 = 0, x2 = 100, y2 = 0;
     snl_rotate(angle, &x1, &y1, &x2, &y2);
 
-    // add filter
-    vt_str_appendf(
-        canvas->surface,
-        "<defs><linearGradient id='%s' x1='%f%%' y1='%f%%' x2='%f%%' y2='%f%%'>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "</linearGradient></defs>\n",
-        id, x1, y1, x2, y2,
-        offsetA, colorA.r, colorA.g, colorA.b, colorA.a, opacityA,
-        offsetB, colorB.r, colorB.g, colorB.b, colorB.a, opacityB
-    );
+    // add gradient
+    const snl_gradient_t gradient = {
+        .start = SNL_POINT(x1, y1), .end = SNL_POINT(x2, y2),
+        .stops = { { offsetA, colorA, opacityA }, { offsetB, colorB, opacityB } },
+        .count = 2
+    };
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->defs->scratch);
+    snl_emit_gradient_linear(&w, id, gradient.start, gradient.end, gradient.stops, gradient.count);
+    snl_canvas_define(canvas, &w, id, &gradient);
 }
 
 void snl_canvas_add_gradient_linear_tricolor(
@@ -161,19 +337,16 @@ void snl_canvas_add_gradient_linear_tricolor(
     float x1 = 0, y1 = 0, x2 = 100, y2 = 0;
     snl_rotate(angle, &x1, &y1, &x2, &y2);
 
-    // add filter
-    vt_str_appendf(
-        canvas->surface,
-        "<defs><linearGradient id='%s' x1='%f%%' y1='%f%%' x2='%f%%' y2='%f%%'>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "</linearGradient></defs>\n",
-        id, x1, y1, x2, y2,
-        offsetA, colorA.r, colorA.g, colorA.b, colorA.a, opacityA,
-        offsetB, colorB.r, colorB.g, colorB.b, colorB.a, opacityB,
-        offsetC, colorC.r, colorC.g, colorC.b, colorC.a, opacityC
-    );
+    // add gradient
+    const snl_gradient_t gradient = {
+        .start = SNL_POINT(x1, y1), .end = SNL_POINT(x2, y2),
+        .stops = { { offsetA, colorA, opacityA }, { offsetB, colorB, opacityB }, { offsetC, colorC, opacityC } },
+        .count = 3
+    };
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->defs->scratch);
+    snl_emit_gradient_linear(&w, id, gradient.start, gradient.end, gradient.stops, gradient.count);
+    snl_canvas_define(canvas, &w, id, &gradient);
 }
 
 void snl_canvas_add_gradient_radial(
@@ -191,17 +364,16 @@ void snl_canvas_add_gradient_radial(
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
 
-    // add filter
-    vt_str_appendf(
-        canvas->surface,
-        "<defs><radialGradient id='%s' x1='50%%' y1='50%%' x2='50%%' y2='50%%'>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "</radialGradient></defs>\n",
-        id,
-        offsetA, colorA.r, colorA.g, colorA.b, colorA.a, opacityA,
-        offsetB, colorB.r, colorB.g, colorB.b, colorB.a, opacityB
-    );
+    // add gradient
+    const snl_gradient_t gradient = {
+        .radial = true,
+        .stops = { { offsetA, colorA, opacityA }, { offsetB, colorB, opacityB } },
+        .count = 2
+    };
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->defs->scratch);
+    snl_emit_gradient_radial(&w, id, gradient.stops, gradient.count);
+    snl_canvas_define(canvas, &w, id, &gradient);
 }
 
 void snl_canvas_add_gradient_radial_tricolor(
@@ -222,19 +394,16 @@ void snl_canvas_add_gradient_radial_tricolor(
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
 
-    // add filter
-    vt_str_appendf(
-        canvas->surface,
-        "<defs><radialGradient id='%s' x1='50%%' y1='50%%' x2='50%%' y2='50%%'>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "<stop offset='%d%%' style='stop-color:rgba(%u, %u, %u, %u);stop-opacity:%f'/>"
-        "</radialGradient></defs>\n",
-        id,
-        offsetA, colorA.r, colorA.g, colorA.b, colorA.a, opacityA,
-        offsetB, colorB.r, colorB.g, colorB.b, colorB.a, opacityB,
-        offsetC, colorC.r, colorC.g, colorC.b, colorC.a, opacityC
-    );
+    // add gradient
+    const snl_gradient_t gradient = {
+        .radial = true,
+        .stops = { { offsetA, colorA, opacityA }, { offsetB, colorB, opacityB }, { offsetC, colorC, opacityC } },
+        .count = 3
+    };
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->defs->scratch);
+    snl_emit_gradient_radial(&w, id, gradient.stops, gradient.count);
+    snl_canvas_define(canvas, &w, id, &gradient);
 }
 
 void snl_canvas_render_line(
@@ -251,32 +420,27 @@ void snl_canvas_render_line(
     start = SNL_POINT_ADJUST(start, canvas->translateX, canvas->translateY);
     end = SNL_POINT_ADJUST(end, canvas->translateX, canvas->translateY);
 
-    // open tag
-    vt_str_appendf(
-        canvas->surface, 
-        "<line x1='%.2f' y1='%.2f' x2='%.2f' y2='%.2f' ",
-        start.x, start.y, end.x, end.y
-    );
+    // cull
+    if (snl_canvas_culls(canvas, &appearance) && !snl_canvas_line_visible(canvas, start.x, start.y, end.x, end.y, fabsf(appearance.stroke_width))) {
+        canvas->culled++;
+        return;
+    }
 
-    // style
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "style='stroke:url(#%s);stroke-width:%.2f;stroke-opacity:%.2f;filter:url(#%s)' ", 
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity, 
-            appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "style='stroke:rgba(%u, %u, %u, %u);stroke-width:%.2f;stroke-opacity:%.2f;filter:url(#%s)' ", 
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity, 
-            appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // record
+    if (canvas->list) {
+        snl_display_list_push(canvas->list, SNL_RECORD_LINE, &appearance);
+        snl_display_list_push_point(canvas->list, start);
+        snl_display_list_push_point(canvas->list, end);
+        return;
     }
 
-    // close tag
-    vt_str_appendf(canvas->surface, "%s", "/>\n");
+    // render
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, NULL);
+    snl_emit_line(&w, start, end, &appearance);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_circle(
@@ -292,45 +456,27 @@ void snl_canvas_render_circle(
     // adjust for translation
     origin = SNL_POINT_ADJUST(origin, canvas->translateX, canvas->translateY);
 
-    // open tag
-    vt_str_appendf(
-        canvas->surface,
-        "<circle cx='%.2f' cy='%.2f' r='%.2f' ",
-        origin.x, origin.y, radius
-    );
+    // cull
+    if (snl_canvas_culls(canvas, &appearance) && !snl_canvas_circle_visible(canvas, origin.x, origin.y, radius, fabsf(appearance.stroke_width))) {
+        canvas->culled++;
+        return;
+    }
 
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // record
+    if (canvas->list) {
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_CIRCLE, &appearance);
+        snl_display_list_push_point(canvas->list, origin);
+        canvas->list->radius[index] = radius;
+        return;
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "%s", "/>\n");
+
+    // render
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, NULL);
+    snl_emit_circle(&w, origin, radius, &appearance);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_ellipse(
@@ -346,45 +492,31 @@ void snl_canvas_render_ellipse(
     // adjust for translation
     origin = SNL_POINT_ADJUST(origin, canvas->translateX, canvas->translateY);
 
-    // open tag
-    vt_str_appendf(
-        canvas->surface,
-        "<ellipse cx='%.2f' cy='%.2f' rx='%.2f' ry='%.2f' ",
-        origin.x, origin.y, radius.x, radius.y
-    );
+    // cull
+    if (snl_canvas_culls(canvas, &appearance)) {
+        const float box[4] = { origin.x - fabsf(radius.x), origin.y - fabsf(radius.y), origin.x + fabsf(radius.x), origin.y + fabsf(radius.y) };
+        if (!snl_canvas_box_visible(canvas, NULL, box, fabsf(appearance.stroke_width))) {
+            canvas->culled++;
+            return;
+        }
+    }
 
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // record
+    if (canvas->list) {
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_ELLIPSE, &appearance);
+        snl_display_list_push_point(canvas->list, origin);
+        canvas->list->size_x[index] = radius.x;
+        canvas->list->size_y[index] = radius.y;
+        return;
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "%s", "/>\n");
+
+    // render
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, NULL);
+    snl_emit_ellipse(&w, origin, radius, &appearance);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_rectangle(
@@ -400,45 +532,29 @@ void snl_canvas_render_rectangle(
     // adjust for translation
     pos = SNL_POINT_ADJUST(pos, canvas->translateX, canvas->translateY);
 
-    // open tag
-    vt_str_appendf(
-        canvas->surface,
-        "<rect x='%.2f' y='%.2f' width='%.2f' height='%.2f' rx='%.2f' ry='%.2f' ",
-        pos.x, pos.y, size.x, size.y, radius, radius
-    );
+    // cull
+    if (snl_canvas_culls(canvas, &appearance) && !snl_canvas_rectangle_visible(canvas, pos.x, pos.y, size.x, size.y, fabsf(appearance.stroke_width))) {
+        canvas->culled++;
+        return;
+    }
 
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // record
+    if (canvas->list) {
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_RECTANGLE, &appearance);
+        snl_display_list_push_point(canvas->list, pos);
+        canvas->list->size_x[index] = size.x;
+        canvas->list->size_y[index] = size.y;
+        canvas->list->radius[index] = radius;
+        return;
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "%s", "/>\n");
+
+    // render
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, NULL);
+    snl_emit_rectangle(&w, pos, size, radius, &appearance);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_polygon_begin(snl_canvas_t *const canvas) {
@@ -447,8 +563,20 @@ void snl_canvas_render_polygon_begin(snl_canvas_t *const canvas) {
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
 
+    // record
+    if (canvas->list) {
+        snl_display_list_push(canvas->list, SNL_RECORD_POLYGON, NULL);
+        canvas->drawing = true;
+        return;
+    }
+
     // render
-    vt_str_appendf(canvas->surface, "<polygon points='");
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_points_begin(&w, true, &canvas->path_cursor);
+    snl_canvas_commit(canvas, &w);
+    canvas->drawing = true;
 }
 
 void snl_canvas_render_polygon_point(snl_canvas_t *const canvas, snl_point_t point) {
@@ -460,8 +588,17 @@ void snl_canvas_render_polygon_point(snl_canvas_t *const canvas, snl_point_t poi
     // adjust for translation
     point = SNL_POINT_ADJUST(point, canvas->translateX, canvas->translateY);
 
+    // record
+    if (canvas->list) {
+        snl_display_list_push_point(canvas->list, point);
+        return;
+    }
+
     // render
-    vt_str_appendf(canvas->surface, "%.2f, %.2f ", point.x, point.y);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_point(&w, &canvas->path_cursor, point);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_polygon_end(snl_canvas_t *const canvas, const snl_appearance_t appearance, const char *const fill_rule) {
@@ -470,43 +607,63 @@ void snl_canvas_render_polygon_end(snl_canvas_t *const canvas, const snl_appeara
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(!snl_can_continue(canvas), "Error: you need to 'snl_render_polygon_begin()' before using 'snl_render_polygon_end()'.\n");
 
-    // open tag
-    vt_str_appendf(canvas->surface, "%s", "' ");
+    // record
+    if (canvas->list) {
+        const size_t index = canvas->list->len - 1;
+        snl_display_list_set_appearance(canvas->list, index, &appearance);
+        canvas->list->aux[index] = snl_display_list_add_string(canvas->list, fill_rule);
+        canvas->drawing = false;
+        return;
+    }
 
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' fill-rule='%s' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, fill_rule,
-            appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // render
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_points_end(&w, &canvas->path_cursor, &appearance, fill_rule);
+    canvas->drawing = false;
+    snl_canvas_commit(canvas, &w);
+}
+
+void snl_canvas_render_polygon_points(
+    snl_canvas_t *const canvas, 
+    const snl_point_t *const points, const size_t n, 
+    const snl_appearance_t appearance, const char *const fill_rule
+) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(n == 0 || points != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+
+    // cull
+    const snl_point_t offset = SNL_POINT(canvas->translateX, canvas->translateY);
+    const snl_point_t *kept = points;
+    size_t count = n;
+    if (n > 0 && snl_canvas_culls(canvas, &appearance)) {
+        count = snl_canvas_clip_points(canvas, points, n, offset, SNL_CULL_MITER * fabsf(appearance.stroke_width), &kept);
+        if (count == 0) {
+            canvas->culled++;
+            return;
+        }
+    }
+
+    if (canvas->list) {
+        // record
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_POLYGON, &appearance);
+        snl_display_list_push_points(canvas->list, kept, count, offset);
+        canvas->list->aux[index] = snl_display_list_add_string(canvas->list, fill_rule);
     } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' fill-rule='%s' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, fill_rule,
-            appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+        // render
+        snl_canvas_push_element(canvas);
+        snl_writer_t w;
+        snl_canvas_writer_init(canvas, &w, canvas->surface);
+        snl_emit_points_begin(&w, true, &canvas->path_cursor);
+        snl_emit_points(&w, &canvas->path_cursor, kept, count, offset);
+        snl_emit_points_end(&w, &canvas->path_cursor, &appearance, fill_rule);
+        snl_canvas_commit(canvas, &w);
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "%s", "/>\n");
+
+    if (kept != points) free((snl_point_t*)kept);
 }
 
 void snl_canvas_render_polyline_begin(snl_canvas_t *const canvas) {
@@ -515,8 +672,20 @@ void snl_canvas_render_polyline_begin(snl_canvas_t *const canvas) {
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
 
+    // record
+    if (canvas->list) {
+        snl_display_list_push(canvas->list, SNL_RECORD_POLYLINE, NULL);
+        canvas->drawing = true;
+        return;
+    }
+
     // render
-    vt_str_appendf(canvas->surface, "<polyline points='");
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_points_begin(&w, false, &canvas->path_cursor);
+    snl_canvas_commit(canvas, &w);
+    canvas->drawing = true;
 }
 
 void snl_canvas_render_polyline_point(snl_canvas_t *const canvas, snl_point_t point) {
@@ -528,8 +697,17 @@ void snl_canvas_render_polyline_point(snl_canvas_t *const canvas, snl_point_t po
     // adjust for translation
     point = SNL_POINT_ADJUST(point, canvas->translateX, canvas->translateY);
 
+    // record
+    if (canvas->list) {
+        snl_display_list_push_point(canvas->list, point);
+        return;
+    }
+
     // render
-    vt_str_appendf(canvas->surface, "%.2f, %.2f ", point.x, point.y);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_point(&w, &canvas->path_cursor, point);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_polyline_end(snl_canvas_t *const canvas, const snl_appearance_t appearance) {
@@ -538,41 +716,60 @@ void snl_canvas_render_polyline_end(snl_canvas_t *const canvas, const snl_appear
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(!snl_can_continue(canvas), "Error: you need to 'snl_render_polyline_begin()' before using 'snl_render_polyline_end()'.\n");
 
-    // open tag
-    vt_str_appendf(canvas->surface, "%s", "' ");
+    // record
+    if (canvas->list) {
+        snl_display_list_set_appearance(canvas->list, canvas->list->len - 1, &appearance);
+        canvas->drawing = false;
+        return;
+    }
+
+    // render
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_points_end(&w, &canvas->path_cursor, &appearance, NULL);
+    canvas->drawing = false;
+    snl_canvas_commit(canvas, &w);
+}
 
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+void snl_canvas_render_polyline_points(
+    snl_canvas_t *const canvas, 
+    const snl_point_t *const points, const size_t n, 
+    const snl_appearance_t appearance
+) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(n == 0 || points != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+
+    // cull
+    const snl_point_t offset = SNL_POINT(canvas->translateX, canvas->translateY);
+    const snl_point_t *kept = points;
+    size_t count = n;
+    if (n > 0 && snl_canvas_culls(canvas, &appearance)) {
+        count = snl_canvas_clip_points(canvas, points, n, offset, SNL_CULL_MITER * fabsf(appearance.stroke_width), &kept);
+        if (count == 0) {
+            canvas->culled++;
+            return;
+        }
+    }
+
+    if (canvas->list) {
+        // record
+        snl_display_list_push(canvas->list, SNL_RECORD_POLYLINE, &appearance);
+        snl_display_list_push_points(canvas->list, kept, count, offset);
     } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+        // render
+        snl_canvas_push_element(canvas);
+        snl_writer_t w;
+        snl_canvas_writer_init(canvas, &w, canvas->surface);
+        snl_emit_points_begin(&w, false, &canvas->path_cursor);
+        snl_emit_points(&w, &canvas->path_cursor, kept, count, offset);
+        snl_emit_points_end(&w, &canvas->path_cursor, &appearance, NULL);
+        snl_canvas_commit(canvas, &w);
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "%s", "/>\n");
+
+    if (kept != points) free((snl_point_t*)kept);
 }
 
 void snl_canvas_render_curve(
@@ -594,45 +791,36 @@ void snl_canvas_render_curve(
     const float curve_height = (delta_end.x + delta_end.y) / 2; 
     const float curvature = (delta_end.x + delta_end.y) / 2; 
 
-    // open tag
-    vt_str_appendf(
-        canvas->surface,
-        "<path d='M %.2f %.2f q %.2f %.2f %.2f %.2f' ",
-        start.x, start.y, curve_height, curvature, delta_end.x, delta_end.y
-    );
+    // cull: the curve lies inside the triangle of its end points and its control point
+    if (snl_canvas_culls(canvas, &appearance)) {
+        const snl_point_t control = SNL_POINT(start.x + curve_height, start.y + curvature);
+        const float box[4] = {
+            fminf(fminf(start.x, end.x), control.x), fminf(fminf(start.y, end.y), control.y),
+            fmaxf(fmaxf(start.x, end.x), control.x), fmaxf(fmaxf(start.y, end.y), control.y)
+        };
+        if (!snl_canvas_box_visible(canvas, NULL, box, fabsf(appearance.stroke_width))) {
+            canvas->culled++;
+            return;
+        }
+    }
 
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // record (delta is derived from the end point on save)
+    if (canvas->list) {
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_CURVE, &appearance);
+        snl_display_list_push_point(canvas->list, start);
+        snl_display_list_push_point(canvas->list, end);
+        canvas->list->size_x[index] = curve_height;
+        canvas->list->size_y[index] = curvature;
+        return;
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "%s", "/>\n");
+
+    // render
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, NULL);
+    snl_emit_curve(&w, start, SNL_POINT(curve_height, curvature), delta_end, &appearance);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_curve_custom(
@@ -653,45 +841,36 @@ void snl_canvas_render_curve_custom(
     // calculte curve_height and curvature
     const snl_point_t delta_end = SNL_POINT(end.x - start.x, end.y - start.y);
 
-    // open tag
-    vt_str_appendf(
-        canvas->surface,
-        "<path d='M %.2f %.2f q %.2f %.2f %.2f %.2f' ",
-        start.x, start.y, curve_height, curvature, delta_end.x, delta_end.y
-    );
+    // cull: the curve lies inside the triangle of its end points and its control point
+    if (snl_canvas_culls(canvas, &appearance)) {
+        const snl_point_t control = SNL_POINT(start.x + curve_height, start.y + curvature);
+        const float box[4] = {
+            fminf(fminf(start.x, end.x), control.x), fminf(fminf(start.y, end.y), control.y),
+            fmaxf(fmaxf(start.x, end.x), control.x), fmaxf(fmaxf(start.y, end.y), control.y)
+        };
+        if (!snl_canvas_box_visible(canvas, NULL, box, fabsf(appearance.stroke_width))) {
+            canvas->culled++;
+            return;
+        }
+    }
 
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // record (delta is derived from the end point on save)
+    if (canvas->list) {
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_CURVE, &appearance);
+        snl_display_list_push_point(canvas->list, start);
+        snl_display_list_push_point(canvas->list, end);
+        canvas->list->size_x[index] = curve_height;
+        canvas->list->size_y[index] = curvature;
+        return;
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "%s", "/>\n");
+
+    // render
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, NULL);
+    snl_emit_curve(&w, start, SNL_POINT(curve_height, curvature), delta_end, &appearance);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_path_begin(snl_canvas_t *const canvas) {
@@ -700,11 +879,22 @@ void snl_canvas_render_path_begin(snl_canvas_t *const canvas) {
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
 
+    // record
+    if (canvas->list) {
+        snl_display_list_push(canvas->list, SNL_RECORD_PATH, NULL);
+        canvas->drawing = true;
+        return;
+    }
+
     // render
-    vt_str_appendf(canvas->surface, "<polyline points='");
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_points_begin(&w, false, &canvas->path_cursor);
+    snl_canvas_commit(canvas, &w);
+    canvas->drawing = true;
 }
 
-static snl_point_t gi_path_prev_point = SNL_POINT(0, 0);
 void snl_canvas_render_path_line_to(snl_canvas_t *const canvas, snl_point_t point) {
     // check for invalid input
     VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
@@ -714,11 +904,20 @@ void snl_canvas_render_path_line_to(snl_canvas_t *const canvas, snl_point_t poin
     // adjust for translation
     point = SNL_POINT_ADJUST(point, canvas->translateX, canvas->translateY);
 
-    // render
-    vt_str_appendf(canvas->surface, "%.2f, %.2f ", point.x, point.y);
-
     // update previous point
-    gi_path_prev_point = point;
+    canvas->path_prev_point = point;
+
+    // record
+    if (canvas->list) {
+        snl_display_list_push_point(canvas->list, point);
+        return;
+    }
+
+    // render
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_point(&w, &canvas->path_cursor, point);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_path_move_by(snl_canvas_t *const canvas, const snl_point_t amount) {
@@ -728,10 +927,19 @@ void snl_canvas_render_path_move_by(snl_canvas_t *const canvas, const snl_point_
     VT_ENFORCE(!snl_can_continue(canvas), "Error: you need to 'snl_render_path_begin()' before using 'snl_render_path_move_by()'.\n");
 
     // calculate the new point which will later become our previous point
-    gi_path_prev_point = SNL_POINT(gi_path_prev_point.x + amount.x, gi_path_prev_point.y + amount.y);
+    canvas->path_prev_point = SNL_POINT(canvas->path_prev_point.x + amount.x, canvas->path_prev_point.y + amount.y);
+
+    // record
+    if (canvas->list) {
+        snl_display_list_push_point(canvas->list, canvas->path_prev_point);
+        return;
+    }
 
     // render
-    vt_str_appendf(canvas->surface, "%.2f, %.2f ", gi_path_prev_point.x, gi_path_prev_point.y);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_point(&w, &canvas->path_cursor, canvas->path_prev_point);
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_path_end(snl_canvas_t *const canvas, const snl_appearance_t appearance) {
@@ -740,41 +948,19 @@ void snl_canvas_render_path_end(snl_canvas_t *const canvas, const snl_appearance
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(!snl_can_continue(canvas), "Error: you need to 'snl_render_path_begin()' before using 'snl_render_path_end()'.\n");
 
-    // open tag
-    vt_str_appendf(canvas->surface, "%s", "' ");
-
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // record
+    if (canvas->list) {
+        snl_display_list_set_appearance(canvas->list, canvas->list->len - 1, &appearance);
+        canvas->drawing = false;
+        return;
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "%s", "/>\n");
+
+    // render
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_points_end(&w, &canvas->path_cursor, &appearance, NULL);
+    canvas->drawing = false;
+    snl_canvas_commit(canvas, &w);
 }
 
 void snl_canvas_render_text(snl_canvas_t *const canvas, snl_point_t pos, const char* const text, const float font_size, const char *const font_family, const struct SnailColor color) {
@@ -788,49 +974,33 @@ void snl_canvas_render_text(snl_canvas_t *const canvas, snl_point_t pos, const c
 
     // default appearance
     const snl_appearance_t appearance = SNL_APPEARANCE(0, 1, color, 1, color, NULL, NULL);
+    const snl_text_style_t text_style = SNL_TEXT_STYLE(font_size, 0, font_family, SNL_FONT_WEIGHT_NORMAL, SNL_FONT_STYLE_NORMAL, SNL_TEXT_NONE);
 
-    // open tag
-    vt_str_appendf(
-        canvas->surface,
-        "<text x='%.2f' y='%.2f' font-family='%s' font-size='%.2f' font-weight='%s' font-style='%s' text-decoration='%s' ",
-        pos.x, pos.y, font_family, font_size, SNL_FONT_WEIGHT_NORMAL, SNL_FONT_STYLE_NORMAL, SNL_TEXT_NONE
-    );
+    // cull
+    if (snl_canvas_culls(canvas, &appearance) && !snl_canvas_text_visible(canvas, pos, text, &text_style, fabsf(appearance.stroke_width))) {
+        canvas->culled++;
+        return;
+    }
 
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // record
+    if (canvas->list) {
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_TEXT, &appearance);
+        snl_display_list_push_point(canvas->list, pos);
+        canvas->list->style[index] = snl_display_list_add_text_style(canvas->list, &text_style);
+        canvas->list->aux[index] = snl_display_list_add_string(canvas->list, text);
+        return;
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "transform='rotate(%.2f)'>%s</text>\n", 0, text);
+
+    // render
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, &text_style);
+    snl_emit_text(&w, pos, text, &appearance, &text_style);
+    snl_canvas_commit(canvas, &w);
 }
 
-extern void snl_canvas_render_text_styled(snl_canvas_t *const canvas, snl_point_t pos, const char* const text, const snl_appearance_t appearance, snl_text_style_t text_style) {
+void snl_canvas_render_text_styled(snl_canvas_t *const canvas, snl_point_t pos, const char* const text, const snl_appearance_t appearance, snl_text_style_t text_style) {
     // check for invalid input
     VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
@@ -839,119 +1009,772 @@ extern void snl_canvas_render_text_styled(snl_canvas_t *const canvas, snl_point_
     // adjust for translation
     pos = SNL_POINT_ADJUST(pos, canvas->translateX, canvas->translateY);
 
-    // open tag
-    vt_str_appendf(
-        canvas->surface,
-        "<text x='%.2f' y='%.2f' font-family='%s' font-size='%.2f' font-weight='%s' font-style='%s' text-decoration='%s' ",
-        pos.x, pos.y, text_style.font_family, text_style.font_size, text_style.font_weight, text_style.font_style, text_style.text_decoration
-    );
+    // cull
+    if (snl_canvas_culls(canvas, &appearance) && !snl_canvas_text_visible(canvas, pos, text, &text_style, fabsf(appearance.stroke_width))) {
+        canvas->culled++;
+        return;
+    }
 
-    // style: stoke
-    if (snl_color_cmp(appearance.stroke_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='url(#%s)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            appearance.gradient, appearance.stroke_width, appearance.stroke_opacity
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
-            SNL_COLOR_EXPAND(appearance.stroke_color), appearance.stroke_width, appearance.stroke_opacity
-        );
-    }
-
-    // style: fill
-    if (snl_color_cmp(appearance.fill_color, SNL_COLOR_NONE) && appearance.gradient) {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='url(#%s)' fill-opacity='%.2f' filter='url(#%s)' ",
-            appearance.gradient, appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
-    } else {
-        vt_str_appendf(
-            canvas->surface,
-            "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
-            SNL_COLOR_EXPAND(appearance.fill_color), appearance.fill_opacity, appearance.filter ? appearance.filter : SNL_FILTER_DEFAULT
-        );
+    // record
+    if (canvas->list) {
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_TEXT, &appearance);
+        snl_display_list_push_point(canvas->list, pos);
+        canvas->list->style[index] = snl_display_list_add_text_style(canvas->list, &text_style);
+        canvas->list->aux[index] = snl_display_list_add_string(canvas->list, text);
+        return;
     }
-    
-    // close tag
-    vt_str_appendf(canvas->surface, "transform='rotate(%.2f)'>%s</text>\n", text_style.text_rotation, text);
+
+    // render
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, &text_style);
+    snl_emit_text(&w, pos, text, &appearance, &text_style);
+    snl_canvas_commit(canvas, &w);
 }
 
-void snl_canvas_undo(snl_canvas_t *const canvas) {
+void snl_canvas_render_circles(
+    snl_canvas_t *const canvas, 
+    const float *const xs, const float *const ys, const float *const rs, const size_t n, 
+    const snl_appearance_t appearance
+) {
     // check for invalid input
     VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(n == 0 || (xs != NULL && ys != NULL && rs != NULL), "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
 
-    // undo the last operation (remove the last line)
-    size_t surface_len = vt_str_len(canvas->surface) - 2;
-    const char *const surface_ptr = vt_str_z(canvas->surface);
-    while (surface_len-- > 0) {
-        if (surface_ptr[surface_len] == '\n') {
-            vt_str_remove(canvas->surface, surface_len + 1, vt_str_len(canvas->surface) - surface_len - 1);
-            break;
+    const bool cull = snl_canvas_culls(canvas, &appearance);
+    const float margin = fabsf(appearance.stroke_width);
+    const float tx = canvas->translateX, ty = canvas->translateY;
+
+    // record
+    if (canvas->list) {
+        size_t first = SIZE_MAX;
+        for (size_t i = 0; i < n; i++) {
+            if (cull && !snl_canvas_circle_visible(canvas, xs[i] + tx, ys[i] + ty, rs[i], margin)) {
+                canvas->culled++;
+                continue;
+            }
+            const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_CIRCLE, first == SIZE_MAX ? &appearance : NULL);
+            if (first == SIZE_MAX) first = index;
+            snl_display_list_push_point(canvas->list, SNL_POINT(xs[i] + tx, ys[i] + ty));
+            canvas->list->appearance[index] = canvas->list->appearance[first];
+            canvas->list->radius[index] = rs[i];
+        }
+        return;
+    }
+
+    // format the shared attributes once
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, NULL);
+    vt_str_t *const tail = vt_str_create_capacity(256, NULL);
+    snl_writer_t tail_w;
+    snl_canvas_writer_init(canvas, &tail_w, tail);
+    tail_w.style_class = w.style_class;
+    snl_emit_tail_shape(&tail_w, &appearance);
+    snl_writer_flush(&tail_w);
+
+    // render runs of visible circles in chunks, so that a streaming canvas stays bounded
+    for (size_t i = 0, end = n; i < n; i = end) {
+        if (cull) {
+            for (; i < n && !snl_canvas_circle_visible(canvas, xs[i] + tx, ys[i] + ty, rs[i], margin); i++) canvas->culled++;
+            for (end = i; end < n && snl_canvas_circle_visible(canvas, xs[end] + tx, ys[end] + ty, rs[end], margin); end++);
+        }
+        for (size_t j = i; j < end; j += SNL_EMIT_BATCH_SIZE) {
+            const size_t count = end - j < SNL_EMIT_BATCH_SIZE ? end - j : SNL_EMIT_BATCH_SIZE;
+            size_t *const starts = snl_canvas_push_elements(canvas, count);
+            snl_emit_circles(&w, xs + j, ys + j, rs + j, count, SNL_POINT(tx, ty), tail, starts);
+            snl_canvas_commit(canvas, &w);
         }
     }
+
+    vt_str_destroy(tail);
 }
 
-void snl_canvas_clear(snl_canvas_t *const canvas) {
+void snl_canvas_render_rectangles(
+    snl_canvas_t *const canvas, 
+    const float *const xs, const float *const ys, const float *const widths, const float *const heights, const size_t n, 
+    const float radius, const snl_appearance_t appearance
+) {
     // check for invalid input
     VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(n == 0 || (xs != NULL && ys != NULL && widths != NULL && heights != NULL), "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
 
-    // undo all canvas operations
-    const size_t remove_from_idx = vt_str_index_find(canvas->surface, "\n");
-    vt_str_remove(canvas->surface, remove_from_idx + 1, vt_str_len(canvas->surface) - remove_from_idx - 1);
+    const bool cull = snl_canvas_culls(canvas, &appearance);
+    const float margin = fabsf(appearance.stroke_width);
+    const float tx = canvas->translateX, ty = canvas->translateY;
+
+    // record
+    if (canvas->list) {
+        size_t first = SIZE_MAX;
+        for (size_t i = 0; i < n; i++) {
+            if (cull && !snl_canvas_rectangle_visible(canvas, xs[i] + tx, ys[i] + ty, widths[i], heights[i], margin)) {
+                canvas->culled++;
+                continue;
+            }
+            const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_RECTANGLE, first == SIZE_MAX ? &appearance : NULL);
+            if (first == SIZE_MAX) first = index;
+            snl_display_list_push_point(canvas->list, SNL_POINT(xs[i] + tx, ys[i] + ty));
+            canvas->list->appearance[index] = canvas->list->appearance[first];
+            canvas->list->size_x[index] = widths[i];
+            canvas->list->size_y[index] = heights[i];
+            canvas->list->radius[index] = radius;
+        }
+        return;
+    }
+
+    // format the shared attributes once
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, NULL);
+    vt_str_t *const tail = vt_str_create_capacity(256, NULL);
+    snl_writer_t tail_w;
+    snl_canvas_writer_init(canvas, &tail_w, tail);
+    tail_w.style_class = w.style_class;
+    snl_emit_tail_rectangle(&tail_w, radius, &appearance);
+    snl_writer_flush(&tail_w);
+
+    // render runs of visible rectangles in chunks, so that a streaming canvas stays bounded
+    for (size_t i = 0, end = n; i < n; i = end) {
+        if (cull) {
+            for (; i < n && !snl_canvas_rectangle_visible(canvas, xs[i] + tx, ys[i] + ty, widths[i], heights[i], margin); i++) canvas->culled++;
+            for (end = i; end < n && snl_canvas_rectangle_visible(canvas, xs[end] + tx, ys[end] + ty, widths[end], heights[end], margin); end++);
+        }
+        for (size_t j = i; j < end; j += SNL_EMIT_BATCH_SIZE) {
+            const size_t count = end - j < SNL_EMIT_BATCH_SIZE ? end - j : SNL_EMIT_BATCH_SIZE;
+            size_t *const starts = snl_canvas_push_elements(canvas, count);
+            snl_emit_rectangles(&w, xs + j, ys + j, widths + j, heights + j, count, SNL_POINT(tx, ty), tail, starts);
+            snl_canvas_commit(canvas, &w);
+        }
+    }
+
+    vt_str_destroy(tail);
 }
 
-void snl_canvas_translate(snl_canvas_t *const canvas, const float x, const float y) {
+void snl_canvas_render_lines(
+    snl_canvas_t *const canvas, 
+    const float *const x1s, const float *const y1s, const float *const x2s, const float *const y2s, const size_t n, 
+    const snl_appearance_t appearance
+) {
     // check for invalid input
     VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(n == 0 || (x1s != NULL && y1s != NULL && x2s != NULL && y2s != NULL), "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
 
-    canvas->translateX = x;
-    canvas->translateY = y;
+    const bool cull = snl_canvas_culls(canvas, &appearance);
+    const float margin = fabsf(appearance.stroke_width);
+    const float tx = canvas->translateX, ty = canvas->translateY;
+
+    // record
+    if (canvas->list) {
+        size_t first = SIZE_MAX;
+        for (size_t i = 0; i < n; i++) {
+            if (cull && !snl_canvas_line_visible(canvas, x1s[i] + tx, y1s[i] + ty, x2s[i] + tx, y2s[i] + ty, margin)) {
+                canvas->culled++;
+                continue;
+            }
+            const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_LINE, first == SIZE_MAX ? &appearance : NULL);
+            if (first == SIZE_MAX) first = index;
+            snl_display_list_push_point(canvas->list, SNL_POINT(x1s[i] + tx, y1s[i] + ty));
+            snl_display_list_push_point(canvas->list, SNL_POINT(x2s[i] + tx, y2s[i] + ty));
+            canvas->list->appearance[index] = canvas->list->appearance[first];
+        }
+        return;
+    }
+
+    // format the shared attributes once
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, NULL);
+    vt_str_t *const tail = vt_str_create_capacity(256, NULL);
+    snl_writer_t tail_w;
+    snl_canvas_writer_init(canvas, &tail_w, tail);
+    tail_w.style_class = w.style_class;
+    snl_emit_tail_line(&tail_w, &appearance);
+    snl_writer_flush(&tail_w);
+
+    // render runs of visible lines in chunks, so that a streaming canvas stays bounded
+    for (size_t i = 0, end = n; i < n; i = end) {
+        if (cull) {
+            for (; i < n && !snl_canvas_line_visible(canvas, x1s[i] + tx, y1s[i] + ty, x2s[i] + tx, y2s[i] + ty, margin); i++) canvas->culled++;
+            for (end = i; end < n && snl_canvas_line_visible(canvas, x1s[end] + tx, y1s[end] + ty, x2s[end] + tx, y2s[end] + ty, margin); end++);
+        }
+        for (size_t j = i; j < end; j += SNL_EMIT_BATCH_SIZE) {
+            const size_t count = end - j < SNL_EMIT_BATCH_SIZE ? end - j : SNL_EMIT_BATCH_SIZE;
+            size_t *const starts = snl_canvas_push_elements(canvas, count);
+            snl_emit_lines(&w, x1s + j, y1s + j, x2s + j, y2s + j, count, SNL_POINT(tx, ty), tail, starts);
+            snl_canvas_commit(canvas, &w);
+        }
+    }
+
+    vt_str_destroy(tail);
 }
 
-void snl_canvas_reset_translation(snl_canvas_t *const canvas) {
+void snl_canvas_render_texts(
+    snl_canvas_t *const canvas, 
+    const float *const xs, const float *const ys, const char *const *const texts, const size_t n, 
+    const snl_appearance_t appearance, const snl_text_style_t text_style
+) {
     // check for invalid input
     VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(n == 0 || (xs != NULL && ys != NULL && texts != NULL), "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
     VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
 
+    const bool cull = snl_canvas_culls(canvas, &appearance);
+    const float margin = fabsf(appearance.stroke_width);
+    const float tx = canvas->translateX, ty = canvas->translateY;
+
+    // record
+    if (canvas->list) {
+        const uint32_t style = n ? snl_display_list_add_text_style(canvas->list, &text_style) : 0;
+        size_t first = SIZE_MAX;
+        for (size_t i = 0; i < n; i++) {
+            if (cull && !snl_canvas_text_visible(canvas, SNL_POINT(xs[i] + tx, ys[i] + ty), texts[i], &text_style, margin)) {
+                canvas->culled++;
+                continue;
+            }
+            const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_TEXT, first == SIZE_MAX ? &appearance : NULL);
+            if (first == SIZE_MAX) first = index;
+            snl_display_list_push_point(canvas->list, SNL_POINT(xs[i] + tx, ys[i] + ty));
+            canvas->list->appearance[index] = canvas->list->appearance[first];
+            canvas->list->style[index] = style;
+            canvas->list->aux[index] = snl_display_list_add_string(canvas->list, texts[i]);
+        }
+        return;
+    }
+
+    // format the shared attributes once
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_class(&w, &appearance, NULL, &text_style);
+    vt_str_t *const tail = vt_str_create_capacity(256, NULL);
+    snl_writer_t tail_w;
+    snl_canvas_writer_init(canvas, &tail_w, tail);
+    tail_w.style_class = w.style_class;
+    snl_emit_tail_text(&tail_w, &appearance, &text_style);
+    snl_writer_flush(&tail_w);
+
+    // render runs of visible texts in chunks, so that a streaming canvas stays bounded
+    for (size_t i = 0, end = n; i < n; i = end) {
+        if (cull) {
+            for (; i < n && !snl_canvas_text_visible(canvas, SNL_POINT(xs[i] + tx, ys[i] + ty), texts[i], &text_style, margin); i++) canvas->culled++;
+            for (end = i; end < n && snl_canvas_text_visible(canvas, SNL_POINT(xs[end] + tx, ys[end] + ty), texts[end], &text_style, margin); end++);
+        }
+        for (size_t j = i; j < end; j += SNL_EMIT_BATCH_SIZE) {
+            const size_t count = end - j < SNL_EMIT_BATCH_SIZE ? end - j : SNL_EMIT_BATCH_SIZE;
+            size_t *const starts = snl_canvas_push_elements(canvas, count);
+            snl_emit_texts(&w, xs + j, ys + j, texts + j, count, SNL_POINT(tx, ty), tail, starts);
+            snl_canvas_commit(canvas, &w);
+        }
+    }
+
+    vt_str_destroy(tail);
+}
+
+void snl_canvas_symbol_begin(snl_canvas_t *const canvas, const char *const id) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(canvas->symbol == NULL, "Error: did you forget to call 'snl_canvas_symbol_end()'?\n");
+
+    // set the canvas state aside
+    snl_symbol_t *const symbol = malloc(sizeof(snl_symbol_t));
+    VT_ENFORCE(symbol != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    symbol->id = vt_str_create_capacity(strlen(id) + 1, NULL);
+    vt_str_append(symbol->id, id);
+    memcpy(&symbol->outer, canvas, sizeof(snl_canvas_t));
+
+    // render calls write straight into the symbol with their own undo stack
+    canvas->symbol = symbol;
+    canvas->surface = vt_str_create_capacity(VT_STR_TMP_BUFFER_SIZE, NULL);
+    canvas->elements = NULL;
+    canvas->nelements = canvas->elements_capacity = 0;
+    canvas->sink = (snl_sink_t) {0};
+    canvas->list = NULL;
+    canvas->index = NULL;
+    canvas->sheet = NULL;
     canvas->translateX = canvas->translateY = 0;
+    canvas->groups = NULL;
+    canvas->ngroups = canvas->groups_capacity = 0;
 }
 
-void snl_canvas_fill(snl_canvas_t *const canvas, struct SnailColor color) {
+void snl_canvas_symbol_end(snl_canvas_t *const canvas) {
     // check for invalid input
     VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
-    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()'?\n");
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(canvas->symbol != NULL, "Error: did you forget to call 'snl_canvas_symbol_begin()'?\n");
+    VT_ENFORCE(canvas->ngroups == 0, "Error: did you forget to call 'snl_canvas_pop_group()'?\n");
+
+    // back to the canvas, keeping what was recorded
+    snl_symbol_t *const symbol = snl_canvas_restore(canvas);
+    vt_str_t *const content = symbol->outer.surface;
+
+    // define the symbol
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->defs->scratch);
+    snl_emit_symbol(&w, vt_str_z(symbol->id), vt_str_z(content), vt_str_len(content));
+    snl_canvas_define(canvas, &w, vt_str_z(symbol->id), NULL);
+
+    vt_str_destroy(content);
+    vt_str_destroy(symbol->id);
+    free(symbol);
+}
+
+void snl_canvas_render_instance(snl_canvas_t *const canvas, const char *const id, snl_point_t pos, const float scale, const float rotation) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+
+    // adjust for translation
+    pos = SNL_POINT_ADJUST(pos, canvas->translateX, canvas->translateY);
+
+    // record
+    if (canvas->list) {
+        const snl_appearance_t appearance = SNL_APPEARANCE_DEFAULT;
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_INSTANCE, &appearance);
+        snl_display_list_push_point(canvas->list, pos);
+        canvas->list->aux[index] = snl_display_list_add_string(canvas->list, id);
+        canvas->list->size_x[index] = scale;
+        canvas->list->radius[index] = rotation;
+        return;
+    }
 
     // render
-    snl_canvas_render_rectangle(canvas, SNL_POINT(0, 0), SNL_POINT(canvas->width, canvas->height), 0, SNL_APPEARANCE(0, 1, SNL_COLOR_NONE, 1, color, NULL, NULL));
+    snl_canvas_push_element(canvas);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, canvas->surface);
+    snl_emit_use(&w, id, pos, scale, rotation);
+    snl_canvas_commit(canvas, &w);
 }
 
-void snl_canvas_save(const snl_canvas_t *const canvas, const char *const filename) {
+void snl_canvas_push_group(snl_canvas_t *const canvas, const snl_transform_t transform, const snl_appearance_t *const appearance) {
     // check for invalid input
     VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
     VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
-    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
-    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()'?\n");
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
 
-    // finalize the canvas
-    vt_str_append(canvas->surface, "</svg>");
+    // record
+    size_t start = 0;
+    if (canvas->list) {
+        const snl_appearance_t none = SNL_APPEARANCE_DEFAULT;
+        start = snl_display_list_push(canvas->list, SNL_RECORD_GROUP, appearance ? appearance : &none);
+        snl_display_list_push_point(canvas->list, SNL_POINT(transform.e, transform.f));
+        snl_display_list_push_point(canvas->list, SNL_POINT(transform.a, transform.b));
+        snl_display_list_push_point(canvas->list, SNL_POINT(transform.c, transform.d));
+        if (appearance) canvas->list->flags[start] |= SNL_RECORD_FLAG_STYLED;
+        canvas->list->style[start] = SNL_RECORD_NONE;
+    } else {
+        // render
+        snl_canvas_push_element(canvas);
+        snl_writer_t w;
+        snl_canvas_writer_init(canvas, &w, canvas->surface);
+        snl_emit_group_open(&w, &transform, appearance);
+        snl_canvas_commit(canvas, &w);
+        start = canvas->nelements ? canvas->nelements - 1 : 0;
+    }
 
-    // save
-    vt_file_write(filename, vt_str_z(canvas->surface));
-}
+    // grow
+    if (canvas->ngroups == canvas->groups_capacity) {
+        const size_t capacity = canvas->groups_capacity ? canvas->groups_capacity * 2 : 8;
+        snl_group_t *const groups = realloc(canvas->groups, capacity * sizeof(snl_group_t));
+        VT_ENFORCE(groups != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        canvas->groups = groups;
+        canvas->groups_capacity = capacity;
+    }
 
-// ------------------------------- PRIVATE ------------------------------- //
+    // the elements of the group inherit its style, or the one the group inherits
+    snl_group_t *const group = &canvas->groups[canvas->ngroups++];
+    group->appearance = appearance ? *appearance : (snl_appearance_t) {0};
+    group->appearance.filter = appearance ? snl_copy_string(appearance->filter) : NULL;
+    group->appearance.gradient = appearance ? snl_copy_string(appearance->gradient) : NULL;
+    group->inherit = appearance ? canvas->ngroups : canvas->ngroups > 1 ? group[-1].inherit : 0;
+    group->start = start;
+    group->transform = canvas->ngroups > 1 ? snl_transform_multiply(group[-1].transform, transform) : transform;
+    group->filtered = (canvas->ngroups > 1 && group[-1].filtered)
+        || (appearance && appearance->filter && strcmp(appearance->filter, SNL_FILTER_DEFAULT) != 0);
+}
+
+void snl_canvas_pop_group(snl_canvas_t *const canvas) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(canvas->ngroups > 0, "Error: did you forget to call 'snl_canvas_push_group()'?\n");
+
+    const snl_group_t *const group = &canvas->groups[canvas->ngroups - 1];
+    if (canvas->list) {
+        // record, with the style inherited again after the group
+        const size_t inherit = canvas->ngroups > 1 ? group[-1].inherit : 0;
+        const snl_appearance_t none = SNL_APPEARANCE_DEFAULT;
+        const size_t index = snl_display_list_push(canvas->list, SNL_RECORD_GROUP_END, inherit ? &canvas->groups[inherit - 1].appearance : &none);
+        if (inherit) canvas->list->flags[index] |= SNL_RECORD_FLAG_STYLED;
+        canvas->list->style[index] = (uint32_t)group->start;
+        canvas->list->style[group->start] = (uint32_t)index;
+    } else {
+        // render
+        snl_writer_t w;
+        snl_canvas_writer_init(canvas, &w, canvas->surface);
+        snl_emit_group_close(&w);
+        snl_canvas_commit(canvas, &w);
+
+        // from now on the group is undone as a whole
+        if (canvas->sink.write == NULL) canvas->nelements = group->start + 1;
+    }
+
+    snl_canvas_drop_groups(canvas, canvas->ngroups - 1);
+}
+
+void snl_canvas_undo(snl_canvas_t *const canvas) {
+    snl_canvas_undo_n(canvas, 1);
+}
+
+void snl_canvas_undo_n(snl_canvas_t *const canvas, const size_t n) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(canvas->list || canvas->sink.write == NULL, "Error: undo is not available on a streaming canvas!\n");
+
+    // undo the last n operations
+    const size_t count = snl_canvas_element_count(canvas);
+    snl_canvas_truncate(canvas, n < count ? count - n : 0);
+}
+
+size_t snl_canvas_mark(const snl_canvas_t *const canvas) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(canvas->list || canvas->sink.write == NULL, "Error: savepoints are not available on a streaming canvas!\n");
+
+    return snl_canvas_element_count(canvas);
+}
+
+void snl_canvas_rollback(snl_canvas_t *const canvas, const size_t mark) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(canvas->list || canvas->sink.write == NULL, "Error: rollback is not available on a streaming canvas!\n");
+    VT_ENFORCE(mark <= snl_canvas_element_count(canvas), "Error: invalid savepoint!\n");
+
+    // undo all operations after the mark
+    snl_canvas_truncate(canvas, mark);
+}
+
+void snl_canvas_clear(snl_canvas_t *const canvas) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(canvas->list || canvas->sink.write == NULL, "Error: clear is not available on a streaming canvas!\n");
+
+    // undo all canvas operations
+    snl_canvas_truncate(canvas, 0);
+}
+
+void snl_canvas_translate(snl_canvas_t *const canvas, const float x, const float y) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+
+    canvas->translateX = x;
+    canvas->translateY = y;
+}
+
+void snl_canvas_reset_translation(snl_canvas_t *const canvas) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+
+    canvas->translateX = canvas->translateY = 0;
+}
+
+void snl_canvas_fill(snl_canvas_t *const canvas, struct SnailColor color) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()'?\n");
+
+    // render
+    snl_canvas_render_rectangle(canvas, SNL_POINT(0, 0), SNL_POINT(canvas->width, canvas->height), 0, SNL_APPEARANCE(0, 1, SNL_COLOR_NONE, 1, color, NULL, NULL));
+}
+
+void snl_canvas_save(snl_canvas_t *const canvas, const char *const filename) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()'?\n");
+    VT_ENFORCE(canvas->symbol == NULL, "Error: did you forget to call 'snl_canvas_symbol_end()'?\n");
+    VT_ENFORCE(canvas->ngroups == 0, "Error: did you forget to call 'snl_canvas_pop_group()'?\n");
+    VT_ENFORCE(canvas->sink.write == NULL, "Error: use 'snl_canvas_finish()' with a streaming canvas!\n");
+    VT_ENFORCE(canvas->base == NULL || canvas->base->data != NULL, "Error: use 'snl_canvas_sync()' with an appending canvas!\n");
+
+    // the classes used by the records are written before them, so a first pass defines them
+    const size_t classes = canvas->sheet ? canvas->sheet->count : 0;
+    if (canvas->list) {
+        if (canvas->flags & SNL_CANVAS_OCCLUDE) snl_occlude(canvas->list, canvas->width, canvas->height, canvas->precision, canvas->grid);
+        if (canvas->sheet) snl_canvas_write_records(canvas, NULL);
+    }
+
+    // save: the header, definitions and classes, the body, then the records
+    FILE *const fp = canvas->base ? snl_load_save_begin(canvas->base, filename) : fopen(filename, "wb");
+    VT_ENFORCE(fp != NULL, "Error: failed to open '%s'!\n", filename);
+    const size_t body_len = vt_str_len(canvas->surface) - canvas->defs_at;
+    const bool written =
+        snl_canvas_write_head(canvas, fp) &&
+        fwrite(vt_str_z(canvas->surface) + canvas->defs_at, 1, body_len, fp) == body_len &&
+        (canvas->list == NULL || snl_canvas_write_records(canvas, fp)) &&
+        fputs("</svg>", fp) >= 0;
+    VT_ENFORCE(written, "Error: failed to write '%s'!\n", filename);
+    if (canvas->base) snl_load_save_end(fp, filename);
+    else VT_ENFORCE(fclose(fp) == 0, "Error: failed to write '%s'!\n", filename);
+
+    // forget the classes of the records, so that rendering can continue
+    if (canvas->sheet) snl_style_sheet_drop(canvas->sheet, classes);
+}
+
+void snl_canvas_flush(snl_canvas_t *const canvas) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(canvas->sink.write != NULL, "Error: canvas has no sink to flush to!\n");
+
+    // write out
+    const size_t len = vt_str_len(canvas->surface);
+    if (len == 0) return;
+    const char *const surface = vt_str_z(canvas->surface);
+    const size_t head = canvas->flushed == 0 ? canvas->defs_at : 0;
+    bool written = head == 0 || canvas->sink.write(canvas->sink.user, surface, head) == head;
+
+    // the first flush puts the definitions between the header and the body; later ones are written in place
+    const size_t defs_len = vt_str_len(canvas->definitions);
+    if (canvas->flushed == 0 && defs_len > 0) {
+        written = written &&
+            canvas->sink.write(canvas->sink.user, "<defs>\n", 7) == 7 &&
+            canvas->sink.write(canvas->sink.user, vt_str_z(canvas->definitions), defs_len) == defs_len &&
+            canvas->sink.write(canvas->sink.user, "</defs>\n", 8) == 8;
+        vt_str_clear(canvas->definitions);
+    }
+    written = written && (len == head || canvas->sink.write(canvas->sink.user, surface + head, len - head) == len - head);
+    VT_ENFORCE(written, "Error: failed to write to the canvas sink!\n");
+
+    // reuse the buffer
+    canvas->flushed += len;
+    vt_str_clear(canvas->surface);
+}
+
+void snl_canvas_finish(snl_canvas_t *const canvas) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()'?\n");
+    VT_ENFORCE(canvas->symbol == NULL, "Error: did you forget to call 'snl_canvas_symbol_end()'?\n");
+    VT_ENFORCE(canvas->ngroups == 0, "Error: did you forget to call 'snl_canvas_pop_group()'?\n");
+    VT_ENFORCE(canvas->sink.write != NULL, "Error: use 'snl_canvas_save()' with a non-streaming canvas!\n");
+
+    // serialize records
+    if (canvas->list) {
+        if (canvas->flags & SNL_CANVAS_OCCLUDE) snl_occlude(canvas->list, canvas->width, canvas->height, canvas->precision, canvas->grid);
+
+        snl_writer_t w;
+        snl_canvas_writer_init(canvas, &w, canvas->surface);
+        for (size_t i = 0; i < canvas->list->len; i++) {
+            if (canvas->list->flags[i] & (SNL_RECORD_FLAG_DEAD | SNL_RECORD_FLAG_HIDDEN)) continue;
+            snl_display_list_serialize(canvas->list, i, &w);
+            snl_canvas_commit(canvas, &w);
+        }
+        snl_display_list_clear(canvas->list);
+    }
+
+    // finalize the canvas
+    vt_str_append(canvas->surface, "</svg>");
+    snl_canvas_flush(canvas);
+}
+
+void snl_canvas_sync(snl_canvas_t *const canvas) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget to call 'snl_render_xxx_end()'?\n");
+    VT_ENFORCE(canvas->symbol == NULL, "Error: did you forget to call 'snl_canvas_symbol_end()'?\n");
+    VT_ENFORCE(canvas->ngroups == 0, "Error: did you forget to call 'snl_canvas_pop_group()'?\n");
+    VT_ENFORCE(canvas->base != NULL && canvas->base->data == NULL, "Error: canvas was not created with 'snl_canvas_append()'!\n");
+
+    // replace the closing tag with the new definitions and elements
+    vt_str_append(canvas->surface, "</svg>");
+    if (vt_str_len(canvas->definitions) > 0) {
+        vt_str_t *const tail = vt_str_create_capacity(vt_str_len(canvas->definitions) + vt_str_len(canvas->surface) + 16, NULL);
+        vt_str_append(tail, "<defs>\n");
+        vt_str_append_n(tail, vt_str_z(canvas->definitions), vt_str_len(canvas->definitions));
+        vt_str_append(tail, "</defs>\n");
+        vt_str_append_n(tail, vt_str_z(canvas->surface), vt_str_len(canvas->surface));
+        snl_load_append(canvas->base, tail);
+        vt_str_destroy(tail);
+    } else {
+        snl_load_append(canvas->base, canvas->surface);
+    }
+
+    // start over; the next definition opens a new <defs> element
+    vt_str_clear(canvas->surface);
+    vt_str_clear(canvas->definitions);
+    canvas->nelements = 0;
+}
+
+size_t snl_canvas_element_count(const snl_canvas_t *const canvas) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    return canvas->list ? canvas->list->len : canvas->nelements;
+}
+
+void snl_canvas_swap_elements(snl_canvas_t *const canvas, const size_t a, const size_t b) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_ENFORCE(canvas->list != NULL, "Error: canvas was not created with SNL_CANVAS_RETAINED!\n");
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(a < canvas->list->len && b < canvas->list->len, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_ENFORCE(
+        canvas->list->kind[a] != SNL_RECORD_GROUP && canvas->list->kind[a] != SNL_RECORD_GROUP_END &&
+        canvas->list->kind[b] != SNL_RECORD_GROUP && canvas->list->kind[b] != SNL_RECORD_GROUP_END,
+        "Error: groups cannot be swapped!\n"
+    );
+
+    snl_display_list_swap(canvas->list, a, b);
+}
+
+void snl_canvas_remove_element(snl_canvas_t *const canvas, const size_t index) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_ENFORCE(canvas->list != NULL, "Error: canvas was not created with SNL_CANVAS_RETAINED!\n");
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(index < canvas->list->len, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // a group goes with its elements
+    snl_display_list_t *const list = canvas->list;
+    size_t first = index, last = index;
+    if (list->kind[index] == SNL_RECORD_GROUP_END) first = list->style[index];
+    if (list->kind[first] == SNL_RECORD_GROUP) {
+        VT_ENFORCE(list->style[first] != SNL_RECORD_NONE, "Error: open groups cannot be removed!\n");
+        last = list->style[first];
+    }
+
+    for (size_t i = first; i <= last; i++) {
+        list->flags[i] |= SNL_RECORD_FLAG_DEAD;
+    }
+    list->version++;
+}
+
+void snl_canvas_move_elements(snl_canvas_t *const canvas, const size_t from, const size_t to, const float x, const float y) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_ENFORCE(canvas->list != NULL, "Error: canvas was not created with SNL_CANVAS_RETAINED!\n");
+    VT_ENFORCE(snl_can_continue(canvas), "Error: did you forget call 'snl_render_xxx_end()' after 'snl_render_xxx_begin()'?\n");
+    VT_ENFORCE(from <= to && to <= canvas->list->len, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // transforms to the canvas of the groups around the first element, outermost first
+    snl_display_list_t *const list = canvas->list;
+    size_t depth = 0, capacity = 0;
+    snl_transform_t *stack = NULL;
+    for (size_t i = from; i-- > 0;) {
+        if (list->kind[i] == SNL_RECORD_GROUP_END) i = list->style[i];
+        else if (list->kind[i] == SNL_RECORD_GROUP) stack = snl_canvas_push_transform(stack, &depth, &capacity, snl_display_list_get_transform(list, i));
+    }
+    for (size_t i = 0; i < depth / 2; i++) {
+        const snl_transform_t swap = stack[i];
+        stack[i] = stack[depth - 1 - i];
+        stack[depth - 1 - i] = swap;
+    }
+    for (size_t i = 1; i < depth; i++) stack[i] = snl_transform_multiply(stack[i - 1], stack[i]);
+
+    // shift all points along the canvas axes, mapped into the coordinates of their group; sizes and radii are relative
+    snl_point_t offset = snl_canvas_local_offset(depth ? &stack[depth - 1] : NULL, x, y);
+    for (size_t i = from; i < to; i++) {
+        switch (list->kind[i]) {
+            case SNL_RECORD_GROUP:
+                // a closed group moves by its translation, its elements stay in its own coordinates
+                if (list->style[i] != SNL_RECORD_NONE && list->style[i] < to) {
+                    list->xs[list->first[i]] += offset.x;
+                    list->ys[list->first[i]] += offset.y;
+                    i = list->style[i];
+                } else {
+                    const snl_transform_t outer = depth ? stack[depth - 1] : SNL_TRANSFORM_IDENTITY;
+                    stack = snl_canvas_push_transform(stack, &depth, &capacity, snl_transform_multiply(outer, snl_display_list_get_transform(list, i)));
+                    offset = snl_canvas_local_offset(&stack[depth - 1], x, y);
+                }
+                break;
+            case SNL_RECORD_GROUP_END:
+                if (depth > 0) depth--;
+                offset = snl_canvas_local_offset(depth ? &stack[depth - 1] : NULL, x, y);
+                break;
+            default: {
+                const size_t end = list->first[i] + list->count[i];
+                for (size_t j = list->first[i]; j < end; j++) {
+                    list->xs[j] += offset.x;
+                    list->ys[j] += offset.y;
+                }
+            }
+        }
+    }
+    free(stack);
+    list->version++;
+}
+
+size_t snl_canvas_query_point(snl_canvas_t *const canvas, const snl_point_t point, size_t *const indices, const size_t max) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(indices != NULL || max == 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    const float box[4] = { point.x, point.y, point.x, point.y };
+    return snl_canvas_query(canvas, box, indices, max);
+}
+
+size_t snl_canvas_query_rect(snl_canvas_t *const canvas, const snl_point_t pos, const snl_point_t size, size_t *const indices, const size_t max) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(indices != NULL || max == 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // negative sizes extend to the left and up
+    const float box[4] = {
+        fminf(pos.x, pos.x + size.x), fminf(pos.y, pos.y + size.y),
+        fmaxf(pos.x, pos.x + size.x), fmaxf(pos.y, pos.y + size.y)
+    };
+    return snl_canvas_query(canvas, box, indices, max);
+}
+
+snl_transform_t snl_transform_multiply(const snl_transform_t m, const snl_transform_t n) {
+    return SNL_TRANSFORM(
+        m.a * n.a + m.c * n.b, m.b * n.a + m.d * n.b,
+        m.a * n.c + m.c * n.d, m.b * n.c + m.d * n.d,
+        m.a * n.e + m.c * n.f + m.e, m.b * n.e + m.d * n.f + m.f
+    );
+}
+
+snl_transform_t snl_transform_rotate(const float degrees) {
+    const float angle = degrees * (float)M_PI / 180;
+    const float c = cosf(angle), s = sinf(angle);
+
+    return SNL_TRANSFORM(c, s, -s, c, 0, 0);
+}
+
+snl_point_t snl_transform_apply(const snl_transform_t m, const snl_point_t point) {
+    return SNL_POINT(m.a * point.x + m.c * point.y + m.e, m.b * point.x + m.d * point.y + m.f);
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
 
 /**
  * @brief This check is meant for situations where the user fogot to call <snl_canvas_render_xxx_end()> after <snl_canvas_render_xxx_begin()>
@@ -959,25 +1782,557 @@ void snl_canvas_save(const snl_canvas_t *const canvas, const char *const filenam
  * @return bool 
  */
 static bool snl_can_continue(const snl_canvas_t *const canvas) {
-    const char *const surface = vt_str_z(canvas->surface);
-    const size_t len = vt_str_len(canvas->surface);
+    return !canvas->drawing;
+}
+
+/**
+ * @brief Initialize a writer with the canvas output profile
+ * @param canvas canvas instance
+ * @param w writer instance
+ * @param target string to append to
+ * @return None
+ */
+static void snl_canvas_writer_init(const snl_canvas_t *const canvas, snl_writer_t *const w, vt_str_t *const target) {
+    snl_writer_init(w, target);
+    w->compact = (canvas->flags & SNL_CANVAS_COMPACT) != 0;
+    w->trim = (canvas->flags & (SNL_CANVAS_COMPACT | SNL_CANVAS_TRIM)) != 0;
+    w->precision = canvas->precision;
+    w->grid = canvas->grid;
+    w->sheet = canvas->sheet;
+    w->class_block = canvas->sink.write == NULL;
+    w->defs = canvas->defs;
+    w->inherited = snl_canvas_inherited(canvas);
+}
 
-    return surface[len - 1] == '\n';
+/**
+ * @brief Append writer data to the canvas and flush to the sink once the high-water mark is reached
+ * @param canvas canvas instance
+ * @param w writer instance
+ * @return None 
+ */
+static void snl_canvas_commit(snl_canvas_t *const canvas, snl_writer_t *const w) {
+    snl_writer_flush(w);
+    if (canvas->sink.write && vt_str_len(canvas->surface) >= canvas->high_water) {
+        snl_canvas_flush(canvas);
+    }
 }
 
 /**
- * @brief Compare colors for equality
- * @param a struct SnailColor
- * @param b struct SnailColor
- * @return bool 
+ * @brief Add the definition written to the scratch buffer to the <defs> element after the header, unless
+ *        the same id or content is already defined
+ * @param canvas canvas instance
+ * @param w writer instance targeting the definition scratch buffer
+ * @param id definition id
+ * @param gradient gradient parameters or NULL for filters
+ * @return None 
  */
-static bool snl_color_cmp(const struct SnailColor a, const struct SnailColor b) {
-    return (
-        a.r == b.r && 
-        a.g == b.g && 
-        a.b == b.b && 
-        a.a == b.a
-    );
+static void snl_canvas_define(snl_canvas_t *const canvas, snl_writer_t *const w, const char *const id, const snl_gradient_t *const gradient) {
+    VT_ENFORCE(canvas->symbol == NULL, "Error: definitions cannot be added while recording a symbol!\n");
+    snl_writer_flush(w);
+    vt_str_t *const def = canvas->defs->scratch;
+    const bool added = snl_defs_add(canvas->defs, id, vt_str_z(def), vt_str_len(def), gradient);
+    if (!added) {
+        vt_str_clear(def);
+        return;
+    }
+
+    // the header has been streamed out already: define it in place
+    if (canvas->flushed > 0) {
+        snl_writer_t out;
+        snl_canvas_writer_init(canvas, &out, canvas->surface);
+        snl_writer_put_str(&out, "<defs>");
+        snl_writer_put_str_n(&out, vt_str_z(def), vt_str_len(def) - 1);
+        snl_writer_put_str(&out, "</defs>\n");
+        snl_canvas_commit(canvas, &out);
+        vt_str_clear(def);
+        return;
+    }
+
+    // otherwise it joins the <defs> element written between the header and the body
+    vt_str_append_n(canvas->definitions, vt_str_z(def), vt_str_len(def));
+    vt_str_clear(def);
+}
+
+/**
+ * @brief Write the header, the <defs> element and the <style> element with all classes, for saving
+ * @param canvas canvas instance
+ * @param fp file
+ * @return false if writing failed
+ */
+static bool snl_canvas_write_head(const snl_canvas_t *const canvas, FILE *const fp) {
+    const size_t defs_len = vt_str_len(canvas->definitions);
+    bool written = fwrite(vt_str_z(canvas->surface), 1, canvas->defs_at, fp) == canvas->defs_at;
+    if (defs_len > 0) {
+        written = written &&
+            fputs("<defs>\n", fp) >= 0 &&
+            fwrite(vt_str_z(canvas->definitions), 1, defs_len, fp) == defs_len &&
+            fputs("</defs>\n", fp) >= 0;
+    }
+    if (canvas->sheet == NULL || canvas->sheet->count == 0) return written;
+
+    // the classes of a non-streaming canvas
+    vt_str_t *const classes = vt_str_create_capacity(VT_STR_TMP_BUFFER_SIZE, NULL);
+    snl_writer_t w;
+    snl_writer_init(&w, classes);
+    snl_emit_style_sheet(&w, canvas->sheet);
+    snl_writer_flush(&w);
+    written = written && fwrite(vt_str_z(classes), 1, vt_str_len(classes), fp) == vt_str_len(classes);
+    vt_str_destroy(classes);
+
+    return written;
+}
+
+/**
+ * @brief Write the records in chunks of about high_water bytes, for saving
+ * @param canvas canvas instance
+ * @param fp file, or NULL to only define the classes of the records
+ * @return false if writing failed
+ */
+static bool snl_canvas_write_records(snl_canvas_t *const canvas, FILE *const fp) {
+    const snl_display_list_t *const list = canvas->list;
+    vt_str_t *const chunk = vt_str_create_capacity(canvas->high_water + SNL_WRITER_BUFFER_SIZE, NULL);
+    snl_writer_t w;
+    snl_canvas_writer_init(canvas, &w, chunk);
+
+    bool written = true;
+    for (size_t i = 0; i < list->len; i++) {
+        if (list->flags[i] & (SNL_RECORD_FLAG_DEAD | SNL_RECORD_FLAG_HIDDEN)) continue;
+        snl_display_list_serialize(list, i, &w);
+        if (vt_str_len(chunk) + w.len < canvas->high_water) continue;
+
+        // write the chunk out and reuse it
+        snl_writer_flush(&w);
+        if (fp) written = written && fwrite(vt_str_z(chunk), 1, vt_str_len(chunk), fp) == vt_str_len(chunk);
+        vt_str_clear(chunk);
+    }
+    snl_writer_flush(&w);
+    if (fp) written = written && fwrite(vt_str_z(chunk), 1, vt_str_len(chunk), fp) == vt_str_len(chunk);
+    vt_str_destroy(chunk);
+
+    return written;
+}
+
+/**
+ * @brief Remember where the next element starts, so that it can be undone in O(1)
+ * @param canvas canvas instance
+ * @return None 
+ */
+static void snl_canvas_push_element(snl_canvas_t *const canvas) {
+    size_t *const start = snl_canvas_push_elements(canvas, 1);
+    if (start) *start = vt_str_len(canvas->surface);
+}
+
+/**
+ * @brief Reserve undo stack entries for the next n elements
+ * @param canvas canvas instance
+ * @param n number of elements
+ * @return entries to fill with element start offsets or NULL if not tracked
+ */
+static size_t *snl_canvas_push_elements(snl_canvas_t *const canvas, const size_t n) {
+    // streamed data cannot be undone, records are tracked by the display list
+    if (canvas->sink.write || canvas->list) return NULL;
+
+    // grow
+    if (canvas->nelements + n > canvas->elements_capacity) {
+        size_t capacity = canvas->elements_capacity ? canvas->elements_capacity * 2 : 64;
+        while (capacity < canvas->nelements + n) capacity *= 2;
+        size_t *const elements = realloc(canvas->elements, capacity * sizeof(size_t));
+        VT_ENFORCE(elements != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        canvas->elements = elements;
+        canvas->elements_capacity = capacity;
+    }
+
+    size_t *const entries = canvas->elements + canvas->nelements;
+    canvas->nelements += n;
+
+    return entries;
+}
+
+/**
+ * @brief Remove all elements past the first nelements
+ * @param canvas canvas instance
+ * @param nelements number of elements to keep
+ * @return None 
+ */
+static void snl_canvas_truncate(snl_canvas_t *const canvas, const size_t nelements) {
+    // retained: drop records, closed groups as a whole
+    if (canvas->list) {
+        size_t keep = nelements;
+        for (size_t i = canvas->list->len; i-- > keep;) {
+            if (canvas->list->kind[i] == SNL_RECORD_GROUP_END && canvas->list->style[i] < keep) keep = canvas->list->style[i];
+        }
+        if (keep == 0) snl_display_list_clear(canvas->list);
+        while (canvas->list->len > keep) snl_display_list_pop(canvas->list);
+        snl_canvas_drop_groups(canvas, snl_canvas_groups_before(canvas, keep));
+        return;
+    }
+
+    // immediate: cut the surface at the element start
+    if (nelements >= canvas->nelements) return;
+    const size_t offset = canvas->elements[nelements];
+    vt_str_remove(canvas->surface, offset, vt_str_len(canvas->surface) - offset);
+    if (canvas->sheet) snl_style_sheet_truncate(canvas->sheet, offset);
+    canvas->nelements = nelements;
+    snl_canvas_drop_groups(canvas, snl_canvas_groups_before(canvas, nelements));
+}
+
+/**
+ * @brief Put the canvas state set aside by <snl_canvas_symbol_begin()> back
+ * @param canvas canvas instance
+ * @return symbol whose outer.surface now holds the recorded elements
+ */
+static snl_symbol_t *snl_canvas_restore(snl_canvas_t *const canvas) {
+    snl_symbol_t *const symbol = canvas->symbol;
+    vt_str_t *const content = canvas->surface;
+    free(canvas->elements);
+    snl_canvas_drop_groups(canvas, 0);
+    free(canvas->groups);
+    memcpy(canvas, &symbol->outer, sizeof(snl_canvas_t));
+    symbol->outer.surface = content;
+
+    return symbol;
+}
+
+/**
+ * @brief Style inherited by the next element
+ * @param canvas canvas instance
+ * @return appearance of the innermost styled group, or NULL
+ */
+static const snl_appearance_t *snl_canvas_inherited(const snl_canvas_t *const canvas) {
+    if (canvas->ngroups == 0) return NULL;
+    const size_t inherit = canvas->groups[canvas->ngroups - 1].inherit;
+
+    return inherit ? &canvas->groups[inherit - 1].appearance : NULL;
+}
+
+/**
+ * @brief Forget the innermost open groups, releasing their strings
+ * @param canvas canvas instance
+ * @param ngroups number of groups to keep
+ * @return None
+ */
+static void snl_canvas_drop_groups(snl_canvas_t *const canvas, const size_t ngroups) {
+    while (canvas->ngroups > ngroups) {
+        snl_group_t *const group = &canvas->groups[--canvas->ngroups];
+        free((char*)group->appearance.filter);
+        free((char*)group->appearance.gradient);
+    }
+}
+
+/**
+ * @brief Count the open groups opened before an element
+ * @param canvas canvas instance
+ * @param nelements element (record when retained) index
+ * @return number of groups
+ */
+static size_t snl_canvas_groups_before(const snl_canvas_t *const canvas, const size_t nelements) {
+    size_t n = canvas->ngroups;
+    while (n > 0 && canvas->groups[n - 1].start >= nelements) n--;
+
+    return n;
+}
+
+/**
+ * @brief Check whether the shapes of an appearance may be culled: never inside symbols or with a filter
+ * @param canvas canvas instance
+ * @param appearance appearance settings
+ * @return bool
+ */
+static bool snl_canvas_culls(const snl_canvas_t *const canvas, const snl_appearance_t *const appearance) {
+    if (!(canvas->flags & SNL_CANVAS_CULL) || canvas->symbol) return false;
+    if (appearance->filter && strcmp(appearance->filter, SNL_FILTER_DEFAULT) != 0) return false;
+
+    return canvas->ngroups == 0 || !canvas->groups[canvas->ngroups - 1].filtered;
+}
+
+/**
+ * @brief Get the transform from the innermost open group to the canvas
+ * @param canvas canvas instance
+ * @return snl_transform_t
+ */
+static snl_transform_t snl_canvas_transform(const snl_canvas_t *const canvas) {
+    return canvas->ngroups ? canvas->groups[canvas->ngroups - 1].transform : SNL_TRANSFORM_IDENTITY;
+}
+
+/**
+ * @brief Check whether a box, grown by a margin, overlaps the viewBox; boxes with NaNs count as visible
+ * @param canvas canvas instance
+ * @param local transform of the box within the innermost group or NULL
+ * @param box x0, y0, x1, y1
+ * @param margin growth of the box in its own units
+ * @return bool
+ */
+static bool snl_canvas_box_visible(const snl_canvas_t *const canvas, const snl_transform_t *const local, const float *const box, const float margin) {
+    snl_transform_t m = snl_canvas_transform(canvas);
+    if (local) m = snl_transform_multiply(m, *local);
+
+    // the corners on the canvas; the margin scales by at most the frobenius norm
+    const snl_point_t corners[4] = {
+        snl_transform_apply(m, SNL_POINT(box[0], box[1])), snl_transform_apply(m, SNL_POINT(box[2], box[1])),
+        snl_transform_apply(m, SNL_POINT(box[0], box[3])), snl_transform_apply(m, SNL_POINT(box[2], box[3]))
+    };
+    const float grow = margin * sqrtf(m.a * m.a + m.b * m.b + m.c * m.c + m.d * m.d);
+    const float x0 = fminf(fminf(corners[0].x, corners[1].x), fminf(corners[2].x, corners[3].x));
+    const float y0 = fminf(fminf(corners[0].y, corners[1].y), fminf(corners[2].y, corners[3].y));
+    const float x1 = fmaxf(fmaxf(corners[0].x, corners[1].x), fmaxf(corners[2].x, corners[3].x));
+    const float y1 = fmaxf(fmaxf(corners[0].y, corners[1].y), fmaxf(corners[2].y, corners[3].y));
+
+    return !(x1 < -grow || y1 < -grow || x0 > canvas->width + grow || y0 > canvas->height + grow);
+}
+
+/**
+ * @brief Check whether a circle is visible
+ * @param canvas canvas instance
+ * @param x center x
+ * @param y center y
+ * @param radius radius
+ * @param margin stroke width
+ * @return bool
+ */
+static bool snl_canvas_circle_visible(const snl_canvas_t *const canvas, const float x, const float y, const float radius, const float margin) {
+    const float r = fabsf(radius);
+    const float box[4] = { x - r, y - r, x + r, y + r };
+    return snl_canvas_box_visible(canvas, NULL, box, margin);
+}
+
+/**
+ * @brief Check whether a rectangle is visible
+ * @param canvas canvas instance
+ * @param x corner x
+ * @param y corner y
+ * @param width width
+ * @param height height
+ * @param margin stroke width
+ * @return bool
+ */
+static bool snl_canvas_rectangle_visible(const snl_canvas_t *const canvas, const float x, const float y, const float width, const float height, const float margin) {
+    const float box[4] = { fminf(x, x + width), fminf(y, y + height), fmaxf(x, x + width), fmaxf(y, y + height) };
+    return snl_canvas_box_visible(canvas, NULL, box, margin);
+}
+
+/**
+ * @brief Check whether a line is visible
+ * @param canvas canvas instance
+ * @param x1 start x
+ * @param y1 start y
+ * @param x2 end x
+ * @param y2 end y
+ * @param margin stroke width
+ * @return bool
+ */
+static bool snl_canvas_line_visible(const snl_canvas_t *const canvas, const float x1, const float y1, const float x2, const float y2, const float margin) {
+    const float box[4] = { fminf(x1, x2), fminf(y1, y2), fmaxf(x1, x2), fmaxf(y1, y2) };
+    return snl_canvas_box_visible(canvas, NULL, box, margin);
+}
+
+/**
+ * @brief Check whether a text is visible, measuring its box and rotating it like the <text> element
+ * @param canvas canvas instance
+ * @param pos text position
+ * @param text text value
+ * @param text_style text style settings
+ * @param margin stroke width
+ * @return bool
+ *
+ * @note the box is grown by SNL_TEXT_MARGIN font sizes, like the boxes of <snl_display_list_bounds()>
+ */
+static bool snl_canvas_text_visible(const snl_canvas_t *const canvas, const snl_point_t pos, const char *const text, const snl_text_style_t *const text_style, const float margin) {
+    const snl_text_box_t b = snl_text_measure(text, *text_style);
+    const float box[4] = { pos.x + b.x, pos.y + b.y, pos.x + b.x + b.width, pos.y + b.y + b.height };
+    const float grow = margin + SNL_TEXT_MARGIN * fabsf(text_style->font_size);
+    if (text_style->text_rotation == 0) return snl_canvas_box_visible(canvas, NULL, box, grow);
+
+    const snl_transform_t rotation = snl_transform_rotate(text_style->text_rotation);
+    return snl_canvas_box_visible(canvas, &rotation, box, grow);
+}
+
+/**
+ * @brief Drop the points between the first and the last of each run of points on the same outer side of the viewBox
+ * @param canvas canvas instance
+ * @param points points
+ * @param n number of points, > 0
+ * @param offset translation added to the points
+ * @param margin growth of the viewBox in the units of the points
+ * @param clipped points to draw: the input, or a copy to free (set on return)
+ * @return number of points to draw, 0 if all of them are on the same outer side
+ *
+ * @note the path that replaces a run stays on the outer side of the run, so the visible part of the stroke does not
+ *       change, and neither does the fill: the difference is a loop whose winding number is 0 inside the viewBox
+ */
+static size_t snl_canvas_clip_points(snl_canvas_t *const canvas, const snl_point_t *const points, const size_t n, const snl_point_t offset, const float margin, const snl_point_t **const clipped) {
+    *clipped = points;
+
+    // the viewBox, grown by the margin, in the units of the points
+    const snl_transform_t m = snl_transform_multiply(snl_canvas_transform(canvas), SNL_TRANSFORM_TRANSLATE(offset.x, offset.y));
+    const float grow = margin * sqrtf(m.a * m.a + m.b * m.b + m.c * m.c + m.d * m.d);
+    const float view[4] = { -grow, -grow, canvas->width + grow, canvas->height + grow };
+
+    // count first, most lists are kept as they are
+    uint32_t all;
+    const size_t count = snl_canvas_clip_pass(&m, view, points, n, NULL, &all);
+    if (all != 0) {
+        canvas->culled_points += n;
+        return 0;
+    }
+    if (count == n) return n;
+
+    snl_point_t *const out = malloc(count * sizeof(snl_point_t));
+    VT_ENFORCE(out != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    snl_canvas_clip_pass(&m, view, points, n, out, &all);
+    canvas->culled_points += n - count;
+    *clipped = out;
+
+    return count;
+}
+
+/**
+ * @brief Select the points kept by <snl_canvas_clip_points()>
+ * @param m transform of the points to the canvas
+ * @param view x0, y0, x1, y1 of the grown viewBox
+ * @param points points
+ * @param n number of points
+ * @param out kept points or NULL to count them only (set on return)
+ * @param all outer sides shared by all points (set on return)
+ * @return number of points kept
+ */
+static size_t snl_canvas_clip_pass(const snl_transform_t *const m, const float *const view, const snl_point_t *const points, const size_t n, snl_point_t *const out, uint32_t *const all) {
+    size_t count = 0;
+    size_t held = SIZE_MAX;     // last point of the current run, not written yet
+    uint32_t run = 0;           // outer sides shared by the points of the current run
+    *all = 0xF;
+    for (size_t i = 0; i < n; i++) {
+        // outer sides: left, right, top, bottom
+        const snl_point_t p = snl_transform_apply(*m, points[i]);
+        const uint32_t code = (uint32_t)(p.x < view[0]) | (uint32_t)(p.x > view[2]) << 1 | (uint32_t)(p.y < view[1]) << 2 | (uint32_t)(p.y > view[3]) << 3;
+        *all &= code;
+
+        // inside a run: the previous point is dropped, this one is held back
+        if (run & code) {
+            run &= code;
+            held = i;
+            continue;
+        }
+
+        // end of a run: its last point and this one are kept
+        if (held != SIZE_MAX) {
+            if (out) out[count] = points[held];
+            count++;
+            held = SIZE_MAX;
+        }
+        if (out) out[count] = points[i];
+        count++;
+        run = code;
+    }
+    if (held != SIZE_MAX) {
+        if (out) out[count] = points[held];
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Query the spatial index, bringing it up to date with the retained shapes first
+ * @param canvas canvas instance
+ * @param box x0, y0, x1, y1
+ * @param indices element indices (set on return)
+ * @param max capacity of indices
+ * @return number of elements found
+ */
+static size_t snl_canvas_query(snl_canvas_t *const canvas, const float *const box, size_t *const indices, const size_t max) {
+    VT_ENFORCE(canvas->list != NULL, "Error: canvas was not created with SNL_CANVAS_RETAINED!\n");
+
+    if (canvas->index == NULL) canvas->index = snl_index_create();
+    snl_index_build(canvas->index, canvas->list);
+
+    return snl_index_query(canvas->index, box, indices, max);
+}
+
+/**
+ * @brief Push a transform onto a growing stack
+ * @param stack stack or NULL
+ * @param depth number of transforms on the stack (updated)
+ * @param capacity stack capacity (updated)
+ * @param transform transform to push
+ * @return the stack, possibly moved
+ */
+static snl_transform_t *snl_canvas_push_transform(snl_transform_t *stack, size_t *const depth, size_t *const capacity, const snl_transform_t transform) {
+    if (*depth == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 8;
+        stack = realloc(stack, *capacity * sizeof(snl_transform_t));
+        VT_ENFORCE(stack != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    }
+    stack[(*depth)++] = transform;
+
+    return stack;
+}
+
+/**
+ * @brief Map a move along the canvas axes into the coordinates of a group
+ * @param m transform from the group to the canvas, or NULL outside groups
+ * @param x move along the horizontal axis of the canvas
+ * @param y move along the vertical axis of the canvas
+ * @return move in the coordinates of the group
+ */
+static snl_point_t snl_canvas_local_offset(const snl_transform_t *const m, const float x, const float y) {
+    if (m == NULL) return SNL_POINT(x, y);
+
+    // inverse of the linear part; translations do not apply to a difference of points
+    const float det = m->a * m->d - m->b * m->c;
+    VT_ENFORCE(det != 0 && isfinite(det), "Error: elements of a group with a singular transform cannot be moved!\n");
+
+    return SNL_POINT((m->d * x - m->c * y) / det, (m->a * y - m->b * x) / det);
+}
+
+/**
+ * @brief Copy a string
+ * @param z string or NULL
+ * @return copy to free, or NULL
+ */
+static char *snl_copy_string(const char *const z) {
+    if (z == NULL) return NULL;
+
+    const size_t size = strlen(z) + 1;
+    char *const copy = malloc(size);
+    VT_ENFORCE(copy != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    memcpy(copy, z, size);
+
+    return copy;
+}
+
+/**
+ * @brief Sink callback for FILE streams
+ * @param user FILE*
+ * @param data data to write
+ * @param size number of bytes
+ * @return number of bytes written
+ */
+static size_t snl_sink_write_file(void *user, const char *data, size_t size) {
+    return fwrite(data, 1, size, (FILE*)user);
+}
+
+/**
+ * @brief Sink callback for file descriptors
+ * @param user file descriptor
+ * @param data data to write
+ * @param size number of bytes
+ * @return number of bytes written
+ */
+static size_t snl_sink_write_fd(void *user, const char *data, size_t size) {
+    const int fd = (int)(intptr_t)user;
+
+    size_t total = 0;
+    while (total < size) {
+    #if defined(_WIN32)
+        const int n = _write(fd, data + total, (unsigned int)(size - total));
+    #else
+        const ssize_t n = write(fd, data + total, size - total);
+    #endif
+        if (n <= 0) break;
+        total += (size_t)n;
+    }
+
+    return total;
 }
 
 /**
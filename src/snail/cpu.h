@@ -0,0 +1,18 @@
+#ifndef SNAIL_CPU_H
+#define SNAIL_CPU_H
+
+/** CPU MODULE (internal)
+ *  - snl_cpu_count
+*/
+
+#include <stddef.h>
+
+/**
+ * @brief Number of online processors
+ *
+ * @return size_t, at least 1
+ */
+extern size_t snl_cpu_count(void);
+
+#endif // SNAIL_CPU_H
+
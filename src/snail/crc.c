@@ -0,0 +1,17 @@
+#include "crc.h"
+
+uint32_t snl_crc32(uint32_t crc, const uint8_t *const data, const size_t size) {
+    // half-byte table of the reflected 0x04c11db7 polynomial
+    static const uint32_t table[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+    };
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xf] ^ (crc >> 4);
+        crc = table[(crc ^ (data[i] >> 4)) & 0xf] ^ (crc >> 4);
+    }
+
+    return ~crc;
+}
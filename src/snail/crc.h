@@ -0,0 +1,22 @@
+#ifndef SNAIL_CRC_H
+#define SNAIL_CRC_H
+
+/** CRC MODULE (internal)
+ *  - snl_crc32
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Update a crc-32 checksum
+ *
+ * @param crc checksum of the preceding bytes, 0 initially
+ * @param data data
+ * @param size number of bytes
+ * @return uint32_t
+ */
+extern uint32_t snl_crc32(uint32_t crc, const uint8_t *const data, const size_t size);
+
+#endif // SNAIL_CRC_H
+
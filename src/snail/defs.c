@@ -0,0 +1,280 @@
+#include "defs.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// initial number of ids and definitions
+#define SNL_DEFS_INITIAL_CAPACITY 16
+
+// id lookup key
+typedef struct SnailDefsIdKey {
+    const char *id;
+    size_t len;
+} snl_defs_id_key_t;
+
+// content lookup key: the definition around its id
+typedef struct SnailDefsContentKey {
+    const char *head;
+    size_t head_len;
+    const char *tail;
+    size_t tail_len;
+} snl_defs_content_key_t;
+
+static uint32_t snl_defs_push_pool(snl_defs_t *const defs, const char *const data, const size_t len);
+static uint32_t snl_defs_push_id(snl_defs_t *const defs, const char *const id, const size_t len, const uint32_t hash);
+static bool snl_defs_id_eq(const void *ctx, const uint32_t index, const void *key);
+static bool snl_defs_content_eq(const void *ctx, const uint32_t index, const void *key);
+
+snl_defs_t *snl_defs_create(void) {
+    snl_defs_t *const defs = calloc(1, sizeof(snl_defs_t));
+    VT_ENFORCE(defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    // allocate
+    defs->id_capacity = defs->def_capacity = SNL_DEFS_INITIAL_CAPACITY;
+    defs->id_offsets = malloc(sizeof(uint32_t) * defs->id_capacity);
+    defs->id_lengths = malloc(sizeof(uint32_t) * defs->id_capacity);
+    defs->targets = malloc(sizeof(uint32_t) * defs->id_capacity);
+    defs->def_offsets = malloc(sizeof(uint32_t) * defs->def_capacity);
+    defs->def_lengths = malloc(sizeof(uint32_t) * defs->def_capacity);
+    defs->names = malloc(sizeof(uint32_t) * defs->def_capacity);
+    defs->gradients = malloc(sizeof(snl_gradient_t) * defs->def_capacity);
+    VT_ENFORCE(
+        defs->id_offsets != NULL && defs->id_lengths != NULL && defs->targets != NULL &&
+        defs->def_offsets != NULL && defs->def_lengths != NULL && defs->names != NULL && defs->gradients != NULL,
+        "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION)
+    );
+    snl_intern_init(&defs->ids);
+    snl_intern_init(&defs->contents);
+    defs->scratch = vt_str_create_capacity(256, NULL);
+
+    return defs;
+}
+
+void snl_defs_destroy(snl_defs_t *const defs) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    free(defs->pool);
+    free(defs->id_offsets);
+    free(defs->id_lengths);
+    free(defs->targets);
+    free(defs->def_offsets);
+    free(defs->def_lengths);
+    free(defs->names);
+    free(defs->gradients);
+    snl_intern_destroy(&defs->ids);
+    snl_intern_destroy(&defs->contents);
+    vt_str_destroy(defs->scratch);
+
+    free(defs);
+}
+
+bool snl_defs_add(snl_defs_t *const defs, const char *const id, const char *const def, const size_t len, const snl_gradient_t *const gradient) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(def != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // the first definition of an id wins
+    const size_t id_len = strlen(id);
+    const uint32_t id_hash = snl_hash_bytes(SNL_HASH_SEED, id, id_len);
+    const snl_defs_id_key_t id_key = { .id = id, .len = id_len };
+    uint32_t id_index = snl_intern_find(&defs->ids, id_hash, snl_defs_id_eq, defs, &id_key);
+    if (id_index != SNL_INTERN_NONE && defs->targets[id_index] != SNL_DEFS_NONE) return false;
+
+    // cut the id, as written with escapes, out of the definition
+    const char *const at = strstr(def, "id='");
+    const char *const quote = at ? memchr(at + 4, '\'', len - (size_t)(at + 4 - def)) : NULL;
+    VT_DEBUG_ASSERT(quote != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    const snl_defs_content_key_t key = {
+        .head = def,
+        .head_len = (size_t)(at + 4 - def),
+        .tail = quote,
+        .tail_len = len - (size_t)(quote - def)
+    };
+    const uint32_t hash = snl_hash_bytes(snl_hash_bytes(SNL_HASH_SEED, key.head, key.head_len), key.tail, key.tail_len);
+
+    // same content under another id: alias it, unless elements already point at this id
+    const uint32_t found = snl_intern_find(&defs->contents, hash, snl_defs_content_eq, defs, &key);
+    if (found != SNL_INTERN_NONE) {
+        const bool referenced = id_index != SNL_INTERN_NONE;
+        if (!referenced) id_index = snl_defs_push_id(defs, id, id_len, id_hash);
+        defs->targets[id_index] = found;
+        return referenced;
+    }
+    if (id_index == SNL_INTERN_NONE) id_index = snl_defs_push_id(defs, id, id_len, id_hash);
+
+    // grow
+    if (defs->def_count == defs->def_capacity) {
+        defs->def_capacity *= 2;
+        defs->def_offsets = realloc(defs->def_offsets, sizeof(uint32_t) * defs->def_capacity);
+        defs->def_lengths = realloc(defs->def_lengths, sizeof(uint32_t) * defs->def_capacity);
+        defs->names = realloc(defs->names, sizeof(uint32_t) * defs->def_capacity);
+        defs->gradients = realloc(defs->gradients, sizeof(snl_gradient_t) * defs->def_capacity);
+        VT_ENFORCE(defs->def_offsets != NULL && defs->def_lengths != NULL && defs->names != NULL && defs->gradients != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    }
+
+    // insert
+    const uint32_t index = (uint32_t)defs->def_count++;
+    defs->def_offsets[index] = snl_defs_push_pool(defs, key.head, key.head_len);
+    snl_defs_push_pool(defs, key.tail, key.tail_len);
+    defs->def_lengths[index] = (uint32_t)(key.head_len + key.tail_len);
+    defs->names[index] = id_index;
+    defs->gradients[index] = gradient ? *gradient : (snl_gradient_t) {0};
+    defs->targets[id_index] = index;
+    snl_intern_insert(&defs->contents, hash, index);
+
+    return true;
+}
+
+const char *snl_defs_resolve(snl_defs_t *const defs, const char *const id, size_t *const len) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(len != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // remember ids referenced before their definition, so they are never turned into aliases
+    *len = strlen(id);
+    const uint32_t hash = snl_hash_bytes(SNL_HASH_SEED, id, *len);
+    const snl_defs_id_key_t key = { .id = id, .len = *len };
+    const uint32_t index = snl_intern_find(&defs->ids, hash, snl_defs_id_eq, defs, &key);
+    if (index == SNL_INTERN_NONE) {
+        defs->targets[snl_defs_push_id(defs, id, *len, hash)] = SNL_DEFS_NONE;
+        return id;
+    }
+    if (defs->targets[index] == SNL_DEFS_NONE) return id;
+
+    // id the definition was written with
+    const uint32_t name = defs->names[defs->targets[index]];
+    *len = defs->id_lengths[name];
+    return defs->pool + defs->id_offsets[name];
+}
+
+const snl_gradient_t *snl_defs_get_gradient(const snl_defs_t *const defs, const char *const id) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    const uint32_t index = snl_defs_find(defs, id, strlen(id));
+    if (index == SNL_DEFS_NONE) return NULL;
+
+    const snl_gradient_t *const gradient = &defs->gradients[index];
+    return gradient->count ? gradient : NULL;
+}
+
+uint32_t snl_defs_find(const snl_defs_t *const defs, const char *const id, const size_t len) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(id != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    const snl_defs_id_key_t key = { .id = id, .len = len };
+    const uint32_t index = snl_intern_find(&defs->ids, snl_hash_bytes(SNL_HASH_SEED, id, len), snl_defs_id_eq, defs, &key);
+
+    return index == SNL_INTERN_NONE ? SNL_DEFS_NONE : defs->targets[index];
+}
+
+void snl_defs_emit(const snl_defs_t *const defs, const uint32_t index, snl_writer_t *const w) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(index < defs->def_count, "%s\n", vt_status_to_str(VT_STATUS_ERROR_OUT_OF_BOUNDS_ACCESS));
+    VT_DEBUG_ASSERT(w != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // the content is stored around the id: up to the first "id='", then from the closing quote on
+    const char *const content = defs->pool + defs->def_offsets[index];
+    const size_t len = defs->def_lengths[index];
+    size_t head_len = 0;
+    while (head_len + 4 < len && memcmp(content + head_len, "id='", 4) != 0) head_len++;
+    head_len += 4;
+
+    const uint32_t name = defs->names[index];
+    snl_writer_put_str_n(w, content, head_len);
+    snl_writer_put_escaped(w, defs->pool + defs->id_offsets[name], defs->id_lengths[name]);
+    snl_writer_put_str_n(w, content + head_len, len - head_len);
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Copy bytes to the pool
+ * @param defs definition table instance
+ * @param data bytes
+ * @param len number of bytes
+ * @return pool offset of the copy
+ */
+static uint32_t snl_defs_push_pool(snl_defs_t *const defs, const char *const data, const size_t len) {
+    // grow
+    if (defs->pool_len + len > defs->pool_capacity) {
+        size_t capacity = defs->pool_capacity ? defs->pool_capacity * 2 : 1024;
+        while (capacity < defs->pool_len + len) capacity *= 2;
+        defs->pool = realloc(defs->pool, capacity);
+        VT_ENFORCE(defs->pool != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        defs->pool_capacity = capacity;
+    }
+
+    // copy
+    const uint32_t offset = (uint32_t)defs->pool_len;
+    memcpy(defs->pool + offset, data, len);
+    defs->pool_len += len;
+
+    return offset;
+}
+
+/**
+ * @brief Add an id without a definition
+ * @param defs definition table instance
+ * @param id id
+ * @param len id length
+ * @param hash id hash
+ * @return id index
+ */
+static uint32_t snl_defs_push_id(snl_defs_t *const defs, const char *const id, const size_t len, const uint32_t hash) {
+    // grow
+    if (defs->id_count == defs->id_capacity) {
+        defs->id_capacity *= 2;
+        defs->id_offsets = realloc(defs->id_offsets, sizeof(uint32_t) * defs->id_capacity);
+        defs->id_lengths = realloc(defs->id_lengths, sizeof(uint32_t) * defs->id_capacity);
+        defs->targets = realloc(defs->targets, sizeof(uint32_t) * defs->id_capacity);
+        VT_ENFORCE(defs->id_offsets != NULL && defs->id_lengths != NULL && defs->targets != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    }
+
+    // insert
+    const uint32_t index = (uint32_t)defs->id_count++;
+    defs->id_offsets[index] = snl_defs_push_pool(defs, id, len);
+    defs->id_lengths[index] = (uint32_t)len;
+    defs->targets[index] = SNL_DEFS_NONE;
+    snl_intern_insert(&defs->ids, hash, index);
+
+    return index;
+}
+
+/**
+ * @brief Compare an id with a lookup key
+ * @param ctx definition table
+ * @param index id index
+ * @param key snl_defs_id_key_t*
+ * @return bool
+ */
+static bool snl_defs_id_eq(const void *ctx, const uint32_t index, const void *key) {
+    const snl_defs_t *const defs = ctx;
+    const snl_defs_id_key_t *const k = key;
+
+    return defs->id_lengths[index] == k->len && memcmp(defs->pool + defs->id_offsets[index], k->id, k->len) == 0;
+}
+
+/**
+ * @brief Compare the content of a definition with a lookup key
+ * @param ctx definition table
+ * @param index definition index
+ * @param key snl_defs_content_key_t*
+ * @return bool
+ */
+static bool snl_defs_content_eq(const void *ctx, const uint32_t index, const void *key) {
+    const snl_defs_t *const defs = ctx;
+    const snl_defs_content_key_t *const k = key;
+    const char *const content = defs->pool + defs->def_offsets[index];
+
+    return defs->def_lengths[index] == k->head_len + k->tail_len &&
+        memcmp(content, k->head, k->head_len) == 0 &&
+        memcmp(content + k->head_len, k->tail, k->tail_len) == 0;
+}
+
@@ -0,0 +1,119 @@
+#ifndef SNAIL_DEFS_H
+#define SNAIL_DEFS_H
+
+/** DEFS MODULE (internal)
+ *  - snl_defs_create
+ *  - snl_defs_destroy
+ *  - snl_defs_add
+ *  - snl_defs_resolve
+ *  - snl_defs_get_gradient
+ *  - snl_defs_find
+ *  - snl_defs_emit
+*/
+
+#include "emit.h"
+#include "intern.h"
+
+// id without a definition yet
+#define SNL_DEFS_NONE UINT32_MAX
+
+// filter and gradient definitions interned by content; ids with the same content alias the first one
+typedef struct SnailDefs {
+    // ids and definition contents, back to back
+    char *pool;
+    size_t pool_len;
+    size_t pool_capacity;
+
+    // ids
+    uint32_t *id_offsets;   // pool offset of the id
+    uint32_t *id_lengths;   // length of the id
+    uint32_t *targets;      // definition the id refers to, or SNL_DEFS_NONE if it was only referenced so far
+    size_t id_count;
+    size_t id_capacity;
+    snl_intern_t ids;
+
+    // definitions
+    uint32_t *def_offsets;  // pool offset of the content, i.e. the definition without its id
+    uint32_t *def_lengths;  // length of the content
+    uint32_t *names;        // id the definition was written with
+    snl_gradient_t *gradients; // gradient parameters, count is 0 for filters
+    size_t def_count;
+    size_t def_capacity;
+    snl_intern_t contents;
+
+    // definition being added, reused between additions
+    vt_str_t *scratch;
+} snl_defs_t;
+
+/**
+ * @brief Create an empty definition table
+ *
+ * @return snl_defs_t*
+ */
+extern snl_defs_t *snl_defs_create(void);
+
+/**
+ * @brief Release definition table memory
+ *
+ * @param defs definition table instance
+ * @return None
+ */
+extern void snl_defs_destroy(snl_defs_t *const defs);
+
+/**
+ * @brief Register a definition under an id
+ *
+ * @param defs definition table instance
+ * @param id definition id
+ * @param def definition markup, starting with "<tag id='<escaped id>'"
+ * @param len definition length
+ * @param gradient gradient parameters or NULL for filters
+ * @return true if the definition has to be written out
+ *
+ * @note nothing has to be written if the id is already defined (the first definition wins, as in SVG)
+ *       or if the same content already exists under another id: the id becomes an alias of it,
+ *       unless the id was referenced before, when an element may already point at it
+ */
+extern bool snl_defs_add(snl_defs_t *const defs, const char *const id, const char *const def, const size_t len, const snl_gradient_t *const gradient);
+
+/**
+ * @brief Find the id to write for a reference
+ *
+ * @param defs definition table instance
+ * @param id referenced id
+ * @param len referenced id length (set on return)
+ * @return id of the definition, valid until the next call
+ */
+extern const char *snl_defs_resolve(snl_defs_t *const defs, const char *const id, size_t *const len);
+
+/**
+ * @brief Find the gradient an id refers to
+ *
+ * @param defs definition table instance
+ * @param id referenced id
+ * @return gradient parameters or NULL if the id is not a defined gradient
+ */
+extern const snl_gradient_t *snl_defs_get_gradient(const snl_defs_t *const defs, const char *const id);
+
+/**
+ * @brief Find the definition an id refers to, leaving the table unchanged
+ *
+ * @param defs definition table instance
+ * @param id referenced id
+ * @param len id length
+ * @return definition index or SNL_DEFS_NONE if the id is not defined
+ */
+extern uint32_t snl_defs_find(const snl_defs_t *const defs, const char *const id, const size_t len);
+
+/**
+ * @brief Write a definition as it was added
+ *
+ * @param defs definition table instance
+ * @param index definition index
+ * @param w writer instance
+ * @return None
+ */
+extern void snl_defs_emit(const snl_defs_t *const defs, const uint32_t index, snl_writer_t *const w);
+
+#endif // SNAIL_DEFS_H
+
@@ -0,0 +1,1709 @@
+#include "emit.h"
+
+#include <math.h>
+#include <stdio.h>
+#include "style.h"
+#include "defs.h"
+
+// 16-byte scan for characters that need escaping
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define SNL_ESCAPE_SSE2
+    #include <emmintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #endif
+#endif
+
+// decimal strings for 0..255
+typedef struct SnailUint8Str {
+    char str[3];
+    uint8_t len;
+} snl_uint8_str_t;
+
+#define SNL_U8_1(n) { { '0' + (n) }, 1 }
+#define SNL_U8_2(n) { { '0' + (n) / 10, '0' + (n) % 10 }, 2 }
+#define SNL_U8_3(n) { { '0' + (n) / 100, '0' + (n) / 10 % 10, '0' + (n) % 10 }, 3 }
+#define SNL_U8_1X10(n) SNL_U8_1(n), SNL_U8_1(n+1), SNL_U8_1(n+2), SNL_U8_1(n+3), SNL_U8_1(n+4), SNL_U8_1(n+5), SNL_U8_1(n+6), SNL_U8_1(n+7), SNL_U8_1(n+8), SNL_U8_1(n+9)
+#define SNL_U8_2X10(n) SNL_U8_2(n), SNL_U8_2(n+1), SNL_U8_2(n+2), SNL_U8_2(n+3), SNL_U8_2(n+4), SNL_U8_2(n+5), SNL_U8_2(n+6), SNL_U8_2(n+7), SNL_U8_2(n+8), SNL_U8_2(n+9)
+#define SNL_U8_3X10(n) SNL_U8_3(n), SNL_U8_3(n+1), SNL_U8_3(n+2), SNL_U8_3(n+3), SNL_U8_3(n+4), SNL_U8_3(n+5), SNL_U8_3(n+6), SNL_U8_3(n+7), SNL_U8_3(n+8), SNL_U8_3(n+9)
+
+static const snl_uint8_str_t gi_uint8_str[256] = {
+    SNL_U8_1X10(0),
+    SNL_U8_2X10(10), SNL_U8_2X10(20), SNL_U8_2X10(30), SNL_U8_2X10(40), SNL_U8_2X10(50),
+    SNL_U8_2X10(60), SNL_U8_2X10(70), SNL_U8_2X10(80), SNL_U8_2X10(90),
+    SNL_U8_3X10(100), SNL_U8_3X10(110), SNL_U8_3X10(120), SNL_U8_3X10(130), SNL_U8_3X10(140),
+    SNL_U8_3X10(150), SNL_U8_3X10(160), SNL_U8_3X10(170), SNL_U8_3X10(180), SNL_U8_3X10(190),
+    SNL_U8_3X10(200), SNL_U8_3X10(210), SNL_U8_3X10(220), SNL_U8_3X10(230), SNL_U8_3X10(240),
+    SNL_U8_3(250), SNL_U8_3(251), SNL_U8_3(252), SNL_U8_3(253), SNL_U8_3(254), SNL_U8_3(255)
+};
+
+// two-digit pairs "00".."99"
+static const char gi_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// powers of 10 used for scaling
+static const double gi_pow10[10] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+// largest scaled value that is still an exact integer in a double
+#define SNL_FORMAT_EXACT_LIMIT 9007199254740992.0 // 2^53
+
+// adding and subtracting 2^52 rounds values below it to an integer (half-to-even)
+#define SNL_FORMAT_ROUND_MAGIC 4503599627370496.0 // 2^52
+
+// the default precision has a fast path in batch formatting
+_Static_assert(SNL_PRECISION_DEFAULT == 2, "snl_writer_put_scaled() expects SNL_PRECISION_DEFAULT == 2");
+_Static_assert(SNL_PRECISION_MAX <= 9, "snl_format_float() supports up to 9 digits");
+
+// U+FFFD, written for invalid utf-8 and control characters
+#define SNL_ESCAPE_REPLACEMENT "\xef\xbf\xbd"
+
+// initial values of the stroke and fill properties, which the root <svg> passes down
+static const snl_appearance_t gi_svg_defaults = { 1, 1, { 0, 0, 0, 0 }, 1, { 0, 0, 0, 255 }, NULL, NULL };
+
+// how style properties are written
+typedef enum SnailSyntax {
+    SNL_SYNTAX_ATTRIBUTE,   // " name='value'"
+    SNL_SYNTAX_CSS          // "name:value;"
+} snl_syntax_t;
+
+static size_t snl_format_uint(char *const dst, uint64_t value);
+static size_t snl_format_trim(char *const dst, size_t len);
+static void snl_writer_put_hex(snl_writer_t *const w, const struct SnailColor color);
+static size_t snl_escape_scan(const char *const z, const size_t n);
+static bool snl_css_is_plain(const char *const z, const size_t n);
+static bool snl_escape_is_stop(const unsigned char c);
+static size_t snl_utf8_sequence(const unsigned char *const z, const size_t n);
+static void snl_emit_paint(snl_writer_t *const w, const struct SnailColor color, const char *const gradient);
+static void snl_emit_url(snl_writer_t *const w, const char *const id);
+static void snl_emit_property(snl_writer_t *const w, const snl_syntax_t syntax, const char *const name);
+static void snl_emit_property_end(snl_writer_t *const w, const snl_syntax_t syntax);
+static void snl_emit_properties(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule, const snl_syntax_t syntax);
+static void snl_emit_properties_compact(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule, const snl_syntax_t syntax);
+static void snl_emit_properties_inherited(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule, const snl_syntax_t syntax);
+static void snl_emit_paint_changes(snl_writer_t *const w, const snl_appearance_t *const appearance, const snl_appearance_t *const base, const bool fill, const snl_syntax_t syntax);
+static bool snl_paint_eq(const struct SnailColor a, const char *const a_gradient, const struct SnailColor b, const char *const b_gradient);
+static void snl_emit_stroke_compact(snl_writer_t *const w, const snl_appearance_t *const appearance, const snl_syntax_t syntax);
+static void snl_emit_filter_compact(snl_writer_t *const w, const char *const filter, const snl_syntax_t syntax);
+static void snl_emit_text_properties(snl_writer_t *const w, const snl_text_style_t *const text_style, const snl_syntax_t syntax);
+static void snl_emit_class_ref(snl_writer_t *const w);
+static void snl_emit_gradient_stops(snl_writer_t *const w, const snl_gradient_stop_t *const stops, const size_t count);
+static void snl_emit_close(snl_writer_t *const w);
+static void snl_emit_corner_radius(snl_writer_t *const w, const float radius);
+static void snl_emit_line_style(snl_writer_t *const w, const snl_appearance_t *const appearance);
+static void snl_emit_text_attributes(snl_writer_t *const w, const snl_appearance_t *const appearance, const snl_text_style_t *const text_style);
+static void snl_emit_scale(const snl_writer_t *const w, float *const values, double *const scaled, const float *const src, const size_t n, const float *const offset, const bool snap);
+static float snl_writer_snap(const snl_writer_t *const w, const float value);
+static void snl_writer_put_scaled(snl_writer_t *const w, const float value, const double scaled);
+static void snl_emit_path_point(snl_writer_t *const w, snl_path_cursor_t *const cursor, snl_point_t point);
+static size_t snl_path_command_len(const snl_path_cursor_t *const cursor, const char command, const char *const a, const size_t a_len, const char *const b, const size_t b_len);
+static void snl_path_command_put(snl_writer_t *const w, snl_path_cursor_t *const cursor, const char command, const char *const a, const size_t a_len, const char *const b, const size_t b_len);
+static bool snl_path_separated(const bool dot, const char *const number);
+static size_t snl_format_fixed(char *const dst, const int64_t value, const int32_t precision);
+
+void snl_writer_init(snl_writer_t *const w, vt_str_t *const target) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(w != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(target != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    w->target = target;
+    w->len = 0;
+    w->compact = false;
+    w->trim = false;
+    w->precision = SNL_PRECISION_DEFAULT;
+    w->grid = 0;
+    w->sheet = NULL;
+    w->defs = NULL;
+    w->inherited = NULL;
+    w->style_class = SNL_STYLE_CLASS_NONE;
+    w->class_block = false;
+    w->css = false;
+    w->css_rejected = false;
+}
+
+void snl_writer_flush(snl_writer_t *const w) {
+    if (w->len == 0) return;
+
+    vt_str_append_n(w->target, w->buf, w->len);
+    w->len = 0;
+}
+
+void snl_writer_put_str_n(snl_writer_t *const w, const char *const z, const size_t n) {
+    // fast path: fits into the buffer
+    if (w->len + n <= SNL_WRITER_BUFFER_SIZE) {
+        memcpy(w->buf + w->len, z, n);
+        w->len += n;
+        return;
+    }
+
+    // large strings go straight to the target
+    snl_writer_flush(w);
+    if (n < SNL_WRITER_BUFFER_SIZE / 2) {
+        memcpy(w->buf, z, n);
+        w->len = n;
+    } else {
+        vt_str_append_n(w->target, z, n);
+    }
+}
+
+void snl_writer_put_float(snl_writer_t *const w, const float value, const int32_t precision) {
+    if (w->len + SNL_FORMAT_NUMBER_MAX > SNL_WRITER_BUFFER_SIZE) snl_writer_flush(w);
+    const size_t len = snl_format_float(w->buf + w->len, value, precision);
+    w->len += w->trim ? snl_format_trim(w->buf + w->len, len) : len;
+}
+
+void snl_writer_put_escaped(snl_writer_t *const w, const char *const z, const size_t n) {
+    // css syntax characters would end the declaration or the class rule
+    if (w->css && !snl_css_is_plain(z, n)) w->css_rejected = true;
+
+    size_t i = 0;
+    while (i < n) {
+        // plain run
+        const size_t run = snl_escape_scan(z + i, n - i);
+        snl_writer_put_str_n(w, z + i, run);
+        i += run;
+        if (i == n) break;
+
+        // markup and control characters
+        const unsigned char c = (unsigned char)z[i];
+        if (c < 0x80) {
+            switch (c) {
+                case '<': snl_writer_put_str_n(w, "&lt;", 4); break;
+                case '>': snl_writer_put_str_n(w, "&gt;", 4); break;
+                case '&': snl_writer_put_str_n(w, "&amp;", 5); break;
+                case '\'': snl_writer_put_str_n(w, "&apos;", 6); break;
+                case '"': snl_writer_put_str_n(w, "&quot;", 6); break;
+                case '\t': case '\n': case '\r': snl_writer_put_char(w, (char)c); break;
+                default: snl_writer_put_str_n(w, SNL_ESCAPE_REPLACEMENT, 3); break;
+            }
+            i++;
+            continue;
+        }
+
+        // multi-byte character, or one replacement per invalid byte
+        const size_t len = snl_utf8_sequence((const unsigned char*)z + i, n - i);
+        if (len) {
+            snl_writer_put_str_n(w, z + i, len);
+            i += len;
+        } else {
+            snl_writer_put_str_n(w, SNL_ESCAPE_REPLACEMENT, 3);
+            i++;
+        }
+    }
+}
+
+void snl_writer_put_coord(snl_writer_t *const w, const float value) {
+    snl_writer_put_float(w, w->grid > 0 ? snl_writer_snap(w, value) : value, w->precision);
+}
+
+void snl_writer_put_length(snl_writer_t *const w, const float value) {
+    snl_writer_put_float(w, value, w->precision);
+}
+
+void snl_writer_put_int(snl_writer_t *const w, const int64_t value) {
+    if (w->len + SNL_FORMAT_NUMBER_MAX > SNL_WRITER_BUFFER_SIZE) snl_writer_flush(w);
+    w->len += snl_format_int(w->buf + w->len, value);
+}
+
+void snl_writer_put_uint8(snl_writer_t *const w, const uint8_t value) {
+    const snl_uint8_str_t *const s = &gi_uint8_str[value];
+    snl_writer_put_str_n(w, s->str, s->len);
+}
+
+void snl_writer_put_rgba(snl_writer_t *const w, const struct SnailColor color) {
+    snl_writer_put_str_n(w, "rgba(", 5);
+    snl_writer_put_uint8(w, color.r);
+    snl_writer_put_str_n(w, ", ", 2);
+    snl_writer_put_uint8(w, color.g);
+    snl_writer_put_str_n(w, ", ", 2);
+    snl_writer_put_uint8(w, color.b);
+    snl_writer_put_str_n(w, ", ", 2);
+    snl_writer_put_uint8(w, color.a);
+    snl_writer_put_char(w, ')');
+}
+
+void snl_writer_put_color(snl_writer_t *const w, const struct SnailColor color) {
+    if (w->compact && color.a != 0) {
+        snl_writer_put_hex(w, color);
+    } else {
+        snl_writer_put_rgba(w, color);
+    }
+}
+
+size_t snl_format_float(char *const dst, const float value, const int32_t precision) {
+    VT_DEBUG_ASSERT(precision >= 0 && precision <= 9, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // the product is correctly rounded to a double; 10^p = 2^p * 5^p with 5^9 < 2^21, so a 24-bit float
+    // mantissa times 10^p needs at most 45 bits and rounding loses nothing; rint() then rounds half-to-even
+    // like printf does on the exact decimal value
+    const double scaled = fabs((double)value) * gi_pow10[precision];
+    if (!(scaled < SNL_FORMAT_EXACT_LIMIT)) {
+        // huge values, nan, inf
+        return (size_t)snprintf(dst, SNL_FORMAT_NUMBER_MAX, "%.*f", (int)precision, value);
+    }
+
+    // split into integer and fractional parts
+    const uint64_t q = (uint64_t)rint(scaled);
+    const uint64_t p = (uint64_t)gi_pow10[precision];
+    const uint64_t ipart = q / p;
+    uint64_t fpart = q % p;
+
+    // sign; a whole number rounded to zero is written as 0, not -0
+    size_t len = 0;
+    if (signbit(value) && (q != 0 || precision > 0)) dst[len++] = '-';
+
+    // integer part
+    len += snl_format_uint(dst + len, ipart);
+    if (precision == 0) return len;
+
+    // fractional part, zero-padded
+    dst[len++] = '.';
+    for (int32_t i = precision - 1; i >= 0; i--) {
+        dst[len + i] = (char)('0' + fpart % 10);
+        fpart /= 10;
+    }
+
+    return len + precision;
+}
+
+size_t snl_format_int(char *const dst, const int64_t value) {
+    if (value < 0) {
+        dst[0] = '-';
+        return 1 + snl_format_uint(dst + 1, (uint64_t)0 - (uint64_t)value);
+    }
+
+    return snl_format_uint(dst, (uint64_t)value);
+}
+
+double snl_round_coord(const float value, const int32_t precision, const float grid) {
+    VT_DEBUG_ASSERT(precision >= 0 && precision <= 9, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // same steps as snl_writer_snap() and snl_format_float()
+    const double snapped = grid > 0 ? (double)(float)(rint((double)value / (double)grid) * (double)grid) : (double)value;
+    const double scaled = fabs(snapped) * gi_pow10[precision];
+    if (!(scaled < SNL_FORMAT_EXACT_LIMIT)) return snapped;
+
+    return copysign(rint(scaled) / gi_pow10[precision], snapped);
+}
+
+void snl_emit_filter_blur(snl_writer_t *const w, const char *const id, const int32_t blurnessHorizontal, const int32_t blurnessVertical, const bool hard_edge) {
+    snl_writer_put_str(w, "<filter id='");
+    snl_writer_put_escaped(w, id, strlen(id));
+    snl_writer_put_str(w, "'><feGaussianBlur stdDeviation='");
+    snl_writer_put_int(w, blurnessHorizontal);
+    snl_writer_put_char(w, ' ');
+    snl_writer_put_int(w, blurnessVertical);
+    snl_writer_put_str(w, "'/>");
+    if (hard_edge) {
+        snl_writer_put_str(w, "<feComponentTransfer><feFuncA type='table' tableValues='1 1'/></feComponentTransfer>");
+    }
+    snl_writer_put_str(w, "</filter>\n");
+}
+
+void snl_emit_filter_shadow(
+    snl_writer_t *const w, 
+    const char *const id, 
+    const int32_t offsetX, 
+    const int32_t offsetY, 
+    const int32_t blurness, 
+    const bool color_blend
+) {
+    snl_writer_put_str(w, "<filter id='");
+    snl_writer_put_escaped(w, id, strlen(id));
+    snl_writer_put_str(w, "' x='0' y='0' width='200%' height='200%'><feOffset result='offOut' in='");
+    snl_writer_put_str(w, color_blend ? "SourceGraphic" : "SourceAlpha");
+    snl_writer_put_str(w, "' dx='");
+    snl_writer_put_int(w, offsetX);
+    snl_writer_put_str(w, "' dy='");
+    snl_writer_put_int(w, offsetY);
+    snl_writer_put_str(w, "'/><feGaussianBlur result='blurOut' in='offOut' stdDeviation='");
+    snl_writer_put_int(w, blurness);
+    snl_writer_put_str(w, "'/><feBlend in='SourceGraphic' in2='blurOut' mode='normal'/></filter>\n");
+}
+
+void snl_emit_gradient_linear(
+    snl_writer_t *const w, 
+    const char *const id, 
+    const snl_point_t start, 
+    const snl_point_t end, 
+    const snl_gradient_stop_t *const stops, 
+    const size_t count
+) {
+    snl_writer_put_str(w, "<linearGradient id='");
+    snl_writer_put_escaped(w, id, strlen(id));
+    snl_writer_put_str(w, "' x1='");
+    snl_writer_put_float(w, start.x, SNL_PRECISION_GRADIENT);
+    snl_writer_put_str(w, "%' y1='");
+    snl_writer_put_float(w, start.y, SNL_PRECISION_GRADIENT);
+    snl_writer_put_str(w, "%' x2='");
+    snl_writer_put_float(w, end.x, SNL_PRECISION_GRADIENT);
+    snl_writer_put_str(w, "%' y2='");
+    snl_writer_put_float(w, end.y, SNL_PRECISION_GRADIENT);
+    snl_writer_put_str(w, "%'>");
+    snl_emit_gradient_stops(w, stops, count);
+    snl_writer_put_str(w, "</linearGradient>\n");
+}
+
+void snl_emit_gradient_radial(snl_writer_t *const w, const char *const id, const snl_gradient_stop_t *const stops, const size_t count) {
+    snl_writer_put_str(w, "<radialGradient id='");
+    snl_writer_put_escaped(w, id, strlen(id));
+    snl_writer_put_str(w, "' x1='50%' y1='50%' x2='50%' y2='50%'>");
+    snl_emit_gradient_stops(w, stops, count);
+    snl_writer_put_str(w, "</radialGradient>\n");
+}
+
+void snl_emit_appearance(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule) {
+    // a class carries the whole style
+    if (w->style_class != SNL_STYLE_CLASS_NONE) {
+        snl_emit_class_ref(w);
+    } else {
+        snl_emit_properties(w, appearance, fill_rule, SNL_SYNTAX_ATTRIBUTE);
+    }
+
+    // the full profile keeps a space before the closing tag
+    if (!w->compact) snl_writer_put_char(w, ' ');
+}
+
+void snl_emit_class(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule, const snl_text_style_t *const text_style) {
+    w->style_class = SNL_STYLE_CLASS_NONE;
+    if (w->sheet == NULL) return;
+
+    // inside a group the attributes depend on the inherited style
+    if (w->inherited) return;
+
+    // format the declarations
+    snl_style_sheet_t *const sheet = w->sheet;
+    vt_str_clear(sheet->scratch);
+    snl_writer_t decl;
+    snl_writer_init(&decl, sheet->scratch);
+    decl.compact = w->compact;
+    decl.trim = w->trim;
+    decl.defs = w->defs;
+    decl.css = true;
+    if (text_style) snl_emit_text_properties(&decl, text_style, SNL_SYNTAX_CSS);
+    snl_emit_properties(&decl, appearance, fill_rule, SNL_SYNTAX_CSS);
+    snl_writer_flush(&decl);
+    if (vt_str_len(sheet->scratch) == 0) return;
+
+    // values with css syntax characters stay in attributes, where xml escaping is enough
+    if (decl.css_rejected) return;
+
+    // define the class on first use, unless all classes go to a single <style> element
+    bool created = false;
+    w->style_class = snl_style_sheet_intern(sheet, vt_str_z(sheet->scratch), vt_str_len(sheet->scratch), vt_str_len(w->target) + w->len, &created);
+    if (created && !w->class_block) {
+        snl_writer_put_str(w, "<style>.a");
+        snl_writer_put_int(w, w->style_class);
+        snl_writer_put_char(w, '{');
+        snl_writer_put_str_n(w, vt_str_z(sheet->scratch), vt_str_len(sheet->scratch));
+        snl_writer_put_str(w, "}</style>\n");
+    }
+}
+
+void snl_emit_style_sheet(snl_writer_t *const w, const snl_style_sheet_t *const sheet) {
+    snl_writer_put_str(w, "<style>\n");
+    for (size_t i = 0; i < sheet->count; i++) {
+        snl_writer_put_str(w, ".a");
+        snl_writer_put_int(w, i);
+        snl_writer_put_char(w, '{');
+        snl_writer_put_str_n(w, sheet->pool + sheet->offsets[i], sheet->lengths[i]);
+        snl_writer_put_str(w, "}\n");
+    }
+    snl_writer_put_str(w, "</style>\n");
+}
+
+void snl_emit_symbol(snl_writer_t *const w, const char *const id, const char *const content, const size_t len) {
+    // symbols are placed by <use> elements without clipping
+    snl_writer_put_str(w, "<symbol id='");
+    snl_writer_put_escaped(w, id, strlen(id));
+    snl_writer_put_str(w, "' overflow='visible'>\n");
+    snl_writer_put_str_n(w, content, len);
+    snl_writer_put_str(w, "</symbol>\n");
+}
+
+void snl_emit_use(snl_writer_t *const w, const char *const id, const snl_point_t pos, const float scale, const float rotation) {
+    // reference
+    size_t len = strlen(id);
+    const char *const name = w->defs ? snl_defs_resolve(w->defs, id, &len) : id;
+    snl_writer_put_str(w, "<use xlink:href='#");
+    snl_writer_put_escaped(w, name, len);
+
+    // placement; identity parts are left out
+    snl_writer_put_str(w, "' transform='translate(");
+    snl_writer_put_coord(w, pos.x);
+    snl_writer_put_char(w, ' ');
+    snl_writer_put_coord(w, pos.y);
+    snl_writer_put_char(w, ')');
+    if (rotation != 0) {
+        snl_writer_put_str(w, " rotate(");
+        snl_writer_put_float(w, rotation, SNL_PRECISION_STYLE);
+        snl_writer_put_char(w, ')');
+    }
+    if (scale != 1) {
+        snl_writer_put_str(w, " scale(");
+        snl_writer_put_float(w, scale, SNL_PRECISION_STYLE);
+        snl_writer_put_char(w, ')');
+    }
+    snl_writer_put_char(w, '\'');
+
+    // close tag
+    snl_emit_close(w);
+}
+
+void snl_emit_group_open(snl_writer_t *const w, const snl_transform_t *const transform, const snl_appearance_t *const appearance) {
+    snl_writer_put_str_n(w, "<g", 2);
+
+    // transform: left out for the identity, translate() when there is nothing else
+    const snl_transform_t *const m = transform;
+    if (m->a != 1 || m->b != 0 || m->c != 0 || m->d != 1) {
+        snl_writer_put_str(w, " transform='matrix(");
+        snl_writer_put_float(w, m->a, SNL_PRECISION_TRANSFORM);
+        snl_writer_put_char(w, ' ');
+        snl_writer_put_float(w, m->b, SNL_PRECISION_TRANSFORM);
+        snl_writer_put_char(w, ' ');
+        snl_writer_put_float(w, m->c, SNL_PRECISION_TRANSFORM);
+        snl_writer_put_char(w, ' ');
+        snl_writer_put_float(w, m->d, SNL_PRECISION_TRANSFORM);
+        snl_writer_put_char(w, ' ');
+        snl_writer_put_coord(w, m->e);
+        snl_writer_put_char(w, ' ');
+        snl_writer_put_coord(w, m->f);
+        snl_writer_put_str_n(w, ")'", 2);
+    } else if (m->e != 0 || m->f != 0) {
+        snl_writer_put_str(w, " transform='translate(");
+        snl_writer_put_coord(w, m->e);
+        snl_writer_put_char(w, ' ');
+        snl_writer_put_coord(w, m->f);
+        snl_writer_put_str_n(w, ")'", 2);
+    }
+
+    // style, relative to the one the group inherits; the filter is not inherited, it applies to the group
+    if (appearance) {
+        snl_emit_paint_changes(w, appearance, w->inherited ? w->inherited : &gi_svg_defaults, true, SNL_SYNTAX_ATTRIBUTE);
+        if (w->compact) {
+            snl_emit_filter_compact(w, appearance->filter, SNL_SYNTAX_ATTRIBUTE);
+        } else if (appearance->filter) {
+            snl_emit_property(w, SNL_SYNTAX_ATTRIBUTE, "filter");
+            snl_emit_url(w, appearance->filter);
+            snl_emit_property_end(w, SNL_SYNTAX_ATTRIBUTE);
+        }
+    }
+    snl_writer_put_str_n(w, ">\n", 2);
+}
+
+void snl_emit_group_close(snl_writer_t *const w) {
+    snl_writer_put_str_n(w, "</g>\n", 5);
+}
+
+void snl_emit_line(snl_writer_t *const w, const snl_point_t start, const snl_point_t end, const snl_appearance_t *const appearance) {
+    // open tag
+    snl_writer_put_str(w, "<line x1='");
+    snl_writer_put_coord(w, start.x);
+    snl_writer_put_str(w, "' y1='");
+    snl_writer_put_coord(w, start.y);
+    snl_writer_put_str(w, "' x2='");
+    snl_writer_put_coord(w, end.x);
+    snl_writer_put_str(w, "' y2='");
+    snl_writer_put_coord(w, end.y);
+
+    // style
+    snl_emit_line_style(w, appearance);
+
+    // close tag
+    snl_emit_close(w);
+}
+
+void snl_emit_circle(snl_writer_t *const w, const snl_point_t origin, const float radius, const snl_appearance_t *const appearance) {
+    // open tag
+    snl_writer_put_str(w, "<circle cx='");
+    snl_writer_put_coord(w, origin.x);
+    snl_writer_put_str(w, "' cy='");
+    snl_writer_put_coord(w, origin.y);
+    snl_writer_put_str(w, "' r='");
+    snl_writer_put_length(w, radius);
+    snl_writer_put_char(w, '\'');
+
+    // style
+    snl_emit_appearance(w, appearance, NULL);
+
+    // close tag
+    snl_emit_close(w);
+}
+
+void snl_emit_ellipse(snl_writer_t *const w, const snl_point_t origin, const snl_point_t radius, const snl_appearance_t *const appearance) {
+    // open tag
+    snl_writer_put_str(w, "<ellipse cx='");
+    snl_writer_put_coord(w, origin.x);
+    snl_writer_put_str(w, "' cy='");
+    snl_writer_put_coord(w, origin.y);
+    snl_writer_put_str(w, "' rx='");
+    snl_writer_put_length(w, radius.x);
+    snl_writer_put_str(w, "' ry='");
+    snl_writer_put_length(w, radius.y);
+    snl_writer_put_char(w, '\'');
+
+    // style
+    snl_emit_appearance(w, appearance, NULL);
+
+    // close tag
+    snl_emit_close(w);
+}
+
+void snl_emit_rectangle(snl_writer_t *const w, const snl_point_t pos, const snl_point_t size, const float radius, const snl_appearance_t *const appearance) {
+    // open tag
+    snl_writer_put_str(w, "<rect x='");
+    snl_writer_put_coord(w, pos.x);
+    snl_writer_put_str(w, "' y='");
+    snl_writer_put_coord(w, pos.y);
+    snl_writer_put_str(w, "' width='");
+    snl_writer_put_length(w, size.x);
+    snl_writer_put_str(w, "' height='");
+    snl_writer_put_length(w, size.y);
+    snl_emit_corner_radius(w, radius);
+
+    // style
+    snl_emit_appearance(w, appearance, NULL);
+
+    // close tag
+    snl_emit_close(w);
+}
+
+void snl_emit_points_begin(snl_writer_t *const w, const bool closed, snl_path_cursor_t *const cursor) {
+    *cursor = (snl_path_cursor_t) { .closed = closed };
+
+    // the compact profile writes path data
+    if (w->compact) {
+        snl_writer_put_str_n(w, "<path d='", 9);
+        return;
+    }
+
+    snl_writer_put_str(w, closed ? "<polygon points='" : "<polyline points='");
+}
+
+void snl_emit_point(snl_writer_t *const w, snl_path_cursor_t *const cursor, const snl_point_t point) {
+    if (w->compact) {
+        snl_emit_path_point(w, cursor, point);
+        return;
+    }
+
+    snl_writer_put_coord(w, point.x);
+    snl_writer_put_str_n(w, ", ", 2);
+    snl_writer_put_coord(w, point.y);
+    snl_writer_put_char(w, ' ');
+}
+
+void snl_emit_points(snl_writer_t *const w, snl_path_cursor_t *const cursor, const snl_point_t *const points, const size_t n, const snl_point_t offset) {
+    if (w->compact) {
+        for (size_t i = 0; i < n; i++) {
+            snl_emit_path_point(w, cursor, SNL_POINT(points[i].x + offset.x, points[i].y + offset.y));
+        }
+        return;
+    }
+
+    float v[2 * SNL_EMIT_BATCH_SIZE];
+    double q[2 * SNL_EMIT_BATCH_SIZE];
+
+    for (size_t i = 0; i < n; i += SNL_EMIT_BATCH_SIZE) {
+        const size_t count = n - i < SNL_EMIT_BATCH_SIZE ? n - i : SNL_EMIT_BATCH_SIZE;
+
+        // translate, then convert all numbers first
+        const snl_point_t *const p = points + i;
+        for (size_t j = 0; j < count; j++) {
+            v[2 * j] = p[j].x + offset.x;
+            v[2 * j + 1] = p[j].y + offset.y;
+        }
+        snl_emit_scale(w, v, q, v, 2 * count, NULL, true);
+
+        // "x, y "
+        for (size_t j = 0; j < 2 * count; j += 2) {
+            snl_writer_put_scaled(w, v[j], q[j]);
+            snl_writer_put_str_n(w, ", ", 2);
+            snl_writer_put_scaled(w, v[j + 1], q[j + 1]);
+            snl_writer_put_char(w, ' ');
+        }
+    }
+}
+
+void snl_emit_points_end(snl_writer_t *const w, const snl_path_cursor_t *const cursor, const snl_appearance_t *const appearance, const char *const fill_rule) {
+    // close the polygon outline
+    if (w->compact && cursor->closed && cursor->command != 0) snl_writer_put_char(w, 'z');
+
+    // open tag
+    snl_writer_put_char(w, '\'');
+
+    // style
+    snl_emit_appearance(w, appearance, fill_rule);
+
+    // close tag
+    snl_emit_close(w);
+}
+
+void snl_emit_curve(snl_writer_t *const w, const snl_point_t start, const snl_point_t control, const snl_point_t delta, const snl_appearance_t *const appearance) {
+    // open tag
+    snl_writer_put_str(w, w->compact ? "<path d='M" : "<path d='M ");
+    snl_writer_put_coord(w, start.x);
+    snl_writer_put_char(w, ' ');
+    snl_writer_put_coord(w, start.y);
+    snl_writer_put_str(w, w->compact ? "q" : " q ");
+    snl_writer_put_coord(w, control.x);
+    snl_writer_put_char(w, ' ');
+    snl_writer_put_coord(w, control.y);
+    snl_writer_put_char(w, ' ');
+    snl_writer_put_coord(w, delta.x);
+    snl_writer_put_char(w, ' ');
+    snl_writer_put_coord(w, delta.y);
+    snl_writer_put_char(w, '\'');
+
+    // style
+    snl_emit_appearance(w, appearance, NULL);
+
+    // close tag
+    snl_emit_close(w);
+}
+
+void snl_emit_text(snl_writer_t *const w, const snl_point_t pos, const char *const text, const snl_appearance_t *const appearance, const snl_text_style_t *const text_style) {
+    // open tag
+    snl_writer_put_str(w, "<text x='");
+    snl_writer_put_coord(w, pos.x);
+    snl_writer_put_str(w, "' y='");
+    snl_writer_put_coord(w, pos.y);
+
+    // style
+    snl_emit_text_attributes(w, appearance, text_style);
+
+    // text value
+    snl_writer_put_escaped(w, text, strlen(text));
+    snl_writer_put_str(w, "</text>\n");
+}
+
+void snl_emit_tail_shape(snl_writer_t *const w, const snl_appearance_t *const appearance) {
+    snl_writer_put_char(w, '\'');
+    snl_emit_appearance(w, appearance, NULL);
+    snl_emit_close(w);
+}
+
+void snl_emit_tail_rectangle(snl_writer_t *const w, const float radius, const snl_appearance_t *const appearance) {
+    snl_emit_corner_radius(w, radius);
+    snl_emit_appearance(w, appearance, NULL);
+    snl_emit_close(w);
+}
+
+void snl_emit_tail_line(snl_writer_t *const w, const snl_appearance_t *const appearance) {
+    snl_emit_line_style(w, appearance);
+    snl_emit_close(w);
+}
+
+void snl_emit_tail_text(snl_writer_t *const w, const snl_appearance_t *const appearance, const snl_text_style_t *const text_style) {
+    snl_emit_text_attributes(w, appearance, text_style);
+}
+
+void snl_emit_circles(
+    snl_writer_t *const w, 
+    const float *const xs, const float *const ys, const float *const rs, const size_t n, 
+    const snl_point_t offset, const vt_str_t *const tail, size_t *const starts
+) {
+    VT_DEBUG_ASSERT(n <= SNL_EMIT_BATCH_SIZE, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // convert all numbers first
+    float x[SNL_EMIT_BATCH_SIZE], y[SNL_EMIT_BATCH_SIZE], r[SNL_EMIT_BATCH_SIZE];
+    double qx[SNL_EMIT_BATCH_SIZE], qy[SNL_EMIT_BATCH_SIZE], qr[SNL_EMIT_BATCH_SIZE];
+    snl_emit_scale(w, x, qx, xs, n, &offset.x, true);
+    snl_emit_scale(w, y, qy, ys, n, &offset.y, true);
+    snl_emit_scale(w, r, qr, rs, n, NULL, false);
+
+    const char *const tail_z = vt_str_z(tail);
+    const size_t tail_len = vt_str_len(tail);
+    for (size_t i = 0; i < n; i++) {
+        if (starts) starts[i] = vt_str_len(w->target) + w->len;
+        snl_writer_put_str_n(w, "<circle cx='", 12);
+        snl_writer_put_scaled(w, x[i], qx[i]);
+        snl_writer_put_str_n(w, "' cy='", 6);
+        snl_writer_put_scaled(w, y[i], qy[i]);
+        snl_writer_put_str_n(w, "' r='", 5);
+        snl_writer_put_scaled(w, r[i], qr[i]);
+        snl_writer_put_str_n(w, tail_z, tail_len);
+    }
+}
+
+void snl_emit_rectangles(
+    snl_writer_t *const w, 
+    const float *const xs, const float *const ys, const float *const widths, const float *const heights, const size_t n, 
+    const snl_point_t offset, const vt_str_t *const tail, size_t *const starts
+) {
+    VT_DEBUG_ASSERT(n <= SNL_EMIT_BATCH_SIZE, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // convert all numbers first
+    float x[SNL_EMIT_BATCH_SIZE], y[SNL_EMIT_BATCH_SIZE], width[SNL_EMIT_BATCH_SIZE], height[SNL_EMIT_BATCH_SIZE];
+    double qx[SNL_EMIT_BATCH_SIZE], qy[SNL_EMIT_BATCH_SIZE], qwidth[SNL_EMIT_BATCH_SIZE], qheight[SNL_EMIT_BATCH_SIZE];
+    snl_emit_scale(w, x, qx, xs, n, &offset.x, true);
+    snl_emit_scale(w, y, qy, ys, n, &offset.y, true);
+    snl_emit_scale(w, width, qwidth, widths, n, NULL, false);
+    snl_emit_scale(w, height, qheight, heights, n, NULL, false);
+
+    const char *const tail_z = vt_str_z(tail);
+    const size_t tail_len = vt_str_len(tail);
+    for (size_t i = 0; i < n; i++) {
+        if (starts) starts[i] = vt_str_len(w->target) + w->len;
+        snl_writer_put_str_n(w, "<rect x='", 9);
+        snl_writer_put_scaled(w, x[i], qx[i]);
+        snl_writer_put_str_n(w, "' y='", 5);
+        snl_writer_put_scaled(w, y[i], qy[i]);
+        snl_writer_put_str_n(w, "' width='", 9);
+        snl_writer_put_scaled(w, width[i], qwidth[i]);
+        snl_writer_put_str_n(w, "' height='", 10);
+        snl_writer_put_scaled(w, height[i], qheight[i]);
+        snl_writer_put_str_n(w, tail_z, tail_len);
+    }
+}
+
+void snl_emit_lines(
+    snl_writer_t *const w, 
+    const float *const x1s, const float *const y1s, const float *const x2s, const float *const y2s, const size_t n, 
+    const snl_point_t offset, const vt_str_t *const tail, size_t *const starts
+) {
+    VT_DEBUG_ASSERT(n <= SNL_EMIT_BATCH_SIZE, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // convert all numbers first
+    float x1[SNL_EMIT_BATCH_SIZE], y1[SNL_EMIT_BATCH_SIZE], x2[SNL_EMIT_BATCH_SIZE], y2[SNL_EMIT_BATCH_SIZE];
+    double qx1[SNL_EMIT_BATCH_SIZE], qy1[SNL_EMIT_BATCH_SIZE], qx2[SNL_EMIT_BATCH_SIZE], qy2[SNL_EMIT_BATCH_SIZE];
+    snl_emit_scale(w, x1, qx1, x1s, n, &offset.x, true);
+    snl_emit_scale(w, y1, qy1, y1s, n, &offset.y, true);
+    snl_emit_scale(w, x2, qx2, x2s, n, &offset.x, true);
+    snl_emit_scale(w, y2, qy2, y2s, n, &offset.y, true);
+
+    const char *const tail_z = vt_str_z(tail);
+    const size_t tail_len = vt_str_len(tail);
+    for (size_t i = 0; i < n; i++) {
+        if (starts) starts[i] = vt_str_len(w->target) + w->len;
+        snl_writer_put_str_n(w, "<line x1='", 10);
+        snl_writer_put_scaled(w, x1[i], qx1[i]);
+        snl_writer_put_str_n(w, "' y1='", 6);
+        snl_writer_put_scaled(w, y1[i], qy1[i]);
+        snl_writer_put_str_n(w, "' x2='", 6);
+        snl_writer_put_scaled(w, x2[i], qx2[i]);
+        snl_writer_put_str_n(w, "' y2='", 6);
+        snl_writer_put_scaled(w, y2[i], qy2[i]);
+        snl_writer_put_str_n(w, tail_z, tail_len);
+    }
+}
+
+void snl_emit_texts(
+    snl_writer_t *const w, 
+    const float *const xs, const float *const ys, const char *const *const texts, const size_t n, 
+    const snl_point_t offset, const vt_str_t *const tail, size_t *const starts
+) {
+    VT_DEBUG_ASSERT(n <= SNL_EMIT_BATCH_SIZE, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // convert all numbers first
+    float x[SNL_EMIT_BATCH_SIZE], y[SNL_EMIT_BATCH_SIZE];
+    double qx[SNL_EMIT_BATCH_SIZE], qy[SNL_EMIT_BATCH_SIZE];
+    snl_emit_scale(w, x, qx, xs, n, &offset.x, true);
+    snl_emit_scale(w, y, qy, ys, n, &offset.y, true);
+
+    const char *const tail_z = vt_str_z(tail);
+    const size_t tail_len = vt_str_len(tail);
+    for (size_t i = 0; i < n; i++) {
+        if (starts) starts[i] = vt_str_len(w->target) + w->len;
+        snl_writer_put_str_n(w, "<text x='", 9);
+        snl_writer_put_scaled(w, x[i], qx[i]);
+        snl_writer_put_str_n(w, "' y='", 5);
+        snl_writer_put_scaled(w, y[i], qy[i]);
+        snl_writer_put_str_n(w, tail_z, tail_len);
+        snl_writer_put_escaped(w, texts[i], strlen(texts[i]));
+        snl_writer_put_str_n(w, "</text>\n", 8);
+    }
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Write gradient color stops
+ * @param w writer instance
+ * @param stops color stops
+ * @param count number of stops
+ * @return None
+ */
+static void snl_emit_gradient_stops(snl_writer_t *const w, const snl_gradient_stop_t *const stops, const size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        snl_writer_put_str(w, "<stop offset='");
+        snl_writer_put_int(w, stops[i].offset);
+        snl_writer_put_str(w, "%' style='stop-color:");
+        snl_writer_put_color(w, stops[i].color);
+        if (!w->compact || stops[i].opacity != 1) {
+            snl_writer_put_str(w, ";stop-opacity:");
+            snl_writer_put_float(w, stops[i].opacity, SNL_PRECISION_GRADIENT);
+        }
+        snl_writer_put_str(w, "'/>");
+    }
+}
+
+/**
+ * @brief Close a shape element
+ * @param w writer instance
+ * @return None
+ */
+static void snl_emit_close(snl_writer_t *const w) {
+    snl_writer_put_str_n(w, "/>\n", 3);
+}
+
+/**
+ * @brief Close the preceding attribute and write the corner radius of a <rect> element
+ * @param w writer instance
+ * @param radius corner smoothness
+ * @return None
+ */
+static void snl_emit_corner_radius(snl_writer_t *const w, const float radius) {
+    // rx defaults to 0 and ry defaults to rx
+    if (w->compact) {
+        snl_writer_put_char(w, '\'');
+        if (radius == 0) return;
+        snl_writer_put_str(w, " rx='");
+        snl_writer_put_length(w, radius);
+        snl_writer_put_char(w, '\'');
+        return;
+    }
+
+    snl_writer_put_str(w, "' rx='");
+    snl_writer_put_length(w, radius);
+    snl_writer_put_str(w, "' ry='");
+    snl_writer_put_length(w, radius);
+    snl_writer_put_char(w, '\'');
+}
+
+/**
+ * @brief Write the inline style of a <line> element
+ * @param w writer instance
+ * @param appearance outlook
+ * @return None
+ */
+static void snl_emit_line_style(snl_writer_t *const w, const snl_appearance_t *const appearance) {
+    if (w->style_class != SNL_STYLE_CLASS_NONE) {
+        snl_writer_put_char(w, '\'');
+        snl_emit_class_ref(w);
+        if (!w->compact) snl_writer_put_char(w, ' ');
+        return;
+    }
+    if (w->inherited) {
+        snl_writer_put_char(w, '\'');
+        snl_emit_paint_changes(w, appearance, w->inherited, false, SNL_SYNTAX_ATTRIBUTE);
+        if (w->compact) {
+            snl_emit_filter_compact(w, appearance->filter, SNL_SYNTAX_ATTRIBUTE);
+            return;
+        }
+        snl_emit_property(w, SNL_SYNTAX_ATTRIBUTE, "filter");
+        snl_emit_url(w, appearance->filter ? appearance->filter : SNL_FILTER_DEFAULT);
+        snl_emit_property_end(w, SNL_SYNTAX_ATTRIBUTE);
+        snl_writer_put_char(w, ' ');
+        return;
+    }
+    if (w->compact) {
+        snl_writer_put_char(w, '\'');
+        snl_emit_stroke_compact(w, appearance, SNL_SYNTAX_ATTRIBUTE);
+        snl_emit_filter_compact(w, appearance->filter, SNL_SYNTAX_ATTRIBUTE);
+        return;
+    }
+
+    snl_writer_put_str(w, "' style='stroke:");
+    snl_emit_paint(w, appearance->stroke_color, appearance->gradient);
+    snl_writer_put_str(w, ";stroke-width:");
+    snl_writer_put_float(w, appearance->stroke_width, SNL_PRECISION_STYLE);
+    snl_writer_put_str(w, ";stroke-opacity:");
+    snl_writer_put_float(w, appearance->stroke_opacity, SNL_PRECISION_STYLE);
+    snl_writer_put_str(w, ";filter:");
+    snl_emit_url(w, appearance->filter ? appearance->filter : SNL_FILTER_DEFAULT);
+    snl_writer_put_str(w, "' ");
+}
+
+/**
+ * @brief Write everything of a <text> element between its position and its value
+ * @param w writer instance
+ * @param appearance outlook
+ * @param text_style text style settings
+ * @return None
+ */
+static void snl_emit_text_attributes(snl_writer_t *const w, const snl_appearance_t *const appearance, const snl_text_style_t *const text_style) {
+    // style
+    snl_writer_put_char(w, '\'');
+    if (w->style_class != SNL_STYLE_CLASS_NONE) {
+        snl_emit_class_ref(w);
+    } else {
+        snl_emit_text_properties(w, text_style, SNL_SYNTAX_ATTRIBUTE);
+        snl_emit_properties(w, appearance, NULL, SNL_SYNTAX_ATTRIBUTE);
+    }
+
+    // rotation
+    if (!w->compact || text_style->text_rotation != 0) {
+        snl_writer_put_str(w, " transform='rotate(");
+        snl_writer_put_float(w, text_style->text_rotation, SNL_PRECISION_STYLE);
+        snl_writer_put_str(w, ")'");
+    }
+    snl_writer_put_char(w, '>');
+}
+
+/**
+ * @brief Translate, snap and scale numbers for <snl_writer_put_scaled()>; branch-free so that the compiler can vectorize it
+ * @param w writer instance
+ * @param values translated values (keep the sign)
+ * @param scaled rounded |value| * 10^w->precision
+ * @param src input values (may be values)
+ * @param n number of values
+ * @param offset value to add or NULL
+ * @param snap values are coordinates, snapped to the writer grid; lengths are not
+ * @return None
+ * 
+ * @note relies on strict IEEE rounding, do not build with -ffast-math
+ */
+static void snl_emit_scale(const snl_writer_t *const w, float *const values, double *const scaled, const float *const src, const size_t n, const float *const offset, const bool snap) {
+    if (offset) {
+        const float dx = *offset;
+        for (size_t i = 0; i < n; i++) values[i] = src[i] + dx;
+    } else if (values != src) {
+        memcpy(values, src, n * sizeof(float));
+    }
+
+    if (snap && w->grid > 0) {
+        for (size_t i = 0; i < n; i++) values[i] = snl_writer_snap(w, values[i]);
+    }
+
+    const double unit = gi_pow10[w->precision];
+    for (size_t i = 0; i < n; i++) {
+        scaled[i] = (fabs((double)values[i]) * unit + SNL_FORMAT_ROUND_MAGIC) - SNL_FORMAT_ROUND_MAGIC;
+    }
+}
+
+/**
+ * @brief Round a coordinate to the nearest multiple of the writer grid
+ * @param w writer instance
+ * @param value number
+ * @return snapped number
+ */
+static float snl_writer_snap(const snl_writer_t *const w, const float value) {
+    return (float)(rint((double)value / (double)w->grid) * (double)w->grid);
+}
+
+/**
+ * @brief Write a number prepared by <snl_emit_scale()>, same output as <snl_writer_put_float()>
+ * @param w writer instance
+ * @param value translated value
+ * @param scaled rounded scaled magnitude
+ * @return None
+ */
+static void snl_writer_put_scaled(snl_writer_t *const w, const float value, const double scaled) {
+    // huge values, nan, inf
+    if (!(scaled < SNL_FORMAT_ROUND_MAGIC)) {
+        snl_writer_put_float(w, value, w->precision);
+        return;
+    }
+
+    if (w->len + SNL_FORMAT_NUMBER_MAX > SNL_WRITER_BUFFER_SIZE) snl_writer_flush(w);
+    char *const dst = w->buf + w->len;
+
+    // sign
+    size_t len = 0;
+    const uint64_t q = (uint64_t)scaled;
+    if (signbit(value) && !((w->trim || w->precision == 0) && q == 0)) dst[len++] = '-';
+
+    // default precision: two decimals from the digit pair table, trailing zeros dropped when trimming
+    if (w->precision == SNL_PRECISION_DEFAULT) {
+        len += snl_format_uint(dst + len, q / 100);
+        const size_t idx = (size_t)(q % 100) * 2;
+        if (!w->trim || idx != 0) {
+            dst[len++] = '.';
+            dst[len++] = gi_digit_pairs[idx];
+            if (!w->trim || gi_digit_pairs[idx + 1] != '0') dst[len++] = gi_digit_pairs[idx + 1];
+        }
+        w->len += len;
+        return;
+    }
+
+    // any other precision
+    const uint64_t p = (uint64_t)gi_pow10[w->precision];
+    len += snl_format_uint(dst + len, q / p);
+    if (w->precision > 0) {
+        uint64_t fpart = q % p;
+        dst[len] = '.';
+        for (int32_t i = w->precision; i > 0; i--) {
+            dst[len + i] = (char)('0' + fpart % 10);
+            fpart /= 10;
+        }
+        len += 1 + w->precision;
+        if (w->trim) {
+            while (dst[len - 1] == '0') len--;
+            if (dst[len - 1] == '.') len--;
+        }
+    }
+
+    w->len += len;
+}
+
+/**
+ * @brief Write a point as path data, choosing the shortest command
+ * @param w writer instance
+ * @param cursor path data encoder position
+ * @param point point
+ * @return None
+ */
+static void snl_emit_path_point(snl_writer_t *const w, snl_path_cursor_t *const cursor, snl_point_t point) {
+    if (w->grid > 0) point = SNL_POINT(snl_writer_snap(w, point.x), snl_writer_snap(w, point.y));
+
+    const double unit = gi_pow10[w->precision];
+    const double sx = (fabs((double)point.x) * unit + SNL_FORMAT_ROUND_MAGIC) - SNL_FORMAT_ROUND_MAGIC;
+    const double sy = (fabs((double)point.y) * unit + SNL_FORMAT_ROUND_MAGIC) - SNL_FORMAT_ROUND_MAGIC;
+
+    // huge values, nan, inf: written as they are, the next point cannot be relative to them
+    if (!(sx < SNL_FORMAT_ROUND_MAGIC) || !(sy < SNL_FORMAT_ROUND_MAGIC)) {
+        snl_writer_put_char(w, cursor->command == 0 ? 'M' : 'L');
+        snl_writer_put_float(w, point.x, w->precision);
+        snl_writer_put_char(w, ' ');
+        snl_writer_put_float(w, point.y, w->precision);
+        cursor->command = 'L';
+        cursor->dot = true;
+        cursor->exact = false;
+        return;
+    }
+
+    // integer coordinates in units of the precision, so relative steps add up exactly
+    const int64_t x = signbit(point.x) ? -(int64_t)sx : (int64_t)sx;
+    const int64_t y = signbit(point.y) ? -(int64_t)sy : (int64_t)sy;
+
+    // absolute candidate
+    char ax[SNL_FORMAT_NUMBER_MAX], ay[SNL_FORMAT_NUMBER_MAX];
+    const size_t ax_len = snl_format_fixed(ax, x, w->precision);
+    const size_t ay_len = snl_format_fixed(ay, y, w->precision);
+
+    // the first point, or one after a point that was not quantized
+    if (!cursor->exact) {
+        snl_path_command_put(w, cursor, cursor->command == 0 ? 'M' : 'L', ax, ax_len, ay, ay_len);
+        cursor->x = x;
+        cursor->y = y;
+        cursor->exact = true;
+        return;
+    }
+
+    // relative candidate
+    char rx[SNL_FORMAT_NUMBER_MAX], ry[SNL_FORMAT_NUMBER_MAX];
+    const size_t rx_len = snl_format_fixed(rx, x - cursor->x, w->precision);
+    const size_t ry_len = snl_format_fixed(ry, y - cursor->y, w->precision);
+
+    // horizontal, vertical or any other segment
+    if (y == cursor->y) {
+        const bool relative = snl_path_command_len(cursor, 'h', rx, rx_len, NULL, 0) < snl_path_command_len(cursor, 'H', ax, ax_len, NULL, 0);
+        snl_path_command_put(w, cursor, relative ? 'h' : 'H', relative ? rx : ax, relative ? rx_len : ax_len, NULL, 0);
+    } else if (x == cursor->x) {
+        const bool relative = snl_path_command_len(cursor, 'v', ry, ry_len, NULL, 0) < snl_path_command_len(cursor, 'V', ay, ay_len, NULL, 0);
+        snl_path_command_put(w, cursor, relative ? 'v' : 'V', relative ? ry : ay, relative ? ry_len : ay_len, NULL, 0);
+    } else if (snl_path_command_len(cursor, 'l', rx, rx_len, ry, ry_len) < snl_path_command_len(cursor, 'L', ax, ax_len, ay, ay_len)) {
+        snl_path_command_put(w, cursor, 'l', rx, rx_len, ry, ry_len);
+    } else {
+        snl_path_command_put(w, cursor, 'L', ax, ax_len, ay, ay_len);
+    }
+
+    cursor->x = x;
+    cursor->y = y;
+}
+
+/**
+ * @brief Count the chars a path command takes
+ * @param cursor path data encoder position
+ * @param command command letter
+ * @param a first number
+ * @param a_len first number length
+ * @param b second number or NULL
+ * @param b_len second number length
+ * @return number of chars
+ */
+static size_t snl_path_command_len(const snl_path_cursor_t *const cursor, const char command, const char *const a, const size_t a_len, const char *const b, const size_t b_len) {
+    // the letter can be left out if it repeats, but then the number may need a separator
+    size_t len = command == cursor->command ? snl_path_separated(cursor->dot, a) : 1;
+    len += a_len;
+    if (b) len += snl_path_separated(memchr(a, '.', a_len) != NULL, b) + b_len;
+
+    return len;
+}
+
+/**
+ * @brief Write a path command
+ * @param w writer instance
+ * @param cursor path data encoder position
+ * @param command command letter
+ * @param a first number
+ * @param a_len first number length
+ * @param b second number or NULL
+ * @param b_len second number length
+ * @return None
+ */
+static void snl_path_command_put(snl_writer_t *const w, snl_path_cursor_t *const cursor, const char command, const char *const a, const size_t a_len, const char *const b, const size_t b_len) {
+    // letter or separator
+    if (command != cursor->command) {
+        snl_writer_put_char(w, command);
+    } else if (snl_path_separated(cursor->dot, a)) {
+        snl_writer_put_char(w, ' ');
+    }
+    snl_writer_put_str_n(w, a, a_len);
+    cursor->dot = memchr(a, '.', a_len) != NULL;
+
+    // second coordinate
+    if (b) {
+        if (snl_path_separated(cursor->dot, b)) snl_writer_put_char(w, ' ');
+        snl_writer_put_str_n(w, b, b_len);
+        cursor->dot = memchr(b, '.', b_len) != NULL;
+    }
+
+    // more coordinates after a moveto are implicit linetos
+    cursor->command = command == 'M' ? 'L' : command;
+}
+
+/**
+ * @brief Check whether a number needs a space to be told apart from the previous one
+ * @param dot the previous number contains a decimal point
+ * @param number number
+ * @return bool
+ */
+static bool snl_path_separated(const bool dot, const char *const number) {
+    // "1-2" and "1.5.5" parse as two numbers
+    return !(number[0] == '-' || (number[0] == '.' && dot));
+}
+
+/**
+ * @brief Format a number given in units of the precision as short as possible: "1.5", ".25", "-.05", "3"
+ * @param dst output buffer (at least SNL_FORMAT_NUMBER_MAX chars)
+ * @param value number times 10^precision
+ * @param precision digits after the decimal point
+ * @return number of chars written
+ */
+static size_t snl_format_fixed(char *const dst, const int64_t value, const int32_t precision) {
+    size_t len = 0;
+    if (value < 0) dst[len++] = '-';
+
+    const uint64_t q = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    const uint64_t p = (uint64_t)gi_pow10[precision];
+    uint64_t fpart = q % p;
+
+    // integer part, without a leading zero
+    if (q >= p || fpart == 0) len += snl_format_uint(dst + len, q / p);
+    if (fpart == 0) return len;
+
+    // decimals without trailing zeros
+    int32_t digits = precision;
+    while (fpart % 10 == 0) {
+        fpart /= 10;
+        digits--;
+    }
+    dst[len] = '.';
+    for (int32_t i = digits; i > 0; i--) {
+        dst[len + i] = (char)('0' + fpart % 10);
+        fpart /= 10;
+    }
+
+    return len + 1 + digits;
+}
+
+/**
+ * @brief Drop trailing fractional zeros and the sign of zero from a formatted number
+ * @param dst formatted number
+ * @param len number of chars
+ * @return new number of chars
+ */
+static size_t snl_format_trim(char *const dst, size_t len) {
+    // "12.50" -> "12.5", "3.00" -> "3"
+    if (memchr(dst, '.', len) != NULL) {
+        while (dst[len - 1] == '0') len--;
+        if (dst[len - 1] == '.') len--;
+    }
+
+    // "-0" -> "0"
+    if (len == 2 && dst[0] == '-' && dst[1] == '0') {
+        dst[0] = '0';
+        len = 1;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Find the first character that needs escaping or utf-8 validation
+ * @param z string
+ * @param n string length
+ * @return length of the plain prefix
+ */
+static size_t snl_escape_scan(const char *const z, const size_t n) {
+    size_t i = 0;
+
+#ifdef SNL_ESCAPE_SSE2
+    // a signed compare against 0x20 catches control characters and all bytes >= 0x80 at once
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>'), amp = _mm_set1_epi8('&');
+    const __m128i apos = _mm_set1_epi8('\''), quot = _mm_set1_epi8('"');
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(z + i));
+        __m128i stop = _mm_cmplt_epi8(v, space);
+        stop = _mm_or_si128(stop, _mm_or_si128(_mm_cmpeq_epi8(v, lt), _mm_cmpeq_epi8(v, gt)));
+        stop = _mm_or_si128(stop, _mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_or_si128(_mm_cmpeq_epi8(v, apos), _mm_cmpeq_epi8(v, quot))));
+
+        const unsigned mask = (unsigned)_mm_movemask_epi8(stop);
+        if (mask != 0) {
+        #if defined(_MSC_VER)
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            return i + bit;
+        #else
+            return i + (size_t)__builtin_ctz(mask);
+        #endif
+        }
+    }
+#endif
+
+    // tail, or everything without sse2
+    while (i < n && !snl_escape_is_stop((unsigned char)z[i])) i++;
+
+    return i;
+}
+
+/**
+ * @brief Check whether a string value can be written into a css declaration as is
+ * @param z string
+ * @param n string length
+ * @return false if it holds anything but letters, digits, spaces, '-', '_', '.', ',', '#', '%' or non-ascii characters
+ */
+static bool snl_css_is_plain(const char *const z, const size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const unsigned char c = (unsigned char)z[i];
+        if (c >= 0x80 || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) continue;
+        if (c != ' ' && c != '-' && c != '_' && c != '.' && c != ',' && c != '#' && c != '%') return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check whether a byte ends a plain run of text
+ * @param c byte
+ * @return bool
+ */
+static bool snl_escape_is_stop(const unsigned char c) {
+    return c < 0x20 || c >= 0x80 || c == '<' || c == '>' || c == '&' || c == '\'' || c == '"';
+}
+
+/**
+ * @brief Measure a well-formed utf-8 sequence: no overlong forms, surrogates or code points above U+10FFFF
+ * @param z first byte (>= 0x80)
+ * @param n bytes available
+ * @return sequence length, or 0 if it is invalid
+ */
+static size_t snl_utf8_sequence(const unsigned char *const z, const size_t n) {
+    // length and the allowed range of the second byte
+    size_t len = 0;
+    unsigned char lo = 0x80, hi = 0xbf;
+    if (z[0] >= 0xc2 && z[0] <= 0xdf) {
+        len = 2;
+    } else if (z[0] >= 0xe0 && z[0] <= 0xef) {
+        len = 3;
+        if (z[0] == 0xe0) lo = 0xa0;
+        if (z[0] == 0xed) hi = 0x9f;
+    } else if (z[0] >= 0xf0 && z[0] <= 0xf4) {
+        len = 4;
+        if (z[0] == 0xf0) lo = 0x90;
+        if (z[0] == 0xf4) hi = 0x8f;
+    }
+    if (len == 0 || len > n) return 0;
+
+    // continuation bytes
+    if (z[1] < lo || z[1] > hi) return 0;
+    for (size_t i = 2; i < len; i++) {
+        if (z[i] < 0x80 || z[i] > 0xbf) return 0;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Write color as '#rgb' or '#rrggbb', ignoring alpha
+ * @param w writer instance
+ * @param color color
+ * @return None
+ */
+static void snl_writer_put_hex(snl_writer_t *const w, const struct SnailColor color) {
+    static const char digits[] = "0123456789abcdef";
+    char hex[7] = { '#' };
+
+    // short form if every channel repeats its digit
+    if ((color.r >> 4) == (color.r & 0xf) && (color.g >> 4) == (color.g & 0xf) && (color.b >> 4) == (color.b & 0xf)) {
+        hex[1] = digits[color.r & 0xf];
+        hex[2] = digits[color.g & 0xf];
+        hex[3] = digits[color.b & 0xf];
+        snl_writer_put_str_n(w, hex, 4);
+        return;
+    }
+
+    hex[1] = digits[color.r >> 4];
+    hex[2] = digits[color.r & 0xf];
+    hex[3] = digits[color.g >> 4];
+    hex[4] = digits[color.g & 0xf];
+    hex[5] = digits[color.b >> 4];
+    hex[6] = digits[color.b & 0xf];
+    snl_writer_put_str_n(w, hex, 7);
+}
+
+/**
+ * @brief Write a reference to a filter or gradient, following aliases of deduplicated definitions
+ * @param w writer instance
+ * @param id referenced id
+ * @return None
+ */
+static void snl_emit_url(snl_writer_t *const w, const char *const id) {
+    size_t len = strlen(id);
+    const char *const name = w->defs ? snl_defs_resolve(w->defs, id, &len) : id;
+    snl_writer_put_str_n(w, "url(#", 5);
+    snl_writer_put_escaped(w, name, len);
+    snl_writer_put_char(w, ')');
+}
+
+/**
+ * @brief Write a stroke or fill value: gradient reference, color or 'none'
+ * @param w writer instance
+ * @param color color
+ * @param gradient gradient name used instead of SNL_COLOR_NONE, or NULL
+ * @return None
+ */
+static void snl_emit_paint(snl_writer_t *const w, const struct SnailColor color, const char *const gradient) {
+    if (gradient && snl_color_is_none(color)) {
+        snl_emit_url(w, gradient);
+    } else if (w->compact && color.a == 0) {
+        snl_writer_put_str_n(w, "none", 4);
+    } else {
+        snl_writer_put_color(w, color);
+    }
+}
+
+/**
+ * @brief Open a style property
+ * @param w writer instance
+ * @param syntax attribute or css
+ * @param name property name
+ * @return None
+ */
+static void snl_emit_property(snl_writer_t *const w, const snl_syntax_t syntax, const char *const name) {
+    if (syntax == SNL_SYNTAX_ATTRIBUTE) {
+        snl_writer_put_char(w, ' ');
+        snl_writer_put_str(w, name);
+        snl_writer_put_str_n(w, "='", 2);
+    } else {
+        snl_writer_put_str(w, name);
+        snl_writer_put_char(w, ':');
+    }
+}
+
+/**
+ * @brief Close a style property
+ * @param w writer instance
+ * @param syntax attribute or css
+ * @return None
+ */
+static void snl_emit_property_end(snl_writer_t *const w, const snl_syntax_t syntax) {
+    snl_writer_put_char(w, syntax == SNL_SYNTAX_ATTRIBUTE ? '\'' : ';');
+}
+
+/**
+ * @brief Write stroke, fill and filter properties
+ * @param w writer instance
+ * @param appearance outlook
+ * @param fill_rule fill rule or NULL to omit it
+ * @param syntax attribute or css
+ * @return None
+ */
+static void snl_emit_properties(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule, const snl_syntax_t syntax) {
+    if (w->inherited) {
+        snl_emit_properties_inherited(w, appearance, fill_rule, syntax);
+        return;
+    }
+    if (w->compact) {
+        snl_emit_properties_compact(w, appearance, fill_rule, syntax);
+        return;
+    }
+
+    // stroke
+    snl_emit_property(w, syntax, "stroke");
+    snl_emit_paint(w, appearance->stroke_color, appearance->gradient);
+    snl_emit_property_end(w, syntax);
+    snl_emit_property(w, syntax, "stroke-width");
+    snl_writer_put_float(w, appearance->stroke_width, SNL_PRECISION_STYLE);
+    snl_emit_property_end(w, syntax);
+    snl_emit_property(w, syntax, "stroke-opacity");
+    snl_writer_put_float(w, appearance->stroke_opacity, SNL_PRECISION_STYLE);
+    snl_emit_property_end(w, syntax);
+
+    // fill
+    snl_emit_property(w, syntax, "fill");
+    snl_emit_paint(w, appearance->fill_color, appearance->gradient);
+    snl_emit_property_end(w, syntax);
+    snl_emit_property(w, syntax, "fill-opacity");
+    snl_writer_put_float(w, appearance->fill_opacity, SNL_PRECISION_STYLE);
+    snl_emit_property_end(w, syntax);
+    if (fill_rule) {
+        snl_emit_property(w, syntax, "fill-rule");
+        snl_writer_put_str(w, fill_rule);
+        snl_emit_property_end(w, syntax);
+    }
+
+    // filter
+    snl_emit_property(w, syntax, "filter");
+    snl_emit_url(w, appearance->filter ? appearance->filter : SNL_FILTER_DEFAULT);
+    snl_emit_property_end(w, syntax);
+}
+
+/**
+ * @brief Write stroke, fill and filter properties that differ from their SVG defaults
+ * @param w writer instance
+ * @param appearance outlook
+ * @param fill_rule fill rule or NULL to omit it
+ * @param syntax attribute or css
+ * @return None
+ */
+static void snl_emit_properties_compact(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule, const snl_syntax_t syntax) {
+    // stroke: defaults to none
+    snl_emit_stroke_compact(w, appearance, syntax);
+
+    // fill: defaults to opaque black
+    const struct SnailColor fill = appearance->fill_color;
+    const bool gradient = appearance->gradient && snl_color_is_none(fill);
+    const bool painted = (gradient || fill.a != 0) && appearance->fill_opacity != 0;
+    if (!painted || gradient || fill.r != 0 || fill.g != 0 || fill.b != 0) {
+        snl_emit_property(w, syntax, "fill");
+        if (painted) {
+            snl_emit_paint(w, fill, appearance->gradient);
+        } else {
+            snl_writer_put_str_n(w, "none", 4);
+        }
+        snl_emit_property_end(w, syntax);
+    }
+    if (painted && appearance->fill_opacity != 1) {
+        snl_emit_property(w, syntax, "fill-opacity");
+        snl_writer_put_float(w, appearance->fill_opacity, SNL_PRECISION_STYLE);
+        snl_emit_property_end(w, syntax);
+    }
+    if (fill_rule && strcmp(fill_rule, "nonzero") != 0) {
+        snl_emit_property(w, syntax, "fill-rule");
+        snl_writer_put_str(w, fill_rule);
+        snl_emit_property_end(w, syntax);
+    }
+
+    // filter
+    snl_emit_filter_compact(w, appearance->filter, syntax);
+}
+
+/**
+ * @brief Write the stroke and fill properties that differ from the inherited ones, then fill rule and filter
+ * @param w writer instance
+ * @param appearance outlook
+ * @param fill_rule fill rule or NULL to omit it
+ * @param syntax attribute or css
+ * @return None
+ */
+static void snl_emit_properties_inherited(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule, const snl_syntax_t syntax) {
+    snl_emit_paint_changes(w, appearance, w->inherited, true, syntax);
+
+    // groups never set the fill rule
+    if (fill_rule && (!w->compact || strcmp(fill_rule, "nonzero") != 0)) {
+        snl_emit_property(w, syntax, "fill-rule");
+        snl_writer_put_str(w, fill_rule);
+        snl_emit_property_end(w, syntax);
+    }
+
+    // filter
+    if (w->compact) {
+        snl_emit_filter_compact(w, appearance->filter, syntax);
+        return;
+    }
+    snl_emit_property(w, syntax, "filter");
+    snl_emit_url(w, appearance->filter ? appearance->filter : SNL_FILTER_DEFAULT);
+    snl_emit_property_end(w, syntax);
+}
+
+/**
+ * @brief Write the stroke and fill properties whose value differs from a base style
+ * @param w writer instance
+ * @param appearance outlook
+ * @param base style in effect, inherited or the svg defaults
+ * @param fill false to skip fill properties
+ * @param syntax attribute or css
+ * @return None
+ */
+static void snl_emit_paint_changes(snl_writer_t *const w, const snl_appearance_t *const appearance, const snl_appearance_t *const base, const bool fill, const snl_syntax_t syntax) {
+    // stroke
+    if (!snl_paint_eq(appearance->stroke_color, appearance->gradient, base->stroke_color, base->gradient)) {
+        snl_emit_property(w, syntax, "stroke");
+        snl_emit_paint(w, appearance->stroke_color, appearance->gradient);
+        snl_emit_property_end(w, syntax);
+    }
+    if (appearance->stroke_width != base->stroke_width) {
+        snl_emit_property(w, syntax, "stroke-width");
+        snl_writer_put_float(w, appearance->stroke_width, SNL_PRECISION_STYLE);
+        snl_emit_property_end(w, syntax);
+    }
+    if (appearance->stroke_opacity != base->stroke_opacity) {
+        snl_emit_property(w, syntax, "stroke-opacity");
+        snl_writer_put_float(w, appearance->stroke_opacity, SNL_PRECISION_STYLE);
+        snl_emit_property_end(w, syntax);
+    }
+    if (!fill) return;
+
+    // fill
+    if (!snl_paint_eq(appearance->fill_color, appearance->gradient, base->fill_color, base->gradient)) {
+        snl_emit_property(w, syntax, "fill");
+        snl_emit_paint(w, appearance->fill_color, appearance->gradient);
+        snl_emit_property_end(w, syntax);
+    }
+    if (appearance->fill_opacity != base->fill_opacity) {
+        snl_emit_property(w, syntax, "fill-opacity");
+        snl_writer_put_float(w, appearance->fill_opacity, SNL_PRECISION_STYLE);
+        snl_emit_property_end(w, syntax);
+    }
+}
+
+/**
+ * @brief Check whether two stroke or fill values are written the same, see <snl_emit_paint()>
+ * @param a color
+ * @param a_gradient gradient name used instead of SNL_COLOR_NONE, or NULL
+ * @param b color
+ * @param b_gradient gradient name used instead of SNL_COLOR_NONE, or NULL
+ * @return bool
+ */
+static bool snl_paint_eq(const struct SnailColor a, const char *const a_gradient, const struct SnailColor b, const char *const b_gradient) {
+    const bool a_url = a_gradient && snl_color_is_none(a);
+    const bool b_url = b_gradient && snl_color_is_none(b);
+    if (a_url || b_url) return a_url && b_url && strcmp(a_gradient, b_gradient) == 0;
+
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+/**
+ * @brief Write stroke properties that differ from their SVG defaults
+ * @param w writer instance
+ * @param appearance outlook
+ * @param syntax attribute or css
+ * @return None
+ */
+static void snl_emit_stroke_compact(snl_writer_t *const w, const snl_appearance_t *const appearance, const snl_syntax_t syntax) {
+    // nothing to draw: no color, zero width or fully transparent
+    const struct SnailColor stroke = appearance->stroke_color;
+    if (stroke.a == 0 && !(appearance->gradient && snl_color_is_none(stroke))) return;
+    if (appearance->stroke_width == 0 || appearance->stroke_opacity == 0) return;
+
+    snl_emit_property(w, syntax, "stroke");
+    snl_emit_paint(w, stroke, appearance->gradient);
+    snl_emit_property_end(w, syntax);
+    if (appearance->stroke_width != 1) {
+        snl_emit_property(w, syntax, "stroke-width");
+        snl_writer_put_float(w, appearance->stroke_width, SNL_PRECISION_STYLE);
+        snl_emit_property_end(w, syntax);
+    }
+    if (appearance->stroke_opacity != 1) {
+        snl_emit_property(w, syntax, "stroke-opacity");
+        snl_writer_put_float(w, appearance->stroke_opacity, SNL_PRECISION_STYLE);
+        snl_emit_property_end(w, syntax);
+    }
+}
+
+/**
+ * @brief Write the filter property unless no filter is set
+ * @param w writer instance
+ * @param filter filter name or NULL
+ * @param syntax attribute or css
+ * @return None
+ */
+static void snl_emit_filter_compact(snl_writer_t *const w, const char *const filter, const snl_syntax_t syntax) {
+    // the no-op default filter is not defined in the compact profile
+    if (filter == NULL || strcmp(filter, SNL_FILTER_DEFAULT) == 0) return;
+
+    snl_emit_property(w, syntax, "filter");
+    snl_emit_url(w, filter);
+    snl_emit_property_end(w, syntax);
+}
+
+/**
+ * @brief Write font properties; the compact profile skips 'normal' and empty values
+ * @param w writer instance
+ * @param text_style text style settings
+ * @param syntax attribute or css
+ * @return None
+ */
+static void snl_emit_text_properties(snl_writer_t *const w, const snl_text_style_t *const text_style, const snl_syntax_t syntax) {
+    snl_emit_property(w, syntax, "font-family");
+    snl_writer_put_escaped(w, text_style->font_family, strlen(text_style->font_family));
+    snl_emit_property_end(w, syntax);
+    snl_emit_property(w, syntax, "font-size");
+    snl_writer_put_float(w, text_style->font_size, SNL_PRECISION_STYLE);
+    if (syntax == SNL_SYNTAX_CSS) snl_writer_put_str_n(w, "px", 2);
+    snl_emit_property_end(w, syntax);
+    if (!w->compact || strcmp(text_style->font_weight, "normal") != 0) {
+        snl_emit_property(w, syntax, "font-weight");
+        snl_writer_put_escaped(w, text_style->font_weight, strlen(text_style->font_weight));
+        snl_emit_property_end(w, syntax);
+    }
+    if (!w->compact || strcmp(text_style->font_style, "normal") != 0) {
+        snl_emit_property(w, syntax, "font-style");
+        snl_writer_put_escaped(w, text_style->font_style, strlen(text_style->font_style));
+        snl_emit_property_end(w, syntax);
+    }
+
+    // an empty value is not valid css
+    const bool decorated = text_style->text_decoration[0] != '\0' && strcmp(text_style->text_decoration, "none") != 0;
+    if (decorated || (!w->compact && (syntax == SNL_SYNTAX_ATTRIBUTE || text_style->text_decoration[0] != '\0'))) {
+        snl_emit_property(w, syntax, "text-decoration");
+        snl_writer_put_escaped(w, text_style->text_decoration, strlen(text_style->text_decoration));
+        snl_emit_property_end(w, syntax);
+    }
+}
+
+/**
+ * @brief Write the class attribute chosen by <snl_emit_class()>
+ * @param w writer instance
+ * @return None
+ */
+static void snl_emit_class_ref(snl_writer_t *const w) {
+    snl_writer_put_str_n(w, " class='a", 9);
+    snl_writer_put_int(w, w->style_class);
+    snl_writer_put_char(w, '\'');
+}
+
+/**
+ * @brief Format an unsigned integer two digits at a time
+ * @param dst output buffer
+ * @param value number
+ * @return number of chars written
+ */
+static size_t snl_format_uint(char *const dst, uint64_t value) {
+    char tmp[24];
+    size_t pos = sizeof(tmp);
+
+    // two digits at a time
+    while (value >= 100) {
+        const size_t idx = (size_t)(value % 100) * 2;
+        value /= 100;
+        tmp[--pos] = gi_digit_pairs[idx + 1];
+        tmp[--pos] = gi_digit_pairs[idx];
+    }
+
+    // the remaining one or two digits
+    if (value >= 10) {
+        const size_t idx = (size_t)value * 2;
+        tmp[--pos] = gi_digit_pairs[idx + 1];
+        tmp[--pos] = gi_digit_pairs[idx];
+    } else {
+        tmp[--pos] = (char)('0' + value);
+    }
+
+    const size_t len = sizeof(tmp) - pos;
+    memcpy(dst, tmp + pos, len);
+
+    return len;
+}
+
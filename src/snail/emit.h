@@ -0,0 +1,650 @@
+#ifndef SNAIL_EMIT_H
+#define SNAIL_EMIT_H
+
+/** EMIT MODULE (internal)
+ *  - snl_writer_init
+ *  - snl_writer_flush
+ *  - snl_writer_put_char
+ *  - snl_writer_put_str_n
+ *  - snl_writer_put_str
+ *  - snl_writer_put_escaped
+ *  - snl_writer_put_float
+ *  - snl_writer_put_coord
+ *  - snl_writer_put_length
+ *  - snl_writer_put_int
+ *  - snl_writer_put_uint8
+ *  - snl_writer_put_rgba
+ *  - snl_writer_put_color
+ *  - snl_format_float
+ *  - snl_format_int
+ *  - snl_round_coord
+ *  - snl_emit_filter_blur
+ *  - snl_emit_filter_shadow
+ *  - snl_emit_gradient_linear
+ *  - snl_emit_gradient_radial
+ *  - snl_emit_appearance
+ *  - snl_emit_class
+ *  - snl_emit_style_sheet
+ *  - snl_emit_symbol
+ *  - snl_emit_use
+ *  - snl_emit_group_open
+ *  - snl_emit_group_close
+ *  - snl_emit_line
+ *  - snl_emit_circle
+ *  - snl_emit_ellipse
+ *  - snl_emit_rectangle
+ *  - snl_emit_points_begin
+ *  - snl_emit_point
+ *  - snl_emit_points
+ *  - snl_emit_points_end
+ *  - snl_emit_curve
+ *  - snl_emit_text
+ *  - snl_emit_tail_shape
+ *  - snl_emit_tail_rectangle
+ *  - snl_emit_tail_line
+ *  - snl_emit_tail_text
+ *  - snl_emit_circles
+ *  - snl_emit_rectangles
+ *  - snl_emit_lines
+ *  - snl_emit_texts
+*/
+
+#include <string.h>
+#include "snail/canvas.h"
+
+// writer scratch buffer size
+#define SNL_WRITER_BUFFER_SIZE 1024
+
+// max chars produced by a single number
+#define SNL_FORMAT_NUMBER_MAX 64
+
+// css classes
+struct SnailStyleSheet;
+
+// filter and gradient definitions
+struct SnailDefs;
+
+// buffered writer: formats into a local buffer, then appends it to the target in one go
+typedef struct SnailWriter {
+    vt_str_t *target;
+    size_t len;
+    bool compact; // SNL_CANVAS_COMPACT output profile
+    bool trim; // numbers lose their trailing zeros
+    int32_t precision; // digits after the decimal point of coordinates and lengths
+    float grid; // coordinates are rounded to multiples of grid, 0 to keep them
+    struct SnailStyleSheet *sheet; // SNL_CANVAS_CLASSES: shared classes, or NULL
+    uint32_t style_class; // class of the element being written, set by <snl_emit_class()>
+    bool class_block; // new classes are left to <snl_emit_style_sheet()> instead of being defined before their first use
+    bool css; // string values go into a css declaration
+    bool css_rejected; // set when a string value could break out of its css declaration
+    struct SnailDefs *defs; // resolves references to deduplicated definitions, or NULL
+    const snl_appearance_t *inherited; // style inherited from the enclosing <g>, or NULL for svg defaults
+    snl_appearance_t scope; // storage for inherited while records of groups are serialized
+    char buf[SNL_WRITER_BUFFER_SIZE];
+} snl_writer_t;
+
+// gradient color stop
+typedef struct SnailGradientStop {
+    int32_t offset;
+    struct SnailColor color;
+    float opacity;
+} snl_gradient_stop_t;
+
+// max number of gradient color stops
+#define SNL_GRADIENT_STOPS_MAX 3
+
+// gradient parameters, kept for rasterization
+typedef struct SnailGradient {
+    bool radial;
+    snl_point_t start, end; // linear gradient vector, percent of the bounding box
+    snl_gradient_stop_t stops[SNL_GRADIENT_STOPS_MAX];
+    size_t count;
+} snl_gradient_t;
+
+// default filter applied when none is specified
+#define SNL_FILTER_DEFAULT "__default__"
+
+// style precision: digits after the decimal point of stroke widths, opacities, font sizes and angles
+#define SNL_PRECISION_STYLE 2
+
+// gradient precision: digits after the decimal point
+#define SNL_PRECISION_GRADIENT 6
+
+// transform precision: digits after the decimal point of the linear part
+#define SNL_PRECISION_TRANSFORM 6
+
+// max number of elements per batch emit call
+#define SNL_EMIT_BATCH_SIZE 256
+
+/**
+ * @brief Initialize writer
+ *
+ * @param w writer instance
+ * @param target string to append to
+ * @return None
+ */
+extern void snl_writer_init(snl_writer_t *const w, vt_str_t *const target);
+
+/**
+ * @brief Append buffered data to the target
+ *
+ * @param w writer instance
+ * @return None
+ */
+extern void snl_writer_flush(snl_writer_t *const w);
+
+/**
+ * @brief Write string of length n
+ *
+ * @param w writer instance
+ * @param z string
+ * @param n string length
+ * @return None
+ */
+extern void snl_writer_put_str_n(snl_writer_t *const w, const char *const z, const size_t n);
+
+/**
+ * @brief Write text as xml character data or attribute value
+ *
+ * @param w writer instance
+ * @param z string
+ * @param n string length
+ * @return None
+ *
+ * @note '<', '>', '&' and both quotes become entities; invalid utf-8 and control characters other than
+ *       tab and newlines become U+FFFD; runs without any of these are copied in bulk
+ */
+extern void snl_writer_put_escaped(snl_writer_t *const w, const char *const z, const size_t n);
+
+/**
+ * @brief Write a fixed-precision number, same output as printf("%.*f", precision, value)
+ *        (trailing zeros trimmed if w->trim is set)
+ *
+ * @param w writer instance
+ * @param value number
+ * @param precision digits after the decimal point
+ * @return None
+ */
+extern void snl_writer_put_float(snl_writer_t *const w, const float value, const int32_t precision);
+
+/**
+ * @brief Write a coordinate with the precision and grid of the writer
+ *
+ * @param w writer instance
+ * @param value number
+ * @return None
+ */
+extern void snl_writer_put_coord(snl_writer_t *const w, const float value);
+
+/**
+ * @brief Write a length, e.g. a radius or a width, with the precision of the writer
+ *
+ * @param w writer instance
+ * @param value number
+ * @return None
+ *
+ * @note lengths are not snapped to the grid, so that small shapes do not collapse
+ */
+extern void snl_writer_put_length(snl_writer_t *const w, const float value);
+
+/**
+ * @brief Write an integer, same output as printf("%lld", value)
+ *
+ * @param w writer instance
+ * @param value number
+ * @return None
+ */
+extern void snl_writer_put_int(snl_writer_t *const w, const int64_t value);
+
+/**
+ * @brief Write an 8-bit unsigned integer using a lookup table
+ *
+ * @param w writer instance
+ * @param value number
+ * @return None
+ */
+extern void snl_writer_put_uint8(snl_writer_t *const w, const uint8_t value);
+
+/**
+ * @brief Write color as 'rgba(r, g, b, a)'
+ *
+ * @param w writer instance
+ * @param color color
+ * @return None
+ */
+extern void snl_writer_put_rgba(snl_writer_t *const w, const struct SnailColor color);
+
+/**
+ * @brief Write color as 'rgba(r, g, b, a)', or as '#rgb'/'#rrggbb' in the compact profile
+ *
+ * @param w writer instance
+ * @param color color
+ * @return None
+ * 
+ * @note rgba() alpha is clamped to 1, so any non-zero alpha already renders opaque and '#rrggbb' draws the same
+ */
+extern void snl_writer_put_color(snl_writer_t *const w, const struct SnailColor color);
+
+/**
+ * @brief Format a fixed-precision number, same output as snprintf("%.*f", precision, value)
+ *
+ * @param dst output buffer of at least SNL_FORMAT_NUMBER_MAX bytes
+ * @param value number
+ * @param precision digits after the decimal point ~[0; 9]
+ * @return number of chars written (no null terminator)
+ */
+extern size_t snl_format_float(char *const dst, const float value, const int32_t precision);
+
+/**
+ * @brief Format an integer
+ *
+ * @param dst output buffer of at least SNL_FORMAT_NUMBER_MAX bytes
+ * @param value number
+ * @return number of chars written (no null terminator)
+ */
+extern size_t snl_format_int(char *const dst, const int64_t value);
+
+/**
+ * @brief Value of a coordinate as written by <snl_writer_put_coord()>, or of a length with grid 0
+ *
+ * @param value number
+ * @param precision digits after the decimal point ~[0; 9]
+ * @param grid grid the number is snapped to, 0 for none
+ * @return written number
+ */
+extern double snl_round_coord(const float value, const int32_t precision, const float grid);
+
+/**
+ * @brief Write a blur filter definition
+ *
+ * @param w writer instance
+ * @param id filter name
+ * @param blurnessHorizontal amount
+ * @param blurnessVertical amount
+ * @param hard_edge keep alpha channel edges sharp
+ * @return None
+ */
+extern void snl_emit_filter_blur(snl_writer_t *const w, const char *const id, const int32_t blurnessHorizontal, const int32_t blurnessVertical, const bool hard_edge);
+
+/**
+ * @brief Write a shadow filter definition
+ *
+ * @param w writer instance
+ * @param id filter name
+ * @param offsetX amount
+ * @param offsetY amount
+ * @param blurness amount
+ * @param color_blend blend colors or not
+ * @return None
+ */
+extern void snl_emit_filter_shadow(
+    snl_writer_t *const w, 
+    const char *const id, 
+    const int32_t offsetX, 
+    const int32_t offsetY, 
+    const int32_t blurness, 
+    const bool color_blend
+);
+
+/**
+ * @brief Write a linear gradient definition
+ *
+ * @param w writer instance
+ * @param id gradient name
+ * @param start gradient vector start ~[0; 100]
+ * @param end gradient vector end ~[0; 100]
+ * @param stops color stops
+ * @param count number of stops
+ * @return None
+ */
+extern void snl_emit_gradient_linear(
+    snl_writer_t *const w, 
+    const char *const id, 
+    const snl_point_t start, 
+    const snl_point_t end, 
+    const snl_gradient_stop_t *const stops, 
+    const size_t count
+);
+
+/**
+ * @brief Write a radial gradient definition
+ *
+ * @param w writer instance
+ * @param id gradient name
+ * @param stops color stops
+ * @param count number of stops
+ * @return None
+ */
+extern void snl_emit_gradient_radial(snl_writer_t *const w, const char *const id, const snl_gradient_stop_t *const stops, const size_t count);
+
+/**
+ * @brief Write stroke, fill and filter attributes
+ *
+ * @param w writer instance
+ * @param appearance outlook
+ * @param fill_rule fill rule or NULL to omit it
+ * @return None
+ * 
+ * @note written right after the closing quote of the previous attribute
+ */
+extern void snl_emit_appearance(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule);
+
+/**
+ * @brief Choose the css class of the next element, defining it in a <style> element on first use
+ *
+ * @param w writer instance
+ * @param appearance outlook
+ * @param fill_rule fill rule or NULL to omit it
+ * @param text_style text style settings or NULL for shapes
+ * @return None
+ * 
+ * @note does nothing unless the writer has a style sheet; call it before the element is opened
+ */
+extern void snl_emit_class(snl_writer_t *const w, const snl_appearance_t *const appearance, const char *const fill_rule, const snl_text_style_t *const text_style);
+
+/**
+ * @brief Write all classes of a style sheet in a single <style> element
+ *
+ * @param w writer instance
+ * @param sheet style sheet instance
+ * @return None
+ */
+extern void snl_emit_style_sheet(snl_writer_t *const w, const struct SnailStyleSheet *const sheet);
+
+/**
+ * @brief Write a <symbol> definition
+ *
+ * @param w writer instance
+ * @param id symbol id
+ * @param content elements of the symbol
+ * @param len content length
+ * @return None
+ */
+extern void snl_emit_symbol(snl_writer_t *const w, const char *const id, const char *const content, const size_t len);
+
+/**
+ * @brief Write a <use> element placing a symbol
+ *
+ * @param w writer instance
+ * @param id symbol id
+ * @param pos position of the symbol origin
+ * @param scale scale factor
+ * @param rotation rotation in degrees
+ * @return None
+ */
+extern void snl_emit_use(snl_writer_t *const w, const char *const id, const snl_point_t pos, const float scale, const float rotation);
+
+/**
+ * @brief Open a <g> element
+ *
+ * @param w writer instance
+ * @param transform group transform
+ * @param appearance style inherited by the elements of the group, or NULL
+ * @return None
+ *
+ * @note only the properties differing from the ones inherited by the group itself are written
+ */
+extern void snl_emit_group_open(snl_writer_t *const w, const snl_transform_t *const transform, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Close a <g> element
+ *
+ * @param w writer instance
+ * @return None
+ */
+extern void snl_emit_group_close(snl_writer_t *const w);
+
+/**
+ * @brief Write a <line> element
+ *
+ * @param w writer instance
+ * @param start starting point of the line
+ * @param end ending point of the line
+ * @param appearance outlook
+ * @return None
+ */
+extern void snl_emit_line(snl_writer_t *const w, const snl_point_t start, const snl_point_t end, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Write a <circle> element
+ *
+ * @param w writer instance
+ * @param origin circle origin
+ * @param radius circle radius
+ * @param appearance outlook
+ * @return None
+ */
+extern void snl_emit_circle(snl_writer_t *const w, const snl_point_t origin, const float radius, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Write an <ellipse> element
+ *
+ * @param w writer instance
+ * @param origin ellipse origin
+ * @param radius along the x and y axis
+ * @param appearance outlook
+ * @return None
+ */
+extern void snl_emit_ellipse(snl_writer_t *const w, const snl_point_t origin, const snl_point_t radius, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Write a <rect> element
+ *
+ * @param w writer instance
+ * @param pos rectangle position
+ * @param size rectangle width and height
+ * @param radius corner smoothness
+ * @param appearance outlook
+ * @return None
+ */
+extern void snl_emit_rectangle(snl_writer_t *const w, const snl_point_t pos, const snl_point_t size, const float radius, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Open a point list element: <polygon> or <polyline>, or <path> when compact
+ *
+ * @param w writer instance
+ * @param closed polygon instead of polyline
+ * @param cursor path data encoder position (reset on return)
+ * @return None
+ */
+extern void snl_emit_points_begin(snl_writer_t *const w, const bool closed, snl_path_cursor_t *const cursor);
+
+/**
+ * @brief Write a single point of a point list
+ *
+ * @param w writer instance
+ * @param cursor path data encoder position
+ * @param point point
+ * @return None
+ *
+ * @note when compact, the point becomes the shortest of its absolute and relative path commands
+ */
+extern void snl_emit_point(snl_writer_t *const w, snl_path_cursor_t *const cursor, const snl_point_t point);
+
+/**
+ * @brief Write many points of a point list
+ *
+ * @param w writer instance
+ * @param cursor path data encoder position
+ * @param points points
+ * @param n number of points
+ * @param offset translation added to every point
+ * @return None
+ */
+extern void snl_emit_points(snl_writer_t *const w, snl_path_cursor_t *const cursor, const snl_point_t *const points, const size_t n, const snl_point_t offset);
+
+/**
+ * @brief Close a point list element
+ *
+ * @param w writer instance
+ * @param cursor path data encoder position
+ * @param appearance outlook
+ * @param fill_rule fill rule or NULL to omit it
+ * @return None
+ */
+extern void snl_emit_points_end(snl_writer_t *const w, const snl_path_cursor_t *const cursor, const snl_appearance_t *const appearance, const char *const fill_rule);
+
+/**
+ * @brief Write a quadratic curve as a <path> element
+ *
+ * @param w writer instance
+ * @param start starting point
+ * @param control control point relative to start
+ * @param delta end point relative to start
+ * @param appearance outlook
+ * @return None
+ */
+extern void snl_emit_curve(snl_writer_t *const w, const snl_point_t start, const snl_point_t control, const snl_point_t delta, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Write a <text> element
+ *
+ * @param w writer instance
+ * @param pos text position
+ * @param text text value
+ * @param appearance outlook
+ * @param text_style text style settings
+ * @return None
+ */
+extern void snl_emit_text(snl_writer_t *const w, const snl_point_t pos, const char *const text, const snl_appearance_t *const appearance, const snl_text_style_t *const text_style);
+
+/**
+ * @brief Write the attributes shared by a batch of <circle> elements, up to the closing tag
+ *
+ * @param w writer instance
+ * @param appearance outlook
+ * @return None
+ */
+extern void snl_emit_tail_shape(snl_writer_t *const w, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Write the attributes shared by a batch of <rect> elements, up to the closing tag
+ *
+ * @param w writer instance
+ * @param radius corner smoothness
+ * @param appearance outlook
+ * @return None
+ */
+extern void snl_emit_tail_rectangle(snl_writer_t *const w, const float radius, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Write the attributes shared by a batch of <line> elements, up to the closing tag
+ *
+ * @param w writer instance
+ * @param appearance outlook
+ * @return None
+ */
+extern void snl_emit_tail_line(snl_writer_t *const w, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Write the attributes shared by a batch of <text> elements, up to the text value
+ *
+ * @param w writer instance
+ * @param appearance outlook
+ * @param text_style text style settings
+ * @return None
+ */
+extern void snl_emit_tail_text(snl_writer_t *const w, const snl_appearance_t *const appearance, const snl_text_style_t *const text_style);
+
+/**
+ * @brief Write up to SNL_EMIT_BATCH_SIZE <circle> elements
+ *
+ * @param w writer instance
+ * @param xs origin x
+ * @param ys origin y
+ * @param rs radius
+ * @param n number of circles
+ * @param offset translation added to the origin
+ * @param tail from <snl_emit_tail_shape()>
+ * @param starts receives the target offset of each element, or NULL
+ * @return None
+ */
+extern void snl_emit_circles(
+    snl_writer_t *const w, 
+    const float *const xs, const float *const ys, const float *const rs, const size_t n, 
+    const snl_point_t offset, const vt_str_t *const tail, size_t *const starts
+);
+
+/**
+ * @brief Write up to SNL_EMIT_BATCH_SIZE <rect> elements
+ *
+ * @param w writer instance
+ * @param xs position x
+ * @param ys position y
+ * @param widths width
+ * @param heights height
+ * @param n number of rectangles
+ * @param offset translation added to the position
+ * @param tail from <snl_emit_tail_rectangle()>
+ * @param starts receives the target offset of each element, or NULL
+ * @return None
+ */
+extern void snl_emit_rectangles(
+    snl_writer_t *const w, 
+    const float *const xs, const float *const ys, const float *const widths, const float *const heights, const size_t n, 
+    const snl_point_t offset, const vt_str_t *const tail, size_t *const starts
+);
+
+/**
+ * @brief Write up to SNL_EMIT_BATCH_SIZE <line> elements
+ *
+ * @param w writer instance
+ * @param x1s start x
+ * @param y1s start y
+ * @param x2s end x
+ * @param y2s end y
+ * @param n number of lines
+ * @param offset translation added to both ends
+ * @param tail from <snl_emit_tail_line()>
+ * @param starts receives the target offset of each element, or NULL
+ * @return None
+ */
+extern void snl_emit_lines(
+    snl_writer_t *const w, 
+    const float *const x1s, const float *const y1s, const float *const x2s, const float *const y2s, const size_t n, 
+    const snl_point_t offset, const vt_str_t *const tail, size_t *const starts
+);
+
+/**
+ * @brief Write up to SNL_EMIT_BATCH_SIZE <text> elements
+ *
+ * @param w writer instance
+ * @param xs position x
+ * @param ys position y
+ * @param texts text values
+ * @param n number of labels
+ * @param offset translation added to the position
+ * @param tail from <snl_emit_tail_text()>
+ * @param starts receives the target offset of each element, or NULL
+ * @return None
+ */
+extern void snl_emit_texts(
+    snl_writer_t *const w, 
+    const float *const xs, const float *const ys, const char *const *const texts, const size_t n, 
+    const snl_point_t offset, const vt_str_t *const tail, size_t *const starts
+);
+
+/**
+ * @brief Check whether color is SNL_COLOR_NONE
+ */
+static inline bool snl_color_is_none(const struct SnailColor color) {
+    return color.r == 0 && color.g == 0 && color.b == 0 && color.a == 0;
+}
+
+/**
+ * @brief Write a single character
+ */
+static inline void snl_writer_put_char(snl_writer_t *const w, const char c) {
+    if (w->len == SNL_WRITER_BUFFER_SIZE) snl_writer_flush(w);
+    w->buf[w->len++] = c;
+}
+
+/**
+ * @brief Write a null-terminated string
+ */
+static inline void snl_writer_put_str(snl_writer_t *const w, const char *const z) {
+    snl_writer_put_str_n(w, z, strlen(z));
+}
+
+#endif // SNAIL_EMIT_H
+
@@ -0,0 +1,337 @@
+#include "index.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ranges shorter than this are sorted by insertion
+#define SNL_INDEX_INSERTION_SORT 32
+
+// depth-first search stack: a tree over 2^32 records has 8 levels, each adds at most SNL_INDEX_FANOUT - 1 entries
+#define SNL_INDEX_STACK (8 * SNL_INDEX_FANOUT)
+
+// sort buffers, reused between the levels of a build
+typedef struct SnailIndexSort {
+    snl_index_node_t *nodes;
+    uint32_t *keys;
+    uint32_t *tmp_keys;
+} snl_index_sort_t;
+
+static void snl_index_reserve(snl_index_t *const index, const size_t n);
+static void snl_index_pack(snl_index_t *const index, const size_t start, const size_t n, const snl_index_sort_t *const buffers);
+static void snl_index_sort(snl_index_node_t *const nodes, const size_t n, const bool by_y, const snl_index_sort_t *const buffers);
+static uint32_t snl_index_key(const snl_index_node_t *const node, const bool by_y);
+static bool snl_index_overlaps(const snl_index_node_t *const node, const float *const box, const float min_size);
+static void snl_index_hit(uint32_t **const hits, size_t *const capacity, size_t *const nhits, const uint32_t record);
+static int snl_index_compare_desc(const void *a, const void *b);
+
+snl_index_t *snl_index_create(void) {
+    snl_index_t *const index = calloc(1, sizeof(snl_index_t));
+    VT_ENFORCE(index != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    return index;
+}
+
+void snl_index_destroy(snl_index_t *const index) {
+    if (index == NULL) return;
+
+    free(index->nodes);
+    free(index->hits);
+    free(index);
+}
+
+void snl_index_build(snl_index_t *const index, const snl_display_list_t *const list) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(index != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    if (index->built && index->version == list->version) return;
+
+    // the records and every level above them
+    index->nnodes = 0;
+    snl_index_reserve(index, list->len + list->len / (SNL_INDEX_FANOUT - 1) + 16);
+
+    // boxes on the canvas, through the transforms of the enclosing groups
+    snl_transform_t *groups = NULL;
+    size_t ngroups = 0, groups_capacity = 0;
+    snl_transform_t transform = SNL_TRANSFORM_IDENTITY;
+    for (size_t i = 0; i < list->len; i++) {
+        if (list->kind[i] == SNL_RECORD_GROUP) {
+            // grow
+            if (ngroups == groups_capacity) {
+                groups_capacity = groups_capacity ? groups_capacity * 2 : 8;
+                groups = realloc(groups, groups_capacity * sizeof(snl_transform_t));
+                VT_ENFORCE(groups != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+            }
+            groups[ngroups++] = transform;
+            transform = snl_transform_multiply(transform, snl_display_list_get_transform(list, i));
+            continue;
+        }
+        if (list->kind[i] == SNL_RECORD_GROUP_END) {
+            if (ngroups) transform = groups[--ngroups];
+            continue;
+        }
+
+        float box[4];
+        if ((list->flags[i] & SNL_RECORD_FLAG_DEAD) || !snl_display_list_bounds(list, i, box)) continue;
+        if (ngroups) {
+            const snl_point_t corners[4] = {
+                snl_transform_apply(transform, SNL_POINT(box[0], box[1])), snl_transform_apply(transform, SNL_POINT(box[2], box[1])),
+                snl_transform_apply(transform, SNL_POINT(box[0], box[3])), snl_transform_apply(transform, SNL_POINT(box[2], box[3]))
+            };
+            box[0] = fminf(fminf(corners[0].x, corners[1].x), fminf(corners[2].x, corners[3].x));
+            box[1] = fminf(fminf(corners[0].y, corners[1].y), fminf(corners[2].y, corners[3].y));
+            box[2] = fmaxf(fmaxf(corners[0].x, corners[1].x), fmaxf(corners[2].x, corners[3].x));
+            box[3] = fmaxf(fmaxf(corners[0].y, corners[1].y), fmaxf(corners[2].y, corners[3].y));
+        }
+
+        // boxes with NaNs are never found
+        if (!(box[0] <= box[2] && box[1] <= box[3])) continue;
+        index->nodes[index->nnodes++] = (snl_index_node_t) { box[0], box[1], box[2], box[3], (uint32_t)i, 0 };
+    }
+    free(groups);
+
+    // sort buffers
+    const size_t n = index->nnodes;
+    snl_index_sort_t buffers = {
+        .nodes = malloc((n ? n : 1) * sizeof(snl_index_node_t)),
+        .keys = malloc((n ? n : 1) * sizeof(uint32_t)),
+        .tmp_keys = malloc((n ? n : 1) * sizeof(uint32_t))
+    };
+    VT_ENFORCE(buffers.nodes != NULL && buffers.keys != NULL && buffers.tmp_keys != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    // pack each level into the next one, up to the root
+    size_t start = 0, count = n;
+    while (count > 1) {
+        snl_index_pack(index, start, count, &buffers);
+        start += count;
+        count = index->nnodes - start;
+    }
+
+    // free
+    free(buffers.nodes);
+    free(buffers.keys);
+    free(buffers.tmp_keys);
+
+    index->version = list->version;
+    index->built = true;
+}
+
+size_t snl_index_query(snl_index_t *const index, const float *const box, size_t *const indices, const size_t max) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(index != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(box != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(max == 0 || indices != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // the last drawn, i.e. the topmost, first
+    const size_t nhits = snl_index_search(index, box, 0, &index->hits, &index->hits_capacity);
+    if (nhits > 1) qsort(index->hits, nhits, sizeof(uint32_t), snl_index_compare_desc);
+    for (size_t i = 0; i < nhits && i < max; i++) {
+        indices[i] = index->hits[i];
+    }
+
+    return nhits;
+}
+
+size_t snl_index_search(const snl_index_t *const index, const float *const box, const float min_size, uint32_t **const hits, size_t *const capacity) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(index != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(box != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(hits != NULL && capacity != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    if (index->nnodes == 0) return 0;
+
+    // depth-first from the root; a node is never smaller than its children, so small nodes are skipped whole
+    size_t nhits = 0;
+    uint32_t stack[SNL_INDEX_STACK];
+    size_t top = 0;
+    stack[top++] = (uint32_t)(index->nnodes - 1);
+    while (top > 0) {
+        const snl_index_node_t *const node = &index->nodes[stack[--top]];
+        if (!snl_index_overlaps(node, box, min_size)) continue;
+        if (node->count == 0) {
+            snl_index_hit(hits, capacity, &nhits, node->first);
+            continue;
+        }
+
+        for (uint32_t c = node->first; c < node->first + node->count; c++) {
+            const snl_index_node_t *const child = &index->nodes[c];
+            if (!snl_index_overlaps(child, box, min_size)) continue;
+            if (child->count == 0) {
+                snl_index_hit(hits, capacity, &nhits, child->first);
+            } else {
+                VT_DEBUG_ASSERT(top < SNL_INDEX_STACK, "%s\n", vt_status_to_str(VT_STATUS_ERROR_OUT_OF_BOUNDS_ACCESS));
+                stack[top++] = c;
+            }
+        }
+    }
+
+    return nhits;
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Make room for n nodes
+ * @param index index instance
+ * @param n number of nodes
+ * @return None
+ */
+static void snl_index_reserve(snl_index_t *const index, const size_t n) {
+    if (n <= index->capacity) return;
+
+    snl_index_node_t *const nodes = realloc(index->nodes, n * sizeof(snl_index_node_t));
+    VT_ENFORCE(nodes != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    index->nodes = nodes;
+    index->capacity = n;
+}
+
+/**
+ * @brief Sort a level into tiles and append the level above it
+ * @param index index instance
+ * @param start first node of the level
+ * @param n number of nodes in the level, > 1
+ * @param buffers sort buffers of at least n entries
+ * @return None
+ */
+static void snl_index_pack(snl_index_t *const index, const size_t start, const size_t n, const snl_index_sort_t *const buffers) {
+    // vertical slices of about sqrt(number of parents) parents each
+    const size_t parents = (n + SNL_INDEX_FANOUT - 1) / SNL_INDEX_FANOUT;
+    const size_t slices = (size_t)ceil(sqrt((double)parents));
+    const size_t slice_len = ((parents + slices - 1) / slices) * SNL_INDEX_FANOUT;
+
+    snl_index_node_t *const level = index->nodes + start;
+    snl_index_sort(level, n, false, buffers);
+    for (size_t s = 0; s < n; s += slice_len) {
+        snl_index_sort(level + s, n - s < slice_len ? n - s : slice_len, true, buffers);
+    }
+
+    // a parent per run of children; runs never cross a slice since slice_len is a multiple of the fanout
+    snl_index_reserve(index, index->nnodes + parents);
+    snl_index_node_t *const children = index->nodes + start;
+    for (size_t i = 0; i < n; i += SNL_INDEX_FANOUT) {
+        const size_t count = n - i < SNL_INDEX_FANOUT ? n - i : SNL_INDEX_FANOUT;
+        snl_index_node_t parent = { children[i].x0, children[i].y0, children[i].x1, children[i].y1, (uint32_t)(start + i), (uint32_t)count };
+        for (size_t c = i + 1; c < i + count; c++) {
+            parent.x0 = fminf(parent.x0, children[c].x0);
+            parent.y0 = fminf(parent.y0, children[c].y0);
+            parent.x1 = fmaxf(parent.x1, children[c].x1);
+            parent.y1 = fmaxf(parent.y1, children[c].y1);
+        }
+        index->nodes[index->nnodes++] = parent;
+    }
+}
+
+/**
+ * @brief Sort nodes by the center of their box, least significant byte first, skipping bytes all keys share
+ * @param nodes nodes
+ * @param n number of nodes
+ * @param by_y sort by center y instead of x
+ * @param buffers sort buffers of at least n entries
+ * @return None
+ */
+static void snl_index_sort(snl_index_node_t *const nodes, const size_t n, const bool by_y, const snl_index_sort_t *const buffers) {
+    uint32_t *keys = buffers->keys;
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = snl_index_key(&nodes[i], by_y);
+    }
+
+    // short ranges
+    if (n < SNL_INDEX_INSERTION_SORT) {
+        for (size_t i = 1; i < n; i++) {
+            const snl_index_node_t node = nodes[i];
+            const uint32_t key = keys[i];
+            size_t j = i;
+            for (; j > 0 && keys[j - 1] > key; j--) {
+                nodes[j] = nodes[j - 1];
+                keys[j] = keys[j - 1];
+            }
+            nodes[j] = node;
+            keys[j] = key;
+        }
+        return;
+    }
+
+    // stable counting passes, swapping between the nodes and the buffer
+    snl_index_node_t *src = nodes, *dst = buffers->nodes;
+    uint32_t *tmp_keys = buffers->tmp_keys;
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < n; i++) {
+            counts[(keys[i] >> shift) & 0xFF]++;
+        }
+        if (counts[(keys[0] >> shift) & 0xFF] == n) continue;
+
+        size_t offset = 0;
+        for (size_t b = 0; b < 256; b++) {
+            const size_t count = counts[b];
+            counts[b] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < n; i++) {
+            const size_t to = counts[(keys[i] >> shift) & 0xFF]++;
+            dst[to] = src[i];
+            tmp_keys[to] = keys[i];
+        }
+
+        snl_index_node_t *const nodes_swap = src; src = dst; dst = nodes_swap;
+        uint32_t *const keys_swap = keys; keys = tmp_keys; tmp_keys = keys_swap;
+    }
+    if (src != nodes) memcpy(nodes, src, n * sizeof(snl_index_node_t));
+}
+
+/**
+ * @brief Map the center of a node to an unsigned integer with the same order
+ * @param node tree node
+ * @param by_y use the center y instead of x
+ * @return sort key
+ */
+static uint32_t snl_index_key(const snl_index_node_t *const node, const bool by_y) {
+    const float center = by_y ? node->y0 * 0.5f + node->y1 * 0.5f : node->x0 * 0.5f + node->x1 * 0.5f;
+
+    uint32_t bits;
+    memcpy(&bits, &center, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+/**
+ * @brief Check whether a node overlaps a box and is large enough
+ * @param node tree node
+ * @param box x0, y0, x1, y1
+ * @param min_size smallest width or height
+ * @return bool
+ */
+static bool snl_index_overlaps(const snl_index_node_t *const node, const float *const box, const float min_size) {
+    return node->x0 <= box[2] && box[0] <= node->x1 && node->y0 <= box[3] && box[1] <= node->y1 &&
+        (min_size <= 0 || node->x1 - node->x0 >= min_size || node->y1 - node->y0 >= min_size);
+}
+
+/**
+ * @brief Add a record to the hits of a search
+ * @param hits record indices (grown as needed)
+ * @param capacity capacity of hits (updated)
+ * @param nhits number of hits so far (updated)
+ * @param record record index
+ * @return None
+ */
+static void snl_index_hit(uint32_t **const hits, size_t *const capacity, size_t *const nhits, const uint32_t record) {
+    // grow
+    if (*nhits == *capacity) {
+        const size_t grown = *capacity ? *capacity * 2 : 64;
+        uint32_t *const p = realloc(*hits, grown * sizeof(uint32_t));
+        VT_ENFORCE(p != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        *hits = p;
+        *capacity = grown;
+    }
+
+    (*hits)[(*nhits)++] = record;
+}
+
+/**
+ * @brief qsort() comparator of record indices in decreasing order
+ * @param a record index
+ * @param b record index
+ * @return int
+ */
+static int snl_index_compare_desc(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x < y) - (x > y);
+}
@@ -0,0 +1,96 @@
+#ifndef SNAIL_INDEX_H
+#define SNAIL_INDEX_H
+
+/** INDEX MODULE (internal)
+ *  - snl_index_create
+ *  - snl_index_destroy
+ *  - snl_index_build
+ *  - snl_index_query
+ *  - snl_index_search
+ *
+ * @note a packed R-tree over the boxes of the records, bulk-loaded with the sort-tile-recursive method:
+ *       the boxes are sorted into vertical slices by center x, each slice by center y, and runs of
+ *       SNL_INDEX_FANOUT boxes become the nodes of the next level, up to a single root
+*/
+
+#include "record.h"
+
+// children per node
+#define SNL_INDEX_FANOUT 16
+
+// tree node; the boxes of the records are the nodes of the lowest level
+typedef struct SnailIndexNode {
+    float x0, y0, x1, y1;
+    uint32_t first;     // first child in the level below, or the record index at the lowest level
+    uint32_t count;     // number of children, 0 at the lowest level
+} snl_index_node_t;
+
+// spatial index over a display list
+typedef struct SnailIndex {
+    // levels stored bottom-up, the root last
+    snl_index_node_t *nodes;
+    size_t nnodes;
+    size_t capacity;
+
+    // display list version the tree was built from
+    size_t version;
+    bool built;
+
+    // hits of the last query
+    uint32_t *hits;
+    size_t hits_capacity;
+} snl_index_t;
+
+/**
+ * @brief Create an empty index
+ *
+ * @return snl_index_t*
+ */
+extern snl_index_t *snl_index_create(void);
+
+/**
+ * @brief Release index memory
+ *
+ * @param index index instance
+ * @return None
+ */
+extern void snl_index_destroy(snl_index_t *const index);
+
+/**
+ * @brief Rebuild the tree from the records, unless it is up to date
+ *
+ * @param index index instance
+ * @param list display list instance
+ * @return None
+ *
+ * @note boxes come from <snl_display_list_bounds()>, mapped through the transforms of the enclosing groups;
+ *       removed records and records without a box are left out
+ */
+extern void snl_index_build(snl_index_t *const index, const snl_display_list_t *const list);
+
+/**
+ * @brief Find the records whose box overlaps a box
+ *
+ * @param index index instance
+ * @param box x0, y0, x1, y1; edges that touch count as overlapping
+ * @param indices record indices, the last drawn first (set on return)
+ * @param max capacity of indices
+ * @return number of records found, which may be more than max
+ */
+extern size_t snl_index_query(snl_index_t *const index, const float *const box, size_t *const indices, const size_t max);
+
+/**
+ * @brief Find the records whose box overlaps a box and is large enough, in no particular order
+ *
+ * @param index index instance
+ * @param box x0, y0, x1, y1; edges that touch count as overlapping
+ * @param min_size records whose box is narrower and lower than this are left out
+ * @param hits record indices (set on return, grown as needed)
+ * @param capacity capacity of hits (updated)
+ * @return number of records found
+ *
+ * @note the index is not modified, so that threads can search it at the same time
+ */
+extern size_t snl_index_search(const snl_index_t *const index, const float *const box, const float min_size, uint32_t **const hits, size_t *const capacity);
+
+#endif // SNAIL_INDEX_H
@@ -0,0 +1,137 @@
+#include "intern.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include "vita/container/str.h"
+
+// initial number of slots
+#define SNL_INTERN_INITIAL_CAPACITY 64
+
+static void snl_intern_grow(snl_intern_t *const t);
+
+void snl_intern_init(snl_intern_t *const t) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(t != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    *t = (snl_intern_t) {0};
+}
+
+void snl_intern_destroy(snl_intern_t *const t) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(t != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    free(t->indices);
+    free(t->hashes);
+    *t = (snl_intern_t) {0};
+}
+
+void snl_intern_clear(snl_intern_t *const t) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(t != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    if (t->capacity) memset(t->indices, 0, sizeof(uint32_t) * t->capacity);
+    t->count = 0;
+}
+
+uint32_t snl_intern_find(const snl_intern_t *const t, const uint32_t hash, snl_intern_eq_fn eq, const void *ctx, const void *key) {
+    if (t->count == 0) return SNL_INTERN_NONE;
+
+    // linear probing
+    const size_t mask = t->capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        const uint32_t slot = t->indices[i];
+        if (slot == 0) return SNL_INTERN_NONE;
+        if (t->hashes[i] == hash && eq(ctx, slot - 1, key)) return slot - 1;
+    }
+}
+
+void snl_intern_insert(snl_intern_t *const t, const uint32_t hash, const uint32_t index) {
+    // keep load factor below 1/2
+    if ((t->count + 1) * 2 > t->capacity) snl_intern_grow(t);
+
+    // find an empty slot
+    const size_t mask = t->capacity - 1;
+    size_t i = hash & mask;
+    while (t->indices[i] != 0) i = (i + 1) & mask;
+
+    t->indices[i] = index + 1;
+    t->hashes[i] = hash;
+    t->count++;
+}
+
+void snl_intern_remove(snl_intern_t *const t, const uint32_t hash, const uint32_t index) {
+    if (t->count == 0) return;
+
+    // find the slot
+    const size_t mask = t->capacity - 1;
+    size_t i = hash & mask;
+    while (t->indices[i] != index + 1) {
+        if (t->indices[i] == 0) return;
+        i = (i + 1) & mask;
+    }
+
+    // shift back entries that probed past the hole
+    for (size_t j = (i + 1) & mask; t->indices[j] != 0; j = (j + 1) & mask) {
+        const size_t home = t->hashes[j] & mask;
+        const bool reachable = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+        if (reachable) continue;
+
+        t->indices[i] = t->indices[j];
+        t->hashes[i] = t->hashes[j];
+        i = j;
+    }
+
+    t->indices[i] = 0;
+    t->count--;
+}
+
+uint32_t snl_hash_bytes(uint32_t hash, const void *const data, const size_t size) {
+    const uint8_t *const bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+uint32_t snl_hash_str(uint32_t hash, const char *const z) {
+    if (z == NULL) return snl_hash_bytes(hash, "\xff", 1);
+
+    // include the terminator so that "ab" + "c" != "a" + "bc"
+    return snl_hash_bytes(hash, z, strlen(z) + 1);
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Double the number of slots and reinsert all entries
+ * @param t table instance
+ * @return None
+ */
+static void snl_intern_grow(snl_intern_t *const t) {
+    const size_t old_capacity = t->capacity;
+    uint32_t *const old_indices = t->indices;
+    uint32_t *const old_hashes = t->hashes;
+
+    // allocate
+    t->capacity = old_capacity ? old_capacity * 2 : SNL_INTERN_INITIAL_CAPACITY;
+    t->indices = calloc(t->capacity, sizeof(uint32_t));
+    t->hashes = calloc(t->capacity, sizeof(uint32_t));
+    VT_ENFORCE(t->indices != NULL && t->hashes != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    // reinsert
+    const size_t mask = t->capacity - 1;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_indices[i] == 0) continue;
+
+        size_t j = old_hashes[i] & mask;
+        while (t->indices[j] != 0) j = (j + 1) & mask;
+        t->indices[j] = old_indices[i];
+        t->hashes[j] = old_hashes[i];
+    }
+
+    free(old_indices);
+    free(old_hashes);
+}
+
@@ -0,0 +1,112 @@
+#ifndef SNAIL_INTERN_H
+#define SNAIL_INTERN_H
+
+/** INTERN MODULE (internal)
+ *  - snl_intern_init
+ *  - snl_intern_destroy
+ *  - snl_intern_clear
+ *  - snl_intern_find
+ *  - snl_intern_insert
+ *  - snl_intern_remove
+ *  - snl_hash_bytes
+ *  - snl_hash_str
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// not found
+#define SNL_INTERN_NONE UINT32_MAX
+
+// compares the key against the item stored at index
+typedef bool (*snl_intern_eq_fn)(const void *ctx, const uint32_t index, const void *key);
+
+// open-addressing hash index over an item array owned by the caller
+typedef struct SnailIntern {
+    uint32_t *indices;  // item index + 1, 0 = empty slot
+    uint32_t *hashes;   // cached hash of the item in the slot
+    size_t capacity;    // power of 2
+    size_t count;
+} snl_intern_t;
+
+/**
+ * @brief Initialize an empty table
+ *
+ * @param t table instance
+ * @return None
+ */
+extern void snl_intern_init(snl_intern_t *const t);
+
+/**
+ * @brief Release table memory
+ *
+ * @param t table instance
+ * @return None
+ */
+extern void snl_intern_destroy(snl_intern_t *const t);
+
+/**
+ * @brief Remove all entries, keeping memory
+ *
+ * @param t table instance
+ * @return None
+ */
+extern void snl_intern_clear(snl_intern_t *const t);
+
+/**
+ * @brief Find an item by hash and key; performs no allocation
+ *
+ * @param t table instance
+ * @param hash key hash
+ * @param eq key comparison
+ * @param ctx comparison context (the item array owner)
+ * @param key lookup key
+ * @return item index or SNL_INTERN_NONE
+ */
+extern uint32_t snl_intern_find(const snl_intern_t *const t, const uint32_t hash, snl_intern_eq_fn eq, const void *ctx, const void *key);
+
+/**
+ * @brief Insert a new item index (the key must not be in the table yet)
+ *
+ * @param t table instance
+ * @param hash key hash
+ * @param index item index
+ * @return None
+ */
+extern void snl_intern_insert(snl_intern_t *const t, const uint32_t hash, const uint32_t index);
+
+/**
+ * @brief Remove an item index, keeping probe chains intact
+ *
+ * @param t table instance
+ * @param hash key hash
+ * @param index item index
+ * @return None
+ */
+extern void snl_intern_remove(snl_intern_t *const t, const uint32_t hash, const uint32_t index);
+
+/**
+ * @brief FNV-1a hash over a byte range
+ *
+ * @param hash running hash (start with SNL_HASH_SEED)
+ * @param data bytes
+ * @param size number of bytes
+ * @return updated hash
+ */
+extern uint32_t snl_hash_bytes(uint32_t hash, const void *const data, const size_t size);
+
+/**
+ * @brief FNV-1a hash over a string; NULL hashes differently from ""
+ *
+ * @param hash running hash (start with SNL_HASH_SEED)
+ * @param z string or NULL
+ * @return updated hash
+ */
+extern uint32_t snl_hash_str(uint32_t hash, const char *const z);
+
+// FNV-1a offset basis
+#define SNL_HASH_SEED 2166136261u
+
+#endif // SNAIL_INTERN_H
+
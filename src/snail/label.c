@@ -0,0 +1,387 @@
+#include "snail/label.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// empty cell or end of a cell list
+#define SNL_LABEL_NONE UINT32_MAX
+
+// the grid has at most this many cells per candidate
+#define SNL_LABEL_CELLS_PER_LABEL 4
+
+// candidate label
+struct SnailLabel {
+    snl_point_t pos;
+    float priority;
+    float width, ascent, descent;   // measured box
+    size_t text;                    // offset of the text in the pool
+    snl_appearance_t appearance;
+    snl_text_style_t text_style;
+};
+
+// candidate in placement order, with the geometry the collision test needs
+typedef struct SnailLabelOrder {
+    uint32_t key;                   // priority mapped to an unsigned integer, highest priority lowest
+    uint32_t index;
+    snl_point_t pos;
+    float width, ascent, descent;
+} snl_label_order_t;
+
+// placed box in a cell list; the box is stored in place to save an indirection per test
+typedef struct SnailLabelEntry {
+    float x0, y0, x1, y1;
+    uint32_t next;
+} snl_label_entry_t;
+
+// placed boxes bucketed in a uniform grid; a box is listed in every cell it overlaps
+typedef struct SnailLabelGrid {
+    float x, y;                     // top-left corner
+    float inv_width, inv_height;    // 1 / cell size
+    size_t cols, rows;
+    uint32_t *heads;                // first entry of each cell
+
+    // copies of the placed boxes in the lists of their cells
+    struct SnailLabelEntry *entries;
+    size_t nentries;
+    size_t capacity;
+
+    size_t placed;                  // number of placed boxes
+} snl_label_grid_t;
+
+// label box around its point for each SNL_LABEL_* position: x and y directions
+static const int8_t snl_label_anchors[9][2] = {
+    { 1, -1 }, { 1, 1 }, { -1, -1 }, { -1, 1 }, { 1, 0 }, { -1, 0 }, { 0, -1 }, { 0, 1 }, { 0, 0 }
+};
+
+static void snl_label_sort(snl_label_order_t *const order, const size_t n);
+static void snl_label_box(const snl_labels_t *const labels, const snl_label_order_t *const label, const size_t anchor, float *const box);
+static void snl_label_grid_init(snl_label_grid_t *const grid, const snl_labels_t *const labels, const snl_label_order_t *const order, const size_t n);
+static void snl_label_grid_free(snl_label_grid_t *const grid);
+static void snl_label_grid_range(const snl_label_grid_t *const grid, const float *const box, size_t *const range);
+static bool snl_label_grid_hits(const snl_label_grid_t *const grid, const float *const box);
+static void snl_label_grid_insert(snl_label_grid_t *const grid, const float *const box);
+
+snl_labels_t snl_labels_create(const snl_label_options_t options) {
+    VT_ENFORCE(isfinite(options.offset) && isfinite(options.padding), "Error: label offset and padding must be finite!\n");
+
+    snl_labels_t labels = { .options = options };
+    if (labels.options.anchors == 0) labels.options.anchors = SNL_LABEL_AROUND;
+
+    return labels;
+}
+
+void snl_labels_destroy(snl_labels_t *const labels) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(labels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    free(labels->labels);
+    free(labels->pool);
+    *labels = (snl_labels_t) { .options = labels->options };
+}
+
+void snl_labels_clear(snl_labels_t *const labels) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(labels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    labels->count = 0;
+    labels->pool_len = 0;
+}
+
+void snl_labels_add(
+    snl_labels_t *const labels, const snl_point_t pos, const char *const text, const float priority,
+    const snl_appearance_t appearance, const snl_text_style_t text_style
+) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(labels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(text != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(labels->count < SNL_LABEL_NONE, "Error: too many labels!\n");
+
+    // grow
+    if (labels->count == labels->capacity) {
+        const size_t capacity = labels->capacity ? labels->capacity * 2 : 256;
+        struct SnailLabel *const items = realloc(labels->labels, capacity * sizeof(struct SnailLabel));
+        VT_ENFORCE(items != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        labels->labels = items;
+        labels->capacity = capacity;
+    }
+
+    // copy the text
+    const size_t len = strlen(text);
+    if (labels->pool_len + len + 1 > labels->pool_capacity) {
+        size_t capacity = labels->pool_capacity ? labels->pool_capacity * 2 : 4096;
+        while (capacity < labels->pool_len + len + 1) capacity *= 2;
+        char *const pool = realloc(labels->pool, capacity);
+        VT_ENFORCE(pool != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        labels->pool = pool;
+        labels->pool_capacity = capacity;
+    }
+    memcpy(labels->pool + labels->pool_len, text, len + 1);
+
+    // measure
+    const snl_text_box_t box = snl_text_measure_n(text, len, text_style);
+    labels->labels[labels->count++] = (struct SnailLabel) {
+        .pos = pos,
+        .priority = priority,
+        .width = box.width,
+        .ascent = -box.y,
+        .descent = box.height + box.y,
+        .text = labels->pool_len,
+        .appearance = appearance,
+        .text_style = text_style
+    };
+    labels->pool_len += len + 1;
+}
+
+size_t snl_labels_place(snl_labels_t *const labels, snl_canvas_t *const canvas) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(labels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // placement order: highest priority first, then the order of adding
+    snl_label_order_t *const order = malloc((labels->count ? labels->count : 1) * sizeof(snl_label_order_t));
+    VT_ENFORCE(order != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    size_t n = 0;
+    for (size_t i = 0; i < labels->count; i++) {
+        const struct SnailLabel *const label = &labels->labels[i];
+        if (!isfinite(label->pos.x) || !isfinite(label->pos.y) || !isfinite(label->priority)) continue;
+
+        // flip the sign bit of positive floats and all bits of negative ones to order them as unsigned integers,
+        // then invert for the highest priority first; adding 0 turns -0 into +0
+        uint32_t key;
+        const float priority = label->priority + 0.0f;
+        memcpy(&key, &priority, sizeof(key));
+        key = ~(key & 0x80000000u ? ~key : key | 0x80000000u);
+        order[n++] = (snl_label_order_t) {
+            .key = key, .index = (uint32_t)i, .pos = label->pos, .width = label->width, .ascent = label->ascent, .descent = label->descent
+        };
+    }
+    snl_label_sort(order, n);
+
+    // place
+    const float padding = labels->options.padding;
+    snl_label_grid_t grid;
+    snl_label_grid_init(&grid, labels, order, n);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t anchor = 0; anchor < sizeof(snl_label_anchors) / sizeof(snl_label_anchors[0]); anchor++) {
+            if (!(labels->options.anchors & (1u << anchor))) continue;
+
+            // the padding is added to the candidate only, placed boxes keep their size
+            float box[4];
+            snl_label_box(labels, &order[i], anchor, box);
+            const float probe[4] = { box[0] - padding, box[1] - padding, box[2] + padding, box[3] + padding };
+            if (snl_label_grid_hits(&grid, probe)) continue;
+
+            const struct SnailLabel *const label = &labels->labels[order[i].index];
+            snl_label_grid_insert(&grid, box);
+            snl_canvas_render_text_styled(
+                canvas, (snl_point_t) { box[0], box[1] + label->ascent }, labels->pool + label->text, label->appearance, label->text_style
+            );
+            break;
+        }
+    }
+    const size_t placed = grid.placed;
+
+    free(order);
+    snl_label_grid_free(&grid);
+
+    return placed;
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Sort candidates by key, keeping the order of equal keys: a radix sort over the key bytes that differ
+ * @param order candidates
+ * @param n number of candidates
+ * @return None
+ */
+static void snl_label_sort(snl_label_order_t *const order, const size_t n) {
+    // histograms of the four key bytes
+    size_t counts[4][256] = {{0}};
+    for (size_t i = 0; i < n; i++) {
+        for (size_t b = 0; b < 4; b++) counts[b][(order[i].key >> (b * 8)) & 0xFF]++;
+    }
+
+    snl_label_order_t *tmp = malloc((n ? n : 1) * sizeof(snl_label_order_t));
+    VT_ENFORCE(tmp != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    snl_label_order_t *from = order, *to = tmp;
+    for (size_t b = 0; b < 4; b++) {
+        // all keys share this byte
+        if (n == 0 || counts[b][(order[0].key >> (b * 8)) & 0xFF] == n) continue;
+
+        size_t offset = 0;
+        for (size_t d = 0; d < 256; d++) {
+            const size_t count = counts[b][d];
+            counts[b][d] = offset;
+            offset += count;
+        }
+        for (size_t i = 0; i < n; i++) to[counts[b][(from[i].key >> (b * 8)) & 0xFF]++] = from[i];
+
+        snl_label_order_t *const swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from != order) memcpy(order, from, n * sizeof(snl_label_order_t));
+
+    free(tmp);
+}
+
+/**
+ * @brief Compute the box of a label at one of its anchor positions
+ * @param labels label layer instance
+ * @param label label
+ * @param anchor index of the SNL_LABEL_* position
+ * @param box x0, y0, x1, y1 (set on return)
+ * @return None
+ */
+static void snl_label_box(const snl_labels_t *const labels, const snl_label_order_t *const label, const size_t anchor, float *const box) {
+    const float offset = labels->options.offset;
+    const float height = label->ascent + label->descent;
+    const int8_t dx = snl_label_anchors[anchor][0];
+    const int8_t dy = snl_label_anchors[anchor][1];
+
+    box[0] = dx > 0 ? label->pos.x + offset : dx < 0 ? label->pos.x - offset - label->width : label->pos.x - label->width / 2;
+    box[1] = dy > 0 ? label->pos.y + offset : dy < 0 ? label->pos.y - offset - height : label->pos.y - height / 2;
+    box[2] = box[0] + label->width;
+    box[3] = box[1] + height;
+}
+
+/**
+ * @brief Size an empty grid to cover every position of the candidates, with cells of the average label size
+ * @param grid grid instance (set on return)
+ * @param labels label layer instance
+ * @param order candidates to place
+ * @param n number of candidates
+ * @return None
+ */
+static void snl_label_grid_init(snl_label_grid_t *const grid, const snl_labels_t *const labels, const snl_label_order_t *const order, const size_t n) {
+    *grid = (snl_label_grid_t) {0};
+
+    // bounds and average size
+    const float reach = fabsf(labels->options.offset) + fabsf(labels->options.padding);
+    float x0 = INFINITY, y0 = INFINITY, x1 = -INFINITY, y1 = -INFINITY;
+    double width = 0, height = 0;
+    for (size_t i = 0; i < n; i++) {
+        const snl_label_order_t *const label = &order[i];
+        const float w = label->width + reach, h = label->ascent + label->descent + reach;
+        if (label->pos.x - w < x0) x0 = label->pos.x - w;
+        if (label->pos.y - h < y0) y0 = label->pos.y - h;
+        if (label->pos.x + w > x1) x1 = label->pos.x + w;
+        if (label->pos.y + h > y1) y1 = label->pos.y + h;
+        width += label->width;
+        height += label->ascent + label->descent;
+    }
+    if (n == 0) x0 = y0 = x1 = y1 = 0;
+
+    // cells of the average label size, doubled until the grid has at most a few cells per candidate
+    double cell_width = n ? width / (double)n + labels->options.padding : 1;
+    double cell_height = n ? height / (double)n + labels->options.padding : 1;
+    if (!(cell_width > 0)) cell_width = cell_height > 0 ? cell_height : 1;
+    if (!(cell_height > 0)) cell_height = cell_width;
+    double cols = floor((x1 - x0) / cell_width) + 1, rows = floor((y1 - y0) / cell_height) + 1;
+    while (cols * rows > (double)(SNL_LABEL_CELLS_PER_LABEL * n + 64)) {
+        cell_width *= 2;
+        cell_height *= 2;
+        cols = floor((x1 - x0) / cell_width) + 1;
+        rows = floor((y1 - y0) / cell_height) + 1;
+    }
+
+    grid->x = x0;
+    grid->y = y0;
+    grid->inv_width = (float)(1 / cell_width);
+    grid->inv_height = (float)(1 / cell_height);
+    grid->cols = (size_t)cols;
+    grid->rows = (size_t)rows;
+
+    // allocate
+    grid->heads = malloc(grid->cols * grid->rows * sizeof(uint32_t));
+    VT_ENFORCE(grid->heads != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    memset(grid->heads, 0xFF, grid->cols * grid->rows * sizeof(uint32_t));
+}
+
+/**
+ * @brief Release grid memory
+ * @param grid grid instance
+ * @return None
+ */
+static void snl_label_grid_free(snl_label_grid_t *const grid) {
+    free(grid->heads);
+    free(grid->entries);
+}
+
+/**
+ * @brief Find the cells a box overlaps
+ * @param grid grid instance
+ * @param box x0, y0, x1, y1
+ * @param range first column, first row, last column, last row (set on return)
+ * @return None
+ */
+static void snl_label_grid_range(const snl_label_grid_t *const grid, const float *const box, size_t *const range) {
+    const float cx0 = (box[0] - grid->x) * grid->inv_width, cy0 = (box[1] - grid->y) * grid->inv_height;
+    const float cx1 = (box[2] - grid->x) * grid->inv_width, cy1 = (box[3] - grid->y) * grid->inv_height;
+
+    range[0] = cx0 > 0 ? (size_t)cx0 : 0;
+    range[1] = cy0 > 0 ? (size_t)cy0 : 0;
+    range[2] = cx1 > 0 ? (size_t)cx1 : 0;
+    range[3] = cy1 > 0 ? (size_t)cy1 : 0;
+    if (range[0] >= grid->cols) range[0] = grid->cols - 1;
+    if (range[1] >= grid->rows) range[1] = grid->rows - 1;
+    if (range[2] >= grid->cols) range[2] = grid->cols - 1;
+    if (range[3] >= grid->rows) range[3] = grid->rows - 1;
+}
+
+/**
+ * @brief Check whether a box overlaps a placed box
+ * @param grid grid instance
+ * @param box x0, y0, x1, y1
+ * @return bool
+ */
+static bool snl_label_grid_hits(const snl_label_grid_t *const grid, const float *const box) {
+    size_t range[4];
+    snl_label_grid_range(grid, box, range);
+    for (size_t row = range[1]; row <= range[3]; row++) {
+        for (size_t col = range[0]; col <= range[2]; col++) {
+            for (uint32_t e = grid->heads[row * grid->cols + col]; e != SNL_LABEL_NONE; e = grid->entries[e].next) {
+                const snl_label_entry_t *const b = &grid->entries[e];
+                if (box[0] < b->x1 && b->x0 < box[2] && box[1] < b->y1 && b->y0 < box[3]) return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Add a placed box to the cells it overlaps
+ * @param grid grid instance
+ * @param box x0, y0, x1, y1
+ * @return None
+ */
+static void snl_label_grid_insert(snl_label_grid_t *const grid, const float *const box) {
+    grid->placed++;
+
+    size_t range[4];
+    snl_label_grid_range(grid, box, range);
+    const size_t count = (range[2] - range[0] + 1) * (range[3] - range[1] + 1);
+
+    // grow
+    if (grid->nentries + count > grid->capacity) {
+        size_t capacity = grid->capacity ? grid->capacity * 2 : 1024;
+        while (capacity < grid->nentries + count) capacity *= 2;
+        VT_ENFORCE(capacity <= SNL_LABEL_NONE, "Error: too many labels!\n");
+        snl_label_entry_t *const entries = realloc(grid->entries, capacity * sizeof(snl_label_entry_t));
+        VT_ENFORCE(entries != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        grid->entries = entries;
+        grid->capacity = capacity;
+    }
+
+    for (size_t row = range[1]; row <= range[3]; row++) {
+        for (size_t col = range[0]; col <= range[2]; col++) {
+            const uint32_t e = (uint32_t)grid->nentries++;
+            grid->entries[e] = (snl_label_entry_t) { box[0], box[1], box[2], box[3], grid->heads[row * grid->cols + col] };
+            grid->heads[row * grid->cols + col] = e;
+        }
+    }
+}
+
@@ -0,0 +1,1426 @@
+#include "load.h"
+#include "xml.h"
+#include "crc.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// initial values of the stroke and fill properties, which the compact profile leaves out
+static const snl_appearance_t gi_load_svg_defaults = { 1, 1, { 0, 0, 0, 0 }, 1, { 0, 0, 0, 255 }, NULL, NULL };
+
+// geometry attributes of the element being rebuilt
+typedef enum SnailLoadAttribute {
+    SNL_LOAD_X, SNL_LOAD_Y, SNL_LOAD_WIDTH, SNL_LOAD_HEIGHT,
+    SNL_LOAD_CX, SNL_LOAD_CY, SNL_LOAD_R, SNL_LOAD_RX, SNL_LOAD_RY,
+    SNL_LOAD_X1, SNL_LOAD_Y1, SNL_LOAD_X2, SNL_LOAD_Y2,
+    SNL_LOAD_POINTS, SNL_LOAD_D, SNL_LOAD_TRANSFORM, SNL_LOAD_HREF,
+    SNL_LOAD_ATTRIBUTES
+} snl_load_attribute_t;
+
+static const char *const gi_load_attributes[SNL_LOAD_ATTRIBUTES] = {
+    "x", "y", "width", "height",
+    "cx", "cy", "r", "rx", "ry",
+    "x1", "y1", "x2", "y2",
+    "points", "d", "transform", "xlink:href"
+};
+
+// transform attribute: the translate(), rotate() and scale() parts as written, and all parts combined
+typedef struct SnailLoadTransform {
+    snl_transform_t matrix;
+    snl_point_t translate;
+    float rotate;
+    float scale;
+} snl_load_transform_t;
+
+// state of <snl_load_replay()>
+typedef struct SnailLoadReplay {
+    snl_canvas_t *canvas;
+    const char *filename;
+    snl_xml_reader_t reader;
+
+    // declarations of the classes .aN of the <style> elements, back to back
+    vt_str_t *classes;
+    size_t *class_offsets;  // SIZE_MAX for a class that is not defined
+    size_t *class_lengths;
+    size_t nclasses;
+
+    // style inherited inside the open groups and symbols; the gradient names are owned copies
+    snl_appearance_t *scopes;
+    size_t nscopes;
+    size_t scopes_capacity;
+
+    // element being rebuilt
+    const char *attributes[SNL_LOAD_ATTRIBUTES];
+    size_t attribute_lengths[SNL_LOAD_ATTRIBUTES];
+    snl_appearance_t appearance;
+    snl_text_style_t text_style;
+    const char *fill_rule;
+    bool styled;            // a stroke, fill or filter property is set
+    vt_str_t *filter;
+    vt_str_t *gradient;
+    vt_str_t *font_family;
+    vt_str_t *font_weight;
+    vt_str_t *font_style;
+    vt_str_t *text_decoration;
+    vt_str_t *value;        // unescaped id or character data
+    vt_str_t *text;         // text content
+    snl_point_t *points;
+    size_t points_capacity;
+} snl_load_replay_t;
+
+static void snl_load_map(snl_load_t *const load, const char *const filename);
+static vt_str_t *snl_load_tmp_name(const char *const filename);
+static void snl_load_scan(snl_load_t *const load, snl_defs_t *const defs, const char *const data, const size_t len, const char *const filename, const bool partial);
+static void snl_load_find_end(snl_load_t *const load, FILE *const fp);
+static void snl_load_recover(const char *const filename, const char *const journal);
+static bool snl_load_write_at(const char *const filename, const size_t offset, const char *const data, const size_t len);
+static bool snl_load_sync_file(FILE *const fp);
+static void snl_load_sync_dir(const char *const filename);
+static void snl_load_size(snl_load_t *const load, const snl_xml_token_t *const token);
+static bool snl_load_is_def(const snl_xml_token_t *const token);
+static void snl_load_define(snl_defs_t *const defs, vt_str_t *const id, const snl_xml_token_t *const open, const char *const end);
+static float snl_load_number(const char *const value, const size_t len, const char **const next);
+static void snl_load_replay_element(snl_load_replay_t *const rep, const snl_xml_token_t *const token);
+static void snl_load_replay_close(snl_load_replay_t *const rep, const snl_xml_token_t *const token);
+static void snl_load_replay_expect(const snl_load_replay_t *const rep, const snl_xml_token_t *const token, const bool cond);
+static void snl_load_replay_skip(snl_load_replay_t *const rep);
+static void snl_load_replay_style(snl_load_replay_t *const rep, const snl_xml_token_t *const token);
+static void snl_load_replay_filter(snl_load_replay_t *const rep, const snl_xml_token_t *const token);
+static void snl_load_replay_gradient(snl_load_replay_t *const rep, const snl_xml_token_t *const token);
+static void snl_load_replay_text(snl_load_replay_t *const rep, const snl_xml_token_t *const token);
+static void snl_load_replay_path(snl_load_replay_t *const rep, const snl_xml_token_t *const token);
+static void snl_load_replay_attributes(snl_load_replay_t *const rep, const snl_xml_token_t *const token);
+static void snl_load_replay_property(
+    snl_load_replay_t *const rep, const snl_xml_token_t *const token,
+    const char *const name, const size_t name_len, const char *const value, const size_t len
+);
+static struct SnailColor snl_load_replay_color(const snl_load_replay_t *const rep, const snl_xml_token_t *const token, const char *const value, const size_t len);
+static snl_load_transform_t snl_load_replay_transform(const snl_load_replay_t *const rep);
+static float snl_load_replay_number(const snl_load_replay_t *const rep, const snl_load_attribute_t attribute);
+static void snl_load_replay_point(snl_load_replay_t *const rep, const size_t index, const double x, const double y);
+static void snl_load_replay_id(snl_load_replay_t *const rep, const snl_xml_token_t *const token, const char *const name);
+static void snl_load_replay_push(snl_load_replay_t *const rep, const snl_appearance_t *const appearance);
+static void snl_load_replay_pop(snl_load_replay_t *const rep);
+static bool snl_load_next_declaration(const char **const p, const char *const end, const char **const name, size_t *const name_len, const char **const value, size_t *const value_len);
+static size_t snl_load_numbers(const char **const p, const char *const end, double *const numbers, const size_t n);
+static void snl_load_unescape_url(vt_str_t *const out, const char *const value, const size_t len);
+static bool snl_load_name_is(const char *const name, const size_t len, const char *const z);
+static const char *snl_load_find(const char *from, const char *const end, const char *const pattern);
+
+snl_load_t *snl_load_open(const char *const filename, snl_defs_t *const defs) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    snl_load_t *const load = calloc(1, sizeof(snl_load_t));
+    VT_ENFORCE(load != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    // complete an append that was interrupted
+    vt_str_t *const journal = vt_str_create_capacity(strlen(filename) + 16, NULL);
+    vt_str_appendf(journal, "%s.journal", filename);
+    snl_load_recover(filename, vt_str_z(journal));
+    vt_str_destroy(journal);
+
+    snl_load_map(load, filename);
+    snl_load_scan(load, defs, load->data, load->len, filename, false);
+
+    return load;
+}
+
+snl_load_t *snl_load_open_tail(const char *const filename, snl_defs_t *const defs) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    snl_load_t *const load = calloc(1, sizeof(snl_load_t));
+    VT_ENFORCE(load != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    load->filename = vt_str_create_capacity(strlen(filename) + 1, NULL);
+    load->journal = vt_str_create_capacity(strlen(filename) + 16, NULL);
+    vt_str_append(load->filename, filename);
+    vt_str_appendf(load->journal, "%s.journal", filename);
+
+    // complete an append that was interrupted
+    snl_load_recover(filename, vt_str_z(load->journal));
+
+    // only the head and the end of the file are read
+    FILE *const fp = fopen(filename, "rb");
+    VT_ENFORCE(fp != NULL, "Error: failed to open '%s'!\n", filename);
+    char head[SNL_LOAD_PEEK_SIZE];
+    const size_t head_len = fread(head, 1, sizeof(head), fp);
+    snl_load_scan(load, defs, head, head_len, filename, true);
+    snl_load_find_end(load, fp);
+    fclose(fp);
+    VT_ENFORCE(load->body_len != SIZE_MAX, "Error: '%s' does not end with </svg>!\n", filename);
+
+    return load;
+}
+
+void snl_load_close(snl_load_t *const load) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(load != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    if (load->filename) {
+        vt_str_destroy(load->filename);
+        vt_str_destroy(load->journal);
+        free(load);
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(load->data);
+    CloseHandle(load->mapping);
+    CloseHandle(load->file);
+#else
+    munmap((void*)load->data, load->len);
+#endif
+
+    free(load);
+}
+
+FILE *snl_load_save_begin(const snl_load_t *const load, const char *const filename) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(load != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(load->data != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // write next to the target
+    vt_str_t *const tmp = snl_load_tmp_name(filename);
+    FILE *const fp = fopen(vt_str_z(tmp), "wb");
+    VT_ENFORCE(fp != NULL, "Error: failed to open '%s'!\n", vt_str_z(tmp));
+    VT_ENFORCE(fwrite(load->data, 1, load->body_len, fp) == load->body_len, "Error: failed to write '%s'!\n", vt_str_z(tmp));
+    vt_str_destroy(tmp);
+
+    return fp;
+}
+
+void snl_load_save_end(FILE *const fp, const char *const filename) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(fp != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    vt_str_t *const tmp = snl_load_tmp_name(filename);
+    VT_ENFORCE(fclose(fp) == 0, "Error: failed to write '%s'!\n", vt_str_z(tmp));
+
+    // replace the target
+#if defined(_WIN32)
+    const bool renamed = MoveFileExA(vt_str_z(tmp), filename, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    const bool renamed = rename(vt_str_z(tmp), filename) == 0;
+#endif
+    VT_ENFORCE(renamed, "Error: failed to replace '%s'!\n", filename);
+    vt_str_destroy(tmp);
+}
+
+void snl_load_append(snl_load_t *const load, const vt_str_t *const tail) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(load != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(load->filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(tail != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    const char *const filename = vt_str_z(load->filename);
+    const char *const journal = vt_str_z(load->journal);
+    const size_t len = vt_str_len(tail);
+
+    // 1. the journal is durable before the file is touched; the commit line is written last
+    char header[128];
+    const int header_len = snprintf(header, sizeof(header), "%s %zu %zu\n", SNL_LOAD_JOURNAL_MAGIC, load->body_len, len);
+    const uint32_t crc = snl_crc32(snl_crc32(0, (const uint8_t*)header, (size_t)header_len), (const uint8_t*)vt_str_z(tail), len);
+    FILE *const fp = fopen(journal, "wb");
+    VT_ENFORCE(fp != NULL, "Error: failed to open '%s'!\n", journal);
+    const bool written =
+        fwrite(header, 1, (size_t)header_len, fp) == (size_t)header_len &&
+        fwrite(vt_str_z(tail), 1, len, fp) == len &&
+        fprintf(fp, "%s %08x\n", SNL_LOAD_JOURNAL_COMMIT, (unsigned)crc) > 0 &&
+        snl_load_sync_file(fp);
+    const bool closed = fclose(fp) == 0;
+    VT_ENFORCE(written && closed, "Error: failed to write '%s'!\n", journal);
+    snl_load_sync_dir(journal);
+
+    // 2. overwrite the closing tag; a crash from here on is repaired by replaying the journal
+    VT_ENFORCE(snl_load_write_at(filename, load->body_len, vt_str_z(tail), len), "Error: failed to append to '%s'!\n", filename);
+
+    // 3. done
+    remove(journal);
+    load->len = load->body_len + len;
+    load->body_len = load->len - (sizeof("</svg>") - 1);
+}
+
+void snl_load_replay(const snl_load_t *const load, snl_canvas_t *const canvas, const char *const filename) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(load != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(load->data != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    snl_load_replay_t rep = {
+        .canvas = canvas,
+        .filename = filename,
+        .classes = vt_str_create_capacity(VT_STR_TMP_BUFFER_SIZE, NULL),
+        .filter = vt_str_create_capacity(64, NULL),
+        .gradient = vt_str_create_capacity(64, NULL),
+        .font_family = vt_str_create_capacity(64, NULL),
+        .font_weight = vt_str_create_capacity(64, NULL),
+        .font_style = vt_str_create_capacity(64, NULL),
+        .text_decoration = vt_str_create_capacity(64, NULL),
+        .value = vt_str_create_capacity(64, NULL),
+        .text = vt_str_create_capacity(64, NULL)
+    };
+
+    // everything up to the closing </svg>; the scan has checked that the markup is well-formed
+    snl_xml_reader_init(&rep.reader, load->data, load->body_len);
+    snl_xml_token_t token;
+    snl_xml_kind_t kind;
+    bool root = false;
+    while ((kind = snl_xml_next(&rep.reader, &token)) != SNL_XML_EOF) {
+        if (kind == SNL_XML_CLOSE) {
+            snl_load_replay_close(&rep, &token);
+        } else if (kind == SNL_XML_OPEN) {
+            if (root) snl_load_replay_element(&rep, &token);
+            root = true;
+        }
+    }
+
+    // release memory
+    while (rep.nscopes > 0) snl_load_replay_pop(&rep);
+    free(rep.scopes);
+    free(rep.class_offsets);
+    free(rep.class_lengths);
+    free(rep.points);
+    vt_str_destroy(rep.classes);
+    vt_str_destroy(rep.filter);
+    vt_str_destroy(rep.gradient);
+    vt_str_destroy(rep.font_family);
+    vt_str_destroy(rep.font_weight);
+    vt_str_destroy(rep.font_style);
+    vt_str_destroy(rep.text_decoration);
+    vt_str_destroy(rep.value);
+    vt_str_destroy(rep.text);
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Name of the temporary file a save is written to before it replaces the target
+ * @param filename target file name
+ * @return "<filename>.tmp"
+ */
+static vt_str_t *snl_load_tmp_name(const char *const filename) {
+    vt_str_t *const tmp = vt_str_create_capacity(strlen(filename) + 8, NULL);
+    vt_str_appendf(tmp, "%s.tmp", filename);
+
+    return tmp;
+}
+
+/**
+ * @brief Map a file read-only
+ * @param load load instance
+ * @param filename file name
+ * @return None
+ */
+static void snl_load_map(snl_load_t *const load, const char *const filename) {
+#if defined(_WIN32)
+    load->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    VT_ENFORCE(load->file != INVALID_HANDLE_VALUE, "Error: failed to open '%s'!\n", filename);
+    LARGE_INTEGER size;
+    VT_ENFORCE(GetFileSizeEx(load->file, &size) && size.QuadPart > 0, "Error: '%s' is not an svg document!\n", filename);
+    load->len = (size_t)size.QuadPart;
+    load->mapping = CreateFileMappingA(load->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    VT_ENFORCE(load->mapping != NULL, "Error: failed to map '%s'!\n", filename);
+    load->data = MapViewOfFile(load->mapping, FILE_MAP_READ, 0, 0, 0);
+    VT_ENFORCE(load->data != NULL, "Error: failed to map '%s'!\n", filename);
+#else
+    const int fd = open(filename, O_RDONLY);
+    VT_ENFORCE(fd >= 0, "Error: failed to open '%s'!\n", filename);
+    struct stat st;
+    VT_ENFORCE(fstat(fd, &st) == 0 && st.st_size > 0, "Error: '%s' is not an svg document!\n", filename);
+    load->len = (size_t)st.st_size;
+    void *const data = mmap(NULL, load->len, PROT_READ, MAP_PRIVATE, fd, 0);
+    VT_ENFORCE(data != MAP_FAILED, "Error: failed to map '%s'!\n", filename);
+    close(fd);
+
+    // the file is read front to back, both when scanning and when saving
+#if defined(MADV_SEQUENTIAL)
+    madvise(data, load->len, MADV_SEQUENTIAL);
+#endif
+    load->data = data;
+#endif
+}
+
+/**
+ * @brief Check the document structure, read its size and register its definitions
+ * @param load load instance
+ * @param defs definition table
+ * @param data document
+ * @param len document length
+ * @param filename file name for error messages
+ * @param partial data is only the head of the document: stop where it is cut off
+ * @return None
+ */
+static void snl_load_scan(snl_load_t *const load, snl_defs_t *const defs, const char *const data, const size_t len, const char *const filename, const bool partial) {
+    snl_xml_reader_t r;
+    snl_xml_reader_init(&r, data, len);
+    vt_str_t *const id = vt_str_create_capacity(64, NULL);
+
+    snl_xml_token_t token, def = {0};
+    size_t depth = 0, def_depth = 0;
+    bool root = false;
+    snl_xml_kind_t kind;
+    while ((kind = snl_xml_next(&r, &token)) != SNL_XML_EOF) {
+        if (partial && kind == SNL_XML_ERROR) break;
+        VT_ENFORCE(kind != SNL_XML_ERROR, "Error: '%s' has malformed markup at byte %zu!\n", filename, r.pos);
+        if (kind == SNL_XML_OPEN) {
+            // the root element
+            if (!root) {
+                VT_ENFORCE(snl_xml_is(&token, "svg") && !token.empty, "Error: '%s' is not an svg document!\n", filename);
+                snl_load_size(load, &token);
+                root = true;
+            } else {
+                VT_ENFORCE(depth > 0, "Error: '%s' has content after </svg> at byte %zu!\n", filename, r.pos - token.len);
+            }
+
+            // outermost filter or gradient
+            if (def.kind == SNL_XML_EOF && snl_load_is_def(&token)) {
+                if (token.empty) snl_load_define(defs, id, &token, token.start + token.len);
+                else def = token, def_depth = depth;
+            }
+            if (!token.empty) depth++;
+        } else if (kind == SNL_XML_CLOSE) {
+            VT_ENFORCE(depth > 0, "Error: '%s' has an unbalanced </%.*s> at byte %zu!\n", filename, (int)token.name_len, token.name, r.pos - token.len);
+            depth--;
+            if (def.kind != SNL_XML_EOF && depth == def_depth) {
+                snl_load_define(defs, id, &def, token.start + token.len);
+                def.kind = SNL_XML_EOF;
+            }
+
+            // new content goes in front of the closing tag of the root
+            if (depth == 0) load->body_len = (size_t)(token.start - data);
+        }
+    }
+    VT_ENFORCE(root, "Error: '%s' is not an svg document!\n", filename);
+    VT_ENFORCE(partial || depth == 0, "Error: '%s' has no closing </svg>!\n", filename);
+
+    vt_str_destroy(id);
+}
+
+/**
+ * @brief Find the closing tag of the root at the end of a file
+ * @param load load instance, body_len is set to SIZE_MAX if there is none
+ * @param fp file
+ * @return None
+ */
+static void snl_load_find_end(snl_load_t *const load, FILE *const fp) {
+    load->body_len = SIZE_MAX;
+
+    // file size
+#if defined(_WIN32)
+    if (_fseeki64(fp, 0, SEEK_END) != 0) return;
+    const int64_t size = _ftelli64(fp);
+#else
+    if (fseeko(fp, 0, SEEK_END) != 0) return;
+    const int64_t size = ftello(fp);
+#endif
+    if (size <= 0) return;
+    load->len = (size_t)size;
+
+    // read the last bytes
+    char tail[SNL_LOAD_PEEK_SIZE];
+    const size_t tail_len = load->len < sizeof(tail) ? load->len : sizeof(tail);
+#if defined(_WIN32)
+    if (_fseeki64(fp, size - (int64_t)tail_len, SEEK_SET) != 0) return;
+#else
+    if (fseeko(fp, (off_t)(size - (int64_t)tail_len), SEEK_SET) != 0) return;
+#endif
+    if (fread(tail, 1, tail_len, fp) != tail_len) return;
+
+    // </svg> followed by whitespace only
+    size_t end = tail_len;
+    while (end > 0 && (tail[end - 1] == ' ' || tail[end - 1] == '\n' || tail[end - 1] == '\t' || tail[end - 1] == '\r')) end--;
+    const size_t tag_len = sizeof("</svg>") - 1;
+    if (end < tag_len || memcmp(tail + end - tag_len, "</svg>", tag_len) != 0) return;
+    load->body_len = load->len - tail_len + end - tag_len;
+}
+
+/**
+ * @brief Replay the journal of an interrupted append, or drop it if it was not completely written
+ * @param filename appended file
+ * @param journal journal file
+ * @return None
+ */
+static void snl_load_recover(const char *const filename, const char *const journal) {
+    FILE *const fp = fopen(journal, "rb");
+    if (fp == NULL) return;
+
+    // header
+    char header[128], magic[16];
+    size_t offset = 0, len = 0;
+    const bool valid =
+        fgets(header, sizeof(header), fp) != NULL &&
+        sscanf(header, "%15s %zu %zu", magic, &offset, &len) == 3 &&
+        strcmp(magic, SNL_LOAD_JOURNAL_MAGIC) == 0;
+
+    // content and commit line
+    char *const data = valid ? malloc(len + 1) : NULL;
+    char commit[64], commit_magic[16];
+    unsigned crc = 0;
+    const bool read =
+        data != NULL &&
+        fread(data, 1, len, fp) == len &&
+        fgets(commit, sizeof(commit), fp) != NULL &&
+        sscanf(commit, "%15s %8x", commit_magic, &crc) == 2 &&
+        strcmp(commit_magic, SNL_LOAD_JOURNAL_COMMIT) == 0;
+    fclose(fp);
+
+    // a journal cut short or with a wrong checksum means the file was not touched yet
+    const bool complete = read && snl_crc32(snl_crc32(0, (const uint8_t*)header, strlen(header)), (const uint8_t*)data, len) == crc;
+    if (complete) {
+        VT_ENFORCE(snl_load_write_at(filename, offset, data, len), "Error: failed to recover '%s' from '%s'!\n", filename, journal);
+    }
+    free(data);
+    remove(journal);
+}
+
+/**
+ * @brief Overwrite the end of a file from an offset on and make it durable
+ * @param filename file name
+ * @param offset file offset
+ * @param data new end of the file
+ * @param len data length
+ * @return true on success
+ */
+static bool snl_load_write_at(const char *const filename, const size_t offset, const char *const data, const size_t len) {
+    FILE *const fp = fopen(filename, "r+b");
+    if (fp == NULL) return false;
+
+#if defined(_WIN32)
+    bool ok = _fseeki64(fp, (int64_t)offset, SEEK_SET) == 0;
+#else
+    bool ok = fseeko(fp, (off_t)offset, SEEK_SET) == 0;
+#endif
+    ok = ok && fwrite(data, 1, len, fp) == len && fflush(fp) == 0;
+
+    // drop whatever followed the old closing tag
+#if defined(_WIN32)
+    ok = ok && _chsize_s(_fileno(fp), (int64_t)(offset + len)) == 0;
+#else
+    ok = ok && ftruncate(fileno(fp), (off_t)(offset + len)) == 0;
+#endif
+    ok = ok && snl_load_sync_file(fp);
+
+    return fclose(fp) == 0 && ok;
+}
+
+/**
+ * @brief Flush a file to the storage device
+ * @param fp file
+ * @return true on success
+ */
+static bool snl_load_sync_file(FILE *const fp) {
+    if (fflush(fp) != 0) return false;
+#if defined(_WIN32)
+    return _commit(_fileno(fp)) == 0;
+#else
+    return fsync(fileno(fp)) == 0;
+#endif
+}
+
+/**
+ * @brief Flush the directory entry of a newly created file to the storage device
+ * @param filename file name
+ * @return None
+ */
+static void snl_load_sync_dir(const char *const filename) {
+#if !defined(_WIN32)
+    // directory part of the path
+    const char *const slash = strrchr(filename, '/');
+    vt_str_t *const dir = vt_str_create_capacity(slash ? (size_t)(slash - filename) + 1 : 2, NULL);
+    if (slash == filename) vt_str_append(dir, "/");
+    else if (slash) vt_str_append_n(dir, filename, (size_t)(slash - filename));
+    else vt_str_append(dir, ".");
+
+    const int fd = open(vt_str_z(dir), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    vt_str_destroy(dir);
+#else
+    (void)filename;
+#endif
+}
+
+/**
+ * @brief Read the size of the root element from its width and height, or from its viewBox
+ * @param load load instance
+ * @param token root element
+ * @return None
+ */
+static void snl_load_size(snl_load_t *const load, const snl_xml_token_t *const token) {
+    const char *value, *next;
+    size_t len;
+    if (snl_xml_attribute(token, "width", &value, &len)) load->width = snl_load_number(value, len, &next);
+    if (snl_xml_attribute(token, "height", &value, &len)) load->height = snl_load_number(value, len, &next);
+    if ((load->width <= 0 || load->height <= 0) && snl_xml_attribute(token, "viewBox", &value, &len)) {
+        // min-x min-y width height
+        const char *const end = value + len;
+        float numbers[4] = {0};
+        for (size_t i = 0; i < 4 && value < end; i++) {
+            numbers[i] = snl_load_number(value, (size_t)(end - value), &next);
+            value = next;
+            while (value < end && (*value == ' ' || *value == ',')) value++;
+        }
+        load->width = numbers[2];
+        load->height = numbers[3];
+    }
+}
+
+/**
+ * @brief Check whether an element is a filter or gradient definition
+ * @param token OPEN token
+ * @return bool
+ */
+static bool snl_load_is_def(const snl_xml_token_t *const token) {
+    return snl_xml_is(token, "filter") || snl_xml_is(token, "linearGradient") || snl_xml_is(token, "radialGradient");
+}
+
+/**
+ * @brief Register a definition of the file, so that new definitions with the same id or content are not written again
+ * @param defs definition table
+ * @param id buffer for the id
+ * @param open opening tag of the definition
+ * @param end end of the definition
+ * @return None
+ */
+static void snl_load_define(snl_defs_t *const defs, vt_str_t *const id, const snl_xml_token_t *const open, const char *const end) {
+    // the definition table splits definitions around id='...'
+    const char *value;
+    size_t len;
+    if (!snl_xml_attribute(open, "id", &value, &len) || value[-1] != '\'') return;
+    snl_xml_unescape(id, value, len);
+
+    // definitions are stored with a trailing newline, as they are written
+    vt_str_t *const def = defs->scratch;
+    vt_str_append_n(def, open->start, (size_t)(end - open->start));
+    vt_str_append(def, "\n");
+    snl_defs_add(defs, vt_str_z(id), vt_str_z(def), vt_str_len(def), NULL);
+    vt_str_clear(def);
+}
+
+/**
+ * @brief Parse a number at the start of an attribute value
+ * @param value attribute value, not NUL-terminated
+ * @param len value length
+ * @param next first byte after the number (set on return)
+ * @return float
+ */
+static float snl_load_number(const char *const value, const size_t len, const char **const next) {
+    char buffer[64];
+    const size_t n = len < sizeof(buffer) - 1 ? len : sizeof(buffer) - 1;
+    memcpy(buffer, value, n);
+    buffer[n] = '\0';
+
+    char *end;
+    const float number = strtof(buffer, &end);
+    *next = value + (end - buffer);
+
+    return number;
+}
+
+/**
+ * @brief Rebuild an element through the render calls of the canvas
+ * @param rep replay state
+ * @param token OPEN token of the element
+ * @return None
+ */
+static void snl_load_replay_element(snl_load_replay_t *const rep, const snl_xml_token_t *const token) {
+    snl_canvas_t *const canvas = rep->canvas;
+
+    // definitions and classes
+    if (snl_xml_is(token, "defs")) return;
+    if (snl_xml_is(token, "style")) {
+        snl_load_replay_style(rep, token);
+        return;
+    }
+    if (snl_xml_is(token, "filter")) {
+        snl_load_replay_filter(rep, token);
+        return;
+    }
+    if (snl_xml_is(token, "linearGradient") || snl_xml_is(token, "radialGradient")) {
+        snl_load_replay_gradient(rep, token);
+        return;
+    }
+
+    // symbols start from the svg defaults, whatever surrounds their definition
+    if (snl_xml_is(token, "symbol")) {
+        snl_load_replay_id(rep, token, "id");
+        snl_canvas_symbol_begin(canvas, vt_str_z(rep->value));
+        snl_load_replay_push(rep, &gi_load_svg_defaults);
+        if (token->empty) snl_load_replay_close(rep, token);
+        return;
+    }
+
+    // style and geometry
+    snl_load_replay_attributes(rep, token);
+    const snl_load_transform_t transform = snl_load_replay_transform(rep);
+    const snl_appearance_t appearance = rep->appearance;
+    if (snl_xml_is(token, "g")) {
+        // the elements of the group inherit its stroke and fill, not its filter
+        snl_canvas_push_group(canvas, transform.matrix, rep->styled ? &appearance : NULL);
+        snl_load_replay_push(rep, &appearance);
+        if (token->empty) snl_load_replay_close(rep, token);
+        return;
+    }
+    if (snl_xml_is(token, "text")) {
+        snl_load_replay_text(rep, token);
+        rep->text_style.text_rotation = transform.rotate;
+        snl_canvas_render_text_styled(
+            canvas, SNL_POINT(snl_load_replay_number(rep, SNL_LOAD_X), snl_load_replay_number(rep, SNL_LOAD_Y)), vt_str_z(rep->text), appearance, rep->text_style
+        );
+        return;
+    }
+
+    // shapes
+    if (snl_xml_is(token, "use")) {
+        snl_load_replay_expect(rep, token, rep->attributes[SNL_LOAD_HREF] != NULL);
+        const char *const href = rep->attributes[SNL_LOAD_HREF];
+        const size_t href_len = rep->attribute_lengths[SNL_LOAD_HREF];
+        snl_xml_unescape(rep->value, href + (href_len > 0 && href[0] == '#'), href_len - (href_len > 0 && href[0] == '#'));
+        snl_canvas_render_instance(canvas, vt_str_z(rep->value), transform.translate, transform.scale, transform.rotate);
+    } else if (snl_xml_is(token, "line")) {
+        snl_canvas_render_line(
+            canvas,
+            SNL_POINT(snl_load_replay_number(rep, SNL_LOAD_X1), snl_load_replay_number(rep, SNL_LOAD_Y1)),
+            SNL_POINT(snl_load_replay_number(rep, SNL_LOAD_X2), snl_load_replay_number(rep, SNL_LOAD_Y2)),
+            appearance
+        );
+    } else if (snl_xml_is(token, "circle")) {
+        snl_canvas_render_circle(
+            canvas, SNL_POINT(snl_load_replay_number(rep, SNL_LOAD_CX), snl_load_replay_number(rep, SNL_LOAD_CY)), snl_load_replay_number(rep, SNL_LOAD_R), appearance
+        );
+    } else if (snl_xml_is(token, "ellipse")) {
+        snl_canvas_render_ellipse(
+            canvas,
+            SNL_POINT(snl_load_replay_number(rep, SNL_LOAD_CX), snl_load_replay_number(rep, SNL_LOAD_CY)),
+            SNL_POINT(snl_load_replay_number(rep, SNL_LOAD_RX), snl_load_replay_number(rep, SNL_LOAD_RY)),
+            appearance
+        );
+    } else if (snl_xml_is(token, "rect")) {
+        snl_canvas_render_rectangle(
+            canvas,
+            SNL_POINT(snl_load_replay_number(rep, SNL_LOAD_X), snl_load_replay_number(rep, SNL_LOAD_Y)),
+            SNL_POINT(snl_load_replay_number(rep, SNL_LOAD_WIDTH), snl_load_replay_number(rep, SNL_LOAD_HEIGHT)),
+            snl_load_replay_number(rep, SNL_LOAD_RX),
+            appearance
+        );
+    } else if (snl_xml_is(token, "polygon") || snl_xml_is(token, "polyline")) {
+        const char *p = rep->attributes[SNL_LOAD_POINTS];
+        const char *const end = p ? p + rep->attribute_lengths[SNL_LOAD_POINTS] : NULL;
+        size_t n = 0;
+        double xy[2];
+        while (p && snl_load_numbers(&p, end, xy, 2) == 2) snl_load_replay_point(rep, n++, xy[0], xy[1]);
+        if (snl_xml_is(token, "polygon")) {
+            snl_canvas_render_polygon_points(canvas, rep->points, n, appearance, rep->fill_rule);
+        } else {
+            snl_canvas_render_polyline_points(canvas, rep->points, n, appearance);
+        }
+    } else if (snl_xml_is(token, "path")) {
+        snl_load_replay_path(rep, token);
+    } else {
+        snl_load_replay_expect(rep, token, false);
+    }
+
+    // shapes have no content of their own
+    if (!token->empty) snl_load_replay_skip(rep);
+}
+
+/**
+ * @brief Close a group or a symbol
+ * @param rep replay state
+ * @param token CLOSE token, or the OPEN token of an empty element
+ * @return None
+ */
+static void snl_load_replay_close(snl_load_replay_t *const rep, const snl_xml_token_t *const token) {
+    if (snl_xml_is(token, "g")) {
+        snl_load_replay_pop(rep);
+        snl_canvas_pop_group(rep->canvas);
+    } else if (snl_xml_is(token, "symbol")) {
+        snl_load_replay_pop(rep);
+        snl_canvas_symbol_end(rep->canvas);
+    }
+}
+
+/**
+ * @brief Stop loading an element that cannot be rebuilt
+ * @param rep replay state
+ * @param token OPEN token of the element
+ * @param cond whether the element can be rebuilt
+ * @return None
+ */
+static void snl_load_replay_expect(const snl_load_replay_t *const rep, const snl_xml_token_t *const token, const bool cond) {
+    VT_ENFORCE(
+        cond, "Error: '%s' has a <%.*s> element at byte %zu that cannot be rebuilt, open it with 'snl_canvas_load()'!\n",
+        rep->filename, (int)token->name_len, token->name, (size_t)(token->start - rep->reader.data)
+    );
+}
+
+/**
+ * @brief Skip the content of an element up to its closing tag
+ * @param rep replay state
+ * @return None
+ */
+static void snl_load_replay_skip(snl_load_replay_t *const rep) {
+    snl_xml_token_t token;
+    snl_xml_kind_t kind;
+    size_t depth = 1;
+    while (depth > 0 && (kind = snl_xml_next(&rep->reader, &token)) != SNL_XML_EOF) {
+        if (kind == SNL_XML_OPEN && !token.empty) depth++;
+        else if (kind == SNL_XML_CLOSE) depth--;
+    }
+}
+
+/**
+ * @brief Read the classes .aN of a <style> element
+ * @param rep replay state
+ * @param token OPEN token of the element
+ * @return None
+ */
+static void snl_load_replay_style(snl_load_replay_t *const rep, const snl_xml_token_t *const token) {
+    if (token->empty) return;
+
+    snl_xml_token_t content;
+    snl_xml_kind_t kind;
+    while ((kind = snl_xml_next(&rep->reader, &content)) != SNL_XML_EOF && kind != SNL_XML_CLOSE) {
+        if (kind != SNL_XML_TEXT) continue;
+
+        // rules .aN{declarations}
+        const char *p = content.start;
+        const char *const end = content.start + content.len;
+        while ((p = snl_load_find(p, end, ".a")) != NULL) {
+            char *next;
+            const unsigned long index = strtoul(p + 2, &next, 10);
+            const char *const open = memchr(next, '{', (size_t)(end - next));
+            const char *const close = open ? memchr(open, '}', (size_t)(end - open)) : NULL;
+            if (close == NULL) break;
+
+            // grow, leaving the classes in between undefined
+            if (index >= rep->nclasses) {
+                size_t *const offsets = realloc(rep->class_offsets, (index + 1) * sizeof(size_t));
+                VT_ENFORCE(offsets != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+                rep->class_offsets = offsets;
+                size_t *const lengths = realloc(rep->class_lengths, (index + 1) * sizeof(size_t));
+                VT_ENFORCE(lengths != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+                rep->class_lengths = lengths;
+                for (size_t i = rep->nclasses; i <= index; i++) rep->class_offsets[i] = SIZE_MAX;
+                rep->nclasses = index + 1;
+            }
+            rep->class_offsets[index] = vt_str_len(rep->classes);
+            rep->class_lengths[index] = (size_t)(close - open - 1);
+            vt_str_append_n(rep->classes, open + 1, (size_t)(close - open - 1));
+            p = close + 1;
+        }
+    }
+}
+
+/**
+ * @brief Rebuild a filter written by <snl_emit_filter_blur()> or <snl_emit_filter_shadow()>
+ * @param rep replay state
+ * @param token OPEN token of the element
+ * @return None
+ */
+static void snl_load_replay_filter(snl_load_replay_t *const rep, const snl_xml_token_t *const token) {
+    snl_load_replay_id(rep, token, "id");
+
+    // primitives
+    double blur[2] = {0}, dx = 0, dy = 0;
+    bool shadow = false, color_blend = false, hard_edge = false;
+    snl_xml_token_t primitive;
+    snl_xml_kind_t kind;
+    size_t depth = token->empty ? 0 : 1;
+    while (depth > 0 && (kind = snl_xml_next(&rep->reader, &primitive)) != SNL_XML_EOF) {
+        if (kind == SNL_XML_CLOSE) depth--;
+        if (kind != SNL_XML_OPEN) continue;
+        if (!primitive.empty) depth++;
+
+        const char *value, *p;
+        size_t len;
+        if (snl_xml_is(&primitive, "feGaussianBlur")) {
+            if (!snl_xml_attribute(&primitive, "stdDeviation", &value, &len)) continue;
+            p = value;
+            if (snl_load_numbers(&p, value + len, blur, 2) == 1) blur[1] = blur[0];
+        } else if (snl_xml_is(&primitive, "feOffset")) {
+            shadow = true;
+            color_blend = snl_xml_attribute(&primitive, "in", &value, &len) && len == 13 && memcmp(value, "SourceGraphic", 13) == 0;
+            if (snl_xml_attribute(&primitive, "dx", &value, &len)) p = value, snl_load_numbers(&p, value + len, &dx, 1);
+            if (snl_xml_attribute(&primitive, "dy", &value, &len)) p = value, snl_load_numbers(&p, value + len, &dy, 1);
+        } else if (snl_xml_is(&primitive, "feComponentTransfer")) {
+            hard_edge = true;
+        } else {
+            snl_load_replay_expect(rep, &primitive, snl_xml_is(&primitive, "feBlend") || snl_xml_is(&primitive, "feFuncA"));
+        }
+    }
+
+    const char *const id = vt_str_z(rep->value);
+    if (shadow) {
+        snl_canvas_add_filter_shadow(rep->canvas, id, (int32_t)lrint(dx), (int32_t)lrint(dy), (int32_t)lrint(blur[0]), color_blend);
+    } else if (hard_edge) {
+        snl_canvas_add_filter_blur_hard_edge(rep->canvas, id, (int32_t)lrint(blur[0]), (int32_t)lrint(blur[1]));
+    } else {
+        snl_canvas_add_filter_blur(rep->canvas, id, (int32_t)lrint(blur[0]), (int32_t)lrint(blur[1]));
+    }
+}
+
+/**
+ * @brief Rebuild a gradient written by <snl_emit_gradient_linear()> or <snl_emit_gradient_radial()>
+ * @param rep replay state
+ * @param token OPEN token of the element
+ * @return None
+ */
+static void snl_load_replay_gradient(snl_load_replay_t *const rep, const snl_xml_token_t *const token) {
+    snl_load_replay_id(rep, token, "id");
+
+    // direction: the line from (0%, 0%) to (100%, 0%) rotated around its center, see <snl_rotate()>
+    double start[2] = {0}, end[2] = {100, 0};
+    const char *const names[4] = { "x1", "y1", "x2", "y2" };
+    double *const coords[4] = { &start[0], &start[1], &end[0], &end[1] };
+    for (size_t i = 0; i < 4; i++) {
+        const char *value, *p;
+        size_t len;
+        if (snl_xml_attribute(token, names[i], &value, &len)) p = value, snl_load_numbers(&p, value + len, coords[i], 1);
+    }
+    // the written coordinates are off by float rounding, so the angle is recovered to 1/10000 of a degree
+    const double degrees = atan2(-(end[1] - start[1]), end[0] - start[0]) * 180 / M_PI;
+    const float angle = (float)(rint(degrees * 1e4) / 1e4);
+
+    // stops
+    struct SnailColor colors[3] = {0};
+    int32_t offsets[3] = {0};
+    float opacities[3] = {1, 1, 1};
+    size_t count = 0;
+    snl_xml_token_t stop;
+    snl_xml_kind_t kind;
+    size_t depth = token->empty ? 0 : 1;
+    while (depth > 0 && (kind = snl_xml_next(&rep->reader, &stop)) != SNL_XML_EOF) {
+        if (kind == SNL_XML_CLOSE) depth--;
+        if (kind != SNL_XML_OPEN) continue;
+        if (!stop.empty) depth++;
+        snl_load_replay_expect(rep, &stop, snl_xml_is(&stop, "stop") && count < 3);
+
+        const char *value, *p, *name;
+        size_t len, name_len;
+        double offset = 0;
+        if (snl_xml_attribute(&stop, "offset", &value, &len)) p = value, snl_load_numbers(&p, value + len, &offset, 1);
+        offsets[count] = (int32_t)lrint(offset);
+        if (snl_xml_attribute(&stop, "style", &value, &len)) {
+            const char *const style_end = value + len;
+            p = value;
+            while (snl_load_next_declaration(&p, style_end, &name, &name_len, &value, &len)) {
+                if (snl_load_name_is(name, name_len, "stop-color")) {
+                    colors[count] = snl_load_replay_color(rep, &stop, value, len);
+                } else if (snl_load_name_is(name, name_len, "stop-opacity")) {
+                    double opacity = 1;
+                    const char *q = value;
+                    snl_load_numbers(&q, value + len, &opacity, 1);
+                    opacities[count] = (float)opacity;
+                }
+            }
+        }
+        count++;
+    }
+    snl_load_replay_expect(rep, token, count >= 2);
+
+    snl_canvas_t *const canvas = rep->canvas;
+    const char *const id = vt_str_z(rep->value);
+    if (snl_xml_is(token, "radialGradient")) {
+        if (count == 2) {
+            snl_canvas_add_gradient_radial(canvas, id, colors[0], colors[1], offsets[0], offsets[1], opacities[0], opacities[1]);
+        } else {
+            snl_canvas_add_gradient_radial_tricolor(
+                canvas, id, colors[0], colors[1], colors[2], offsets[0], offsets[1], offsets[2], opacities[0], opacities[1], opacities[2]
+            );
+        }
+    } else if (count == 2) {
+        snl_canvas_add_gradient_linear(canvas, id, colors[0], colors[1], offsets[0], offsets[1], opacities[0], opacities[1], angle);
+    } else {
+        snl_canvas_add_gradient_linear_tricolor(
+            canvas, id, colors[0], colors[1], colors[2], offsets[0], offsets[1], offsets[2], opacities[0], opacities[1], opacities[2], angle
+        );
+    }
+}
+
+/**
+ * @brief Read the content of a <text> element up to its closing tag
+ * @param rep replay state, the unescaped content is put in rep->text
+ * @param token OPEN token of the element
+ * @return None
+ */
+static void snl_load_replay_text(snl_load_replay_t *const rep, const snl_xml_token_t *const token) {
+    vt_str_clear(rep->text);
+    if (token->empty) return;
+
+    snl_xml_token_t content;
+    snl_xml_kind_t kind;
+    while ((kind = snl_xml_next(&rep->reader, &content)) != SNL_XML_EOF && kind != SNL_XML_CLOSE) {
+        snl_load_replay_expect(rep, token, kind != SNL_XML_OPEN);
+        if (kind != SNL_XML_TEXT) continue;
+        snl_xml_unescape(rep->value, content.start, content.len);
+        vt_str_append_n(rep->text, vt_str_z(rep->value), vt_str_len(rep->value));
+    }
+}
+
+/**
+ * @brief Rebuild the path data written for curves and, by the compact profile, for polygons and polylines
+ * @param rep replay state
+ * @param token OPEN token of the element
+ * @return None
+ */
+static void snl_load_replay_path(snl_load_replay_t *const rep, const snl_xml_token_t *const token) {
+    const char *p = rep->attributes[SNL_LOAD_D];
+    const char *const end = p ? p + rep->attribute_lengths[SNL_LOAD_D] : NULL;
+
+    // the points are added up in double, so that relative steps land on the numbers that were written
+    double x = 0, y = 0, v[4];
+    size_t n = 0;
+    char command = 0;
+    bool closed = false;
+    while (p && p < end) {
+        while (p < end && (*p == ' ' || *p == ',' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+        if (p == end) break;
+
+        // a new command, otherwise the last one repeats
+        if ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')) {
+            command = *p++;
+            if (command == 'z' || command == 'Z') {
+                closed = true;
+                continue;
+            }
+        }
+
+        // a quadratic curve from the first point, see <snl_emit_curve()>
+        if (command == 'q') {
+            snl_load_replay_expect(rep, token, n == 1 && snl_load_numbers(&p, end, v, 4) == 4);
+            snl_canvas_render_curve_custom(
+                rep->canvas, rep->points[0], SNL_POINT((float)(x + v[2]), (float)(y + v[3])), (float)v[0], (float)v[1], rep->appearance
+            );
+            return;
+        }
+
+        // line segments
+        const size_t needed = command == 'H' || command == 'h' || command == 'V' || command == 'v' ? 1 : 2;
+        snl_load_replay_expect(rep, token, snl_load_numbers(&p, end, v, needed) == needed);
+        switch (command) {
+            case 'M': case 'L': x = v[0]; y = v[1]; break;
+            case 'm': case 'l': x += v[0]; y += v[1]; break;
+            case 'H': x = v[0]; break;
+            case 'h': x += v[0]; break;
+            case 'V': y = v[0]; break;
+            case 'v': y += v[0]; break;
+            default: snl_load_replay_expect(rep, token, false);
+        }
+        snl_load_replay_point(rep, n++, x, y);
+
+        // more coordinates after a moveto are implicit linetos
+        if (command == 'M') command = 'L';
+        if (command == 'm') command = 'l';
+    }
+
+    if (closed) {
+        snl_canvas_render_polygon_points(rep->canvas, rep->points, n, rep->appearance, rep->fill_rule);
+    } else {
+        snl_canvas_render_polyline_points(rep->canvas, rep->points, n, rep->appearance);
+    }
+}
+
+/**
+ * @brief Read the attributes of an element: geometry into rep->attributes, style into rep->appearance and rep->text_style
+ * @param rep replay state
+ * @param token OPEN token of the element
+ * @return None
+ */
+static void snl_load_replay_attributes(snl_load_replay_t *const rep, const snl_xml_token_t *const token) {
+    // the inherited style; the filter is not inherited
+    rep->appearance = rep->nscopes ? rep->scopes[rep->nscopes - 1] : gi_load_svg_defaults;
+    rep->appearance.filter = NULL;
+    rep->text_style = SNL_TEXT_STYLE(10, 0, "", SNL_FONT_WEIGHT_NORMAL, SNL_FONT_STYLE_NORMAL, SNL_TEXT_NONE);
+    rep->fill_rule = SNL_FILL_RULE_NONZERO;
+    rep->styled = false;
+    for (size_t i = 0; i < SNL_LOAD_ATTRIBUTES; i++) rep->attributes[i] = NULL;
+
+    const char *cursor = NULL, *name, *value;
+    size_t name_len, len;
+    while (snl_xml_next_attribute(token, &cursor, &name, &name_len, &value, &len)) {
+        // geometry
+        size_t i = 0;
+        while (i < SNL_LOAD_ATTRIBUTES && !snl_load_name_is(name, name_len, gi_load_attributes[i])) i++;
+        if (i < SNL_LOAD_ATTRIBUTES) {
+            rep->attributes[i] = value;
+            rep->attribute_lengths[i] = len;
+            continue;
+        }
+
+        // style declarations, inline or from a class
+        const char *p = value, *end = value + len;
+        if (snl_load_name_is(name, name_len, "class")) {
+            const unsigned long index = len > 1 && value[0] == 'a' ? strtoul(value + 1, NULL, 10) : ULONG_MAX;
+            snl_load_replay_expect(rep, token, index < rep->nclasses && rep->class_offsets[index] != SIZE_MAX);
+            p = vt_str_z(rep->classes) + rep->class_offsets[index];
+            end = p + rep->class_lengths[index];
+        } else if (!snl_load_name_is(name, name_len, "style")) {
+            snl_load_replay_property(rep, token, name, name_len, value, len);
+            continue;
+        }
+        const char *decl, *decl_value;
+        size_t decl_len, decl_value_len;
+        while (snl_load_next_declaration(&p, end, &decl, &decl_len, &decl_value, &decl_value_len)) {
+            snl_load_replay_property(rep, token, decl, decl_len, decl_value, decl_value_len);
+        }
+    }
+}
+
+/**
+ * @brief Apply a style property to the element being rebuilt; other properties are dropped
+ * @param rep replay state
+ * @param token OPEN token of the element
+ * @param name property name
+ * @param name_len name length
+ * @param value property value, escaped
+ * @param len value length
+ * @return None
+ */
+static void snl_load_replay_property(
+    snl_load_replay_t *const rep, const snl_xml_token_t *const token,
+    const char *const name, const size_t name_len, const char *const value, const size_t len
+) {
+    snl_appearance_t *const appearance = &rep->appearance;
+    const char *p = value;
+    double number = 0;
+
+    // stroke and fill
+    if (snl_load_name_is(name, name_len, "stroke") || snl_load_name_is(name, name_len, "fill")) {
+        struct SnailColor *const color = name_len == 4 ? &appearance->fill_color : &appearance->stroke_color;
+        if (len > 5 && memcmp(value, "url(#", 5) == 0) {
+            snl_load_unescape_url(rep->gradient, value, len);
+            appearance->gradient = vt_str_z(rep->gradient);
+            *color = SNL_COLOR_NONE;
+        } else {
+            *color = snl_load_replay_color(rep, token, value, len);
+        }
+    } else if (snl_load_name_is(name, name_len, "stroke-width")) {
+        snl_load_numbers(&p, value + len, &number, 1);
+        appearance->stroke_width = (float)number;
+    } else if (snl_load_name_is(name, name_len, "stroke-opacity")) {
+        snl_load_numbers(&p, value + len, &number, 1);
+        appearance->stroke_opacity = (float)number;
+    } else if (snl_load_name_is(name, name_len, "fill-opacity")) {
+        snl_load_numbers(&p, value + len, &number, 1);
+        appearance->fill_opacity = (float)number;
+    } else if (snl_load_name_is(name, name_len, "filter")) {
+        snl_load_unescape_url(rep->filter, value, len);
+        appearance->filter = vt_str_z(rep->filter);
+    } else if (snl_load_name_is(name, name_len, "fill-rule")) {
+        rep->fill_rule = snl_load_name_is(value, len, SNL_FILL_RULE_EVENODD) ? SNL_FILL_RULE_EVENODD : SNL_FILL_RULE_NONZERO;
+        return;
+    } else {
+        // text style
+        if (snl_load_name_is(name, name_len, "font-size")) {
+            snl_load_numbers(&p, value + len, &number, 1);
+            rep->text_style.font_size = (float)number;
+        } else if (snl_load_name_is(name, name_len, "font-family")) {
+            snl_xml_unescape(rep->font_family, value, len);
+            rep->text_style.font_family = vt_str_z(rep->font_family);
+        } else if (snl_load_name_is(name, name_len, "font-weight")) {
+            snl_xml_unescape(rep->font_weight, value, len);
+            rep->text_style.font_weight = vt_str_z(rep->font_weight);
+        } else if (snl_load_name_is(name, name_len, "font-style")) {
+            snl_xml_unescape(rep->font_style, value, len);
+            rep->text_style.font_style = vt_str_z(rep->font_style);
+        } else if (snl_load_name_is(name, name_len, "text-decoration")) {
+            snl_xml_unescape(rep->text_decoration, value, len);
+            rep->text_style.text_decoration = vt_str_z(rep->text_decoration);
+        }
+        return;
+    }
+    rep->styled = true;
+}
+
+/**
+ * @brief Parse a color: 'none', #rgb, #rrggbb, rgb() or rgba() with an alpha of 0..255
+ * @param rep replay state
+ * @param token OPEN token of the element, for error messages
+ * @param value color value
+ * @param len value length
+ * @return struct SnailColor
+ */
+static struct SnailColor snl_load_replay_color(const snl_load_replay_t *const rep, const snl_xml_token_t *const token, const char *const value, const size_t len) {
+    if (snl_load_name_is(value, len, "none")) return SNL_COLOR_NONE;
+
+    // hex
+    if (len > 0 && value[0] == '#') {
+        snl_load_replay_expect(rep, token, len == 4 || len == 7);
+        uint8_t channels[3];
+        for (size_t i = 0; i < 3; i++) {
+            char digits[3] = { value[1 + i * (len / 3)], value[len == 4 ? 1 + i : 2 + i * 2], '\0' };
+            char *next;
+            channels[i] = (uint8_t)strtoul(digits, &next, 16);
+            snl_load_replay_expect(rep, token, next == digits + 2);
+        }
+        return SNL_COLOR(channels[0], channels[1], channels[2], 255);
+    }
+
+    // rgb(r, g, b) and rgba(r, g, b, a)
+    const bool alpha = len > 5 && memcmp(value, "rgba(", 5) == 0;
+    snl_load_replay_expect(rep, token, alpha || (len > 4 && memcmp(value, "rgb(", 4) == 0));
+    double channels[4] = { 0, 0, 0, 255 };
+    const char *p = value + (alpha ? 5 : 4);
+    const size_t count = alpha ? 4 : 3;
+    snl_load_replay_expect(rep, token, snl_load_numbers(&p, value + len, channels, count) == count);
+
+    return SNL_COLOR((uint8_t)lrint(channels[0]), (uint8_t)lrint(channels[1]), (uint8_t)lrint(channels[2]), (uint8_t)lrint(channels[3]));
+}
+
+/**
+ * @brief Parse the transform attribute of the element being rebuilt
+ * @param rep replay state
+ * @return snl_load_transform_t
+ */
+static snl_load_transform_t snl_load_replay_transform(const snl_load_replay_t *const rep) {
+    snl_load_transform_t transform = { SNL_TRANSFORM_IDENTITY, SNL_POINT(0, 0), 0, 1 };
+    const char *p = rep->attributes[SNL_LOAD_TRANSFORM];
+    if (p == NULL) return transform;
+
+    // functions, applied from right to left
+    const char *const end = p + rep->attribute_lengths[SNL_LOAD_TRANSFORM];
+    const char *open;
+    while ((open = memchr(p, '(', (size_t)(end - p))) != NULL) {
+        const char *const close = memchr(open, ')', (size_t)(end - open));
+        if (close == NULL) break;
+        while (p < open && (*p == ' ' || *p == ',')) p++;
+        const size_t name_len = (size_t)(open - p);
+        const char *const name = p;
+
+        double v[6] = { 0, 0, 0, 0, 0, 0 };
+        p = open + 1;
+        const size_t n = snl_load_numbers(&p, close, v, 6);
+        snl_transform_t m = SNL_TRANSFORM_IDENTITY;
+        if (snl_load_name_is(name, name_len, "translate")) {
+            transform.translate = SNL_POINT((float)v[0], (float)v[1]);
+            m = SNL_TRANSFORM_TRANSLATE((float)v[0], (float)v[1]);
+        } else if (snl_load_name_is(name, name_len, "rotate")) {
+            transform.rotate = (float)v[0];
+            m = snl_transform_rotate((float)v[0]);
+        } else if (snl_load_name_is(name, name_len, "scale")) {
+            transform.scale = (float)v[0];
+            m = SNL_TRANSFORM_SCALE((float)v[0], (float)(n > 1 ? v[1] : v[0]));
+        } else if (snl_load_name_is(name, name_len, "matrix")) {
+            m = SNL_TRANSFORM((float)v[0], (float)v[1], (float)v[2], (float)v[3], (float)v[4], (float)v[5]);
+        }
+        transform.matrix = snl_transform_multiply(transform.matrix, m);
+        p = close + 1;
+    }
+
+    return transform;
+}
+
+/**
+ * @brief Read a geometry attribute of the element being rebuilt as a number
+ * @param rep replay state
+ * @param attribute attribute
+ * @return number, 0 if the attribute is missing
+ */
+static float snl_load_replay_number(const snl_load_replay_t *const rep, const snl_load_attribute_t attribute) {
+    if (rep->attributes[attribute] == NULL) return 0;
+
+    const char *next;
+    return snl_load_number(rep->attributes[attribute], rep->attribute_lengths[attribute], &next);
+}
+
+/**
+ * @brief Set a point of the element being rebuilt, growing the point buffer
+ * @param rep replay state
+ * @param index point index
+ * @param x x coordinate
+ * @param y y coordinate
+ * @return None
+ */
+static void snl_load_replay_point(snl_load_replay_t *const rep, const size_t index, const double x, const double y) {
+    if (index == rep->points_capacity) {
+        const size_t capacity = rep->points_capacity ? rep->points_capacity * 2 : 64;
+        snl_point_t *const points = realloc(rep->points, capacity * sizeof(snl_point_t));
+        VT_ENFORCE(points != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        rep->points = points;
+        rep->points_capacity = capacity;
+    }
+    rep->points[index] = SNL_POINT((float)x, (float)y);
+}
+
+/**
+ * @brief Unescape an id attribute into rep->value, dropping a leading '#'
+ * @param rep replay state
+ * @param token OPEN token of the element
+ * @param name attribute name
+ * @return None
+ */
+static void snl_load_replay_id(snl_load_replay_t *const rep, const snl_xml_token_t *const token, const char *const name) {
+    const char *value;
+    size_t len;
+    snl_load_replay_expect(rep, token, snl_xml_attribute(token, name, &value, &len) && len > 0);
+    if (value[0] == '#') value++, len--;
+    snl_xml_unescape(rep->value, value, len);
+}
+
+/**
+ * @brief Open a group or symbol scope
+ * @param rep replay state
+ * @param appearance style inherited by the elements of the scope
+ * @return None
+ */
+static void snl_load_replay_push(snl_load_replay_t *const rep, const snl_appearance_t *const appearance) {
+    if (rep->nscopes == rep->scopes_capacity) {
+        const size_t capacity = rep->scopes_capacity ? rep->scopes_capacity * 2 : 8;
+        snl_appearance_t *const scopes = realloc(rep->scopes, capacity * sizeof(snl_appearance_t));
+        VT_ENFORCE(scopes != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        rep->scopes = scopes;
+        rep->scopes_capacity = capacity;
+    }
+
+    snl_appearance_t *const scope = &rep->scopes[rep->nscopes++];
+    *scope = *appearance;
+    scope->filter = NULL;
+    scope->gradient = NULL;
+    if (appearance->gradient) {
+        const size_t size = strlen(appearance->gradient) + 1;
+        char *const gradient = malloc(size);
+        VT_ENFORCE(gradient != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        memcpy(gradient, appearance->gradient, size);
+        scope->gradient = gradient;
+    }
+}
+
+/**
+ * @brief Close the innermost group or symbol scope
+ * @param rep replay state
+ * @return None
+ */
+static void snl_load_replay_pop(snl_load_replay_t *const rep) {
+    if (rep->nscopes == 0) return;
+
+    rep->nscopes--;
+    free((char*)rep->scopes[rep->nscopes].gradient);
+}
+
+/**
+ * @brief Read the next "name:value" declaration of a style attribute or class
+ * @param p cursor, moved past the declaration
+ * @param end end of the declarations
+ * @param name property name (set on return)
+ * @param name_len name length (set on return)
+ * @param value property value (set on return)
+ * @param value_len value length (set on return)
+ * @return false when there are no more declarations
+ */
+static bool snl_load_next_declaration(const char **const p, const char *const end, const char **const name, size_t *const name_len, const char **const value, size_t *const value_len) {
+    const char *q = *p;
+    while (q < end && (*q == ' ' || *q == ';' || *q == '\t' || *q == '\n' || *q == '\r')) q++;
+    if (q == end) return false;
+
+    // name up to ':', value up to ';', both trimmed
+    const char *const colon = memchr(q, ':', (size_t)(end - q));
+    if (colon == NULL) return false;
+    const char *const semicolon = memchr(colon, ';', (size_t)(end - colon));
+    const char *const stop = semicolon ? semicolon : end;
+    const char *name_end = colon, *v = colon + 1, *value_end = stop;
+    while (name_end > q && name_end[-1] == ' ') name_end--;
+    while (v < value_end && *v == ' ') v++;
+    while (value_end > v && value_end[-1] == ' ') value_end--;
+
+    *name = q;
+    *name_len = (size_t)(name_end - q);
+    *value = v;
+    *value_len = (size_t)(value_end - v);
+    *p = stop;
+
+    return true;
+}
+
+/**
+ * @brief Parse numbers separated by spaces or commas
+ * @param p cursor, moved past the numbers read
+ * @param end end of the input
+ * @param numbers parsed numbers (set on return)
+ * @param n number of numbers to read
+ * @return number of numbers read
+ */
+static size_t snl_load_numbers(const char **const p, const char *const end, double *const numbers, const size_t n) {
+    size_t count = 0;
+    while (count < n) {
+        while (*p < end && (**p == ' ' || **p == ',' || **p == '\t' || **p == '\n' || **p == '\r')) (*p)++;
+        if (*p == end) break;
+
+        // strtod needs a terminated copy
+        char buffer[64];
+        const size_t len = (size_t)(end - *p) < sizeof(buffer) - 1 ? (size_t)(end - *p) : sizeof(buffer) - 1;
+        memcpy(buffer, *p, len);
+        buffer[len] = '\0';
+        char *next;
+        const double number = strtod(buffer, &next);
+        if (next == buffer) break;
+
+        numbers[count++] = number;
+        *p += next - buffer;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Unescape the id of a url(#id) reference
+ * @param out output string
+ * @param value reference
+ * @param len reference length
+ * @return None
+ */
+static void snl_load_unescape_url(vt_str_t *const out, const char *const value, const size_t len) {
+    const char *const start = len > 5 && memcmp(value, "url(#", 5) == 0 ? value + 5 : value;
+    const char *const close = memchr(start, ')', (size_t)(value + len - start));
+    snl_xml_unescape(out, start, (size_t)((close ? close : value + len) - start));
+}
+
+/**
+ * @brief Compare a name that is not NUL-terminated
+ * @param name name
+ * @param len name length
+ * @param z NUL-terminated name
+ * @return bool
+ */
+static bool snl_load_name_is(const char *const name, const size_t len, const char *const z) {
+    return strlen(z) == len && memcmp(name, z, len) == 0;
+}
+
+/**
+ * @brief Find a pattern in a byte range
+ * @param from start of the range
+ * @param end end of the range
+ * @param pattern pattern
+ * @return first match or NULL
+ */
+static const char *snl_load_find(const char *from, const char *const end, const char *const pattern) {
+    const size_t len = strlen(pattern);
+    while ((size_t)(end - from) >= len) {
+        const char *const hit = memchr(from, pattern[0], (size_t)(end - from) - len + 1);
+        if (hit == NULL) return NULL;
+        if (memcmp(hit, pattern, len) == 0) return hit;
+        from = hit + 1;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,127 @@
+#ifndef SNAIL_LOAD_H
+#define SNAIL_LOAD_H
+
+/** LOAD MODULE (internal)
+ *  - snl_load_open
+ *  - snl_load_open_tail
+ *  - snl_load_close
+ *  - snl_load_save_begin
+ *  - snl_load_save_end
+ *  - snl_load_append
+ *  - snl_load_replay
+*/
+
+#include "defs.h"
+
+#include <stdio.h>
+
+// bytes read from the head and the end of a file opened for appending
+#define SNL_LOAD_PEEK_SIZE 4096
+
+// first word of an append journal
+#define SNL_LOAD_JOURNAL_MAGIC "snail-journal"
+
+// first word of the last line of an append journal, followed by the crc-32 of everything before it
+#define SNL_LOAD_JOURNAL_COMMIT "snail-commit"
+
+// svg document mapped read-only into memory, or opened for appending
+typedef struct SnailLoad {
+    const char *data;       // mapped file contents, NULL when appending
+    size_t len;             // file length
+    size_t body_len;        // offset of the closing </svg>, i.e. the length kept when saving
+    float width, height;    // root element size
+
+    // appending
+    vt_str_t *filename;     // appended file, NULL when mapped
+    vt_str_t *journal;      // "<filename>.journal"
+
+    // platform handles
+#if defined(_WIN32)
+    void *file;
+    void *mapping;
+#endif
+} snl_load_t;
+
+/**
+ * @brief Map an svg file and scan its elements
+ *
+ * @param filename file name
+ * @param defs definition table to register the file's filters and gradients in
+ * @return snl_load_t*
+ *
+ * @note the file is tokenized in place without being copied; only filter and gradient definitions
+ *       with single-quoted ids are copied into the definition table
+ * @note the journal of an interrupted append is replayed first, see <snl_load_append()>
+ */
+extern snl_load_t *snl_load_open(const char *const filename, snl_defs_t *const defs);
+
+/**
+ * @brief Open an svg file for appending, reading only its head and its end
+ *
+ * @param filename file name
+ * @param defs definition table to register the filters and gradients of the head in
+ * @return snl_load_t*
+ *
+ * @note the journal of an interrupted append is replayed first
+ */
+extern snl_load_t *snl_load_open_tail(const char *const filename, snl_defs_t *const defs);
+
+/**
+ * @brief Unmap the file and release memory
+ *
+ * @param load load instance
+ * @return None
+ */
+extern void snl_load_close(snl_load_t *const load);
+
+/**
+ * @brief Start saving: write the mapped body, to which the caller appends new content ending with </svg>
+ *
+ * @param load load instance
+ * @param filename file name
+ * @return file the new content is written to
+ *
+ * @note the file is written under a temporary name and renamed over the target by <snl_load_save_end()>,
+ *       so the target may be the mapped file itself
+ */
+extern FILE *snl_load_save_begin(const snl_load_t *const load, const char *const filename);
+
+/**
+ * @brief Finish saving: close the file started by <snl_load_save_begin()> and rename it over the target
+ *
+ * @param fp file returned by <snl_load_save_begin()>
+ * @param filename file name given to <snl_load_save_begin()>
+ * @return None
+ */
+extern void snl_load_save_end(FILE *const fp, const char *const filename);
+
+/**
+ * @brief Replace the closing tag of the file with new content
+ *
+ * @param load load instance opened with <snl_load_open_tail()>
+ * @param tail content to write, ending with </svg>
+ * @return None
+ *
+ * @note the content is written and flushed to "<filename>.journal" first, then over the closing tag of the file,
+ *       which is flushed before the journal is removed: if the process dies halfway, the file either
+ *       keeps its old end or the journal is complete and replayed by the next <snl_load_open_tail()>
+ * @note the journal ends with a commit line holding the crc-32 of the header and the content, so that a journal
+ *       whose last writes did not reach the disk is recognized and dropped instead of replayed
+ */
+extern void snl_load_append(snl_load_t *const load, const vt_str_t *const tail);
+
+/**
+ * @brief Rebuild the elements of a mapped file on a canvas through its render calls
+ *
+ * @param load load instance opened with <snl_load_open()>
+ * @param canvas canvas to draw on
+ * @param filename file name for error messages
+ * @return None
+ *
+ * @note recognizes what snail writes: filters, gradients, classes, symbols, groups, text and the shapes,
+ *       including path data; other attributes are dropped and other elements stop with an error
+ */
+extern void snl_load_replay(const snl_load_t *const load, snl_canvas_t *const canvas, const char *const filename);
+
+#endif // SNAIL_LOAD_H
+
@@ -0,0 +1,298 @@
+#include "occlude.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// empty cell or end of a cell list
+#define SNL_OCCLUDE_NONE UINT32_MAX
+
+// the grid has at most this many cells per occluder
+#define SNL_OCCLUDE_CELLS_PER_RECT 4
+
+// occluder in a cell list; the box is stored in place to save an indirection per test
+typedef struct SnailOccluder {
+    float x0, y0, x1, y1;
+    uint32_t next;
+} snl_occluder_t;
+
+// occluders bucketed in a uniform grid; an occluder is listed in every cell it overlaps
+typedef struct SnailOccluderGrid {
+    float x, y;                     // top-left corner
+    float inv_width, inv_height;    // 1 / cell size
+    size_t cols, rows;
+    uint32_t *heads;                // first entry of each cell
+
+    // copies of the occluders in the lists of their cells
+    snl_occluder_t *entries;
+    size_t nentries;
+    size_t capacity;
+} snl_occluder_grid_t;
+
+static bool snl_occlude_is_occluder(const snl_display_list_t *const list, const size_t index, const float *const view, const int32_t precision, const float grid, float *const box);
+static bool snl_occlude_bounds(const snl_display_list_t *const list, const size_t index, const float slack, float *const box);
+static bool snl_occlude_has_filter(const snl_display_list_t *const list, const size_t index);
+static void snl_occlude_grid_init(snl_occluder_grid_t *const grid, const float *const bounds, const double width, const double height, const size_t n);
+static void snl_occlude_grid_free(snl_occluder_grid_t *const grid);
+static void snl_occlude_grid_range(const snl_occluder_grid_t *const grid, const float *const box, size_t *const range);
+static bool snl_occlude_grid_covers(const snl_occluder_grid_t *const grid, const float *const box);
+static void snl_occlude_grid_insert(snl_occluder_grid_t *const grid, const float *const box);
+
+size_t snl_occlude(snl_display_list_t *const list, const float width, const float height, const int32_t precision, const float grid) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // forget the previous pass
+    for (size_t i = 0; i < list->len; i++) {
+        list->flags[i] &= (uint8_t)~SNL_RECORD_FLAG_HIDDEN;
+    }
+
+    // the viewBox as written, and how far rounding may move an edge of a shape: both ends of a length move
+    const float view[4] = { 0, 0, (float)snl_round_coord(width, precision, 0), (float)snl_round_coord(height, precision, 0) };
+    const float slack = grid + powf(10, (float)-precision);
+
+    // occluders: bounds on the canvas and average size
+    float bounds[4] = { INFINITY, INFINITY, -INFINITY, -INFINITY };
+    double sum_width = 0, sum_height = 0;
+    size_t noccluders = 0;
+    int64_t depth = 0;
+    for (size_t i = 0; i < list->len; i++) {
+        if (list->flags[i] & SNL_RECORD_FLAG_DEAD) continue;
+        if (list->kind[i] == SNL_RECORD_GROUP) depth++;
+        if (list->kind[i] == SNL_RECORD_GROUP_END) depth--;
+
+        float box[4];
+        if (depth != 0 || !snl_occlude_is_occluder(list, i, view, precision, grid, box)) continue;
+
+        // clamp to the viewBox, where the grid is needed
+        const float x0 = fmaxf(box[0], view[0]), y0 = fmaxf(box[1], view[1]);
+        const float x1 = fminf(box[2], view[2]), y1 = fminf(box[3], view[3]);
+        bounds[0] = fminf(bounds[0], x0);
+        bounds[1] = fminf(bounds[1], y0);
+        bounds[2] = fmaxf(bounds[2], x1);
+        bounds[3] = fmaxf(bounds[3], y1);
+        sum_width += x1 - x0;
+        sum_height += y1 - y0;
+        noccluders++;
+    }
+    if (noccluders == 0) return 0;
+
+    // walk back from the last record, so that the grid holds the occluders drawn after the current one
+    snl_occluder_grid_t occluders;
+    snl_occlude_grid_init(&occluders, bounds, sum_width / (double)noccluders, sum_height / (double)noccluders, noccluders);
+
+    size_t hidden = 0;
+    depth = 0;
+    for (size_t i = list->len; i-- > 0;) {
+        if (list->flags[i] & SNL_RECORD_FLAG_DEAD) continue;
+        if (list->kind[i] == SNL_RECORD_GROUP_END) depth++;
+        if (list->kind[i] == SNL_RECORD_GROUP) depth--;
+        if (depth != 0) continue;
+
+        // only the part within the viewBox has to be covered
+        float box[4];
+        if (snl_occlude_bounds(list, i, slack, box)) {
+            box[0] = fmaxf(box[0], view[0]);
+            box[1] = fmaxf(box[1], view[1]);
+            box[2] = fminf(box[2], view[2]);
+            box[3] = fminf(box[3], view[3]);
+            if (box[0] <= box[2] && box[1] <= box[3] && snl_occlude_grid_covers(&occluders, box)) {
+                list->flags[i] |= SNL_RECORD_FLAG_HIDDEN;
+                hidden++;
+                continue;
+            }
+        }
+
+        // a hidden occluder lies inside another one, so only the visible ones go to the grid
+        if (snl_occlude_is_occluder(list, i, view, precision, grid, box)) {
+            snl_occlude_grid_insert(&occluders, box);
+        }
+    }
+
+    // free
+    snl_occlude_grid_free(&occluders);
+
+    return hidden;
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Check whether a record is an occluder and get the box it covers in the output
+ * @param list display list instance
+ * @param index record index
+ * @param view viewBox: x0, y0, x1, y1
+ * @param precision digits after the decimal point of the output
+ * @param grid grid of the output, 0 for none
+ * @param box x0, y0, x1, y1 as written; sides on or past the viewBox are pushed to infinity (set on return)
+ * @return false if the record is not an occluder or lies outside the viewBox
+ */
+static bool snl_occlude_is_occluder(const snl_display_list_t *const list, const size_t index, const float *const view, const int32_t precision, const float grid, float *const box) {
+    if (list->kind[index] != SNL_RECORD_RECTANGLE || list->radius[index] != 0) return false;
+
+    // opaque fill
+    const snl_record_appearance_t *const a = &list->appearances[list->appearance[index]];
+    if (a->fill_color.a != 255 || !(a->fill_opacity >= 1) || a->gradient != SNL_POOL_NONE) return false;
+    if (snl_occlude_has_filter(list, index)) return false;
+
+    // the rectangle as written; shapes with a negative or zero size are not drawn
+    const size_t first = list->first[index];
+    const double x = snl_round_coord(list->xs[first], precision, grid), y = snl_round_coord(list->ys[first], precision, grid);
+    const double w = snl_round_coord(list->size_x[index], precision, 0), h = snl_round_coord(list->size_y[index], precision, 0);
+    if (!(w > 0 && h > 0 && isfinite(x + w) && isfinite(y + h))) return false;
+
+    box[0] = (float)x;
+    box[1] = (float)y;
+    box[2] = (float)(x + w);
+    box[3] = (float)(y + h);
+    if (box[0] <= view[0]) box[0] = -INFINITY;
+    if (box[1] <= view[1]) box[1] = -INFINITY;
+    if (box[2] >= view[2]) box[2] = INFINITY;
+    if (box[3] >= view[3]) box[3] = INFINITY;
+
+    return box[0] < view[2] && view[0] < box[2] && box[1] < view[3] && view[1] < box[3];
+}
+
+/**
+ * @brief Get the box a record may paint, grown by its stroke and the slack
+ * @param list display list instance
+ * @param index record index
+ * @param slack rounding of the output
+ * @param box x0, y0, x1, y1 (set on return)
+ * @return false for the records that are never hidden: groups, instances, filtered shapes, empty point lists
+ */
+static bool snl_occlude_bounds(const snl_display_list_t *const list, const size_t index, const float slack, float *const box) {
+    if (!snl_display_list_bounds(list, index, box) || snl_occlude_has_filter(list, index)) return false;
+
+    // text boxes are already grown for the glyphs outside their advance; boxes with NaNs are never covered
+    box[0] -= slack;
+    box[1] -= slack;
+    box[2] += slack;
+    box[3] += slack;
+
+    return true;
+}
+
+/**
+ * @brief Check whether a record has a filter other than the no-op default one
+ * @param list display list instance
+ * @param index record index
+ * @return bool
+ */
+static bool snl_occlude_has_filter(const snl_display_list_t *const list, const size_t index) {
+    const uint32_t filter = list->appearances[list->appearance[index]].filter;
+    return filter != SNL_POOL_NONE && strcmp(snl_display_list_get_string(list, filter), SNL_FILTER_DEFAULT) != 0;
+}
+
+/**
+ * @brief Size an empty grid to cover the occluders, with cells of their average size
+ * @param grid grid instance (set on return)
+ * @param bounds x0, y0, x1, y1 of the occluders
+ * @param width average occluder width
+ * @param height average occluder height
+ * @param n number of occluders
+ * @return None
+ */
+static void snl_occlude_grid_init(snl_occluder_grid_t *const grid, const float *const bounds, const double width, const double height, const size_t n) {
+    *grid = (snl_occluder_grid_t) {0};
+
+    // cells of the average occluder size, doubled until the grid has at most a few cells per occluder
+    double cell_width = width > 0 ? width : 1;
+    double cell_height = height > 0 ? height : 1;
+    double cols = floor((bounds[2] - bounds[0]) / cell_width) + 1, rows = floor((bounds[3] - bounds[1]) / cell_height) + 1;
+    while (cols * rows > (double)(SNL_OCCLUDE_CELLS_PER_RECT * n + 64)) {
+        cell_width *= 2;
+        cell_height *= 2;
+        cols = floor((bounds[2] - bounds[0]) / cell_width) + 1;
+        rows = floor((bounds[3] - bounds[1]) / cell_height) + 1;
+    }
+
+    grid->x = bounds[0];
+    grid->y = bounds[1];
+    grid->inv_width = (float)(1 / cell_width);
+    grid->inv_height = (float)(1 / cell_height);
+    grid->cols = (size_t)cols;
+    grid->rows = (size_t)rows;
+
+    // allocate
+    grid->heads = malloc(grid->cols * grid->rows * sizeof(uint32_t));
+    VT_ENFORCE(grid->heads != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    memset(grid->heads, 0xFF, grid->cols * grid->rows * sizeof(uint32_t));
+}
+
+/**
+ * @brief Release grid memory
+ * @param grid grid instance
+ * @return None
+ */
+static void snl_occlude_grid_free(snl_occluder_grid_t *const grid) {
+    free(grid->heads);
+    free(grid->entries);
+}
+
+/**
+ * @brief Find the cells a box overlaps, clamped to the grid
+ * @param grid grid instance
+ * @param box x0, y0, x1, y1
+ * @param range first column, first row, last column, last row (set on return)
+ * @return None
+ */
+static void snl_occlude_grid_range(const snl_occluder_grid_t *const grid, const float *const box, size_t *const range) {
+    const float cx0 = (box[0] - grid->x) * grid->inv_width, cy0 = (box[1] - grid->y) * grid->inv_height;
+    const float cx1 = (box[2] - grid->x) * grid->inv_width, cy1 = (box[3] - grid->y) * grid->inv_height;
+
+    range[0] = cx0 > 0 ? (cx0 < (float)grid->cols ? (size_t)cx0 : grid->cols - 1) : 0;
+    range[1] = cy0 > 0 ? (cy0 < (float)grid->rows ? (size_t)cy0 : grid->rows - 1) : 0;
+    range[2] = cx1 > 0 ? (cx1 < (float)grid->cols ? (size_t)cx1 : grid->cols - 1) : 0;
+    range[3] = cy1 > 0 ? (cy1 < (float)grid->rows ? (size_t)cy1 : grid->rows - 1) : 0;
+}
+
+/**
+ * @brief Check whether a single occluder contains a box
+ * @param grid grid instance
+ * @param box x0, y0, x1, y1
+ * @return bool
+ *
+ * @note an occluder that contains the box contains its top-left corner, so only the cell of the corner is searched
+ */
+static bool snl_occlude_grid_covers(const snl_occluder_grid_t *const grid, const float *const box) {
+    size_t range[4];
+    snl_occlude_grid_range(grid, box, range);
+    for (uint32_t e = grid->heads[range[1] * grid->cols + range[0]]; e != SNL_OCCLUDE_NONE; e = grid->entries[e].next) {
+        const snl_occluder_t *const o = &grid->entries[e];
+        if (o->x0 <= box[0] && o->y0 <= box[1] && box[2] <= o->x1 && box[3] <= o->y1) return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Add an occluder to the cells it overlaps
+ * @param grid grid instance
+ * @param box x0, y0, x1, y1
+ * @return None
+ */
+static void snl_occlude_grid_insert(snl_occluder_grid_t *const grid, const float *const box) {
+    size_t range[4];
+    snl_occlude_grid_range(grid, box, range);
+    const size_t count = (range[2] - range[0] + 1) * (range[3] - range[1] + 1);
+
+    // grow
+    if (grid->nentries + count > grid->capacity) {
+        size_t capacity = grid->capacity ? grid->capacity * 2 : 1024;
+        while (capacity < grid->nentries + count) capacity *= 2;
+        VT_ENFORCE(capacity <= SNL_OCCLUDE_NONE, "Error: too many occluders!\n");
+        snl_occluder_t *const entries = realloc(grid->entries, capacity * sizeof(snl_occluder_t));
+        VT_ENFORCE(entries != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        grid->entries = entries;
+        grid->capacity = capacity;
+    }
+
+    for (size_t row = range[1]; row <= range[3]; row++) {
+        for (size_t col = range[0]; col <= range[2]; col++) {
+            const uint32_t e = (uint32_t)grid->nentries++;
+            grid->entries[e] = (snl_occluder_t) { box[0], box[1], box[2], box[3], grid->heads[row * grid->cols + col] };
+            grid->heads[row * grid->cols + col] = e;
+        }
+    }
+}
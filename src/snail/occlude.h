@@ -0,0 +1,32 @@
+#ifndef SNAIL_OCCLUDE_H
+#define SNAIL_OCCLUDE_H
+
+/** OCCLUDE MODULE (internal)
+ *  - snl_occlude
+ *
+ * @note an occluder is an opaque rectangle drawn outside any group: square corners, fully opaque fill color,
+ *       no filter and no gradient; a record is hidden if the box it may paint, grown by its stroke and clipped
+ *       to the viewBox, lies inside a single occluder drawn after it
+ * @note records inside groups, symbol instances and shapes with a filter are never hidden
+*/
+
+#include "record.h"
+
+/**
+ * @brief Mark the records covered by a later occluder with SNL_RECORD_FLAG_HIDDEN
+ *
+ * @param list display list instance
+ * @param width viewBox width
+ * @param height viewBox height
+ * @param precision digits after the decimal point of the output
+ * @param grid grid of the output, 0 for none
+ * @return number of hidden records
+ *
+ * @note the rectangles are taken as written, after rounding; the other shapes are grown by the largest
+ *       rounding error, so that what is hidden is covered in the output too
+ * @note the flags set by a previous call are cleared first
+ */
+extern size_t snl_occlude(snl_display_list_t *const list, const float width, const float height, const int32_t precision, const float grid);
+
+#endif // SNAIL_OCCLUDE_H
+
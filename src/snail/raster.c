@@ -0,0 +1,985 @@
+#include "snail/raster.h"
+#include "record.h"
+#include "defs.h"
+#include "scan.h"
+#include "cpu.h"
+#include "crc.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+// max distance in pixels between a curve and its flattened outline
+#define SNL_RASTER_TOLERANCE 0.25f
+
+// max segments per curve
+#define SNL_RASTER_SEGMENTS_MAX 1024
+
+// svg default stroke-miterlimit
+#define SNL_RASTER_MITER_LIMIT 4.0f
+
+// max bytes of a stored deflate block
+#define SNL_PNG_BLOCK_SIZE 65535
+
+// a worker of the parallel rasterizer: it draws the tiles of its range and steals from the others when done
+typedef struct SnailRasterWorker {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    size_t begin, end;          // tiles left, guarded by the lock
+    snl_scanner_t *scanner;
+    const struct SnailRasterJob *job;
+} snl_raster_worker_t;
+
+// shapes binned into tiles
+typedef struct SnailRasterJob {
+    const snl_canvas_t *canvas;
+    snl_raster_t *raster;
+    snl_transform_t base;           // canvas to pixels
+    snl_transform_t *transforms;    // canvas to pixels of each record inside groups, or NULL
+    size_t tiles_x;
+    uint32_t *tile_first;       // first entry of each tile in tile_records, plus the end
+    uint32_t *tile_records;     // records overlapping each tile, in drawing order
+    snl_raster_worker_t *workers;
+    size_t nworkers;
+} snl_raster_job_t;
+
+// png image data: stored deflate blocks, one per IDAT chunk
+typedef struct SnailPngStream {
+    snl_sink_t sink;
+    uint8_t block[SNL_PNG_BLOCK_SIZE];
+    size_t len;
+    uint32_t adler_a, adler_b;
+    bool started;
+} snl_png_stream_t;
+
+static bool snl_raster_is_drawn(const snl_display_list_t *const list, const size_t index);
+static snl_transform_t snl_raster_fit(const snl_canvas_t *const canvas, const snl_raster_t *const raster);
+static snl_transform_t *snl_raster_transforms(const snl_display_list_t *const list, const snl_transform_t base);
+static float snl_raster_stretch(const snl_transform_t *const m);
+static void snl_raster_draw(const snl_canvas_t *const canvas, snl_scanner_t *const s, const snl_scan_target_t *const target, const size_t index, const snl_transform_t *const m);
+static bool snl_raster_bounds(const snl_display_list_t *const list, const size_t index, const snl_transform_t *const m, float *const bounds);
+static void snl_raster_bin(snl_raster_job_t *const job);
+static void *snl_raster_work(void *arg);
+static bool snl_raster_take(snl_raster_worker_t *const worker, size_t *const tile);
+static bool snl_raster_steal(snl_raster_worker_t *const worker, size_t *const tile);
+static void snl_raster_draw_tile(const snl_raster_job_t *const job, snl_scanner_t *const s, const size_t tile);
+static bool snl_raster_paint(const snl_canvas_t *const canvas, const struct SnailColor color, const float opacity, const char *const gradient, const float *const bbox, snl_scan_paint_t *const paint);
+static void snl_raster_push(snl_scanner_t *const s, const snl_point_t point, const snl_transform_t *const m);
+static void snl_raster_ellipse(snl_scanner_t *const s, const snl_point_t origin, const float rx, const float ry, const snl_transform_t *const m);
+static void snl_raster_rectangle(snl_scanner_t *const s, const snl_point_t pos, const snl_point_t size, float radius, const snl_transform_t *const m);
+static void snl_raster_curve(snl_scanner_t *const s, const snl_point_t start, const snl_point_t control, const snl_point_t end, const snl_transform_t *const m);
+static void snl_raster_stroke(snl_scanner_t *const s, const bool closed, const float half_width);
+static void snl_raster_join(snl_scanner_t *const s, const snl_point_t prev, const snl_point_t v, const snl_point_t next, const float half_width);
+static size_t snl_raster_segments(const float radius, const float angle);
+static void snl_raster_write(const snl_sink_t sink, const void *const data, const size_t size);
+static void snl_png_chunk(const snl_sink_t sink, const char *const type, const uint8_t *const data, const size_t size);
+static void snl_png_put(snl_png_stream_t *const png, const uint8_t *data, size_t size);
+static void snl_png_block(snl_png_stream_t *const png, const bool final);
+static void snl_put_u32_be(uint8_t *const dst, const uint32_t value);
+
+snl_raster_t snl_raster_create(const uint32_t width, const uint32_t height) {
+    VT_ENFORCE(width > 0 && height > 0, "Error: raster size must be positive!\n");
+
+    // allocate
+    uint8_t *const pixels = calloc((size_t)width * height, 4);
+    VT_ENFORCE(pixels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    return (snl_raster_t) {
+        .width = width,
+        .height = height,
+        .pixels = pixels,
+        .scanner = snl_scanner_create()
+    };
+}
+
+void snl_raster_destroy(snl_raster_t *const raster) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(raster != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    free(raster->pixels);
+    snl_scanner_destroy(raster->scanner);
+    raster->pixels = NULL;
+    raster->scanner = NULL;
+}
+
+void snl_raster_clear(snl_raster_t *const raster, const struct SnailColor color) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(raster != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(raster->pixels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // rgba() alpha is clamped to 1, so any alpha is opaque
+    const uint8_t px[4] = { color.a ? color.r : 0, color.a ? color.g : 0, color.a ? color.b : 0, color.a ? 255 : 0 };
+    const size_t n = (size_t)raster->width * raster->height;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(raster->pixels + 4 * i, px, 4);
+    }
+}
+
+void snl_canvas_rasterize(const snl_canvas_t *const canvas, snl_raster_t *const raster) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(raster != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(raster->pixels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(canvas->list != NULL, "Error: canvas was not created with SNL_CANVAS_RETAINED!\n");
+    if (canvas->width <= 0 || canvas->height <= 0) return;
+
+    // fit the canvas into the raster, then place the elements of groups
+    const snl_transform_t base = snl_raster_fit(canvas, raster);
+    snl_transform_t *const transforms = snl_raster_transforms(canvas->list, base);
+
+    // draw
+    const snl_scan_target_t target = { .pixels = raster->pixels, .width = raster->width, .x1 = raster->width, .y1 = raster->height };
+    for (size_t i = 0; i < canvas->list->len; i++) {
+        if (!snl_raster_is_drawn(canvas->list, i)) continue;
+        snl_raster_draw(canvas, raster->scanner, &target, i, transforms ? &transforms[i] : &base);
+    }
+
+    free(transforms);
+}
+
+void snl_canvas_rasterize_parallel(const snl_canvas_t *const canvas, snl_raster_t *const raster, size_t nthreads) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(raster != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(raster->pixels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_ENFORCE(canvas->list != NULL, "Error: canvas was not created with SNL_CANVAS_RETAINED!\n");
+    if (canvas->width <= 0 || canvas->height <= 0) return;
+
+    // a single thread draws without tiles
+    if (nthreads == 0) nthreads = snl_cpu_count();
+    if (nthreads == 1) {
+        snl_canvas_rasterize(canvas, raster);
+        return;
+    }
+
+    // bin the shapes
+    snl_raster_job_t job = {
+        .canvas = canvas,
+        .raster = raster,
+        .base = snl_raster_fit(canvas, raster),
+        .tiles_x = (raster->width + SNL_RASTER_TILE_SIZE - 1) / SNL_RASTER_TILE_SIZE
+    };
+    const size_t ntiles = job.tiles_x * ((raster->height + SNL_RASTER_TILE_SIZE - 1) / SNL_RASTER_TILE_SIZE);
+    job.transforms = snl_raster_transforms(canvas->list, job.base);
+    snl_raster_bin(&job);
+
+    // workers start with equal runs of tiles
+    job.nworkers = nthreads < ntiles ? nthreads : ntiles;
+    job.workers = calloc(job.nworkers, sizeof(snl_raster_worker_t));
+    VT_ENFORCE(job.workers != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    for (size_t i = 0; i < job.nworkers; i++) {
+        snl_raster_worker_t *const worker = &job.workers[i];
+        pthread_mutex_init(&worker->lock, NULL);
+        worker->begin = ntiles * i / job.nworkers;
+        worker->end = ntiles * (i + 1) / job.nworkers;
+        worker->scanner = i == 0 ? raster->scanner : snl_scanner_create();
+        worker->job = &job;
+    }
+
+    // the calling thread is the first worker; tiles of a thread that failed to start are stolen by the others
+    bool *const started = calloc(job.nworkers, sizeof(bool));
+    VT_ENFORCE(started != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    for (size_t i = 1; i < job.nworkers; i++) {
+        started[i] = pthread_create(&job.workers[i].thread, NULL, snl_raster_work, &job.workers[i]) == 0;
+    }
+    snl_raster_work(&job.workers[0]);
+    for (size_t i = 1; i < job.nworkers; i++) {
+        if (started[i]) pthread_join(job.workers[i].thread, NULL);
+    }
+
+    // free
+    for (size_t i = 0; i < job.nworkers; i++) {
+        if (i > 0) snl_scanner_destroy(job.workers[i].scanner);
+        pthread_mutex_destroy(&job.workers[i].lock);
+    }
+
+    free(started);
+    free(job.workers);
+    free(job.tile_first);
+    free(job.tile_records);
+    free(job.transforms);
+}
+
+void snl_raster_write_ppm(const snl_raster_t *const raster, const snl_sink_t sink) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(raster != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(raster->pixels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(sink.write != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // header
+    char header[64];
+    const int len = snprintf(header, sizeof(header), "P6\n%u %u\n255\n", raster->width, raster->height);
+    snl_raster_write(sink, header, (size_t)len);
+
+    // rows over white
+    uint8_t *const row = malloc((size_t)raster->width * 3);
+    VT_ENFORCE(row != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    for (size_t y = 0; y < raster->height; y++) {
+        const uint8_t *const src = raster->pixels + y * raster->width * 4;
+        for (size_t x = 0; x < raster->width; x++) {
+            const uint8_t *const px = src + 4 * x;
+            row[3 * x + 0] = (uint8_t)(px[0] + 255 - px[3]);
+            row[3 * x + 1] = (uint8_t)(px[1] + 255 - px[3]);
+            row[3 * x + 2] = (uint8_t)(px[2] + 255 - px[3]);
+        }
+        snl_raster_write(sink, row, (size_t)raster->width * 3);
+    }
+    free(row);
+}
+
+void snl_raster_write_png(const snl_raster_t *const raster, const snl_sink_t sink) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(raster != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(raster->pixels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(sink.write != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // signature and header: 8-bit rgba, no interlacing
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    snl_raster_write(sink, signature, sizeof(signature));
+    uint8_t ihdr[13] = { 0, 0, 0, 0, 0, 0, 0, 0, 8, 6, 0, 0, 0 };
+    snl_put_u32_be(ihdr, raster->width);
+    snl_put_u32_be(ihdr + 4, raster->height);
+    snl_png_chunk(sink, "IHDR", ihdr, sizeof(ihdr));
+
+    // image data: each row starts with filter type 0, colors are not premultiplied
+    snl_png_stream_t *const png = malloc(sizeof(snl_png_stream_t));
+    uint8_t *const row = malloc((size_t)raster->width * 4 + 1);
+    VT_ENFORCE(png != NULL && row != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    png->sink = sink;
+    png->len = 0;
+    png->adler_a = 1;
+    png->adler_b = 0;
+    png->started = false;
+
+    row[0] = 0;
+    for (size_t y = 0; y < raster->height; y++) {
+        const uint8_t *const src = raster->pixels + y * raster->width * 4;
+        for (size_t x = 0; x < raster->width; x++) {
+            const uint8_t *const px = src + 4 * x;
+            uint8_t *const dst = row + 1 + 4 * x;
+            const uint32_t a = px[3];
+            dst[0] = a ? (uint8_t)((px[0] * 255u + a / 2) / a) : 0;
+            dst[1] = a ? (uint8_t)((px[1] * 255u + a / 2) / a) : 0;
+            dst[2] = a ? (uint8_t)((px[2] * 255u + a / 2) / a) : 0;
+            dst[3] = (uint8_t)a;
+        }
+        snl_png_put(png, row, (size_t)raster->width * 4 + 1);
+    }
+    snl_png_block(png, true);
+    free(row);
+    free(png);
+
+    // end
+    snl_png_chunk(sink, "IEND", NULL, 0);
+}
+
+void snl_raster_save_ppm(const snl_raster_t *const raster, const char *const filename) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    FILE *const fp = fopen(filename, "wb");
+    VT_ENFORCE(fp != NULL, "Error: failed to open '%s'!\n", filename);
+    snl_raster_write_ppm(raster, snl_sink_file(fp));
+    fclose(fp);
+}
+
+void snl_raster_save_png(const snl_raster_t *const raster, const char *const filename) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(filename != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    FILE *const fp = fopen(filename, "wb");
+    VT_ENFORCE(fp != NULL, "Error: failed to open '%s'!\n", filename);
+    snl_raster_write_png(raster, snl_sink_file(fp));
+    fclose(fp);
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Check whether a record is rasterized: text, symbol instances and group boundaries are not
+ * @param list display list instance
+ * @param index record index
+ * @return bool
+ */
+static bool snl_raster_is_drawn(const snl_display_list_t *const list, const size_t index) {
+    if (list->flags[index] & SNL_RECORD_FLAG_DEAD) return false;
+    switch (list->kind[index]) {
+        case SNL_RECORD_TEXT:
+        case SNL_RECORD_INSTANCE:
+        case SNL_RECORD_GROUP:
+        case SNL_RECORD_GROUP_END:
+            return false;
+        default:
+            return true;
+    }
+}
+
+/**
+ * @brief Canvas to pixels transform: the canvas is scaled to fit and centered
+ * @param canvas canvas instance
+ * @param raster raster instance
+ * @return snl_transform_t
+ */
+static snl_transform_t snl_raster_fit(const snl_canvas_t *const canvas, const snl_raster_t *const raster) {
+    const float scale = fminf(raster->width / canvas->width, raster->height / canvas->height);
+
+    return SNL_TRANSFORM(scale, 0, 0, scale, (raster->width - canvas->width * scale) / 2, (raster->height - canvas->height * scale) / 2);
+}
+
+/**
+ * @brief Compose the transforms of the groups enclosing each record
+ * @param list display list instance
+ * @param base canvas to pixels transform
+ * @return transform of each record, or NULL if there are no groups
+ */
+static snl_transform_t *snl_raster_transforms(const snl_display_list_t *const list, const snl_transform_t base) {
+    size_t i = 0;
+    while (i < list->len && list->kind[i] != SNL_RECORD_GROUP) i++;
+    if (i == list->len) return NULL;
+
+    snl_transform_t *const transforms = malloc(list->len * sizeof(snl_transform_t));
+    VT_ENFORCE(transforms != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    // a group record keeps the transform in effect before it, which its closing record restores
+    snl_transform_t current = base;
+    for (i = 0; i < list->len; i++) {
+        transforms[i] = current;
+        if (list->kind[i] == SNL_RECORD_GROUP) {
+            const float *const xs = list->xs + list->first[i], *const ys = list->ys + list->first[i];
+            current = snl_transform_multiply(current, SNL_TRANSFORM(xs[1], ys[1], xs[2], ys[2], xs[0], ys[0]));
+        } else if (list->kind[i] == SNL_RECORD_GROUP_END) {
+            current = transforms[i] = transforms[list->style[i]];
+        }
+    }
+
+    return transforms;
+}
+
+/**
+ * @brief Largest factor by which a transform stretches lengths, used for tolerances
+ * @param m transform
+ * @return float
+ */
+static float snl_raster_stretch(const snl_transform_t *const m) {
+    return sqrtf(fmaxf(m->a * m->a + m->b * m->b, m->c * m->c + m->d * m->d));
+}
+
+/**
+ * @brief Fill and stroke a single record
+ * @param canvas canvas instance
+ * @param s scanner instance
+ * @param target pixels and clip box
+ * @param index record index
+ * @param m canvas to pixels transform
+ * @return None
+ */
+static void snl_raster_draw(const snl_canvas_t *const canvas, snl_scanner_t *const s, const snl_scan_target_t *const target, const size_t index, const snl_transform_t *const m) {
+    const snl_display_list_t *const list = canvas->list;
+    const snl_appearance_t appearance = snl_display_list_get_appearance(list, index);
+    const size_t first = list->first[index];
+    const size_t count = list->count[index];
+    const snl_point_t p0 = count > 0 ? SNL_POINT(list->xs[first], list->ys[first]) : SNL_POINT(0, 0);
+    const snl_point_t p1 = count > 1 ? SNL_POINT(list->xs[first + 1], list->ys[first + 1]) : SNL_POINT(0, 0);
+
+    // flatten the outline
+    s->npoints = 0;
+    bool closed = true, fillable = true;
+    snl_fill_rule_t rule = SNL_FILL_NONZERO;
+    switch (list->kind[index]) {
+        case SNL_RECORD_LINE:
+            snl_raster_push(s, p0, m);
+            snl_raster_push(s, p1, m);
+            closed = fillable = false;
+            break;
+        case SNL_RECORD_CIRCLE:
+            snl_raster_ellipse(s, p0, list->radius[index], list->radius[index], m);
+            break;
+        case SNL_RECORD_ELLIPSE:
+            snl_raster_ellipse(s, p0, list->size_x[index], list->size_y[index], m);
+            break;
+        case SNL_RECORD_RECTANGLE:
+            snl_raster_rectangle(s, p0, SNL_POINT(list->size_x[index], list->size_y[index]), list->radius[index], m);
+            break;
+        case SNL_RECORD_POLYGON:
+        case SNL_RECORD_POLYLINE:
+        case SNL_RECORD_PATH: {
+            for (size_t i = first; i < first + count; i++) {
+                snl_raster_push(s, SNL_POINT(list->xs[i], list->ys[i]), m);
+            }
+            const char *const fill_rule = snl_display_list_get_string(list, list->aux[index]);
+            if (fill_rule && strcmp(fill_rule, SNL_FILL_RULE_EVENODD) == 0) rule = SNL_FILL_EVENODD;
+            closed = list->kind[index] == SNL_RECORD_POLYGON;
+        } break;
+        case SNL_RECORD_CURVE:
+            snl_raster_curve(s, p0, SNL_POINT(p0.x + list->size_x[index], p0.y + list->size_y[index]), p1, m);
+            closed = false;
+            break;
+        default:
+            break;
+    }
+    if (s->npoints < 2) return;
+
+    // gradient bounding box: the geometry without the stroke
+    float min_x = s->points[0].x, min_y = s->points[0].y, max_x = min_x, max_y = min_y;
+    for (size_t i = 1; i < s->npoints; i++) {
+        min_x = fminf(min_x, s->points[i].x);
+        min_y = fminf(min_y, s->points[i].y);
+        max_x = fmaxf(max_x, s->points[i].x);
+        max_y = fmaxf(max_y, s->points[i].y);
+    }
+    const float bbox[4] = { min_x, min_y, max_x - min_x, max_y - min_y };
+
+    // fill, open outlines are closed implicitly
+    snl_scan_paint_t paint;
+    if (fillable && s->npoints > 2 && snl_raster_paint(canvas, appearance.fill_color, appearance.fill_opacity, appearance.gradient, bbox, &paint)) {
+        snl_scanner_add_ring(s, s->points, s->npoints);
+        snl_scanner_fill(s, target, rule, &paint);
+    }
+
+    // stroke
+    if (appearance.stroke_width > 0 && snl_raster_paint(canvas, appearance.stroke_color, appearance.stroke_opacity, appearance.gradient, bbox, &paint)) {
+        snl_raster_stroke(s, closed, appearance.stroke_width * sqrtf(fabsf(m->a * m->d - m->b * m->c)) / 2);
+        snl_scanner_fill(s, target, SNL_FILL_NONZERO, &paint);
+    }
+}
+
+/**
+ * @brief Pixel bounds of a record, stroke included
+ * @param list display list instance
+ * @param index record index
+ * @param m canvas to pixels transform
+ * @param bounds min x, min y, max x, max y (set on return)
+ * @return false if the record draws nothing
+ */
+static bool snl_raster_bounds(const snl_display_list_t *const list, const size_t index, const snl_transform_t *const m, float *const bounds) {
+    const size_t first = list->first[index], count = list->count[index];
+    if (count == 0) return false;
+
+    // geometry
+    float min_x = list->xs[first], min_y = list->ys[first], max_x = min_x, max_y = min_y;
+    switch (list->kind[index]) {
+        case SNL_RECORD_CIRCLE:
+            min_x -= list->radius[index];
+            min_y -= list->radius[index];
+            max_x += list->radius[index];
+            max_y += list->radius[index];
+            break;
+        case SNL_RECORD_ELLIPSE:
+            min_x -= list->size_x[index];
+            min_y -= list->size_y[index];
+            max_x += list->size_x[index];
+            max_y += list->size_y[index];
+            break;
+        case SNL_RECORD_RECTANGLE:
+            max_x += list->size_x[index];
+            max_y += list->size_y[index];
+            break;
+        case SNL_RECORD_CURVE:
+            // the curve stays inside the triangle of its start, control and end points
+            min_x = fminf(min_x, min_x + list->size_x[index]);
+            min_y = fminf(min_y, min_y + list->size_y[index]);
+            max_x = fmaxf(max_x, max_x + list->size_x[index]);
+            max_y = fmaxf(max_y, max_y + list->size_y[index]);
+            /* fallthrough */
+        default:
+            for (size_t i = first + 1; i < first + count; i++) {
+                min_x = fminf(min_x, list->xs[i]);
+                min_y = fminf(min_y, list->ys[i]);
+                max_x = fmaxf(max_x, list->xs[i]);
+                max_y = fmaxf(max_y, list->ys[i]);
+            }
+            break;
+    }
+
+    // corners in pixels
+    const snl_point_t corners[4] = {
+        snl_transform_apply(*m, SNL_POINT(min_x, min_y)), snl_transform_apply(*m, SNL_POINT(max_x, min_y)),
+        snl_transform_apply(*m, SNL_POINT(max_x, max_y)), snl_transform_apply(*m, SNL_POINT(min_x, max_y))
+    };
+    bounds[0] = bounds[2] = corners[0].x;
+    bounds[1] = bounds[3] = corners[0].y;
+    for (size_t i = 1; i < 4; i++) {
+        bounds[0] = fminf(bounds[0], corners[i].x);
+        bounds[1] = fminf(bounds[1], corners[i].y);
+        bounds[2] = fmaxf(bounds[2], corners[i].x);
+        bounds[3] = fmaxf(bounds[3], corners[i].y);
+    }
+
+    // miter joins reach at most SNL_RASTER_MITER_LIMIT half widths out, plus a pixel of anti-aliasing
+    const float stroke_width = list->appearances[list->appearance[index]].stroke_width;
+    const float pad = (stroke_width > 0 ? stroke_width * SNL_RASTER_MITER_LIMIT / 2 : 0) * snl_raster_stretch(m) + 1;
+    bounds[0] -= pad;
+    bounds[1] -= pad;
+    bounds[2] += pad;
+    bounds[3] += pad;
+
+    return isfinite(bounds[0]) && isfinite(bounds[1]) && isfinite(bounds[2]) && isfinite(bounds[3]);
+}
+
+/**
+ * @brief Bin the records into the tiles they overlap, keeping the drawing order within each tile
+ * @param job rasterization job
+ * @return None
+ */
+static void snl_raster_bin(snl_raster_job_t *const job) {
+    const snl_display_list_t *const list = job->canvas->list;
+    const size_t tiles_y = (job->raster->height + SNL_RASTER_TILE_SIZE - 1) / SNL_RASTER_TILE_SIZE;
+    const size_t ntiles = job->tiles_x * tiles_y;
+    job->tile_first = calloc(ntiles + 1, sizeof(uint32_t));
+    VT_ENFORCE(job->tile_first != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    // count per tile, then place; both passes walk the records in order
+    uint32_t *cursor = NULL;
+    for (size_t pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < list->len; i++) {
+            if (!snl_raster_is_drawn(list, i)) continue;
+
+            float bounds[4];
+            if (!snl_raster_bounds(list, i, job->transforms ? &job->transforms[i] : &job->base, bounds)) continue;
+            if (bounds[2] < 0 || bounds[3] < 0 || bounds[0] >= job->raster->width || bounds[1] >= job->raster->height) continue;
+
+            const size_t tx0 = bounds[0] > 0 ? (size_t)bounds[0] / SNL_RASTER_TILE_SIZE : 0;
+            const size_t ty0 = bounds[1] > 0 ? (size_t)bounds[1] / SNL_RASTER_TILE_SIZE : 0;
+            const size_t tx1 = bounds[2] < job->raster->width ? (size_t)bounds[2] / SNL_RASTER_TILE_SIZE : job->tiles_x - 1;
+            const size_t ty1 = bounds[3] < job->raster->height ? (size_t)bounds[3] / SNL_RASTER_TILE_SIZE : tiles_y - 1;
+            for (size_t ty = ty0; ty <= ty1; ty++) {
+                for (size_t tx = tx0; tx <= tx1; tx++) {
+                    const size_t tile = ty * job->tiles_x + tx;
+                    if (pass == 0) {
+                        job->tile_first[tile + 1]++;
+                    } else {
+                        job->tile_records[cursor[tile]++] = (uint32_t)i;
+                    }
+                }
+            }
+        }
+
+        // prefix sums
+        if (pass == 0) {
+            for (size_t t = 0; t < ntiles; t++) job->tile_first[t + 1] += job->tile_first[t];
+            job->tile_records = malloc(sizeof(uint32_t) * (job->tile_first[ntiles] ? job->tile_first[ntiles] : 1));
+            cursor = malloc(sizeof(uint32_t) * ntiles);
+            VT_ENFORCE(job->tile_records != NULL && cursor != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+            memcpy(cursor, job->tile_first, sizeof(uint32_t) * ntiles);
+        }
+    }
+
+    free(cursor);
+}
+
+/**
+ * @brief Worker loop: draw own tiles, then steal until no tiles are left
+ * @param arg snl_raster_worker_t*
+ * @return NULL
+ */
+static void *snl_raster_work(void *arg) {
+    snl_raster_worker_t *const worker = arg;
+
+    size_t tile;
+    while (snl_raster_take(worker, &tile) || snl_raster_steal(worker, &tile)) {
+        snl_raster_draw_tile(worker->job, worker->scanner, tile);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Take the next tile of the worker's own range
+ * @param worker worker
+ * @param tile tile index (set on return)
+ * @return false if the range is empty
+ */
+static bool snl_raster_take(snl_raster_worker_t *const worker, size_t *const tile) {
+    pthread_mutex_lock(&worker->lock);
+    const bool found = worker->begin < worker->end;
+    if (found) *tile = worker->begin++;
+    pthread_mutex_unlock(&worker->lock);
+
+    return found;
+}
+
+/**
+ * @brief Move the back half of another worker's range to this worker and take its first tile
+ * @param worker worker with an empty range
+ * @param tile tile index (set on return)
+ * @return false if all ranges are empty
+ */
+static bool snl_raster_steal(snl_raster_worker_t *const worker, size_t *const tile) {
+    const snl_raster_job_t *const job = worker->job;
+    const size_t self = (size_t)(worker - job->workers);
+    for (size_t i = 1; i < job->nworkers; i++) {
+        snl_raster_worker_t *const victim = &job->workers[(self + i) % job->nworkers];
+
+        // split the victim's range
+        pthread_mutex_lock(&victim->lock);
+        const size_t left = victim->end - victim->begin;
+        const size_t end = victim->end;
+        if (left > 0) victim->end -= (left + 1) / 2;
+        const size_t begin = victim->end;
+        pthread_mutex_unlock(&victim->lock);
+        if (left == 0) continue;
+
+        pthread_mutex_lock(&worker->lock);
+        worker->begin = begin + 1;
+        worker->end = end;
+        pthread_mutex_unlock(&worker->lock);
+        *tile = begin;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Draw the records of a tile clipped to it
+ * @param job rasterization job
+ * @param s scanner of the drawing thread
+ * @param tile tile index
+ * @return None
+ */
+static void snl_raster_draw_tile(const snl_raster_job_t *const job, snl_scanner_t *const s, const size_t tile) {
+    const size_t x0 = tile % job->tiles_x * SNL_RASTER_TILE_SIZE, y0 = tile / job->tiles_x * SNL_RASTER_TILE_SIZE;
+    const snl_scan_target_t target = {
+        .pixels = job->raster->pixels,
+        .width = job->raster->width,
+        .x0 = x0, .y0 = y0,
+        .x1 = x0 + SNL_RASTER_TILE_SIZE < job->raster->width ? x0 + SNL_RASTER_TILE_SIZE : job->raster->width,
+        .y1 = y0 + SNL_RASTER_TILE_SIZE < job->raster->height ? y0 + SNL_RASTER_TILE_SIZE : job->raster->height
+    };
+
+    for (size_t i = job->tile_first[tile]; i < job->tile_first[tile + 1]; i++) {
+        const size_t index = job->tile_records[i];
+        snl_raster_draw(job->canvas, s, &target, index, job->transforms ? &job->transforms[index] : &job->base);
+    }
+}
+
+/**
+ * @brief Resolve a stroke or fill paint the way it is written to svg
+ * @param canvas canvas instance
+ * @param color color
+ * @param opacity opacity
+ * @param gradient gradient id used instead of SNL_COLOR_NONE, or NULL
+ * @param bbox bounding box in pixels: x, y, width, height
+ * @param paint paint (set on return)
+ * @return false if nothing is painted
+ */
+static bool snl_raster_paint(const snl_canvas_t *const canvas, const struct SnailColor color, const float opacity, const char *const gradient, const float *const bbox, snl_scan_paint_t *const paint) {
+    const float alpha = fminf(fmaxf(opacity, 0), 1);
+    if (gradient && snl_color_is_none(color)) {
+        // an unknown gradient paints nothing, as does a bounding box without area
+        const snl_gradient_t *const g = snl_defs_get_gradient(canvas->defs, gradient);
+        if (g == NULL || bbox[2] <= 0 || bbox[3] <= 0 || alpha == 0) return false;
+
+        *paint = (snl_scan_paint_t) { .gradient = g, .opacity = alpha, .bbox = { bbox[0], bbox[1], bbox[2], bbox[3] } };
+        return true;
+    }
+
+    // rgba() alpha is clamped to 1
+    if (color.a == 0 || alpha == 0) return false;
+    *paint = (snl_scan_paint_t) { .color = { color.r / 255.0f * alpha, color.g / 255.0f * alpha, color.b / 255.0f * alpha, alpha } };
+
+    return true;
+}
+
+/**
+ * @brief Append an outline point in pixels, skipping repeated points
+ * @param s scanner instance
+ * @param point point in canvas units
+ * @param m canvas to pixels transform
+ * @return None
+ */
+static void snl_raster_push(snl_scanner_t *const s, const snl_point_t point, const snl_transform_t *const m) {
+    const snl_point_t p = SNL_POINT(m->a * point.x + m->c * point.y + m->e, m->b * point.x + m->d * point.y + m->f);
+    if (s->npoints > 0 && s->points[s->npoints - 1].x == p.x && s->points[s->npoints - 1].y == p.y) return;
+    snl_scanner_push_point(s, p);
+}
+
+/**
+ * @brief Flatten an ellipse
+ * @param s scanner instance
+ * @param origin center
+ * @param rx horizontal radius
+ * @param ry vertical radius
+ * @param m canvas to pixels transform
+ * @return None
+ */
+static void snl_raster_ellipse(snl_scanner_t *const s, const snl_point_t origin, const float rx, const float ry, const snl_transform_t *const m) {
+    if (rx <= 0 || ry <= 0) return;
+
+    const size_t n = snl_raster_segments(fmaxf(rx, ry) * snl_raster_stretch(m), 2 * (float)M_PI);
+    for (size_t i = 0; i < n; i++) {
+        const float angle = 2 * (float)M_PI * i / n;
+        snl_raster_push(s, SNL_POINT(origin.x + rx * cosf(angle), origin.y + ry * sinf(angle)), m);
+    }
+}
+
+/**
+ * @brief Flatten a rectangle with rounded corners
+ * @param s scanner instance
+ * @param pos top left corner
+ * @param size width and height
+ * @param radius corner radius
+ * @param m canvas to pixels transform
+ * @return None
+ */
+static void snl_raster_rectangle(snl_scanner_t *const s, const snl_point_t pos, const snl_point_t size, float radius, const snl_transform_t *const m) {
+    if (size.x <= 0 || size.y <= 0) return;
+
+    // sharp corners
+    radius = fminf(radius, fminf(size.x, size.y) / 2);
+    if (radius <= 0) {
+        snl_raster_push(s, pos, m);
+        snl_raster_push(s, SNL_POINT(pos.x + size.x, pos.y), m);
+        snl_raster_push(s, SNL_POINT(pos.x + size.x, pos.y + size.y), m);
+        snl_raster_push(s, SNL_POINT(pos.x, pos.y + size.y), m);
+        return;
+    }
+
+    // quarter arcs from the top right corner, clockwise; the straight sides connect them
+    const snl_point_t centers[4] = {
+        SNL_POINT(pos.x + size.x - radius, pos.y + radius),
+        SNL_POINT(pos.x + size.x - radius, pos.y + size.y - radius),
+        SNL_POINT(pos.x + radius, pos.y + size.y - radius),
+        SNL_POINT(pos.x + radius, pos.y + radius)
+    };
+    const size_t n = snl_raster_segments(radius * snl_raster_stretch(m), (float)M_PI / 2);
+    for (size_t corner = 0; corner < 4; corner++) {
+        for (size_t i = 0; i <= n; i++) {
+            const float angle = (float)M_PI / 2 * ((float)corner - 1 + (float)i / n);
+            snl_raster_push(s, SNL_POINT(centers[corner].x + radius * cosf(angle), centers[corner].y + radius * sinf(angle)), m);
+        }
+    }
+}
+
+/**
+ * @brief Flatten a quadratic bezier curve
+ * @param s scanner instance
+ * @param start start point
+ * @param control control point
+ * @param end end point
+ * @param m canvas to pixels transform
+ * @return None
+ */
+static void snl_raster_curve(snl_scanner_t *const s, const snl_point_t start, const snl_point_t control, const snl_point_t end, const snl_transform_t *const m) {
+    // the flattening error of n segments is |start - 2 * control + end| / (8 * n^2)
+    const float dd = hypotf(start.x - 2 * control.x + end.x, start.y - 2 * control.y + end.y) * snl_raster_stretch(m);
+    const float segments = ceilf(sqrtf(dd / (8 * SNL_RASTER_TOLERANCE)));
+    const size_t n = segments < 1 ? 1 : segments > SNL_RASTER_SEGMENTS_MAX ? SNL_RASTER_SEGMENTS_MAX : (size_t)segments;
+
+    for (size_t i = 0; i <= n; i++) {
+        const float t = (float)i / n, u = 1 - t;
+        snl_raster_push(s, SNL_POINT(
+            u * u * start.x + 2 * u * t * control.x + t * t * end.x,
+            u * u * start.y + 2 * u * t * control.y + t * t * end.y
+        ), m);
+    }
+}
+
+/**
+ * @brief Add the stroke of the outline as convex pieces: a quad per segment, miter or bevel joins and butt caps
+ * @param s scanner instance
+ * @param closed whether the outline is closed
+ * @param half_width half of the stroke width in pixels
+ * @return None
+ */
+static void snl_raster_stroke(snl_scanner_t *const s, const bool closed, const float half_width) {
+    const snl_point_t *const p = s->points;
+    size_t n = s->npoints;
+    if (closed && n > 2 && p[0].x == p[n - 1].x && p[0].y == p[n - 1].y) n--;
+
+    // segments
+    const size_t nsegments = closed && n > 2 ? n : n - 1;
+    for (size_t i = 0; i < nsegments; i++) {
+        const snl_point_t a = p[i], b = p[(i + 1) % n];
+        const float len = hypotf(b.x - a.x, b.y - a.y);
+        if (len == 0) continue;
+
+        const float nx = -(b.y - a.y) / len * half_width, ny = (b.x - a.x) / len * half_width;
+        const snl_point_t quad[4] = {
+            SNL_POINT(a.x + nx, a.y + ny), SNL_POINT(b.x + nx, b.y + ny),
+            SNL_POINT(b.x - nx, b.y - ny), SNL_POINT(a.x - nx, a.y - ny)
+        };
+        snl_scanner_add_convex(s, quad, 4);
+    }
+
+    // joins
+    if (closed && n > 2) {
+        for (size_t i = 0; i < n; i++) {
+            snl_raster_join(s, p[(i + n - 1) % n], p[i], p[(i + 1) % n], half_width);
+        }
+    } else {
+        for (size_t i = 1; i + 1 < n; i++) {
+            snl_raster_join(s, p[i - 1], p[i], p[i + 1], half_width);
+        }
+    }
+}
+
+/**
+ * @brief Add the outer join between two stroked segments
+ * @param s scanner instance
+ * @param prev previous point
+ * @param v joint
+ * @param next next point
+ * @param half_width half of the stroke width in pixels
+ * @return None
+ */
+static void snl_raster_join(snl_scanner_t *const s, const snl_point_t prev, const snl_point_t v, const snl_point_t next, const float half_width) {
+    const float len0 = hypotf(v.x - prev.x, v.y - prev.y), len1 = hypotf(next.x - v.x, next.y - v.y);
+    if (len0 == 0 || len1 == 0) return;
+
+    // directions and turn
+    const float d0x = (v.x - prev.x) / len0, d0y = (v.y - prev.y) / len0;
+    const float d1x = (next.x - v.x) / len1, d1y = (next.y - v.y) / len1;
+    const float cross = d0x * d1y - d0y * d1x, dot = d0x * d1x + d0y * d1y;
+    if (fabsf(cross) < 1e-6f && dot > 0) return;
+
+    // offsets on the outer side of the turn
+    const float side = cross > 0 ? -half_width : half_width;
+    const float n0x = -d0y * side, n0y = d0x * side;
+    const float n1x = -d1y * side, n1y = d1x * side;
+    const snl_point_t a = SNL_POINT(v.x + n0x, v.y + n0y), b = SNL_POINT(v.x + n1x, v.y + n1y);
+
+    // miter tip, v + (n0 + n1) / (1 + cos(turn)), within the miter limit, otherwise a bevel
+    const float k = 1 + dot;
+    if (k > 1e-6f) {
+        const float mx = (n0x + n1x) / k, my = (n0y + n1y) / k;
+        if (mx * mx + my * my <= SNL_RASTER_MITER_LIMIT * SNL_RASTER_MITER_LIMIT * half_width * half_width) {
+            const snl_point_t miter[4] = { v, a, SNL_POINT(v.x + mx, v.y + my), b };
+            snl_scanner_add_convex(s, miter, 4);
+            return;
+        }
+    }
+    const snl_point_t bevel[3] = { v, a, b };
+    snl_scanner_add_convex(s, bevel, 3);
+}
+
+/**
+ * @brief Number of segments that keep an arc within the flattening tolerance
+ * @param radius radius in pixels
+ * @param angle arc angle
+ * @return size_t
+ */
+static size_t snl_raster_segments(const float radius, const float angle) {
+    // a chord spanning `step` radians deviates from the arc by radius * (1 - cos(step / 2))
+    const float step = radius > SNL_RASTER_TOLERANCE ? 2 * acosf(1 - SNL_RASTER_TOLERANCE / radius) : (float)M_PI / 2;
+    const float n = ceilf(angle / step);
+
+    return n < 2 ? 2 : n > SNL_RASTER_SEGMENTS_MAX ? SNL_RASTER_SEGMENTS_MAX : (size_t)n;
+}
+
+/**
+ * @brief Write bytes to a sink, aborting on failure
+ * @param sink output sink
+ * @param data data to write
+ * @param size number of bytes
+ * @return None
+ */
+static void snl_raster_write(const snl_sink_t sink, const void *const data, const size_t size) {
+    if (size == 0) return;
+
+    const size_t written = sink.write(sink.user, (const char*)data, size);
+    VT_ENFORCE(written == size, "Error: failed to write to the raster sink!\n");
+}
+
+/**
+ * @brief Write a png chunk
+ * @param sink output sink
+ * @param type chunk type, 4 chars
+ * @param data chunk data
+ * @param size chunk data size
+ * @return None
+ */
+static void snl_png_chunk(const snl_sink_t sink, const char *const type, const uint8_t *const data, const size_t size) {
+    uint8_t head[8], tail[4];
+    snl_put_u32_be(head, (uint32_t)size);
+    memcpy(head + 4, type, 4);
+    snl_put_u32_be(tail, snl_crc32(snl_crc32(0, head + 4, 4), data, size));
+
+    snl_raster_write(sink, head, sizeof(head));
+    snl_raster_write(sink, data, size);
+    snl_raster_write(sink, tail, sizeof(tail));
+}
+
+/**
+ * @brief Add bytes to the png image data
+ * @param png png stream
+ * @param data data
+ * @param size number of bytes
+ * @return None
+ */
+static void snl_png_put(snl_png_stream_t *const png, const uint8_t *data, size_t size) {
+    while (size > 0) {
+        // checksum and copy as much as fits
+        const size_t n = size < SNL_PNG_BLOCK_SIZE - png->len ? size : SNL_PNG_BLOCK_SIZE - png->len;
+        for (size_t i = 0; i < n; i++) {
+            png->adler_a = (png->adler_a + data[i]) % 65521;
+            png->adler_b = (png->adler_b + png->adler_a) % 65521;
+        }
+        memcpy(png->block + png->len, data, n);
+        png->len += n;
+        data += n;
+        size -= n;
+
+        // full block
+        if (png->len == SNL_PNG_BLOCK_SIZE) snl_png_block(png, false);
+    }
+}
+
+/**
+ * @brief Write the buffered image data as a stored deflate block in its own IDAT chunk
+ * @param png png stream
+ * @param final whether it is the last block, which is followed by the zlib checksum
+ * @return None
+ */
+static void snl_png_block(snl_png_stream_t *const png, const bool final) {
+    uint8_t head[8], tail[4];
+    const size_t head_len = png->started ? 5 : 7;
+    const size_t size = head_len + png->len + (final ? 4 : 0);
+
+    // zlib header before the first block, then the stored block header
+    uint8_t *p = head;
+    if (!png->started) {
+        *p++ = 0x78;
+        *p++ = 0x01;
+    }
+    *p++ = final ? 1 : 0;
+    *p++ = (uint8_t)(png->len & 0xff);
+    *p++ = (uint8_t)(png->len >> 8);
+    *p++ = (uint8_t)(~png->len & 0xff);
+    *p++ = (uint8_t)((~png->len >> 8) & 0xff);
+    snl_put_u32_be(tail, (png->adler_b << 16) | png->adler_a);
+
+    // chunk
+    uint8_t length_type[8];
+    snl_put_u32_be(length_type, (uint32_t)size);
+    memcpy(length_type + 4, "IDAT", 4);
+    uint32_t crc = snl_crc32(0, length_type + 4, 4);
+    crc = snl_crc32(crc, head, head_len);
+    crc = snl_crc32(crc, png->block, png->len);
+    if (final) crc = snl_crc32(crc, tail, 4);
+    uint8_t crc_bytes[4];
+    snl_put_u32_be(crc_bytes, crc);
+
+    snl_raster_write(png->sink, length_type, sizeof(length_type));
+    snl_raster_write(png->sink, head, head_len);
+    snl_raster_write(png->sink, png->block, png->len);
+    if (final) snl_raster_write(png->sink, tail, sizeof(tail));
+    snl_raster_write(png->sink, crc_bytes, sizeof(crc_bytes));
+
+    png->started = true;
+    png->len = 0;
+}
+
+/**
+ * @brief Store a big-endian 32-bit value
+ * @param dst destination
+ * @param value value
+ * @return None
+ */
+static void snl_put_u32_be(uint8_t *const dst, const uint32_t value) {
+    dst[0] = (uint8_t)(value >> 24);
+    dst[1] = (uint8_t)(value >> 16);
+    dst[2] = (uint8_t)(value >> 8);
+    dst[3] = (uint8_t)value;
+}
+
@@ -0,0 +1,573 @@
+#include "record.h"
+#include "style.h"
+#include "snail/text.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// initial number of records
+#define SNL_DISPLAY_LIST_INITIAL_CAPACITY 256
+
+// growth of the box of point lists in stroke widths: a miter join reaches stroke-miterlimit (4) half stroke widths
+#define SNL_DISPLAY_LIST_MITER 2.0f
+
+static void *snl_realloc(void *ptr, const size_t count, const size_t size);
+static void snl_display_list_reserve_records(snl_display_list_t *const list, const size_t n);
+static void snl_display_list_reserve_points(snl_display_list_t *const list, const size_t n);
+static bool snl_display_list_appearance_eq(const void *ctx, const uint32_t index, const void *key);
+static bool snl_display_list_text_style_eq(const void *ctx, const uint32_t index, const void *key);
+static bool snl_str_eq(const char *const a, const char *const b);
+
+snl_display_list_t *snl_display_list_create(void) {
+    snl_display_list_t *const list = calloc(1, sizeof(snl_display_list_t));
+    VT_ENFORCE(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    // allocate
+    snl_display_list_reserve_records(list, SNL_DISPLAY_LIST_INITIAL_CAPACITY);
+    snl_display_list_reserve_points(list, SNL_DISPLAY_LIST_INITIAL_CAPACITY * 2);
+    snl_intern_init(&list->appearance_index);
+    snl_intern_init(&list->style_index);
+
+    return list;
+}
+
+void snl_display_list_destroy(snl_display_list_t *const list) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // records
+    free(list->kind);
+    free(list->flags);
+    free(list->appearance);
+    free(list->first);
+    free(list->count);
+    free(list->size_x);
+    free(list->size_y);
+    free(list->radius);
+    free(list->aux);
+    free(list->style);
+
+    // points
+    free(list->xs);
+    free(list->ys);
+
+    // strings, interned data
+    free(list->pool);
+    free(list->appearances);
+    free(list->styles);
+    snl_intern_destroy(&list->appearance_index);
+    snl_intern_destroy(&list->style_index);
+
+    free(list);
+}
+
+void snl_display_list_clear(snl_display_list_t *const list) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    list->len = 0;
+    list->npoints = 0;
+    list->version++;
+}
+
+size_t snl_display_list_push(snl_display_list_t *const list, const snl_record_kind_t kind, const snl_appearance_t *const appearance) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // grow
+    if (list->len == list->capacity) snl_display_list_reserve_records(list, list->capacity * 2);
+
+    // append
+    const size_t index = list->len++;
+    list->version++;
+    list->kind[index] = (uint8_t)kind;
+    list->flags[index] = 0;
+    list->appearance[index] = 0;
+    list->first[index] = (uint32_t)list->npoints;
+    list->count[index] = 0;
+    list->size_x[index] = list->size_y[index] = list->radius[index] = 0;
+    list->aux[index] = SNL_POOL_NONE;
+    list->style[index] = 0;
+    if (appearance) snl_display_list_set_appearance(list, index, appearance);
+
+    return index;
+}
+
+void snl_display_list_push_point(snl_display_list_t *const list, const snl_point_t point) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(list->len > 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // grow
+    if (list->npoints == list->points_capacity) snl_display_list_reserve_points(list, list->points_capacity * 2);
+
+    // append
+    list->xs[list->npoints] = point.x;
+    list->ys[list->npoints] = point.y;
+    list->npoints++;
+    list->count[list->len - 1]++;
+    list->version++;
+}
+
+void snl_display_list_push_points(snl_display_list_t *const list, const snl_point_t *const points, const size_t n, const snl_point_t offset) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(list->len > 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(n == 0 || points != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // grow once
+    if (list->npoints + n > list->points_capacity) {
+        size_t capacity = list->points_capacity * 2;
+        while (capacity < list->npoints + n) capacity *= 2;
+        snl_display_list_reserve_points(list, capacity);
+    }
+
+    // append
+    float *const xs = list->xs + list->npoints;
+    float *const ys = list->ys + list->npoints;
+    for (size_t i = 0; i < n; i++) {
+        xs[i] = points[i].x + offset.x;
+        ys[i] = points[i].y + offset.y;
+    }
+    list->npoints += n;
+    list->count[list->len - 1] += (uint32_t)n;
+    list->version++;
+}
+
+void snl_display_list_set_appearance(snl_display_list_t *const list, const size_t index, const snl_appearance_t *const appearance) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(appearance != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(index < list->len, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // hash by value
+    uint32_t hash = SNL_HASH_SEED;
+    hash = snl_hash_bytes(hash, &appearance->stroke_width, sizeof(float));
+    hash = snl_hash_bytes(hash, &appearance->stroke_opacity, sizeof(float));
+    hash = snl_hash_bytes(hash, &appearance->stroke_color, sizeof(struct SnailColor));
+    hash = snl_hash_bytes(hash, &appearance->fill_opacity, sizeof(float));
+    hash = snl_hash_bytes(hash, &appearance->fill_color, sizeof(struct SnailColor));
+    hash = snl_hash_str(hash, appearance->filter);
+    hash = snl_hash_str(hash, appearance->gradient);
+
+    // lookup
+    uint32_t found = snl_intern_find(&list->appearance_index, hash, snl_display_list_appearance_eq, list, appearance);
+    if (found == SNL_INTERN_NONE) {
+        // grow
+        if (list->nappearances == list->appearances_capacity) {
+            list->appearances_capacity = list->appearances_capacity ? list->appearances_capacity * 2 : 16;
+            list->appearances = snl_realloc(list->appearances, list->appearances_capacity, sizeof(snl_record_appearance_t));
+        }
+
+        // insert
+        found = (uint32_t)list->nappearances++;
+        list->appearances[found] = (snl_record_appearance_t) {
+            .stroke_width = appearance->stroke_width,
+            .stroke_opacity = appearance->stroke_opacity,
+            .stroke_color = appearance->stroke_color,
+            .fill_opacity = appearance->fill_opacity,
+            .fill_color = appearance->fill_color,
+            .filter = snl_display_list_add_string(list, appearance->filter),
+            .gradient = snl_display_list_add_string(list, appearance->gradient)
+        };
+        snl_intern_insert(&list->appearance_index, hash, found);
+    }
+
+    list->appearance[index] = found;
+    list->version++;
+}
+
+uint32_t snl_display_list_add_text_style(snl_display_list_t *const list, const snl_text_style_t *const text_style) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(text_style != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // hash by value
+    uint32_t hash = SNL_HASH_SEED;
+    hash = snl_hash_bytes(hash, &text_style->font_size, sizeof(float));
+    hash = snl_hash_bytes(hash, &text_style->text_rotation, sizeof(float));
+    hash = snl_hash_str(hash, text_style->font_family);
+    hash = snl_hash_str(hash, text_style->font_weight);
+    hash = snl_hash_str(hash, text_style->font_style);
+    hash = snl_hash_str(hash, text_style->text_decoration);
+
+    // lookup
+    uint32_t found = snl_intern_find(&list->style_index, hash, snl_display_list_text_style_eq, list, text_style);
+    if (found == SNL_INTERN_NONE) {
+        // grow
+        if (list->nstyles == list->styles_capacity) {
+            list->styles_capacity = list->styles_capacity ? list->styles_capacity * 2 : 16;
+            list->styles = snl_realloc(list->styles, list->styles_capacity, sizeof(snl_record_text_style_t));
+        }
+
+        // insert
+        found = (uint32_t)list->nstyles++;
+        list->styles[found] = (snl_record_text_style_t) {
+            .font_size = text_style->font_size,
+            .text_rotation = text_style->text_rotation,
+            .font_family = snl_display_list_add_string(list, text_style->font_family),
+            .font_weight = snl_display_list_add_string(list, text_style->font_weight),
+            .font_style = snl_display_list_add_string(list, text_style->font_style),
+            .text_decoration = snl_display_list_add_string(list, text_style->text_decoration)
+        };
+        snl_intern_insert(&list->style_index, hash, found);
+    }
+
+    return found;
+}
+
+uint32_t snl_display_list_add_string(snl_display_list_t *const list, const char *const z) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    if (z == NULL) return SNL_POOL_NONE;
+
+    // grow
+    const size_t size = strlen(z) + 1;
+    if (list->pool_len + size > list->pool_capacity) {
+        size_t capacity = list->pool_capacity ? list->pool_capacity * 2 : 1024;
+        while (capacity < list->pool_len + size) capacity *= 2;
+        list->pool = snl_realloc(list->pool, capacity, 1);
+        list->pool_capacity = capacity;
+    }
+
+    // copy
+    const uint32_t offset = (uint32_t)list->pool_len;
+    memcpy(list->pool + offset, z, size);
+    list->pool_len += size;
+
+    return offset;
+}
+
+void snl_display_list_pop(snl_display_list_t *const list) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    if (list->len == 0) return;
+
+    // release points and the record string, unless a swap moved them away from the end of the storage
+    const size_t index = --list->len;
+    list->version++;
+    if (list->first[index] + list->count[index] == list->npoints) {
+        list->npoints = list->first[index];
+    }
+    const uint32_t aux = list->aux[index];
+    if (aux != SNL_POOL_NONE && aux + strlen(list->pool + aux) + 1 == list->pool_len) {
+        list->pool_len = aux;
+    }
+}
+
+void snl_display_list_swap(snl_display_list_t *const list, const size_t a, const size_t b) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(a < list->len && b < list->len, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    #define SNL_SWAP(type, arr) do { const type tmp = arr[a]; arr[a] = arr[b]; arr[b] = tmp; } while (0)
+    SNL_SWAP(uint8_t, list->kind);
+    SNL_SWAP(uint8_t, list->flags);
+    SNL_SWAP(uint32_t, list->appearance);
+    SNL_SWAP(uint32_t, list->first);
+    SNL_SWAP(uint32_t, list->count);
+    SNL_SWAP(float, list->size_x);
+    SNL_SWAP(float, list->size_y);
+    SNL_SWAP(float, list->radius);
+    SNL_SWAP(uint32_t, list->aux);
+    SNL_SWAP(uint32_t, list->style);
+    #undef SNL_SWAP
+    list->version++;
+}
+
+const char *snl_display_list_get_string(const snl_display_list_t *const list, const uint32_t offset) {
+    return offset == SNL_POOL_NONE ? NULL : list->pool + offset;
+}
+
+snl_appearance_t snl_display_list_get_appearance(const snl_display_list_t *const list, const size_t index) {
+    const snl_record_appearance_t *const a = &list->appearances[list->appearance[index]];
+    return SNL_APPEARANCE(
+        a->stroke_width, a->stroke_opacity, a->stroke_color, a->fill_opacity, a->fill_color,
+        snl_display_list_get_string(list, a->filter),
+        snl_display_list_get_string(list, a->gradient)
+    );
+}
+
+snl_text_style_t snl_display_list_get_text_style(const snl_display_list_t *const list, const size_t index) {
+    const snl_record_text_style_t *const s = &list->styles[list->style[index]];
+    return SNL_TEXT_STYLE(
+        s->font_size, s->text_rotation,
+        snl_display_list_get_string(list, s->font_family),
+        snl_display_list_get_string(list, s->font_weight),
+        snl_display_list_get_string(list, s->font_style),
+        snl_display_list_get_string(list, s->text_decoration)
+    );
+}
+
+snl_transform_t snl_display_list_get_transform(const snl_display_list_t *const list, const size_t index) {
+    const size_t first = list->first[index];
+    return SNL_TRANSFORM(list->xs[first + 1], list->ys[first + 1], list->xs[first + 2], list->ys[first + 2], list->xs[first], list->ys[first]);
+}
+
+bool snl_display_list_bounds(const snl_display_list_t *const list, const size_t index, float *const box) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(index < list->len, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    switch (list->kind[index]) {
+        case SNL_RECORD_INSTANCE:
+        case SNL_RECORD_GROUP:
+        case SNL_RECORD_GROUP_END:
+            return false;
+        default:
+            break;
+    }
+    if (list->count[index] == 0) return false;
+
+    const size_t first = list->first[index];
+    const size_t count = list->count[index];
+    const float stroke = fabsf(list->appearances[list->appearance[index]].stroke_width);
+    const float x = list->xs[first], y = list->ys[first];
+    float x0 = x, y0 = y, x1 = x, y1 = y;
+    float margin = stroke;
+    switch (list->kind[index]) {
+        case SNL_RECORD_LINE:
+            x0 = fminf(x, list->xs[first + 1]);
+            y0 = fminf(y, list->ys[first + 1]);
+            x1 = fmaxf(x, list->xs[first + 1]);
+            y1 = fmaxf(y, list->ys[first + 1]);
+            break;
+        case SNL_RECORD_CIRCLE: {
+            const float r = fabsf(list->radius[index]);
+            x0 = x - r; y0 = y - r; x1 = x + r; y1 = y + r;
+        } break;
+        case SNL_RECORD_ELLIPSE: {
+            const float rx = fabsf(list->size_x[index]), ry = fabsf(list->size_y[index]);
+            x0 = x - rx; y0 = y - ry; x1 = x + rx; y1 = y + ry;
+        } break;
+        case SNL_RECORD_RECTANGLE: {
+            const float w = list->size_x[index], h = list->size_y[index];
+            x0 = fminf(x, x + w); y0 = fminf(y, y + h); x1 = fmaxf(x, x + w); y1 = fmaxf(y, y + h);
+        } break;
+        case SNL_RECORD_POLYGON:
+        case SNL_RECORD_POLYLINE:
+        case SNL_RECORD_PATH:
+            for (size_t i = first + 1; i < first + count; i++) {
+                x0 = fminf(x0, list->xs[i]);
+                y0 = fminf(y0, list->ys[i]);
+                x1 = fmaxf(x1, list->xs[i]);
+                y1 = fmaxf(y1, list->ys[i]);
+            }
+            margin = SNL_DISPLAY_LIST_MITER * stroke;
+            break;
+        case SNL_RECORD_CURVE: {
+            // the curve stays within the triangle of its ends and its control point
+            const float cx = x + list->size_x[index], cy = y + list->size_y[index];
+            const float ex = list->xs[first + 1], ey = list->ys[first + 1];
+            x0 = fminf(x, fminf(cx, ex)); y0 = fminf(y, fminf(cy, ey));
+            x1 = fmaxf(x, fmaxf(cx, ex)); y1 = fmaxf(y, fmaxf(cy, ey));
+        } break;
+        case SNL_RECORD_TEXT: {
+            // the measured box, rotated about the origin like the <text> element and grown for the glyphs outside it
+            const snl_text_style_t text_style = snl_display_list_get_text_style(list, index);
+            const snl_text_box_t b = snl_text_measure(snl_display_list_get_string(list, list->aux[index]), text_style);
+            const snl_transform_t m = snl_transform_rotate(text_style.text_rotation);
+            const snl_point_t corners[4] = {
+                snl_transform_apply(m, SNL_POINT(x + b.x, y + b.y)), snl_transform_apply(m, SNL_POINT(x + b.x + b.width, y + b.y)),
+                snl_transform_apply(m, SNL_POINT(x + b.x, y + b.y + b.height)), snl_transform_apply(m, SNL_POINT(x + b.x + b.width, y + b.y + b.height))
+            };
+            x0 = fminf(fminf(corners[0].x, corners[1].x), fminf(corners[2].x, corners[3].x));
+            y0 = fminf(fminf(corners[0].y, corners[1].y), fminf(corners[2].y, corners[3].y));
+            x1 = fmaxf(fmaxf(corners[0].x, corners[1].x), fmaxf(corners[2].x, corners[3].x));
+            y1 = fmaxf(fmaxf(corners[0].y, corners[1].y), fmaxf(corners[2].y, corners[3].y));
+            margin += SNL_TEXT_MARGIN * fabsf(text_style.font_size);
+        } break;
+        default:
+            break;
+    }
+
+    box[0] = x0 - margin;
+    box[1] = y0 - margin;
+    box[2] = x1 + margin;
+    box[3] = y1 + margin;
+
+    return true;
+}
+
+void snl_display_list_serialize(const snl_display_list_t *const list, const size_t index, snl_writer_t *const w) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(list != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(index < list->len, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    const snl_appearance_t appearance = snl_display_list_get_appearance(list, index);
+    const size_t first = list->first[index];
+    const snl_point_t p0 = list->count[index] > 0 ? SNL_POINT(list->xs[first], list->ys[first]) : SNL_POINT(0, 0);
+    const snl_point_t p1 = list->count[index] > 1 ? SNL_POINT(list->xs[first + 1], list->ys[first + 1]) : SNL_POINT(0, 0);
+
+    // css class; point lists are streamed before their style is known, so they never use one
+    const snl_text_style_t text_style = list->kind[index] == SNL_RECORD_TEXT ? snl_display_list_get_text_style(list, index) : (snl_text_style_t) {0};
+    switch (list->kind[index]) {
+        case SNL_RECORD_POLYGON:
+        case SNL_RECORD_POLYLINE:
+        case SNL_RECORD_PATH:
+        case SNL_RECORD_INSTANCE:
+        case SNL_RECORD_GROUP:
+        case SNL_RECORD_GROUP_END:
+            w->style_class = SNL_STYLE_CLASS_NONE;
+            break;
+        default:
+            snl_emit_class(w, &appearance, NULL, list->kind[index] == SNL_RECORD_TEXT ? &text_style : NULL);
+            break;
+    }
+
+    switch (list->kind[index]) {
+        case SNL_RECORD_LINE:
+            snl_emit_line(w, p0, p1, &appearance);
+            break;
+        case SNL_RECORD_CIRCLE:
+            snl_emit_circle(w, p0, list->radius[index], &appearance);
+            break;
+        case SNL_RECORD_ELLIPSE:
+            snl_emit_ellipse(w, p0, SNL_POINT(list->size_x[index], list->size_y[index]), &appearance);
+            break;
+        case SNL_RECORD_RECTANGLE:
+            snl_emit_rectangle(w, p0, SNL_POINT(list->size_x[index], list->size_y[index]), list->radius[index], &appearance);
+            break;
+        case SNL_RECORD_POLYGON:
+        case SNL_RECORD_POLYLINE:
+        case SNL_RECORD_PATH: {
+            snl_path_cursor_t cursor;
+            snl_emit_points_begin(w, list->kind[index] == SNL_RECORD_POLYGON, &cursor);
+            for (size_t i = first; i < first + list->count[index]; i++) {
+                snl_emit_point(w, &cursor, SNL_POINT(list->xs[i], list->ys[i]));
+            }
+            snl_emit_points_end(w, &cursor, &appearance, snl_display_list_get_string(list, list->aux[index]));
+        } break;
+        case SNL_RECORD_CURVE:
+            snl_emit_curve(w, p0, SNL_POINT(list->size_x[index], list->size_y[index]), SNL_POINT(p1.x - p0.x, p1.y - p0.y), &appearance);
+            break;
+        case SNL_RECORD_TEXT:
+            snl_emit_text(w, p0, snl_display_list_get_string(list, list->aux[index]), &appearance, &text_style);
+            break;
+        case SNL_RECORD_INSTANCE:
+            snl_emit_use(w, snl_display_list_get_string(list, list->aux[index]), p0, list->size_x[index], list->radius[index]);
+            break;
+        case SNL_RECORD_GROUP: {
+            const snl_transform_t transform = snl_display_list_get_transform(list, index);
+            const bool styled = (list->flags[index] & SNL_RECORD_FLAG_STYLED) != 0;
+            snl_emit_group_open(w, &transform, styled ? &appearance : NULL);
+            if (styled) {
+                w->scope = appearance;
+                w->inherited = &w->scope;
+            }
+        } break;
+        case SNL_RECORD_GROUP_END:
+            snl_emit_group_close(w);
+            w->scope = appearance;
+            w->inherited = (list->flags[index] & SNL_RECORD_FLAG_STYLED) ? &w->scope : NULL;
+            break;
+        default:
+            break;
+    }
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Resize an array, aborting on failure
+ * @param ptr array
+ * @param count number of elements
+ * @param size element size
+ * @return resized array
+ */
+static void *snl_realloc(void *ptr, const size_t count, const size_t size) {
+    void *const p = realloc(ptr, count * size);
+    VT_ENFORCE(p != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    return p;
+}
+
+/**
+ * @brief Resize record arrays
+ * @param list display list instance
+ * @param n number of records
+ * @return None
+ */
+static void snl_display_list_reserve_records(snl_display_list_t *const list, const size_t n) {
+    list->kind = snl_realloc(list->kind, n, sizeof(uint8_t));
+    list->flags = snl_realloc(list->flags, n, sizeof(uint8_t));
+    list->appearance = snl_realloc(list->appearance, n, sizeof(uint32_t));
+    list->first = snl_realloc(list->first, n, sizeof(uint32_t));
+    list->count = snl_realloc(list->count, n, sizeof(uint32_t));
+    list->size_x = snl_realloc(list->size_x, n, sizeof(float));
+    list->size_y = snl_realloc(list->size_y, n, sizeof(float));
+    list->radius = snl_realloc(list->radius, n, sizeof(float));
+    list->aux = snl_realloc(list->aux, n, sizeof(uint32_t));
+    list->style = snl_realloc(list->style, n, sizeof(uint32_t));
+    list->capacity = n;
+}
+
+/**
+ * @brief Resize point arrays
+ * @param list display list instance
+ * @param n number of points
+ * @return None
+ */
+static void snl_display_list_reserve_points(snl_display_list_t *const list, const size_t n) {
+    list->xs = snl_realloc(list->xs, n, sizeof(float));
+    list->ys = snl_realloc(list->ys, n, sizeof(float));
+    list->points_capacity = n;
+}
+
+/**
+ * @brief Compare an interned appearance with a lookup key
+ * @param ctx display list
+ * @param index interned appearance index
+ * @param key snl_appearance_t*
+ * @return bool
+ */
+static bool snl_display_list_appearance_eq(const void *ctx, const uint32_t index, const void *key) {
+    const snl_display_list_t *const list = ctx;
+    const snl_record_appearance_t *const a = &list->appearances[index];
+    const snl_appearance_t *const b = key;
+
+    return (
+        a->stroke_width == b->stroke_width &&
+        a->stroke_opacity == b->stroke_opacity &&
+        memcmp(&a->stroke_color, &b->stroke_color, sizeof(struct SnailColor)) == 0 &&
+        a->fill_opacity == b->fill_opacity &&
+        memcmp(&a->fill_color, &b->fill_color, sizeof(struct SnailColor)) == 0 &&
+        snl_str_eq(snl_display_list_get_string(list, a->filter), b->filter) &&
+        snl_str_eq(snl_display_list_get_string(list, a->gradient), b->gradient)
+    );
+}
+
+/**
+ * @brief Compare an interned text style with a lookup key
+ * @param ctx display list
+ * @param index interned text style index
+ * @param key snl_text_style_t*
+ * @return bool
+ */
+static bool snl_display_list_text_style_eq(const void *ctx, const uint32_t index, const void *key) {
+    const snl_display_list_t *const list = ctx;
+    const snl_record_text_style_t *const a = &list->styles[index];
+    const snl_text_style_t *const b = key;
+
+    return (
+        a->font_size == b->font_size &&
+        a->text_rotation == b->text_rotation &&
+        snl_str_eq(snl_display_list_get_string(list, a->font_family), b->font_family) &&
+        snl_str_eq(snl_display_list_get_string(list, a->font_weight), b->font_weight) &&
+        snl_str_eq(snl_display_list_get_string(list, a->font_style), b->font_style) &&
+        snl_str_eq(snl_display_list_get_string(list, a->text_decoration), b->text_decoration)
+    );
+}
+
+/**
+ * @brief Compare strings, NULL only equals NULL
+ * @param a string or NULL
+ * @param b string or NULL
+ * @return bool
+ */
+static bool snl_str_eq(const char *const a, const char *const b) {
+    if (a == NULL || b == NULL) return a == b;
+    return strcmp(a, b) == 0;
+}
+
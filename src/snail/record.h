@@ -0,0 +1,280 @@
+#ifndef SNAIL_RECORD_H
+#define SNAIL_RECORD_H
+
+/** RECORD MODULE (internal)
+ *  - snl_display_list_create
+ *  - snl_display_list_destroy
+ *  - snl_display_list_clear
+ *  - snl_display_list_push
+ *  - snl_display_list_push_point
+ *  - snl_display_list_push_points
+ *  - snl_display_list_set_appearance
+ *  - snl_display_list_add_text_style
+ *  - snl_display_list_add_string
+ *  - snl_display_list_pop
+ *  - snl_display_list_swap
+ *  - snl_display_list_get_string
+ *  - snl_display_list_get_appearance
+ *  - snl_display_list_get_text_style
+ *  - snl_display_list_get_transform
+ *  - snl_display_list_bounds
+ *  - snl_display_list_serialize
+*/
+
+#include "emit.h"
+#include "intern.h"
+
+// no string
+#define SNL_POOL_NONE UINT32_MAX
+
+// no record
+#define SNL_RECORD_NONE UINT32_MAX
+
+// record flags
+#define SNL_RECORD_FLAG_DEAD 0x1
+#define SNL_RECORD_FLAG_STYLED 0x2  // group records: the appearance is inherited by the elements that follow
+#define SNL_RECORD_FLAG_HIDDEN 0x4  // covered by a later opaque rectangle, see <snl_occlude()>; set on save
+
+// primitive kinds
+typedef enum SnailRecordKind {
+    SNL_RECORD_LINE,        // points: start, end
+    SNL_RECORD_CIRCLE,      // points: origin; radius
+    SNL_RECORD_ELLIPSE,     // points: origin; size: radius
+    SNL_RECORD_RECTANGLE,   // points: pos; size; radius
+    SNL_RECORD_POLYGON,     // points: all; aux: fill rule
+    SNL_RECORD_POLYLINE,    // points: all
+    SNL_RECORD_PATH,        // points: all
+    SNL_RECORD_CURVE,       // points: start, end; size: curve height, curvature
+    SNL_RECORD_TEXT,        // points: pos; aux: text; style: text style
+    SNL_RECORD_INSTANCE,    // points: pos; aux: symbol id; size: scale; radius: rotation
+    SNL_RECORD_GROUP,       // points: (e, f), (a, b), (c, d) of the transform; style: closing record or SNL_RECORD_NONE
+    SNL_RECORD_GROUP_END    // appearance: style inherited again after the group; style: opening record
+} snl_record_kind_t;
+
+// interned appearance; strings are pool offsets
+typedef struct SnailRecordAppearance {
+    float stroke_width;
+    float stroke_opacity;
+    struct SnailColor stroke_color;
+    float fill_opacity;
+    struct SnailColor fill_color;
+    uint32_t filter;
+    uint32_t gradient;
+} snl_record_appearance_t;
+
+// interned text style; strings are pool offsets
+typedef struct SnailRecordTextStyle {
+    float font_size;
+    float text_rotation;
+    uint32_t font_family;
+    uint32_t font_weight;
+    uint32_t font_style;
+    uint32_t text_decoration;
+} snl_record_text_style_t;
+
+// retained primitives stored as structure of arrays
+typedef struct SnailDisplayList {
+    // records
+    uint8_t *kind;
+    uint8_t *flags;
+    uint32_t *appearance;
+    uint32_t *first;
+    uint32_t *count;
+    float *size_x;
+    float *size_y;
+    float *radius;
+    uint32_t *aux;
+    uint32_t *style;
+    size_t len;
+    size_t capacity;
+
+    // bumped by every change, so that data derived from the records knows when it is stale
+    size_t version;
+
+    // points
+    float *xs;
+    float *ys;
+    size_t npoints;
+    size_t points_capacity;
+
+    // strings
+    char *pool;
+    size_t pool_len;
+    size_t pool_capacity;
+
+    // interned appearances
+    snl_record_appearance_t *appearances;
+    size_t nappearances;
+    size_t appearances_capacity;
+    snl_intern_t appearance_index;
+
+    // interned text styles
+    snl_record_text_style_t *styles;
+    size_t nstyles;
+    size_t styles_capacity;
+    snl_intern_t style_index;
+} snl_display_list_t;
+
+/**
+ * @brief Create an empty display list
+ *
+ * @return snl_display_list_t*
+ */
+extern snl_display_list_t *snl_display_list_create(void);
+
+/**
+ * @brief Release display list memory
+ *
+ * @param list display list instance
+ * @return None
+ */
+extern void snl_display_list_destroy(snl_display_list_t *const list);
+
+/**
+ * @brief Remove all records in O(1), keeping interned appearances
+ *
+ * @param list display list instance
+ * @return None
+ */
+extern void snl_display_list_clear(snl_display_list_t *const list);
+
+/**
+ * @brief Append a record with no points
+ *
+ * @param list display list instance
+ * @param kind primitive kind
+ * @param appearance outlook or NULL to set it later
+ * @return record index
+ */
+extern size_t snl_display_list_push(snl_display_list_t *const list, const snl_record_kind_t kind, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Append a point to the last record
+ *
+ * @param list display list instance
+ * @param point point
+ * @return None
+ */
+extern void snl_display_list_push_point(snl_display_list_t *const list, const snl_point_t point);
+
+/**
+ * @brief Append many points to the last record
+ *
+ * @param list display list instance
+ * @param points points
+ * @param n number of points
+ * @param offset translation added to every point
+ * @return None
+ */
+extern void snl_display_list_push_points(snl_display_list_t *const list, const snl_point_t *const points, const size_t n, const snl_point_t offset);
+
+/**
+ * @brief Intern and assign an appearance to a record
+ *
+ * @param list display list instance
+ * @param index record index
+ * @param appearance outlook
+ * @return None
+ */
+extern void snl_display_list_set_appearance(snl_display_list_t *const list, const size_t index, const snl_appearance_t *const appearance);
+
+/**
+ * @brief Intern a text style
+ *
+ * @param list display list instance
+ * @param text_style text style
+ * @return text style index
+ */
+extern uint32_t snl_display_list_add_text_style(snl_display_list_t *const list, const snl_text_style_t *const text_style);
+
+/**
+ * @brief Copy a string into the pool
+ *
+ * @param list display list instance
+ * @param z string or NULL
+ * @return pool offset or SNL_POOL_NONE
+ */
+extern uint32_t snl_display_list_add_string(snl_display_list_t *const list, const char *const z);
+
+/**
+ * @brief Remove the last record in O(1)
+ *
+ * @param list display list instance
+ * @return None
+ */
+extern void snl_display_list_pop(snl_display_list_t *const list);
+
+/**
+ * @brief Swap two records in O(1)
+ *
+ * @param list display list instance
+ * @param a record index
+ * @param b record index
+ * @return None
+ */
+extern void snl_display_list_swap(snl_display_list_t *const list, const size_t a, const size_t b);
+
+/**
+ * @brief Get string from the pool
+ *
+ * @param list display list instance
+ * @param offset pool offset
+ * @return string or NULL for SNL_POOL_NONE
+ */
+extern const char *snl_display_list_get_string(const snl_display_list_t *const list, const uint32_t offset);
+
+/**
+ * @brief Get record appearance
+ *
+ * @param list display list instance
+ * @param index record index
+ * @return snl_appearance_t with strings pointing into the pool
+ */
+extern snl_appearance_t snl_display_list_get_appearance(const snl_display_list_t *const list, const size_t index);
+
+/**
+ * @brief Get record text style
+ *
+ * @param list display list instance
+ * @param index record index
+ * @return snl_text_style_t with strings pointing into the pool
+ */
+extern snl_text_style_t snl_display_list_get_text_style(const snl_display_list_t *const list, const size_t index);
+
+/**
+ * @brief Get the transform of a group record
+ *
+ * @param list display list instance
+ * @param index index of a SNL_RECORD_GROUP record
+ * @return transform from the group to the enclosing group (or canvas)
+ */
+extern snl_transform_t snl_display_list_get_transform(const snl_display_list_t *const list, const size_t index);
+
+/**
+ * @brief Get the box a record may paint, in its own coordinates
+ *
+ * @param list display list instance
+ * @param index record index
+ * @param box x0, y0, x1, y1 grown by the stroke width, or by a miter for point lists (set on return)
+ * @return false for records without a box of their own: groups, instances and empty point lists
+ *
+ * @note text is measured with <snl_text_measure()>, rotated like the <text> element and grown by SNL_TEXT_MARGIN
+ *       font sizes; filters are ignored
+ */
+extern bool snl_display_list_bounds(const snl_display_list_t *const list, const size_t index, float *const box);
+
+/**
+ * @brief Serialize a single record
+ *
+ * @param list display list instance
+ * @param index record index
+ * @param w writer instance
+ * @return None
+ *
+ * @note records have to be serialized in order with the same writer, which keeps track of the style
+ *       inherited from the enclosing group
+ */
+extern void snl_display_list_serialize(const snl_display_list_t *const list, const size_t index, snl_writer_t *const w);
+
+#endif // SNAIL_RECORD_H
+
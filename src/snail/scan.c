@@ -0,0 +1,388 @@
+#include "scan.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// initial number of edges and outline points
+#define SNL_SCAN_INITIAL_CAPACITY 256
+
+static void snl_scanner_drop(snl_scanner_t *const s);
+static void snl_scanner_reserve(snl_scanner_t *const s, const size_t width);
+static void snl_scanner_span(float *const cover, float xa, float xb, const float x0, const float x1, const float weight);
+static void snl_scanner_build_lut(snl_scanner_t *const s, const snl_gradient_t *const gradient, const float opacity);
+static void snl_scanner_blend_solid(const float *const color, float *const cover, uint8_t *const row, const size_t col0, const size_t col1);
+static void snl_scanner_blend_gradient(snl_scanner_t *const s, const snl_scan_paint_t *const paint, uint8_t *const row, const size_t y, const size_t col0, const size_t col1);
+static int snl_scan_edge_cmp(const void *a, const void *b);
+
+snl_scanner_t *snl_scanner_create(void) {
+    snl_scanner_t *const s = calloc(1, sizeof(snl_scanner_t));
+    VT_ENFORCE(s != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    // allocate
+    s->edges_capacity = s->points_capacity = SNL_SCAN_INITIAL_CAPACITY;
+    s->edges = malloc(sizeof(snl_scan_edge_t) * s->edges_capacity);
+    s->points = malloc(sizeof(snl_point_t) * s->points_capacity);
+    VT_ENFORCE(s->edges != NULL && s->points != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    snl_scanner_drop(s);
+
+    return s;
+}
+
+void snl_scanner_destroy(snl_scanner_t *const s) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(s != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    free(s->edges);
+    free(s->active);
+    free(s->crossings);
+    free(s->cover);
+    free(s->points);
+
+    free(s);
+}
+
+void snl_scanner_add_edge(snl_scanner_t *const s, const snl_point_t a, const snl_point_t b) {
+    // horizontal edges never cross a sample row
+    if (a.y == b.y || !isfinite(a.x) || !isfinite(a.y) || !isfinite(b.x) || !isfinite(b.y)) return;
+
+    // grow
+    if (s->nedges == s->edges_capacity) {
+        s->edges_capacity *= 2;
+        s->edges = realloc(s->edges, sizeof(snl_scan_edge_t) * s->edges_capacity);
+        VT_ENFORCE(s->edges != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    }
+
+    // store it going down
+    const bool down = b.y > a.y;
+    const snl_point_t top = down ? a : b;
+    const snl_point_t bottom = down ? b : a;
+    s->edges[s->nedges++] = (snl_scan_edge_t) {
+        .x0 = top.x, .y0 = top.y, .y1 = bottom.y,
+        .dxdy = (bottom.x - top.x) / (bottom.y - top.y),
+        .dir = down ? 1 : -1
+    };
+
+    // bounds
+    s->min_x = fminf(s->min_x, fminf(a.x, b.x));
+    s->max_x = fmaxf(s->max_x, fmaxf(a.x, b.x));
+    s->min_y = fminf(s->min_y, top.y);
+    s->max_y = fmaxf(s->max_y, bottom.y);
+}
+
+void snl_scanner_add_ring(snl_scanner_t *const s, const snl_point_t *const points, const size_t n) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(s != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(points != NULL || n == 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    for (size_t i = 0; i < n; i++) {
+        snl_scanner_add_edge(s, points[i], points[i + 1 < n ? i + 1 : 0]);
+    }
+}
+
+void snl_scanner_add_convex(snl_scanner_t *const s, const snl_point_t *const points, const size_t n) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(s != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(points != NULL || n == 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // signed area
+    float area = 0;
+    for (size_t i = 0; i < n; i++) {
+        const snl_point_t a = points[i], b = points[i + 1 < n ? i + 1 : 0];
+        area += a.x * b.y - b.x * a.y;
+    }
+
+    // add it counter-clockwise
+    for (size_t i = 0; i < n; i++) {
+        const size_t j = i + 1 < n ? i + 1 : 0;
+        if (area >= 0) {
+            snl_scanner_add_edge(s, points[i], points[j]);
+        } else {
+            snl_scanner_add_edge(s, points[j], points[i]);
+        }
+    }
+}
+
+void snl_scanner_push_point(snl_scanner_t *const s, const snl_point_t point) {
+    // grow
+    if (s->npoints == s->points_capacity) {
+        s->points_capacity *= 2;
+        s->points = realloc(s->points, sizeof(snl_point_t) * s->points_capacity);
+        VT_ENFORCE(s->points != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    }
+
+    s->points[s->npoints++] = point;
+}
+
+void snl_scanner_fill(snl_scanner_t *const s, const snl_scan_target_t *const target, const snl_fill_rule_t rule, const snl_scan_paint_t *const paint) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(s != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(target != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(target->pixels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(target->x1 <= target->width, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(paint != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // nothing inside the clip box
+    const float x0 = (float)target->x0, y0 = (float)target->y0, x1 = (float)target->x1, y1 = (float)target->y1;
+    if (s->nedges == 0 || s->max_x <= x0 || s->max_y <= y0 || s->min_x >= x1 || s->min_y >= y1) {
+        snl_scanner_drop(s);
+        return;
+    }
+
+    // pixel rows and columns touched by the shape
+    const size_t row0 = s->min_y > y0 ? (size_t)s->min_y : target->y0;
+    const size_t row1 = s->max_y < y1 ? (size_t)ceilf(s->max_y) : target->y1;
+    const size_t col0 = s->min_x > x0 ? (size_t)s->min_x : target->x0;
+    const size_t col1 = s->max_x < x1 ? (size_t)s->max_x + 1 : target->x1;
+
+    // prepare
+    snl_scanner_reserve(s, target->width);
+    qsort(s->edges, s->nedges, sizeof(snl_scan_edge_t), snl_scan_edge_cmp);
+    if (paint->gradient) snl_scanner_build_lut(s, paint->gradient, paint->opacity);
+    const float color[4] = { paint->color[0] * 255, paint->color[1] * 255, paint->color[2] * 255, paint->color[3] };
+
+    size_t next = 0, nactive = 0;
+    for (size_t y = row0; y < row1; y++) {
+        for (size_t k = 0; k < SNL_SCAN_SUBSAMPLES; k++) {
+            const float sy = (float)y + ((float)k + 0.5f) / SNL_SCAN_SUBSAMPLES;
+
+            // edges starting above the sample row
+            for (; next < s->nedges && s->edges[next].y0 <= sy; next++) {
+                if (s->edges[next].y1 > sy) s->active[nactive++] = (uint32_t)next;
+            }
+
+            // drop finished edges, find where the others cross the sample row
+            size_t ncrossings = 0;
+            for (size_t i = 0; i < nactive;) {
+                const snl_scan_edge_t *const e = &s->edges[s->active[i]];
+                if (e->y1 <= sy) {
+                    s->active[i] = s->active[--nactive];
+                    continue;
+                }
+                // rounding must not move a crossing out of the columns blended below
+                const float x = fminf(fmaxf(e->x0 + (sy - e->y0) * e->dxdy, s->min_x), s->max_x);
+                s->crossings[ncrossings++] = (snl_scan_crossing_t) { x, e->dir };
+                i++;
+            }
+
+            // sort crossings, mostly in order already; ties are broken by direction so that the
+            // spans do not depend on the order edges became active in, which varies with the clip box
+            for (size_t i = 1; i < ncrossings; i++) {
+                const snl_scan_crossing_t c = s->crossings[i];
+                size_t j = i;
+                for (; j > 0 && (s->crossings[j - 1].x > c.x || (s->crossings[j - 1].x == c.x && s->crossings[j - 1].dir > c.dir)); j--) {
+                    s->crossings[j] = s->crossings[j - 1];
+                }
+                s->crossings[j] = c;
+            }
+
+            // accumulate coverage of the spans inside the shape
+            int32_t winding = 0;
+            float start = 0;
+            for (size_t i = 0; i < ncrossings; i++) {
+                const bool was_inside = rule == SNL_FILL_EVENODD ? (winding & 1) != 0 : winding != 0;
+                winding += s->crossings[i].dir;
+                const bool inside = rule == SNL_FILL_EVENODD ? (winding & 1) != 0 : winding != 0;
+                if (!was_inside && inside) {
+                    start = s->crossings[i].x;
+                } else if (was_inside && !inside) {
+                    snl_scanner_span(s->cover, start, s->crossings[i].x, x0, x1, 1.0f / SNL_SCAN_SUBSAMPLES);
+                }
+            }
+        }
+
+        // blend the row
+        uint8_t *const row = target->pixels + y * target->width * 4;
+        if (paint->gradient) {
+            snl_scanner_blend_gradient(s, paint, row, y, col0, col1);
+        } else {
+            snl_scanner_blend_solid(color, s->cover, row, col0, col1);
+        }
+    }
+
+    snl_scanner_drop(s);
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Forget the edges of the filled shape
+ * @param s scanner instance
+ * @return None
+ */
+static void snl_scanner_drop(snl_scanner_t *const s) {
+    s->nedges = 0;
+    s->min_x = s->min_y = INFINITY;
+    s->max_x = s->max_y = -INFINITY;
+}
+
+/**
+ * @brief Make room for the active edges and a coverage row
+ * @param s scanner instance
+ * @param width width in pixels
+ * @return None
+ */
+static void snl_scanner_reserve(snl_scanner_t *const s, const size_t width) {
+    if (s->active_capacity < s->nedges) {
+        s->active_capacity = s->edges_capacity;
+        free(s->active);
+        free(s->crossings);
+        s->active = malloc(sizeof(uint32_t) * s->active_capacity);
+        s->crossings = malloc(sizeof(snl_scan_crossing_t) * s->active_capacity);
+        VT_ENFORCE(s->active != NULL && s->crossings != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    }
+
+    // one extra cell for spans ending on the right border; blending leaves the row zeroed
+    if (s->cover_len < width + 1) {
+        free(s->cover);
+        s->cover_len = width + 1;
+        s->cover = calloc(s->cover_len, sizeof(float));
+        VT_ENFORCE(s->cover != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    }
+}
+
+/**
+ * @brief Add the coverage of a horizontal span; pixels it only partly covers get the covered fraction
+ * @param cover coverage row
+ * @param xa span start
+ * @param xb span end
+ * @param x0 left clip
+ * @param x1 right clip
+ * @param weight coverage of a fully covered pixel
+ * @return None
+ */
+static void snl_scanner_span(float *const cover, float xa, float xb, const float x0, const float x1, const float weight) {
+    // clip; pixels inside the clip box get the same coverage as without it
+    if (xa < x0) xa = x0;
+    if (xb > x1) xb = x1;
+    if (xb <= xa) return;
+
+    // ends
+    const size_t ia = (size_t)xa, ib = (size_t)xb;
+    if (ia == ib) {
+        cover[ia] += (xb - xa) * weight;
+        return;
+    }
+    cover[ia] += ((float)(ia + 1) - xa) * weight;
+    cover[ib] += (xb - (float)ib) * weight;
+
+    // interior; a plain loop the compiler turns into vector adds
+    for (size_t i = ia + 1; i < ib; i++) {
+        cover[i] += weight;
+    }
+}
+
+/**
+ * @brief Precompute premultiplied gradient colors, scaled to ~[0; 255] with alpha ~[0; 1]
+ * @param s scanner instance
+ * @param gradient gradient
+ * @param opacity opacity ~[0; 1]
+ * @return None
+ */
+static void snl_scanner_build_lut(snl_scanner_t *const s, const snl_gradient_t *const gradient, const float opacity) {
+    // stop offsets never decrease, rgba() alpha is clamped to 1
+    float offsets[SNL_GRADIENT_STOPS_MAX], colors[SNL_GRADIENT_STOPS_MAX][4];
+    for (size_t i = 0; i < gradient->count; i++) {
+        const snl_gradient_stop_t *const stop = &gradient->stops[i];
+        const float offset = fminf(fmaxf((float)stop->offset / 100, 0), 1);
+        offsets[i] = i > 0 ? fmaxf(offset, offsets[i - 1]) : offset;
+
+        const float alpha = (stop->color.a ? 1.0f : 0.0f) * fminf(fmaxf(stop->opacity, 0), 1) * opacity;
+        colors[i][0] = (float)stop->color.r * alpha;
+        colors[i][1] = (float)stop->color.g * alpha;
+        colors[i][2] = (float)stop->color.b * alpha;
+        colors[i][3] = alpha;
+    }
+
+    // pad before the first and after the last stop
+    const size_t last = gradient->count - 1;
+    for (size_t i = 0; i < SNL_SCAN_LUT_SIZE; i++) {
+        const float t = (float)i / (SNL_SCAN_LUT_SIZE - 1);
+        size_t j = 0;
+        while (j < last && offsets[j + 1] <= t) j++;
+
+        const float span = j < last ? offsets[j + 1] - offsets[j] : 0;
+        const float f = span > 0 ? fminf(fmaxf((t - offsets[j]) / span, 0), 1) : 0;
+        const size_t k = j < last ? j + 1 : j;
+        for (size_t c = 0; c < 4; c++) {
+            s->lut[i][c] = colors[j][c] + (colors[k][c] - colors[j][c]) * (t < offsets[0] ? 0 : f);
+        }
+    }
+}
+
+/**
+ * @brief Blend a solid color over a pixel row through the coverage row, and clear the coverage
+ * @param color premultiplied color scaled to ~[0; 255] with alpha ~[0; 1]
+ * @param cover coverage row
+ * @param row pixel row
+ * @param col0 first column
+ * @param col1 past the last column
+ * @return None
+ */
+static void snl_scanner_blend_solid(const float *const color, float *const cover, uint8_t *const row, const size_t col0, const size_t col1) {
+    for (size_t x = col0; x < col1; x++) {
+        const float a = fminf(fmaxf(cover[x], 0), 1);
+        const float keep = 1 - color[3] * a;
+        uint8_t *const px = row + 4 * x;
+        px[0] = (uint8_t)(color[0] * a + px[0] * keep + 0.5f);
+        px[1] = (uint8_t)(color[1] * a + px[1] * keep + 0.5f);
+        px[2] = (uint8_t)(color[2] * a + px[2] * keep + 0.5f);
+        px[3] = (uint8_t)(255 * color[3] * a + px[3] * keep + 0.5f);
+        cover[x] = 0;
+    }
+}
+
+/**
+ * @brief Blend a gradient over a pixel row through the coverage row, and clear the coverage
+ * @param s scanner instance
+ * @param paint gradient paint
+ * @param row pixel row
+ * @param y row index
+ * @param col0 first column
+ * @param col1 past the last column
+ * @return None
+ */
+static void snl_scanner_blend_gradient(snl_scanner_t *const s, const snl_scan_paint_t *const paint, uint8_t *const row, const size_t y, const size_t col0, const size_t col1) {
+    // pixel centers in bounding box units
+    const float *const bbox = paint->bbox;
+    const float v = ((float)y + 0.5f - bbox[1]) / bbox[3];
+    const float du = 1 / bbox[2];
+
+    // linear gradient: projection onto the gradient vector, percent of the bounding box
+    const snl_gradient_t *const g = paint->gradient;
+    const float sx = g->start.x / 100, sy = g->start.y / 100;
+    const float dx = (g->end.x - g->start.x) / 100, dy = (g->end.y - g->start.y) / 100;
+    const float len2 = dx * dx + dy * dy;
+
+    float *const cover = s->cover;
+    for (size_t x = col0; x < col1; x++) {
+        const float u = ((float)x + 0.5f - bbox[0]) * du;
+        float t;
+        if (g->radial) {
+            t = 2 * sqrtf((u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f));
+        } else {
+            t = len2 > 0 ? ((u - sx) * dx + (v - sy) * dy) / len2 : 1;
+        }
+        const float *const color = s->lut[(size_t)(fminf(fmaxf(t, 0), 1) * (SNL_SCAN_LUT_SIZE - 1) + 0.5f)];
+
+        const float a = fminf(fmaxf(cover[x], 0), 1);
+        const float keep = 1 - color[3] * a;
+        uint8_t *const px = row + 4 * x;
+        px[0] = (uint8_t)(color[0] * a + px[0] * keep + 0.5f);
+        px[1] = (uint8_t)(color[1] * a + px[1] * keep + 0.5f);
+        px[2] = (uint8_t)(color[2] * a + px[2] * keep + 0.5f);
+        px[3] = (uint8_t)(255 * color[3] * a + px[3] * keep + 0.5f);
+        cover[x] = 0;
+    }
+}
+
+/**
+ * @brief Order edges by their top
+ * @param a snl_scan_edge_t*
+ * @param b snl_scan_edge_t*
+ * @return int
+ */
+static int snl_scan_edge_cmp(const void *a, const void *b) {
+    const float ya = ((const snl_scan_edge_t*)a)->y0, yb = ((const snl_scan_edge_t*)b)->y0;
+    return (ya > yb) - (ya < yb);
+}
+
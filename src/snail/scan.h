@@ -0,0 +1,150 @@
+#ifndef SNAIL_SCAN_H
+#define SNAIL_SCAN_H
+
+/** SCAN MODULE (internal)
+ *  - snl_scanner_create
+ *  - snl_scanner_destroy
+ *  - snl_scanner_add_edge
+ *  - snl_scanner_add_ring
+ *  - snl_scanner_add_convex
+ *  - snl_scanner_push_point
+ *  - snl_scanner_fill
+*/
+
+#include "emit.h"
+
+// sample rows per pixel row; coverage along a row is exact
+#define SNL_SCAN_SUBSAMPLES 4
+
+// number of precomputed gradient colors
+#define SNL_SCAN_LUT_SIZE 256
+
+// fill rules
+typedef enum SnailFillRule {
+    SNL_FILL_NONZERO,
+    SNL_FILL_EVENODD
+} snl_fill_rule_t;
+
+// edge going down (y0 < y1); dir is +1 if it was drawn downwards, -1 otherwise
+typedef struct SnailScanEdge {
+    float x0, y0, y1;
+    float dxdy;
+    int32_t dir;
+} snl_scan_edge_t;
+
+// edge crossing a sample row
+typedef struct SnailScanCrossing {
+    float x;
+    int32_t dir;
+} snl_scan_crossing_t;
+
+// pixels a fill may touch: a clip box inside a premultiplied rgba buffer
+typedef struct SnailScanTarget {
+    uint8_t *pixels;
+    size_t width;           // pixels per row
+    size_t x0, y0, x1, y1;  // clip box, past the last column/row
+} snl_scan_target_t;
+
+// solid color or gradient paint
+typedef struct SnailScanPaint {
+    float color[4];                 // premultiplied rgba ~[0; 1], used without a gradient
+    const snl_gradient_t *gradient; // gradient or NULL
+    float bbox[4];                  // gradient bounding box in pixels: x, y, width, height
+    float opacity;                  // gradient opacity ~[0; 1]
+} snl_scan_paint_t;
+
+// scanline rasterizer state, reused between shapes
+typedef struct SnailScanner {
+    // edges of the shape being filled
+    snl_scan_edge_t *edges;
+    size_t nedges;
+    size_t edges_capacity;
+    float min_x, min_y, max_x, max_y;
+
+    // active edges and their crossings with the current sample row
+    uint32_t *active;
+    snl_scan_crossing_t *crossings;
+    size_t active_capacity;
+
+    // coverage of the current pixel row
+    float *cover;
+    size_t cover_len;
+
+    // flattened outline of the shape being built
+    snl_point_t *points;
+    size_t npoints;
+    size_t points_capacity;
+
+    // gradient colors, premultiplied
+    float lut[SNL_SCAN_LUT_SIZE][4];
+} snl_scanner_t;
+
+/**
+ * @brief Create a scanner
+ *
+ * @return snl_scanner_t*
+ */
+extern snl_scanner_t *snl_scanner_create(void);
+
+/**
+ * @brief Release scanner memory
+ *
+ * @param s scanner instance
+ * @return None
+ */
+extern void snl_scanner_destroy(snl_scanner_t *const s);
+
+/**
+ * @brief Add an edge of the shape being filled
+ *
+ * @param s scanner instance
+ * @param a start point in pixels
+ * @param b end point in pixels
+ * @return None
+ */
+extern void snl_scanner_add_edge(snl_scanner_t *const s, const snl_point_t a, const snl_point_t b);
+
+/**
+ * @brief Add a closed ring of edges
+ *
+ * @param s scanner instance
+ * @param points ring points in pixels
+ * @param n number of points
+ * @return None
+ */
+extern void snl_scanner_add_ring(snl_scanner_t *const s, const snl_point_t *const points, const size_t n);
+
+/**
+ * @brief Add a convex ring, oriented so that overlapping convex rings add up under the nonzero rule
+ *
+ * @param s scanner instance
+ * @param points ring points in pixels
+ * @param n number of points
+ * @return None
+ */
+extern void snl_scanner_add_convex(snl_scanner_t *const s, const snl_point_t *const points, const size_t n);
+
+/**
+ * @brief Append a point to the outline of the shape being built
+ *
+ * @param s scanner instance
+ * @param point point in pixels
+ * @return None
+ */
+extern void snl_scanner_push_point(snl_scanner_t *const s, const snl_point_t point);
+
+/**
+ * @brief Fill the added edges with anti-aliased coverage, blend the paint over the pixels and drop the edges
+ *
+ * @param s scanner instance
+ * @param target pixels and clip box
+ * @param rule fill rule
+ * @param paint paint
+ * @return None
+ *
+ * @note a pixel gets the same value whatever the clip box, as long as it is inside it
+ */
+extern void snl_scanner_fill(snl_scanner_t *const s, const snl_scan_target_t *const target, const snl_fill_rule_t rule, const snl_scan_paint_t *const paint);
+
+#endif // SNAIL_SCAN_H
+
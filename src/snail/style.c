@@ -0,0 +1,134 @@
+#include "style.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// initial number of classes
+#define SNL_STYLE_SHEET_INITIAL_CAPACITY 16
+
+// lookup key
+typedef struct SnailStyleKey {
+    const char *decl;
+    size_t len;
+} snl_style_key_t;
+
+static bool snl_style_sheet_eq(const void *ctx, const uint32_t index, const void *key);
+
+snl_style_sheet_t *snl_style_sheet_create(void) {
+    snl_style_sheet_t *const sheet = calloc(1, sizeof(snl_style_sheet_t));
+    VT_ENFORCE(sheet != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    // allocate
+    sheet->capacity = SNL_STYLE_SHEET_INITIAL_CAPACITY;
+    sheet->offsets = malloc(sizeof(uint32_t) * sheet->capacity);
+    sheet->lengths = malloc(sizeof(uint32_t) * sheet->capacity);
+    sheet->defined_at = malloc(sizeof(size_t) * sheet->capacity);
+    VT_ENFORCE(sheet->offsets != NULL && sheet->lengths != NULL && sheet->defined_at != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    snl_intern_init(&sheet->index);
+    sheet->scratch = vt_str_create_capacity(256, NULL);
+
+    return sheet;
+}
+
+void snl_style_sheet_destroy(snl_style_sheet_t *const sheet) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(sheet != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    free(sheet->pool);
+    free(sheet->offsets);
+    free(sheet->lengths);
+    free(sheet->defined_at);
+    snl_intern_destroy(&sheet->index);
+    vt_str_destroy(sheet->scratch);
+
+    free(sheet);
+}
+
+void snl_style_sheet_clear(snl_style_sheet_t *const sheet) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(sheet != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    sheet->pool_len = 0;
+    sheet->count = 0;
+    snl_intern_clear(&sheet->index);
+}
+
+uint32_t snl_style_sheet_intern(snl_style_sheet_t *const sheet, const char *const decl, const size_t len, const size_t defined_at, bool *const created) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(sheet != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(decl != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(created != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    // lookup
+    const uint32_t hash = snl_hash_bytes(SNL_HASH_SEED, decl, len);
+    const snl_style_key_t key = { .decl = decl, .len = len };
+    const uint32_t found = snl_intern_find(&sheet->index, hash, snl_style_sheet_eq, sheet, &key);
+    *created = found == SNL_INTERN_NONE;
+    if (!*created) return found;
+
+    // grow
+    if (sheet->count == sheet->capacity) {
+        sheet->capacity *= 2;
+        sheet->offsets = realloc(sheet->offsets, sizeof(uint32_t) * sheet->capacity);
+        sheet->lengths = realloc(sheet->lengths, sizeof(uint32_t) * sheet->capacity);
+        sheet->defined_at = realloc(sheet->defined_at, sizeof(size_t) * sheet->capacity);
+        VT_ENFORCE(sheet->offsets != NULL && sheet->lengths != NULL && sheet->defined_at != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    }
+    if (sheet->pool_len + len > sheet->pool_capacity) {
+        size_t capacity = sheet->pool_capacity ? sheet->pool_capacity * 2 : 1024;
+        while (capacity < sheet->pool_len + len) capacity *= 2;
+        sheet->pool = realloc(sheet->pool, capacity);
+        VT_ENFORCE(sheet->pool != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        sheet->pool_capacity = capacity;
+    }
+
+    // insert
+    const uint32_t index = (uint32_t)sheet->count++;
+    memcpy(sheet->pool + sheet->pool_len, decl, len);
+    sheet->offsets[index] = (uint32_t)sheet->pool_len;
+    sheet->lengths[index] = (uint32_t)len;
+    sheet->defined_at[index] = defined_at;
+    sheet->pool_len += len;
+    snl_intern_insert(&sheet->index, hash, index);
+
+    return index;
+}
+
+void snl_style_sheet_truncate(snl_style_sheet_t *const sheet, const size_t offset) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(sheet != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    // classes are defined in output order, so drop them from the end
+    size_t count = sheet->count;
+    while (count > 0 && sheet->defined_at[count - 1] >= offset) count--;
+    snl_style_sheet_drop(sheet, count);
+}
+
+void snl_style_sheet_drop(snl_style_sheet_t *const sheet, const size_t count) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(sheet != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    while (sheet->count > count) {
+        const uint32_t index = (uint32_t)--sheet->count;
+        const char *const decl = sheet->pool + sheet->offsets[index];
+        snl_intern_remove(&sheet->index, snl_hash_bytes(SNL_HASH_SEED, decl, sheet->lengths[index]), index);
+        sheet->pool_len = sheet->offsets[index];
+    }
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Compare the declarations of a class with a lookup key
+ * @param ctx style sheet
+ * @param index class index
+ * @param key snl_style_key_t*
+ * @return bool
+ */
+static bool snl_style_sheet_eq(const void *ctx, const uint32_t index, const void *key) {
+    const snl_style_sheet_t *const sheet = ctx;
+    const snl_style_key_t *const k = key;
+
+    return sheet->lengths[index] == k->len && memcmp(sheet->pool + sheet->offsets[index], k->decl, k->len) == 0;
+}
+
@@ -0,0 +1,92 @@
+#ifndef SNAIL_STYLE_H
+#define SNAIL_STYLE_H
+
+/** STYLE MODULE (internal)
+ *  - snl_style_sheet_create
+ *  - snl_style_sheet_destroy
+ *  - snl_style_sheet_clear
+ *  - snl_style_sheet_intern
+ *  - snl_style_sheet_truncate
+ *  - snl_style_sheet_drop
+*/
+
+#include "intern.h"
+#include "vita/container/str.h"
+
+// no class
+#define SNL_STYLE_CLASS_NONE UINT32_MAX
+
+// css classes shared by elements with the same style; class i is named "a<i>"
+typedef struct SnailStyleSheet {
+    // declarations of each class, back to back
+    char *pool;
+    size_t pool_len;
+    size_t pool_capacity;
+
+    // classes
+    uint32_t *offsets;      // pool offset of the declarations
+    uint32_t *lengths;      // length of the declarations
+    size_t *defined_at;     // output offset of the first element using the class
+    size_t count;
+    size_t capacity;
+    snl_intern_t index;
+
+    // declarations being looked up, reused between lookups
+    vt_str_t *scratch;
+} snl_style_sheet_t;
+
+/**
+ * @brief Create an empty style sheet
+ *
+ * @return snl_style_sheet_t*
+ */
+extern snl_style_sheet_t *snl_style_sheet_create(void);
+
+/**
+ * @brief Release style sheet memory
+ *
+ * @param sheet style sheet instance
+ * @return None
+ */
+extern void snl_style_sheet_destroy(snl_style_sheet_t *const sheet);
+
+/**
+ * @brief Remove all classes, keeping memory
+ *
+ * @param sheet style sheet instance
+ * @return None
+ */
+extern void snl_style_sheet_clear(snl_style_sheet_t *const sheet);
+
+/**
+ * @brief Find the class with the given declarations or add a new one
+ *
+ * @param sheet style sheet instance
+ * @param decl declarations
+ * @param len declarations length
+ * @param defined_at output offset of the element a new class is added for
+ * @param created set to true if the class was added
+ * @return class index
+ */
+extern uint32_t snl_style_sheet_intern(snl_style_sheet_t *const sheet, const char *const decl, const size_t len, const size_t defined_at, bool *const created);
+
+/**
+ * @brief Remove classes defined at or after an output offset, i.e. whose definition was cut from the output
+ *
+ * @param sheet style sheet instance
+ * @param offset output offset
+ * @return None
+ */
+extern void snl_style_sheet_truncate(snl_style_sheet_t *const sheet, const size_t offset);
+
+/**
+ * @brief Remove the classes added after the first ones
+ *
+ * @param sheet style sheet instance
+ * @param count number of classes to keep
+ * @return None
+ */
+extern void snl_style_sheet_drop(snl_style_sheet_t *const sheet, const size_t count);
+
+#endif // SNAIL_STYLE_H
+
@@ -0,0 +1,295 @@
+#include "snail/text.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// the advance tables cover the printable ascii characters ' ' to '~'
+#define SNL_TEXT_ASCII_FIRST ' '
+#define SNL_TEXT_ASCII_COUNT 95
+
+// units per em of the advance tables
+#define SNL_TEXT_UNITS 1000
+
+// advances and vertical metrics of a font face in 1/1000 em
+typedef struct SnailFontFace {
+    uint16_t advances[SNL_TEXT_ASCII_COUNT];
+    uint16_t other;         // advance of non-ascii characters, except for wide ones
+    uint16_t ascent;        // above the baseline
+    uint16_t descent;       // below the baseline
+} snl_font_face_t;
+
+// a font family: its faces and their width scale relative to the tables
+typedef struct SnailFontFamily {
+    const char *name;
+    const snl_font_face_t *normal, *bold;
+    float normal_scale, bold_scale;
+} snl_font_family_t;
+
+// Helvetica, from the Adobe core font metrics
+static const snl_font_face_t snl_face_helvetica = {
+    .advances = {
+        /*  !"#$%&'() */ 278, 278, 355, 556, 556, 889, 667, 191, 333, 333,
+        /* *+,-./0123 */ 389, 584, 278, 333, 278, 278, 556, 556, 556, 556,
+        /* 456789:;<= */ 556, 556, 556, 556, 556, 556, 278, 278, 584, 584,
+        /* >?@ABCDEFG */ 584, 556, 1015, 667, 667, 722, 722, 667, 611, 778,
+        /* HIJKLMNOPQ */ 722, 278, 500, 667, 556, 833, 722, 778, 667, 778,
+        /* RSTUVWXYZ[ */ 722, 667, 611, 722, 667, 944, 667, 667, 611, 278,
+        /* \]^_`abcde */ 278, 278, 469, 556, 333, 556, 556, 500, 556, 556,
+        /* fghijklmno */ 278, 556, 556, 222, 222, 500, 222, 833, 556, 556,
+        /* pqrstuvwxy */ 556, 556, 333, 500, 278, 556, 500, 722, 500, 500,
+        /* z{|}~      */ 500, 334, 260, 334, 584
+    },
+    .other = 556, .ascent = 718, .descent = 207
+};
+
+// Helvetica-Bold, from the Adobe core font metrics
+static const snl_font_face_t snl_face_helvetica_bold = {
+    .advances = {
+        /*  !"#$%&'() */ 278, 333, 474, 556, 556, 889, 722, 238, 333, 333,
+        /* *+,-./0123 */ 389, 584, 278, 333, 278, 278, 556, 556, 556, 556,
+        /* 456789:;<= */ 556, 556, 556, 556, 556, 556, 333, 333, 584, 584,
+        /* >?@ABCDEFG */ 584, 611, 975, 722, 722, 722, 722, 667, 611, 778,
+        /* HIJKLMNOPQ */ 722, 278, 556, 722, 611, 833, 722, 778, 667, 778,
+        /* RSTUVWXYZ[ */ 722, 667, 611, 722, 667, 944, 667, 667, 611, 333,
+        /* \]^_`abcde */ 278, 333, 584, 556, 333, 556, 611, 556, 611, 556,
+        /* fghijklmno */ 333, 611, 611, 278, 278, 556, 278, 889, 611, 611,
+        /* pqrstuvwxy */ 611, 611, 389, 556, 333, 611, 556, 778, 556, 556,
+        /* z{|}~      */ 500, 389, 280, 389, 584
+    },
+    .other = 611, .ascent = 718, .descent = 207
+};
+
+// Times-Roman, from the Adobe core font metrics
+static const snl_font_face_t snl_face_times = {
+    .advances = {
+        /*  !"#$%&'() */ 250, 333, 408, 500, 500, 833, 778, 180, 333, 333,
+        /* *+,-./0123 */ 500, 564, 250, 333, 250, 278, 500, 500, 500, 500,
+        /* 456789:;<= */ 500, 500, 500, 500, 500, 500, 278, 278, 564, 564,
+        /* >?@ABCDEFG */ 564, 444, 921, 722, 667, 667, 722, 611, 556, 722,
+        /* HIJKLMNOPQ */ 722, 333, 389, 722, 611, 889, 722, 722, 556, 722,
+        /* RSTUVWXYZ[ */ 667, 556, 611, 722, 722, 944, 722, 722, 611, 333,
+        /* \]^_`abcde */ 278, 333, 469, 500, 333, 444, 500, 444, 500, 444,
+        /* fghijklmno */ 333, 500, 500, 278, 278, 500, 278, 778, 500, 500,
+        /* pqrstuvwxy */ 500, 500, 333, 389, 278, 500, 500, 722, 500, 500,
+        /* z{|}~      */ 444, 480, 200, 480, 541
+    },
+    .other = 500, .ascent = 683, .descent = 217
+};
+
+// Times-Bold, from the Adobe core font metrics
+static const snl_font_face_t snl_face_times_bold = {
+    .advances = {
+        /*  !"#$%&'() */ 250, 333, 555, 500, 500, 1000, 833, 278, 333, 333,
+        /* *+,-./0123 */ 500, 570, 250, 333, 250, 278, 500, 500, 500, 500,
+        /* 456789:;<= */ 500, 500, 500, 500, 500, 500, 333, 333, 570, 570,
+        /* >?@ABCDEFG */ 570, 500, 930, 722, 667, 722, 722, 667, 611, 778,
+        /* HIJKLMNOPQ */ 778, 389, 500, 778, 667, 944, 722, 778, 611, 778,
+        /* RSTUVWXYZ[ */ 722, 556, 667, 722, 722, 1000, 722, 722, 667, 333,
+        /* \]^_`abcde */ 278, 333, 581, 500, 333, 500, 556, 444, 556, 444,
+        /* fghijklmno */ 333, 500, 556, 278, 333, 556, 278, 833, 556, 500,
+        /* pqrstuvwxy */ 556, 556, 444, 389, 333, 556, 500, 722, 500, 500,
+        /* z{|}~      */ 444, 394, 220, 394, 520
+    },
+    .other = 500, .ascent = 683, .descent = 217
+};
+
+// Courier, regular and bold: every glyph is 600 units wide
+static const snl_font_face_t snl_face_courier = {
+    .advances = {
+        600, 600, 600, 600, 600, 600, 600, 600, 600, 600,
+        600, 600, 600, 600, 600, 600, 600, 600, 600, 600,
+        600, 600, 600, 600, 600, 600, 600, 600, 600, 600,
+        600, 600, 600, 600, 600, 600, 600, 600, 600, 600,
+        600, 600, 600, 600, 600, 600, 600, 600, 600, 600,
+        600, 600, 600, 600, 600, 600, 600, 600, 600, 600,
+        600, 600, 600, 600, 600, 600, 600, 600, 600, 600,
+        600, 600, 600, 600, 600, 600, 600, 600, 600, 600,
+        600, 600, 600, 600, 600, 600, 600, 600, 600, 600,
+        600, 600, 600, 600, 600
+    },
+    .other = 600, .ascent = 629, .descent = 157
+};
+
+// Verdana, from its 2048-unit advances
+static const snl_font_face_t snl_face_verdana = {
+    .advances = {
+        /*  !"#$%&'() */ 352, 394, 459, 818, 636, 1076, 727, 269, 454, 454,
+        /* *+,-./0123 */ 636, 818, 364, 454, 364, 454, 636, 636, 636, 636,
+        /* 456789:;<= */ 636, 636, 636, 636, 636, 636, 454, 454, 818, 818,
+        /* >?@ABCDEFG */ 818, 545, 1000, 684, 686, 698, 771, 632, 575, 775,
+        /* HIJKLMNOPQ */ 751, 421, 455, 693, 557, 843, 748, 787, 603, 787,
+        /* RSTUVWXYZ[ */ 695, 684, 616, 732, 684, 989, 685, 615, 685, 454,
+        /* \]^_`abcde */ 454, 454, 818, 636, 636, 601, 623, 521, 623, 596,
+        /* fghijklmno */ 352, 623, 633, 274, 344, 592, 274, 973, 633, 607,
+        /* pqrstuvwxy */ 623, 623, 427, 521, 394, 633, 592, 818, 592, 592,
+        /* z{|}~      */ 525, 636, 454, 636, 818
+    },
+    .other = 607, .ascent = 1005, .descent = 210
+};
+
+// SNL_FONT_* families and the generic families; the first entry is the fallback
+static const snl_font_family_t snl_font_families[] = {
+    { SNL_FONT_ARIAL,           &snl_face_helvetica, &snl_face_helvetica_bold, 1.00f, 1.00f },
+    { SNL_FONT_ARIAL_BLACK,     &snl_face_helvetica_bold, &snl_face_helvetica_bold, 1.18f, 1.18f },
+    { SNL_FONT_HEVETICA,        &snl_face_helvetica, &snl_face_helvetica_bold, 1.00f, 1.00f },
+    { "helvetica",              &snl_face_helvetica, &snl_face_helvetica_bold, 1.00f, 1.00f },
+    { SNL_FONT_VERDANA,         &snl_face_verdana, &snl_face_verdana, 1.00f, 1.11f },
+    { SNL_FONT_TAHOMA,          &snl_face_verdana, &snl_face_verdana, 0.88f, 0.96f },
+    { SNL_FONT_TREBUCHET_MS,    &snl_face_helvetica, &snl_face_helvetica_bold, 0.97f, 0.97f },
+    { SNL_FONT_IMPACT,          &snl_face_helvetica_bold, &snl_face_helvetica_bold, 0.82f, 0.82f },
+    { SNL_FONT_GILL_SANS,       &snl_face_helvetica, &snl_face_helvetica_bold, 0.91f, 0.95f },
+    { SNL_FONT_TIMES_NEW_ROMAN, &snl_face_times, &snl_face_times_bold, 1.00f, 1.00f },
+    { SNL_FONT_GEORGIA,         &snl_face_times, &snl_face_times_bold, 1.12f, 1.15f },
+    { SNL_FONT_PALATINO,        &snl_face_times, &snl_face_times_bold, 1.06f, 1.06f },
+    { SNL_FONT_BASKERVILLE,     &snl_face_times, &snl_face_times_bold, 1.03f, 1.05f },
+    { SNL_FONT_COURIER,         &snl_face_courier, &snl_face_courier, 1.00f, 1.00f },
+    { SNL_FONT_MONACO,          &snl_face_courier, &snl_face_courier, 1.00f, 1.00f },
+    { SNL_FONT_LUMINARI,        &snl_face_times, &snl_face_times_bold, 1.12f, 1.12f },
+    { SNL_FONT_COMIC_SANS_MS,   &snl_face_helvetica, &snl_face_helvetica_bold, 1.06f, 1.04f },
+    { "sans-serif",             &snl_face_helvetica, &snl_face_helvetica_bold, 1.00f, 1.00f },
+    { "serif",                  &snl_face_times, &snl_face_times_bold, 1.00f, 1.00f },
+    { "monospace",              &snl_face_courier, &snl_face_courier, 1.00f, 1.00f }
+};
+
+static const snl_font_family_t *snl_text_family(const char *const font_family);
+static bool snl_text_is_bold(const char *const font_weight);
+static uint32_t snl_text_advance(const snl_font_face_t *const face, const char *const text, const size_t len);
+static bool snl_text_is_wide(const uint32_t code);
+static size_t snl_text_decode(const char *const text, const size_t len, uint32_t *const code);
+
+snl_text_box_t snl_text_measure(const char *const text, const snl_text_style_t text_style) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(text != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    return snl_text_measure_n(text, strlen(text), text_style);
+}
+
+snl_text_box_t snl_text_measure_n(const char *const text, const size_t len, const snl_text_style_t text_style) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(text != NULL || len == 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    const snl_font_family_t *const family = snl_text_family(text_style.font_family);
+    const bool bold = snl_text_is_bold(text_style.font_weight);
+    const snl_font_face_t *const face = bold ? family->bold : family->normal;
+    const float scale = bold ? family->bold_scale : family->normal_scale;
+
+    const float em = text_style.font_size / SNL_TEXT_UNITS;
+    return (snl_text_box_t) {
+        .x = 0,
+        .y = -(float)face->ascent * em,
+        .width = (float)snl_text_advance(face, text, len) * scale * em,
+        .height = (float)(face->ascent + face->descent) * em
+    };
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Find the family of the first name of a font-family list, case-insensitively and without quotes
+ * @param font_family font-family value or NULL
+ * @return family, the first entry of <snl_font_families> if unknown
+ */
+static const snl_font_family_t *snl_text_family(const char *const font_family) {
+    if (font_family == NULL) return &snl_font_families[0];
+
+    // first name of the list
+    const char *start = font_family;
+    while (*start == ' ' || *start == '\'' || *start == '"') start++;
+    const char *end = start;
+    while (*end != '\0' && *end != ',') end++;
+    while (end > start && (end[-1] == ' ' || end[-1] == '\'' || end[-1] == '"')) end--;
+    const size_t len = (size_t)(end - start);
+
+    for (size_t i = 0; i < sizeof(snl_font_families) / sizeof(snl_font_families[0]); i++) {
+        const char *const name = snl_font_families[i].name;
+        size_t j = 0;
+        while (j < len && name[j] != '\0' && (start[j] | 0x20) == name[j]) j++;
+        if (j == len && name[j] == '\0') return &snl_font_families[i];
+    }
+
+    return &snl_font_families[0];
+}
+
+/**
+ * @brief Check whether a font-weight value selects the bold face
+ * @param font_weight font-weight value or NULL
+ * @return bool
+ */
+static bool snl_text_is_bold(const char *const font_weight) {
+    if (font_weight == NULL) return false;
+    if (strcmp(font_weight, SNL_FONT_WEIGHT_BOLD) == 0 || strcmp(font_weight, "bolder") == 0) return true;
+
+    return atoi(font_weight) >= 600;
+}
+
+/**
+ * @brief Sum the advances of a text
+ * @param face font face
+ * @param text utf-8 text
+ * @param len text length in bytes
+ * @return advance in 1/1000 em
+ */
+static uint32_t snl_text_advance(const snl_font_face_t *const face, const char *const text, const size_t len) {
+    uint32_t advance = 0;
+    size_t i = 0;
+    while (i < len) {
+        // printable ascii, the common case
+        const unsigned char c = (unsigned char)text[i];
+        if ((unsigned)(c - SNL_TEXT_ASCII_FIRST) < SNL_TEXT_ASCII_COUNT) {
+            advance += face->advances[c - SNL_TEXT_ASCII_FIRST];
+            i++;
+            continue;
+        }
+
+        // control characters take no space, invalid bytes are one replacement character
+        uint32_t code = c;
+        i += c < 0x80 ? 1 : snl_text_decode(text + i, len - i, &code);
+        if (code < SNL_TEXT_ASCII_FIRST || code == 0x7F) continue;
+        if (code >= 0x0300 && code < 0x0370) continue; // combining marks
+        advance += snl_text_is_wide(code) ? SNL_TEXT_UNITS : face->other;
+    }
+
+    return advance;
+}
+
+/**
+ * @brief Check for a character that is a full em wide: CJK, hangul syllables, fullwidth forms and the supplementary ideographs
+ * @param code code point
+ * @return bool
+ */
+static bool snl_text_is_wide(const uint32_t code) {
+    return (code >= 0x2E80 && code < 0xA4D0)
+        || (code >= 0xAC00 && code < 0xD7A4)
+        || (code >= 0xF900 && code < 0xFB00)
+        || (code >= 0xFF00 && code < 0xFF61)
+        || (code >= 0x20000 && code < 0x3FFFE);
+}
+
+/**
+ * @brief Decode a multibyte utf-8 sequence
+ * @param text sequence start, a byte >= 0x80
+ * @param len bytes left
+ * @param code code point, U+FFFD for an invalid sequence (set on return)
+ * @return bytes consumed, at least 1
+ */
+static size_t snl_text_decode(const char *const text, const size_t len, uint32_t *const code) {
+    const unsigned char *const s = (const unsigned char*)text;
+    const size_t n = s[0] >= 0xF0 && s[0] < 0xF5 ? 4 : s[0] >= 0xE0 ? (s[0] < 0xF0 ? 3 : 0) : s[0] >= 0xC2 ? 2 : 0;
+
+    *code = 0xFFFD;
+    if (n == 0 || n > len) return 1;
+
+    uint32_t value = s[0] & (0x7F >> n);
+    for (size_t i = 1; i < n; i++) {
+        if ((s[i] & 0xC0) != 0x80) return 1;
+        value = (value << 6) | (s[i] & 0x3F);
+    }
+
+    // overlong forms, surrogates and values past U+10FFFF
+    static const uint32_t min[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    if (value < min[n] || (value >= 0xD800 && value < 0xE000) || value > 0x10FFFF) return 1;
+
+    *code = value;
+    return n;
+}
+
@@ -0,0 +1,663 @@
+#include "snail/tiles.h"
+#include "record.h"
+#include "style.h"
+#include "defs.h"
+#include "index.h"
+#include "occlude.h"
+#include "xml.h"
+#include "cpu.h"
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+    #include <direct.h>
+#endif
+
+// no enclosing group
+#define SNL_TILES_NONE UINT32_MAX
+
+// a level of the pyramid
+typedef struct SnailTilesLevel {
+    float scale;                // canvas units per tile pixel
+    size_t columns, rows;
+    size_t first;               // first tile of the level in the order tiles are handed out
+    size_t written;             // tiles written, guarded by the job lock
+} snl_tiles_level_t;
+
+// tiles being written
+typedef struct SnailTilesJob {
+    const snl_canvas_t *canvas;
+    const snl_index_t *index;
+    const char *dir;
+    uint32_t tile_w, tile_h;
+    snl_tiles_level_t *levels;
+    size_t nlevels;
+    size_t ntiles;
+    uint32_t *parents;          // innermost group around each record, or SNL_TILES_NONE; NULL without groups
+    uint32_t *instances;        // symbol instances in drawing order
+    size_t ninstances;
+    uint32_t *refs;             // definitions each appearance refers to, filter then gradient, or SNL_DEFS_NONE
+    uint32_t *shared;           // definitions of every tile: the symbols of the instances and those they refer to
+    size_t nshared;
+    pthread_mutex_t lock;
+    size_t next;                // next tile to hand out, guarded by the lock
+} snl_tiles_job_t;
+
+// a thread writing tiles, one at a time
+typedef struct SnailTilesWorker {
+    pthread_t thread;
+    snl_tiles_job_t *job;
+    uint32_t *hits;             // records of the current tile
+    size_t hits_capacity;
+    uint32_t *groups;           // groups open in the current tile
+    size_t groups_capacity;
+    snl_style_sheet_t *sheet;   // classes of the current tile, or NULL
+    uint32_t *picked;           // per definition, the tile it was last picked for, plus one
+    uint32_t *defs;             // definitions of the current tile
+    size_t ndefs;
+    uint32_t tiles;             // tiles written so far
+    vt_str_t *buffer;
+    char *path;
+    size_t path_capacity;
+} snl_tiles_worker_t;
+
+static void snl_tiles_prepare(snl_tiles_job_t *const job);
+static void snl_tiles_resolve(snl_tiles_job_t *const job, const bool *const used);
+static void snl_tiles_share(snl_tiles_job_t *const job, bool *const shared, vt_str_t *const id, const uint32_t symbol);
+static void snl_tiles_pick_defs(snl_tiles_worker_t *const worker, const size_t n);
+static void snl_tiles_pick(snl_tiles_worker_t *const worker, const uint32_t def);
+static void *snl_tiles_work(void *arg);
+static bool snl_tiles_write(snl_tiles_worker_t *const worker, const size_t level, const size_t tile);
+static size_t snl_tiles_collect(snl_tiles_worker_t *const worker, const float *const box, const float min_size);
+static void snl_tiles_open_groups(snl_tiles_worker_t *const worker, snl_writer_t *const w, size_t *const ngroups, const uint32_t index);
+static void snl_tiles_flush(snl_tiles_worker_t *const worker, snl_writer_t *const w, FILE *const fp);
+static void snl_tiles_manifest(const snl_tiles_job_t *const job);
+static void snl_tiles_writer_init(const snl_canvas_t *const canvas, snl_style_sheet_t *const sheet, snl_writer_t *const w, vt_str_t *const target);
+static void snl_tiles_mkdir(const char *const path);
+static int snl_tiles_compare_asc(const void *a, const void *b);
+
+size_t snl_canvas_save_tiles(snl_canvas_t *const canvas, const char *const dir, const uint32_t tile_w, const uint32_t tile_h, const uint32_t levels) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(canvas != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(canvas->surface != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(dir != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_ENFORCE(canvas->list != NULL, "Error: canvas was not created with SNL_CANVAS_RETAINED!\n");
+    VT_ENFORCE(!canvas->drawing, "Error: did you forget to call 'snl_render_xxx_end()'?\n");
+    VT_ENFORCE(canvas->symbol == NULL, "Error: did you forget to call 'snl_canvas_symbol_end()'?\n");
+    VT_ENFORCE(canvas->ngroups == 0, "Error: did you forget to call 'snl_canvas_pop_group()'?\n");
+    VT_ENFORCE(canvas->sink.write == NULL, "Error: tiles cannot be saved from a streaming canvas!\n");
+    VT_ENFORCE(tile_w > 0 && tile_h > 0, "Error: tile size must be positive!\n");
+    VT_ENFORCE(levels >= 1 && levels <= SNL_TILES_LEVELS_MAX, "Error: levels must be within [1; %d]!\n", SNL_TILES_LEVELS_MAX);
+
+    // the elements <snl_canvas_save()> would write, found through the index
+    if (canvas->flags & SNL_CANVAS_OCCLUDE) snl_occlude(canvas->list, canvas->width, canvas->height, canvas->precision, canvas->grid);
+    if (canvas->index == NULL) canvas->index = snl_index_create();
+    snl_index_build(canvas->index, canvas->list);
+
+    // levels; the last one is at full size
+    snl_tiles_job_t job = {
+        .canvas = canvas,
+        .index = canvas->index,
+        .dir = dir,
+        .tile_w = tile_w,
+        .tile_h = tile_h,
+        .levels = calloc(levels, sizeof(snl_tiles_level_t)),
+        .nlevels = levels
+    };
+    VT_ENFORCE(job.levels != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    for (size_t z = 0; z < levels; z++) {
+        snl_tiles_level_t *const level = &job.levels[z];
+        level->scale = ldexpf(1.0f, (int)(levels - 1 - z));
+        level->columns = canvas->width > 0 ? (size_t)ceilf(canvas->width / (tile_w * level->scale)) : 0;
+        level->rows = canvas->height > 0 ? (size_t)ceilf(canvas->height / (tile_h * level->scale)) : 0;
+        level->first = job.ntiles;
+        job.ntiles += level->columns * level->rows;
+    }
+
+    // directories: <dir>/<level>/<column>
+    const size_t path_capacity = strlen(dir) + 64;
+    char *const path = malloc(path_capacity);
+    VT_ENFORCE(path != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    snl_tiles_mkdir(dir);
+    for (size_t z = 0; z < levels; z++) {
+        snprintf(path, path_capacity, "%s/%zu", dir, z);
+        snl_tiles_mkdir(path);
+        for (size_t x = 0; x < job.levels[z].columns; x++) {
+            snprintf(path, path_capacity, "%s/%zu/%zu", dir, z, x);
+            snl_tiles_mkdir(path);
+        }
+    }
+    free(path);
+
+    // group nesting, instances and definition ids, shared by all threads
+    snl_tiles_prepare(&job);
+
+    // threads take the next tile until none is left; the calling thread is the first one
+    const size_t cpus = snl_cpu_count();
+    const size_t nworkers = job.ntiles == 0 ? 0 : cpus < job.ntiles ? cpus : job.ntiles;
+    snl_tiles_worker_t *const workers = calloc(nworkers ? nworkers : 1, sizeof(snl_tiles_worker_t));
+    bool *const started = calloc(nworkers ? nworkers : 1, sizeof(bool));
+    VT_ENFORCE(workers != NULL && started != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    pthread_mutex_init(&job.lock, NULL);
+    for (size_t i = 0; i < nworkers; i++) {
+        snl_tiles_worker_t *const worker = &workers[i];
+        worker->job = &job;
+        worker->sheet = canvas->sheet ? snl_style_sheet_create() : NULL;
+        worker->picked = calloc(canvas->defs->def_count ? canvas->defs->def_count : 1, sizeof(uint32_t));
+        worker->defs = malloc((canvas->defs->def_count ? canvas->defs->def_count : 1) * sizeof(uint32_t));
+        VT_ENFORCE(worker->picked != NULL && worker->defs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        worker->buffer = vt_str_create_capacity(SNL_STREAM_HIGH_WATER_DEFAULT + SNL_WRITER_BUFFER_SIZE, NULL);
+        worker->path_capacity = path_capacity;
+        worker->path = malloc(path_capacity);
+        VT_ENFORCE(worker->path != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    }
+    for (size_t i = 1; i < nworkers; i++) {
+        started[i] = pthread_create(&workers[i].thread, NULL, snl_tiles_work, &workers[i]) == 0;
+    }
+    if (nworkers) snl_tiles_work(&workers[0]);
+    for (size_t i = 1; i < nworkers; i++) {
+        if (started[i]) pthread_join(workers[i].thread, NULL);
+    }
+
+    // describe the pyramid
+    snl_tiles_manifest(&job);
+    size_t written = 0;
+    for (size_t z = 0; z < levels; z++) {
+        written += job.levels[z].written;
+    }
+
+    // free
+    for (size_t i = 0; i < nworkers; i++) {
+        if (workers[i].sheet) snl_style_sheet_destroy(workers[i].sheet);
+        vt_str_destroy(workers[i].buffer);
+        free(workers[i].hits);
+        free(workers[i].groups);
+        free(workers[i].picked);
+        free(workers[i].defs);
+        free(workers[i].path);
+    }
+    pthread_mutex_destroy(&job.lock);
+    free(started);
+    free(workers);
+    free(job.levels);
+    free(job.parents);
+    free(job.instances);
+    free(job.refs);
+    free(job.shared);
+
+    return written;
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Find the group around each record, the symbol instances and the definitions the tiles refer to
+ * @param job tiles job
+ * @return None
+ */
+static void snl_tiles_prepare(snl_tiles_job_t *const job) {
+    const snl_display_list_t *const list = job->canvas->list;
+
+    job->parents = malloc((list->len ? list->len : 1) * sizeof(uint32_t));
+    job->instances = malloc((list->len ? list->len : 1) * sizeof(uint32_t));
+    bool *const used = calloc(list->nappearances ? list->nappearances : 1, sizeof(bool));
+    VT_ENFORCE(job->parents != NULL && job->instances != NULL && used != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    uint32_t parent = SNL_TILES_NONE;
+    bool grouped = false;
+    for (size_t i = 0; i < list->len; i++) {
+        job->parents[i] = parent;
+        if (list->kind[i] == SNL_RECORD_GROUP) {
+            parent = (uint32_t)i;
+            grouped = true;
+        } else if (list->kind[i] == SNL_RECORD_GROUP_END) {
+            parent = job->parents[list->style[i]];
+        }
+
+        if (list->flags[i] & (SNL_RECORD_FLAG_DEAD | SNL_RECORD_FLAG_HIDDEN)) continue;
+        if (list->kind[i] == SNL_RECORD_INSTANCE) job->instances[job->ninstances++] = (uint32_t)i;
+        used[list->appearance[i]] = true;
+    }
+    snl_tiles_resolve(job, used);
+    free(used);
+
+    // records of a tile are scattered over the list, so lookups that are not needed are left out
+    if (!grouped) {
+        free(job->parents);
+        job->parents = NULL;
+    }
+
+}
+
+/**
+ * @brief Look up every definition id the tiles refer to, so that the lookups of the threads find them and
+ *        leave the definitions unchanged; find the definitions of each appearance and those of every tile
+ * @param job tiles job
+ * @param used appearances of the written records
+ * @return None
+ */
+static void snl_tiles_resolve(snl_tiles_job_t *const job, const bool *const used) {
+    const snl_canvas_t *const canvas = job->canvas;
+    const snl_display_list_t *const list = canvas->list;
+    const bool compact = (canvas->flags & SNL_CANVAS_COMPACT) != 0;
+
+    job->refs = malloc((list->nappearances ? list->nappearances : 1) * 2 * sizeof(uint32_t));
+    VT_ENFORCE(job->refs != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+
+    size_t len = 0;
+    for (size_t i = 0; i < list->nappearances; i++) {
+        job->refs[2 * i] = job->refs[2 * i + 1] = SNL_DEFS_NONE;
+        if (!used[i]) continue;
+
+        // the compact profile leaves the default filter out
+        const snl_record_appearance_t *const appearance = &list->appearances[i];
+        const char *filter = snl_display_list_get_string(list, appearance->filter);
+        const char *const gradient = snl_display_list_get_string(list, appearance->gradient);
+        if (filter && compact && strcmp(filter, SNL_FILTER_DEFAULT) == 0) filter = NULL;
+        else if (filter == NULL && !compact) filter = SNL_FILTER_DEFAULT;
+        if (filter) {
+            snl_defs_resolve(canvas->defs, filter, &len);
+            job->refs[2 * i] = snl_defs_find(canvas->defs, filter, strlen(filter));
+        }
+
+        // a gradient takes the place of a paint without a color
+        if (gradient) {
+            snl_defs_resolve(canvas->defs, gradient, &len);
+            if (snl_color_is_none(appearance->stroke_color) || snl_color_is_none(appearance->fill_color)) {
+                job->refs[2 * i + 1] = snl_defs_find(canvas->defs, gradient, strlen(gradient));
+            }
+        }
+    }
+
+    // instances are written to every tile, and so are their symbols
+    bool *const shared = calloc(canvas->defs->def_count ? canvas->defs->def_count : 1, sizeof(bool));
+    job->shared = malloc((canvas->defs->def_count ? canvas->defs->def_count : 1) * sizeof(uint32_t));
+    VT_ENFORCE(shared != NULL && job->shared != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    vt_str_t *const id = vt_str_create_capacity(64, NULL);
+    for (size_t i = 0; i < list->len; i++) {
+        if (list->kind[i] != SNL_RECORD_INSTANCE || (list->flags[i] & SNL_RECORD_FLAG_DEAD)) continue;
+        const char *const symbol = snl_display_list_get_string(list, list->aux[i]);
+        snl_defs_resolve(canvas->defs, symbol, &len);
+        snl_tiles_share(job, shared, id, snl_defs_find(canvas->defs, symbol, strlen(symbol)));
+    }
+    vt_str_destroy(id);
+    free(shared);
+}
+
+/**
+ * @brief Add a symbol to the definitions of every tile, with the definitions its elements refer to
+ * @param job tiles job
+ * @param shared definitions added so far
+ * @param id scratch string
+ * @param symbol definition index or SNL_DEFS_NONE
+ * @return None
+ */
+static void snl_tiles_share(snl_tiles_job_t *const job, bool *const shared, vt_str_t *const id, const uint32_t symbol) {
+    const snl_defs_t *const defs = job->canvas->defs;
+    if (symbol == SNL_DEFS_NONE || shared[symbol]) return;
+    shared[symbol] = true;
+    job->shared[job->nshared++] = symbol;
+
+    // references in the attributes of the recorded elements: url(#id) and xlink:href='#id'
+    static const char *const attributes[] = { "filter", "fill", "stroke", "xlink:href" };
+    static const char *const prefixes[] = { "url(#", "url(#", "url(#", "#" };
+    snl_xml_reader_t r;
+    snl_xml_token_t token;
+    snl_xml_reader_init(&r, defs->pool + defs->def_offsets[symbol], defs->def_lengths[symbol]);
+    while (snl_xml_next(&r, &token) != SNL_XML_EOF && token.kind != SNL_XML_ERROR) {
+        if (token.kind != SNL_XML_OPEN) continue;
+        for (size_t i = 0; i < sizeof(attributes) / sizeof(attributes[0]); i++) {
+            const char *value;
+            size_t value_len;
+            if (!snl_xml_attribute(&token, attributes[i], &value, &value_len)) continue;
+            const size_t skip = strlen(prefixes[i]);
+            const size_t close = skip > 1 ? 1 : 0;
+            if (value_len <= skip + close || memcmp(value, prefixes[i], skip) != 0) continue;
+
+            // the id, without the closing parenthesis of url()
+            snl_xml_unescape(id, value + skip, value_len - skip - close);
+            snl_tiles_share(job, shared, id, snl_defs_find(defs, vt_str_z(id), vt_str_len(id)));
+        }
+    }
+}
+
+/**
+ * @brief Thread loop: write tiles until none is left
+ * @param arg snl_tiles_worker_t*
+ * @return NULL
+ */
+static void *snl_tiles_work(void *arg) {
+    snl_tiles_worker_t *const worker = arg;
+    snl_tiles_job_t *const job = worker->job;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        const size_t tile = job->next < job->ntiles ? job->next++ : job->ntiles;
+        pthread_mutex_unlock(&job->lock);
+        if (tile == job->ntiles) break;
+
+        // levels are handed out in order
+        size_t z = job->nlevels - 1;
+        while (tile < job->levels[z].first) z--;
+
+        if (snl_tiles_write(worker, z, tile - job->levels[z].first)) {
+            pthread_mutex_lock(&job->lock);
+            job->levels[z].written++;
+            pthread_mutex_unlock(&job->lock);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Write a tile unless it has no elements
+ * @param worker thread state
+ * @param level level index
+ * @param tile tile index within the level, row by row
+ * @return true if the tile was written
+ */
+static bool snl_tiles_write(snl_tiles_worker_t *const worker, const size_t level, const size_t tile) {
+    const snl_tiles_job_t *const job = worker->job;
+    const snl_canvas_t *const canvas = job->canvas;
+    const snl_display_list_t *const list = canvas->list;
+    const snl_tiles_level_t *const l = &job->levels[level];
+
+    // area covered, cut at the canvas edge
+    const size_t column = tile % l->columns, row = tile / l->columns;
+    const float span_w = (float)job->tile_w * l->scale, span_h = (float)job->tile_h * l->scale;
+    const float x0 = (float)column * span_w, y0 = (float)row * span_h;
+    const float x1 = fminf(x0 + span_w, canvas->width), y1 = fminf(y0 + span_h, canvas->height);
+
+    // elements over it, in drawing order
+    const float box[4] = { x0, y0, x1, y1 };
+    const size_t n = snl_tiles_collect(worker, box, level + 1 < job->nlevels ? SNL_TILES_DETAIL * l->scale : 0);
+    if (n == 0) return false;
+
+    snprintf(worker->path, worker->path_capacity, "%s/%zu/%zu/%zu.svg", job->dir, level, column, row);
+    FILE *const fp = fopen(worker->path, "wb");
+    VT_ENFORCE(fp != NULL, "Error: failed to open '%s'!\n", worker->path);
+    vt_str_clear(worker->buffer);
+    if (worker->sheet) snl_style_sheet_clear(worker->sheet);
+
+    // header
+    snl_writer_t w;
+    snl_tiles_writer_init(canvas, worker->sheet, &w, worker->buffer);
+    snl_writer_put_str(&w, "<svg width='");
+    snl_writer_put_float(&w, (x1 - x0) / l->scale, w.precision);
+    snl_writer_put_str(&w, "' height='");
+    snl_writer_put_float(&w, (y1 - y0) / l->scale, w.precision);
+    snl_writer_put_str(&w, "' viewBox='");
+    snl_writer_put_float(&w, x0, w.precision);
+    snl_writer_put_char(&w, ' ');
+    snl_writer_put_float(&w, y0, w.precision);
+    snl_writer_put_char(&w, ' ');
+    snl_writer_put_float(&w, x1 - x0, w.precision);
+    snl_writer_put_char(&w, ' ');
+    snl_writer_put_float(&w, y1 - y0, w.precision);
+    snl_writer_put_str(&w, "' xmlns='http://www.w3.org/2000/svg' version='1.1' xmlns:xlink='http://www.w3.org/1999/xlink'>\n");
+
+    // the definitions its elements refer to, symbols included
+    snl_tiles_pick_defs(worker, n);
+    if (worker->ndefs > 0) {
+        snl_writer_put_str(&w, "<defs>\n");
+        for (size_t i = 0; i < worker->ndefs; i++) {
+            snl_defs_emit(canvas->defs, worker->defs[i], &w);
+        }
+        snl_writer_put_str(&w, "</defs>\n");
+    }
+
+    // elements, inside the groups they were rendered in
+    size_t ngroups = 0;
+    for (size_t k = 0; k < n; k++) {
+        const uint32_t index = worker->hits[k];
+
+        // close the groups the element is not in, then open those it is in
+        if (job->parents) {
+            while (ngroups > 0 && index > list->style[worker->groups[ngroups - 1]]) {
+                snl_display_list_serialize(list, list->style[worker->groups[--ngroups]], &w);
+            }
+            snl_tiles_open_groups(worker, &w, &ngroups, index);
+        }
+
+        snl_display_list_serialize(list, index, &w);
+        if (vt_str_len(worker->buffer) + w.len >= SNL_STREAM_HIGH_WATER_DEFAULT) snl_tiles_flush(worker, &w, fp);
+    }
+    while (ngroups > 0) {
+        snl_display_list_serialize(list, list->style[worker->groups[--ngroups]], &w);
+    }
+
+    // finalize the tile
+    snl_writer_put_str(&w, "</svg>");
+    snl_tiles_flush(worker, &w, fp);
+    VT_ENFORCE(fclose(fp) == 0, "Error: failed to write '%s'!\n", worker->path);
+
+    return true;
+}
+
+/**
+ * @brief Gather the records of a tile into the worker hits, in drawing order
+ * @param worker thread state
+ * @param box x0, y0, x1, y1
+ * @param min_size records whose box is narrower and lower than this are left out
+ * @return number of records
+ */
+static size_t snl_tiles_collect(snl_tiles_worker_t *const worker, const float *const box, const float min_size) {
+    const snl_tiles_job_t *const job = worker->job;
+    const snl_display_list_t *const list = job->canvas->list;
+
+    // shapes, without those a later rectangle hides
+    const size_t found = snl_index_search(job->index, box, min_size, &worker->hits, &worker->hits_capacity);
+    size_t n = found;
+    if (job->canvas->flags & SNL_CANVAS_OCCLUDE) {
+        n = 0;
+        for (size_t i = 0; i < found; i++) {
+            if (!(list->flags[worker->hits[i]] & SNL_RECORD_FLAG_HIDDEN)) worker->hits[n++] = worker->hits[i];
+        }
+    }
+    if (n > 1) qsort(worker->hits, n, sizeof(uint32_t), snl_tiles_compare_asc);
+    if (n == 0 || job->ninstances == 0) return n;
+
+    // grow
+    const size_t total = n + job->ninstances;
+    if (total > worker->hits_capacity) {
+        uint32_t *const hits = realloc(worker->hits, total * sizeof(uint32_t));
+        VT_ENFORCE(hits != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+        worker->hits = hits;
+        worker->hits_capacity = total;
+    }
+
+    // merge the instances in from the back
+    size_t i = n, j = job->ninstances, k = total;
+    while (j > 0) {
+        if (i > 0 && worker->hits[i - 1] > job->instances[j - 1]) worker->hits[--k] = worker->hits[--i];
+        else worker->hits[--k] = job->instances[--j];
+    }
+
+    return total;
+}
+
+/**
+ * @brief Find the definitions the records of a tile and their groups refer to, in the order they were added
+ * @param worker thread state
+ * @param n number of records
+ * @return None
+ */
+static void snl_tiles_pick_defs(snl_tiles_worker_t *const worker, const size_t n) {
+    const snl_tiles_job_t *const job = worker->job;
+    const snl_display_list_t *const list = job->canvas->list;
+
+    worker->tiles++;
+    worker->ndefs = 0;
+    for (size_t i = 0; i < job->nshared; i++) {
+        snl_tiles_pick(worker, job->shared[i]);
+    }
+    for (size_t k = 0; k < n; k++) {
+        const uint32_t index = worker->hits[k];
+        snl_tiles_pick(worker, job->refs[2 * list->appearance[index]]);
+        snl_tiles_pick(worker, job->refs[2 * list->appearance[index] + 1]);
+        if (job->parents == NULL) continue;
+        for (uint32_t g = job->parents[index]; g != SNL_TILES_NONE; g = job->parents[g]) {
+            snl_tiles_pick(worker, job->refs[2 * list->appearance[g]]);
+            snl_tiles_pick(worker, job->refs[2 * list->appearance[g] + 1]);
+        }
+    }
+    if (worker->ndefs > 1) qsort(worker->defs, worker->ndefs, sizeof(uint32_t), snl_tiles_compare_asc);
+}
+
+/**
+ * @brief Add a definition to those of the current tile, unless it is there already
+ * @param worker thread state
+ * @param def definition index or SNL_DEFS_NONE
+ * @return None
+ */
+static void snl_tiles_pick(snl_tiles_worker_t *const worker, const uint32_t def) {
+    if (def == SNL_DEFS_NONE || worker->picked[def] == worker->tiles) return;
+    worker->picked[def] = worker->tiles;
+    worker->defs[worker->ndefs++] = def;
+}
+
+/**
+ * @brief Open the groups around a record that are not open yet, outermost first
+ * @param worker thread state
+ * @param w writer instance
+ * @param ngroups number of open groups (updated)
+ * @param index record index
+ * @return None
+ */
+static void snl_tiles_open_groups(snl_tiles_worker_t *const worker, snl_writer_t *const w, size_t *const ngroups, const uint32_t index) {
+    const snl_tiles_job_t *const job = worker->job;
+
+    // walk up to the innermost open group
+    const size_t open = *ngroups;
+    for (uint32_t g = job->parents[index]; g != SNL_TILES_NONE && (open == 0 || g != worker->groups[open - 1]); g = job->parents[g]) {
+        // grow
+        if (*ngroups == worker->groups_capacity) {
+            const size_t capacity = worker->groups_capacity ? worker->groups_capacity * 2 : 8;
+            uint32_t *const groups = realloc(worker->groups, capacity * sizeof(uint32_t));
+            VT_ENFORCE(groups != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+            worker->groups = groups;
+            worker->groups_capacity = capacity;
+        }
+        worker->groups[(*ngroups)++] = g;
+    }
+
+    // found innermost first
+    for (size_t a = open, b = *ngroups; a + 1 < b; a++, b--) {
+        const uint32_t tmp = worker->groups[a];
+        worker->groups[a] = worker->groups[b - 1];
+        worker->groups[b - 1] = tmp;
+    }
+    for (size_t i = open; i < *ngroups; i++) {
+        snl_display_list_serialize(job->canvas->list, worker->groups[i], w);
+    }
+}
+
+/**
+ * @brief Write the buffered part of a tile to its file
+ * @param worker thread state
+ * @param w writer instance targeting the worker buffer
+ * @param fp tile file
+ * @return None
+ */
+static void snl_tiles_flush(snl_tiles_worker_t *const worker, snl_writer_t *const w, FILE *const fp) {
+    snl_writer_flush(w);
+
+    const size_t len = vt_str_len(worker->buffer);
+    VT_ENFORCE(fwrite(vt_str_z(worker->buffer), 1, len, fp) == len, "Error: failed to write '%s'!\n", worker->path);
+    vt_str_clear(worker->buffer);
+}
+
+/**
+ * @brief Write <dir>/tiles.json: canvas size, tile size, file names and the levels
+ * @param job tiles job
+ * @return None
+ */
+static void snl_tiles_manifest(const snl_tiles_job_t *const job) {
+    vt_str_t *const manifest = vt_str_create_capacity(256 + 96 * job->nlevels, NULL);
+
+    snl_writer_t w;
+    snl_writer_init(&w, manifest);
+    snl_writer_put_str(&w, "{\n  \"width\": ");
+    snl_writer_put_float(&w, job->canvas->width, job->canvas->precision);
+    snl_writer_put_str(&w, ",\n  \"height\": ");
+    snl_writer_put_float(&w, job->canvas->height, job->canvas->precision);
+    snl_writer_put_str(&w, ",\n  \"tile_width\": ");
+    snl_writer_put_int(&w, job->tile_w);
+    snl_writer_put_str(&w, ",\n  \"tile_height\": ");
+    snl_writer_put_int(&w, job->tile_h);
+    snl_writer_put_str(&w, ",\n  \"url\": \"{z}/{x}/{y}.svg\",\n  \"levels\": [");
+    for (size_t z = 0; z < job->nlevels; z++) {
+        const snl_tiles_level_t *const level = &job->levels[z];
+        snl_writer_put_str(&w, z ? ",\n    " : "\n    ");
+        snl_writer_put_str(&w, "{ \"scale\": ");
+        snl_writer_put_int(&w, (int64_t)level->scale);
+        snl_writer_put_str(&w, ", \"columns\": ");
+        snl_writer_put_int(&w, (int64_t)level->columns);
+        snl_writer_put_str(&w, ", \"rows\": ");
+        snl_writer_put_int(&w, (int64_t)level->rows);
+        snl_writer_put_str(&w, ", \"tiles\": ");
+        snl_writer_put_int(&w, (int64_t)level->written);
+        snl_writer_put_str(&w, " }");
+    }
+    snl_writer_put_str(&w, "\n  ]\n}\n");
+    snl_writer_flush(&w);
+
+    // save
+    const size_t path_capacity = strlen(job->dir) + 16;
+    char *const path = malloc(path_capacity);
+    VT_ENFORCE(path != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_ALLOCATION));
+    snprintf(path, path_capacity, "%s/tiles.json", job->dir);
+    vt_file_write(path, vt_str_z(manifest));
+
+    free(path);
+    vt_str_destroy(manifest);
+}
+
+/**
+ * @brief Initialize a writer with the canvas output profile and a class sheet of its own
+ * @param canvas canvas instance
+ * @param sheet class sheet or NULL
+ * @param w writer instance
+ * @param target string to append to
+ * @return None
+ */
+static void snl_tiles_writer_init(const snl_canvas_t *const canvas, snl_style_sheet_t *const sheet, snl_writer_t *const w, vt_str_t *const target) {
+    snl_writer_init(w, target);
+    w->compact = (canvas->flags & SNL_CANVAS_COMPACT) != 0;
+    w->trim = (canvas->flags & (SNL_CANVAS_COMPACT | SNL_CANVAS_TRIM)) != 0;
+    w->precision = canvas->precision;
+    w->grid = canvas->grid;
+    w->sheet = sheet;
+    w->defs = canvas->defs;
+}
+
+/**
+ * @brief Create a directory unless it exists
+ * @param path directory path
+ * @return None
+ */
+static void snl_tiles_mkdir(const char *const path) {
+#if defined(_WIN32)
+    const int failed = _mkdir(path);
+#else
+    const int failed = mkdir(path, 0755);
+#endif
+    VT_ENFORCE(!failed || errno == EEXIST, "Error: failed to create '%s'!\n", path);
+}
+
+/**
+ * @brief qsort() comparator of record or definition indices in increasing order
+ * @param a index
+ * @param b index
+ * @return int
+ */
+static int snl_tiles_compare_asc(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
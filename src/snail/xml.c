@@ -0,0 +1,210 @@
+#include "xml.h"
+
+#include <string.h>
+#include "vita/container/str.h"
+
+static const char *snl_xml_find(const char *const from, const char *const end, const char *const pattern, const size_t pattern_len);
+static bool snl_xml_is_space(const char c);
+
+void snl_xml_reader_init(snl_xml_reader_t *const r, const char *const data, const size_t len) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(r != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(data != NULL || len == 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    *r = (snl_xml_reader_t) { .data = data, .len = len };
+}
+
+snl_xml_kind_t snl_xml_next(snl_xml_reader_t *const r, snl_xml_token_t *const token) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(r != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(token != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+
+    const char *const p = r->data + r->pos;
+    const char *const end = r->data + r->len;
+    *token = (snl_xml_token_t) { .kind = SNL_XML_EOF, .start = p };
+    if (p == end) return SNL_XML_EOF;
+
+    // character data up to the next tag
+    if (*p != '<') {
+        const char *const lt = memchr(p, '<', (size_t)(end - p));
+        token->kind = SNL_XML_TEXT;
+        token->len = (size_t)((lt ? lt : end) - p);
+        r->pos += token->len;
+        return SNL_XML_TEXT;
+    }
+
+    // comments, cdata sections, doctype and processing instructions
+    const char *close = NULL;
+    if (end - p >= 4 && memcmp(p, "<!--", 4) == 0) {
+        close = snl_xml_find(p + 4, end, "-->", 3);
+        token->kind = SNL_XML_OTHER;
+    } else if (end - p >= 9 && memcmp(p, "<![CDATA[", 9) == 0) {
+        close = snl_xml_find(p + 9, end, "]]>", 3);
+        token->kind = SNL_XML_OTHER;
+    } else if (end - p >= 2 && p[1] == '?') {
+        close = snl_xml_find(p + 2, end, "?>", 2);
+        token->kind = SNL_XML_OTHER;
+    } else if (end - p >= 2 && p[1] == '!') {
+        close = memchr(p + 2, '>', (size_t)(end - p - 2));
+        token->kind = SNL_XML_OTHER;
+    }
+    if (token->kind == SNL_XML_OTHER) {
+        if (close == NULL) return token->kind = SNL_XML_ERROR;
+        token->len = (size_t)(close - p) + (*close == '>' ? 1 : close[1] == '>' ? 2 : 3);
+        r->pos += token->len;
+        return SNL_XML_OTHER;
+    }
+
+    // tag name
+    const bool closing = end - p >= 2 && p[1] == '/';
+    const char *q = p + (closing ? 2 : 1);
+    token->name = q;
+    while (q < end && !snl_xml_is_space(*q) && *q != '>' && *q != '/') q++;
+    token->name_len = (size_t)(q - token->name);
+    if (token->name_len == 0) return token->kind = SNL_XML_ERROR;
+
+    // end of the tag, skipping quoted attribute values
+    while (q < end && *q != '>') {
+        if (*q == '\'' || *q == '"') {
+            const char *const quote = memchr(q + 1, *q, (size_t)(end - q - 1));
+            if (quote == NULL) return token->kind = SNL_XML_ERROR;
+            q = quote;
+        }
+        q++;
+    }
+    if (q == end) return token->kind = SNL_XML_ERROR;
+
+    token->kind = closing ? SNL_XML_CLOSE : SNL_XML_OPEN;
+    token->empty = !closing && q[-1] == '/';
+    token->len = (size_t)(q + 1 - p);
+    r->pos += token->len;
+
+    return token->kind;
+}
+
+bool snl_xml_is(const snl_xml_token_t *const token, const char *const name) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(token != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(name != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    const size_t len = strlen(name);
+    return token->name_len == len && memcmp(token->name, name, len) == 0;
+}
+
+bool snl_xml_attribute(const snl_xml_token_t *const token, const char *const name, const char **const value, size_t *const value_len) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(token != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(token->kind == SNL_XML_OPEN, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(name != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(value != NULL && value_len != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    const size_t len = strlen(name);
+    const char *cursor = NULL, *attr;
+    size_t attr_len;
+    while (snl_xml_next_attribute(token, &cursor, &attr, &attr_len, value, value_len)) {
+        if (attr_len == len && memcmp(attr, name, len) == 0) return true;
+    }
+
+    return false;
+}
+
+bool snl_xml_next_attribute(const snl_xml_token_t *const token, const char **const cursor, const char **const name, size_t *const name_len, const char **const value, size_t *const value_len) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(token != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(token->kind == SNL_XML_OPEN, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(cursor != NULL && name != NULL && name_len != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+    VT_DEBUG_ASSERT(value != NULL && value_len != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    const char *p = *cursor ? *cursor : token->name + token->name_len;
+    const char *const end = token->start + token->len - (token->empty ? 2 : 1);
+
+    // attribute name
+    while (p < end && snl_xml_is_space(*p)) p++;
+    if (p == end) return false;
+    *name = p;
+    while (p < end && *p != '=' && !snl_xml_is_space(*p)) p++;
+    *name_len = (size_t)(p - *name);
+
+    // quoted value
+    while (p < end && snl_xml_is_space(*p)) p++;
+    if (p == end || *p != '=') return false;
+    p++;
+    while (p < end && snl_xml_is_space(*p)) p++;
+    if (p == end || (*p != '\'' && *p != '"')) return false;
+    const char *const quote = memchr(p + 1, *p, (size_t)(end - p - 1));
+    if (quote == NULL) return false;
+
+    *value = p + 1;
+    *value_len = (size_t)(quote - p - 1);
+    *cursor = quote + 1;
+
+    return true;
+}
+
+void snl_xml_unescape(vt_str_t *const out, const char *const value, const size_t len) {
+    // check for invalid input
+    VT_DEBUG_ASSERT(out != NULL, "%s\n", vt_status_to_str(VT_STATUS_ERROR_INVALID_ARGUMENTS));
+    VT_DEBUG_ASSERT(value != NULL || len == 0, "%s\n", vt_status_to_str(VT_STATUS_ERROR_IS_NULL));
+
+    static const char *const entities[] = { "&lt;", "&gt;", "&amp;", "&apos;", "&quot;" };
+    static const char chars[] = "<>&'\"";
+
+    vt_str_clear(out);
+    const char *p = value;
+    const char *const end = value + len;
+    while (p < end) {
+        const char *const amp = memchr(p, '&', (size_t)(end - p));
+        if (amp == NULL) {
+            vt_str_append_n(out, p, (size_t)(end - p));
+            break;
+        }
+        vt_str_append_n(out, p, (size_t)(amp - p));
+
+        // other entities are kept as they are
+        size_t i = 0;
+        while (i < sizeof(entities) / sizeof(entities[0])) {
+            const size_t n = strlen(entities[i]);
+            if ((size_t)(end - amp) >= n && memcmp(amp, entities[i], n) == 0) break;
+            i++;
+        }
+        if (i < sizeof(entities) / sizeof(entities[0])) {
+            vt_str_append_n(out, &chars[i], 1);
+            p = amp + strlen(entities[i]);
+        } else {
+            vt_str_append_n(out, "&", 1);
+            p = amp + 1;
+        }
+    }
+}
+
+// ------------------------------- PRIVATE ------------------------------- //
+
+/**
+ * @brief Find a pattern in a byte range
+ * @param from range start
+ * @param end range end
+ * @param pattern pattern
+ * @param pattern_len pattern length
+ * @return first occurrence or NULL
+ */
+static const char *snl_xml_find(const char *const from, const char *const end, const char *const pattern, const size_t pattern_len) {
+    const char *p = from;
+    while (end - p >= (ptrdiff_t)pattern_len) {
+        p = memchr(p, pattern[0], (size_t)(end - p) - pattern_len + 1);
+        if (p == NULL) return NULL;
+        if (memcmp(p, pattern, pattern_len) == 0) return p;
+        p++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Check for xml whitespace
+ * @param c character
+ * @return bool
+ */
+static bool snl_xml_is_space(const char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
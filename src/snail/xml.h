@@ -0,0 +1,109 @@
+#ifndef SNAIL_XML_H
+#define SNAIL_XML_H
+
+/** XML MODULE (internal)
+ *  - snl_xml_reader_init
+ *  - snl_xml_next
+ *  - snl_xml_is
+ *  - snl_xml_attribute
+ *  - snl_xml_next_attribute
+ *  - snl_xml_unescape
+*/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "vita/container/str.h"
+
+// token kinds
+typedef enum SnailXmlKind {
+    SNL_XML_EOF,    // end of input
+    SNL_XML_OPEN,   // <name ...> or <name .../>
+    SNL_XML_CLOSE,  // </name>
+    SNL_XML_TEXT,   // character data between tags
+    SNL_XML_OTHER,  // comment, processing instruction, doctype or cdata section
+    SNL_XML_ERROR   // malformed markup
+} snl_xml_kind_t;
+
+// token pointing into the input, nothing is copied
+typedef struct SnailXmlToken {
+    snl_xml_kind_t kind;
+    const char *start;      // first byte of the token
+    size_t len;             // length of the token
+    const char *name;       // tag name of OPEN and CLOSE tokens
+    size_t name_len;
+    bool empty;             // OPEN token closed by '/>'
+} snl_xml_token_t;
+
+// tokenizer over a byte range, which does not have to be NUL-terminated
+typedef struct SnailXmlReader {
+    const char *data;
+    size_t len;
+    size_t pos;
+} snl_xml_reader_t;
+
+/**
+ * @brief Start reading a byte range
+ *
+ * @param r reader instance
+ * @param data input
+ * @param len input length
+ * @return None
+ */
+extern void snl_xml_reader_init(snl_xml_reader_t *const r, const char *const data, const size_t len);
+
+/**
+ * @brief Read the next token
+ *
+ * @param r reader instance
+ * @param token token (set on return)
+ * @return token kind; the reader stays at the token start on SNL_XML_ERROR
+ */
+extern snl_xml_kind_t snl_xml_next(snl_xml_reader_t *const r, snl_xml_token_t *const token);
+
+/**
+ * @brief Check the tag name of a token
+ *
+ * @param token OPEN or CLOSE token
+ * @param name tag name
+ * @return true if the names are equal
+ */
+extern bool snl_xml_is(const snl_xml_token_t *const token, const char *const name);
+
+/**
+ * @brief Find an attribute of an OPEN token
+ *
+ * @param token OPEN token
+ * @param name attribute name
+ * @param value attribute value, without quotes (set on return)
+ * @param value_len attribute value length (set on return)
+ * @return false if the attribute is missing
+ */
+extern bool snl_xml_attribute(const snl_xml_token_t *const token, const char *const name, const char **const value, size_t *const value_len);
+
+/**
+ * @brief Read the attributes of an OPEN token one after the other
+ *
+ * @param token OPEN token
+ * @param cursor NULL for the first attribute, then the position after the last one read (set on return)
+ * @param name attribute name (set on return)
+ * @param name_len attribute name length (set on return)
+ * @param value attribute value, without quotes (set on return)
+ * @param value_len attribute value length (set on return)
+ * @return false after the last attribute
+ */
+extern bool snl_xml_next_attribute(const snl_xml_token_t *const token, const char **const cursor, const char **const name, size_t *const name_len, const char **const value, size_t *const value_len);
+
+/**
+ * @brief Copy an attribute value, replacing the entities that snail writes with their characters
+ *
+ * @param out string to set
+ * @param value attribute value
+ * @param len value length
+ * @return None
+ *
+ * @note other entities are kept as they are
+ */
+extern void snl_xml_unescape(vt_str_t *const out, const char *const value, const size_t len);
+
+#endif // SNAIL_XML_H
+
@@ -0,0 +1,852 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snail/snail.h"
+
+#define BENCH_SHAPES 200000
+
+// svg renderer used to measure downstream rasterization time, called with the file name as last argument
+#define BENCH_RASTERIZER_ENV "SNAIL_BENCH_RASTERIZER"
+#define BENCH_RASTERIZER_DEFAULT "rsvg-convert -o /dev/null"
+
+void bench_render_shapes(void);
+void bench_stream(void);
+void bench_retained(void);
+void bench_polyline(void);
+void bench_compact(void);
+void bench_precision(void);
+void bench_classes(void);
+void bench_defs(void);
+void bench_raster(void);
+void bench_load(void);
+void bench_append(void);
+void bench_symbols(void);
+void bench_groups(void);
+void bench_escape(void);
+void bench_text_measure(void);
+void bench_labels(void);
+void bench_cull(void);
+void bench_occlude(void);
+void bench_query(void);
+void bench_tiles(void);
+
+int main(void) {
+    printf("*** snail benchmarks ***\n");
+
+    bench_render_shapes();
+    bench_stream();
+    bench_retained();
+    bench_polyline();
+    bench_compact();
+    bench_precision();
+    bench_classes();
+    bench_defs();
+    bench_raster();
+    bench_load();
+    bench_append();
+    bench_symbols();
+    bench_groups();
+    bench_escape();
+    bench_text_measure();
+    bench_labels();
+    bench_cull();
+    bench_occlude();
+    bench_query();
+    bench_tiles();
+
+    return 0;
+}
+
+// ------------------------------- HELPERS ------------------------------- //
+
+static double bench_now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static float bench_randf(const float max) {
+    return (float)rand() / (float)RAND_MAX * max;
+}
+
+// runs the svg renderer command of BENCH_RASTERIZER_ENV (default: rsvg-convert) on a file;
+// returns the time taken in seconds, or -1 if the renderer is missing or fails
+static double bench_external_raster(const char *const filename) {
+    const char *const renderer = getenv(BENCH_RASTERIZER_ENV);
+    char command[1024];
+    snprintf(
+        command, sizeof(command), "%s %s > /dev/null 2>&1",
+        renderer && *renderer ? renderer : BENCH_RASTERIZER_DEFAULT, filename
+    );
+
+    const double t0 = bench_now();
+    const int status = system(command);
+    const double time = bench_now() - t0;
+
+    return status == 0 ? time : -1;
+}
+
+// the printf-based serialization snail used before the fast emitter
+static void legacy_render_circle(vt_str_t *const s, const snl_point_t origin, const float radius, const snl_appearance_t appearance) {
+    vt_str_appendf(s, "<circle cx='%.2f' cy='%.2f' r='%.2f' ", origin.x, origin.y, radius);
+    vt_str_appendf(
+        s, "stroke='rgba(%u, %u, %u, %u)' stroke-width='%.2f' stroke-opacity='%.2f' ",
+        appearance.stroke_color.r, appearance.stroke_color.g, appearance.stroke_color.b, appearance.stroke_color.a,
+        appearance.stroke_width, appearance.stroke_opacity
+    );
+    vt_str_appendf(
+        s, "fill='rgba(%u, %u, %u, %u)' fill-opacity='%.2f' filter='url(#%s)' ",
+        appearance.fill_color.r, appearance.fill_color.g, appearance.fill_color.b, appearance.fill_color.a,
+        appearance.fill_opacity, "__default__"
+    );
+    vt_str_appendf(s, "%s", "/>\n");
+}
+
+// a tests/test.svg-style scene: mostly default appearances, a few filters and gradients
+static void bench_draw_scene(snl_canvas_t *const canvas) {
+    snl_canvas_add_filter_blur(canvas, "b0", 1, 1);
+    snl_canvas_add_filter_shadow(canvas, "s0", 10, 10, 5, true);
+    snl_canvas_add_gradient_linear(canvas, "lg0", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 0);
+    snl_canvas_add_gradient_radial(canvas, "rg0", SNL_COLOR_CORAL, SNL_COLOR_PURPLE, 0, 100, 1, 1);
+
+    for (size_t i = 0; i < BENCH_SHAPES / 10; i++) {
+        const snl_point_t p = SNL_POINT(bench_randf(4096), bench_randf(4096));
+        snl_canvas_render_line(canvas, p, SNL_POINT(p.x + 50, p.y + 50), SNL_APPEARANCE_DEFAULT);
+        snl_canvas_render_circle(canvas, p, 25, SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_NONE, NULL, NULL));
+        snl_canvas_render_circle(canvas, p, 25, SNL_APPEARANCE(3, 1, SNL_COLOR_TEAL, 1, SNL_COLOR_CORAL, NULL, NULL));
+        snl_canvas_render_ellipse(canvas, p, SNL_POINT(40, 25), SNL_APPEARANCE(5, 1, SNL_COLOR_PURPLE, 0.5, SNL_COLOR_DARKORANGE, NULL, NULL));
+        snl_canvas_render_rectangle(canvas, p, SNL_POINT(40, 40), 0, SNL_APPEARANCE(7, 1, SNL_COLOR_GOLD, 1, SNL_COLOR_YELLOW, NULL, NULL));
+        snl_canvas_render_rectangle(canvas, p, SNL_POINT(60, 60), 0, SNL_APPEARANCE(1, 1, SNL_COLOR_BLUE, 1, SNL_COLOR_NONE, NULL, "lg0"));
+        snl_canvas_render_curve(canvas, p, SNL_POINT(p.x + 50, p.y), SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_NONE, NULL, NULL));
+        snl_canvas_render_circle(canvas, p, 25, SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_NONE, "s0", "rg0"));
+        snl_canvas_render_text(canvas, p, "hello, world!", 14, SNL_FONT_ARIAL, SNL_COLOR_CORAL);
+        snl_canvas_render_rectangle(canvas, p, SNL_POINT(60, 60), 0, SNL_APPEARANCE(1, 1, SNL_COLOR_BLUE, 1, SNL_COLOR_LIME, "b0", NULL));
+    }
+}
+
+// a map marker: a few circles plus a polygon
+static void bench_draw_marker(snl_canvas_t *const canvas, const snl_point_t p) {
+    const snl_point_t pin[] = { SNL_POINT(p.x - 4, p.y - 8), SNL_POINT(p.x + 4, p.y - 8), SNL_POINT(p.x, p.y - 16) };
+    snl_canvas_render_circle(canvas, p, 6, SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_CORAL, NULL, NULL));
+    snl_canvas_render_circle(canvas, p, 3, SNL_APPEARANCE(0, 1, SNL_COLOR_NONE, 1, SNL_COLOR_WHITE, NULL, NULL));
+    snl_canvas_render_circle(canvas, p, 1, SNL_APPEARANCE(0, 1, SNL_COLOR_NONE, 1, SNL_COLOR_BLACK, NULL, NULL));
+    snl_canvas_render_polygon_points(canvas, pin, 3, SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_TEAL, NULL, NULL), NULL);
+}
+
+// ------------------------------- BENCHMARKS ------------------------------- //
+
+void bench_render_shapes(void) {
+    // random input
+    float *xs = malloc(sizeof(float) * BENCH_SHAPES);
+    float *ys = malloc(sizeof(float) * BENCH_SHAPES);
+    float *rs = malloc(sizeof(float) * BENCH_SHAPES);
+    srand(42);
+    for (size_t i = 0; i < BENCH_SHAPES; i++) {
+        xs[i] = bench_randf(4096) - 100;
+        ys[i] = bench_randf(4096) - 100;
+        rs[i] = bench_randf(16);
+    }
+    const snl_appearance_t appearance = SNL_APPEARANCE(1.5, 1, SNL_COLOR_TEAL, 0.75, SNL_COLOR_CORAL, NULL, NULL);
+
+    // legacy: vt_str_appendf
+    snl_canvas_t legacy = snl_canvas_create(4096, 4096);
+    double t0 = bench_now();
+    for (size_t i = 0; i < BENCH_SHAPES; i++) {
+        legacy_render_circle(legacy.surface, SNL_POINT(xs[i], ys[i]), rs[i], appearance);
+    }
+    const double legacy_time = bench_now() - t0;
+
+    // snail
+    snl_canvas_t canvas = snl_canvas_create(4096, 4096);
+    t0 = bench_now();
+    for (size_t i = 0; i < BENCH_SHAPES; i++) {
+        snl_canvas_render_circle(&canvas, SNL_POINT(xs[i], ys[i]), rs[i], appearance);
+    }
+    const double snail_time = bench_now() - t0;
+
+    // snail batch
+    snl_canvas_t batch = snl_canvas_create(4096, 4096);
+    t0 = bench_now();
+    snl_canvas_render_circles(&batch, xs, ys, rs, BENCH_SHAPES, appearance);
+    const double batch_time = bench_now() - t0;
+
+    // output must be byte-identical
+    const bool same = (
+        strcmp(vt_str_z(legacy.surface), vt_str_z(canvas.surface)) == 0 && 
+        strcmp(vt_str_z(legacy.surface), vt_str_z(batch.surface)) == 0
+    );
+
+    printf("- render_circle x %d\n", BENCH_SHAPES);
+    printf("    vt_str_appendf: %10.0f shapes/s\n", BENCH_SHAPES / legacy_time);
+    printf("    snail emitter : %10.0f shapes/s (%.2fx)\n", BENCH_SHAPES / snail_time, legacy_time / snail_time);
+    printf("    snail batch   : %10.0f shapes/s (%.2fx)\n", BENCH_SHAPES / batch_time, legacy_time / batch_time);
+    printf("    identical     : %s\n", same ? "yes" : "NO");
+
+    snl_canvas_destroy(&legacy);
+    snl_canvas_destroy(&canvas);
+    snl_canvas_destroy(&batch);
+    free(xs);
+    free(ys);
+    free(rs);
+}
+
+void bench_stream(void) {
+    FILE *fp = fopen("bench_stream.svg", "wb");
+    if (!fp) return;
+
+    // stream circles straight to the file
+    snl_canvas_t canvas = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .sink = snl_sink_file(fp) });
+    const snl_appearance_t appearance = SNL_APPEARANCE(1.5, 1, SNL_COLOR_TEAL, 0.75, SNL_COLOR_CORAL, NULL, NULL);
+    srand(42);
+    const double t0 = bench_now();
+    for (size_t i = 0; i < BENCH_SHAPES * 5; i++) {
+        snl_canvas_render_circle(&canvas, SNL_POINT(bench_randf(4096), bench_randf(4096)), bench_randf(16), appearance);
+    }
+    snl_canvas_finish(&canvas);
+    const double stream_time = bench_now() - t0;
+
+    printf("- stream render_circle x %d\n", BENCH_SHAPES * 5);
+    printf("    written       : %10zu bytes\n", canvas.flushed);
+    printf("    buffer        : %10zu bytes\n", vt_str_capacity(canvas.surface));
+    printf("    throughput    : %10.0f shapes/s\n", BENCH_SHAPES * 5 / stream_time);
+
+    snl_canvas_destroy(&canvas);
+    fclose(fp);
+    remove("bench_stream.svg");
+}
+
+void bench_retained(void) {
+    srand(42);
+    const snl_appearance_t appearance = SNL_APPEARANCE(1.5, 1, SNL_COLOR_TEAL, 0.75, SNL_COLOR_CORAL, NULL, NULL);
+
+    // record circles, undo half of them, then serialize once
+    snl_canvas_t canvas = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+    double t0 = bench_now();
+    for (size_t i = 0; i < BENCH_SHAPES; i++) {
+        snl_canvas_render_circle(&canvas, SNL_POINT(bench_randf(4096), bench_randf(4096)), bench_randf(16), appearance);
+    }
+    const double record_time = bench_now() - t0;
+    t0 = bench_now();
+    for (size_t i = 0; i < BENCH_SHAPES / 2; i++) {
+        snl_canvas_undo(&canvas);
+    }
+    const double undo_time = bench_now() - t0;
+    t0 = bench_now();
+    snl_canvas_save(&canvas, "bench_retained.svg");
+    const double save_time = bench_now() - t0;
+
+    printf("- retained render_circle x %d\n", BENCH_SHAPES);
+    printf("    record        : %10.0f shapes/s\n", BENCH_SHAPES / record_time);
+    printf("    undo          : %10.0f ops/s\n", BENCH_SHAPES / 2 / undo_time);
+    printf("    save          : %10.0f shapes/s\n", BENCH_SHAPES / 2 / save_time);
+
+    snl_canvas_destroy(&canvas);
+    remove("bench_retained.svg");
+}
+
+void bench_polyline(void) {
+    // a long time series
+    const size_t n = BENCH_SHAPES * 5;
+    snl_point_t *points = malloc(sizeof(snl_point_t) * n);
+    srand(42);
+    for (size_t i = 0; i < n; i++) {
+        points[i] = SNL_POINT((float)i * 0.01f, bench_randf(512));
+    }
+
+    // one call per point
+    snl_canvas_t single = snl_canvas_create(4096, 512);
+    double t0 = bench_now();
+    snl_canvas_render_polyline_begin(&single);
+    for (size_t i = 0; i < n; i++) {
+        snl_canvas_render_polyline_point(&single, points[i]);
+    }
+    snl_canvas_render_polyline_end(&single, SNL_APPEARANCE_DEFAULT);
+    const double single_time = bench_now() - t0;
+
+    // one call per polyline
+    snl_canvas_t bulk = snl_canvas_create(4096, 512);
+    t0 = bench_now();
+    snl_canvas_render_polyline_points(&bulk, points, n, SNL_APPEARANCE_DEFAULT);
+    const double bulk_time = bench_now() - t0;
+
+    // path data
+    snl_canvas_options_t options = SNL_CANVAS_OPTIONS_DEFAULT;
+    options.flags = SNL_CANVAS_COMPACT;
+    snl_canvas_t compact = snl_canvas_create_ex(4096, 512, options);
+    t0 = bench_now();
+    snl_canvas_render_polyline_points(&compact, points, n, SNL_APPEARANCE_DEFAULT);
+    const double compact_time = bench_now() - t0;
+
+    printf("- polyline x %zu points\n", n);
+    printf("    per point     : %10.0f points/s\n", n / single_time);
+    printf("    point array   : %10.0f points/s (%.2fx)\n", n / bulk_time, single_time / bulk_time);
+    printf("    identical     : %s\n", strcmp(vt_str_z(single.surface), vt_str_z(bulk.surface)) == 0 ? "yes" : "NO");
+    printf("    path data     : %10.0f points/s, %.2fx smaller\n", n / compact_time, (double)vt_str_len(bulk.surface) / (double)vt_str_len(compact.surface));
+
+    snl_canvas_destroy(&single);
+    snl_canvas_destroy(&bulk);
+    snl_canvas_destroy(&compact);
+    free(points);
+}
+
+
+void bench_compact(void) {
+    // default profile
+    srand(42);
+    snl_canvas_t full = snl_canvas_create(4096, 4096);
+    double t0 = bench_now();
+    bench_draw_scene(&full);
+    const double full_time = bench_now() - t0;
+
+    // compact profile
+    srand(42);
+    snl_canvas_t compact = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT });
+    t0 = bench_now();
+    bench_draw_scene(&compact);
+    const double compact_time = bench_now() - t0;
+
+    const size_t full_size = vt_str_len(full.surface);
+    const size_t compact_size = vt_str_len(compact.surface);
+    printf("- compact profile, test.svg-style scene x %d shapes\n", BENCH_SHAPES);
+    printf("    default       : %10zu bytes, %10.0f shapes/s\n", full_size, BENCH_SHAPES / full_time);
+    printf("    compact       : %10zu bytes, %10.0f shapes/s\n", compact_size, BENCH_SHAPES / compact_time);
+    printf("    saved         : %9.1f%%\n", 100.0 * (double)(full_size - compact_size) / (double)full_size);
+
+    // downstream rasterization by an svg renderer, where the __default__ filter costs the most
+    snl_canvas_save(&full, "bench_compact_full.svg");
+    snl_canvas_save(&compact, "bench_compact.svg");
+    const double full_raster = bench_external_raster("bench_compact_full.svg");
+    const double compact_raster = bench_external_raster("bench_compact.svg");
+    if (full_raster >= 0 && compact_raster >= 0) {
+        printf("    rasterize     : %9.2fs default, %.2fs compact (%.2fx)\n", full_raster, compact_raster, full_raster / compact_raster);
+    } else {
+        printf("    rasterize     : skipped, set %s to an svg renderer command\n", BENCH_RASTERIZER_ENV);
+    }
+
+    snl_canvas_destroy(&full);
+    snl_canvas_destroy(&compact);
+    remove("bench_compact_full.svg");
+    remove("bench_compact.svg");
+}
+
+void bench_precision(void) {
+    const int32_t precisions[] = { SNL_PRECISION_INTEGER, 1, SNL_PRECISION_DEFAULT, 3, 4, SNL_PRECISION_INTEGER };
+    const float grids[] = { 0, 0, 0, 0, 0, 8 };
+    const char *const names[] = { "integer", "1 digit", "2 digits", "3 digits", "4 digits", "8px grid" };
+
+    printf("- precision, compact test.svg-style scene x %d shapes\n", BENCH_SHAPES);
+    for (size_t i = 0; i < sizeof(precisions) / sizeof(precisions[0]); i++) {
+        srand(42);
+        const snl_canvas_options_t options = { .flags = SNL_CANVAS_COMPACT, .precision = precisions[i], .grid = grids[i] };
+        snl_canvas_t canvas = snl_canvas_create_ex(4096, 4096, options);
+        const double t0 = bench_now();
+        bench_draw_scene(&canvas);
+        const double time = bench_now() - t0;
+
+        // coordinates move by at most half a step, lengths by at most half a digit
+        const double step = grids[i] > 0 ? grids[i] : pow(10, -(precisions[i] < 0 ? 0 : precisions[i]));
+        const size_t size = vt_str_len(canvas.surface);
+        printf("    %-13s : %10zu bytes, %10.0f shapes/s, error <= %g\n", names[i], size, BENCH_SHAPES / time, step / 2);
+
+        snl_canvas_destroy(&canvas);
+    }
+}
+
+void bench_classes(void) {
+    const uint32_t flags[] = { 0, SNL_CANVAS_CLASSES, SNL_CANVAS_COMPACT, SNL_CANVAS_COMPACT | SNL_CANVAS_CLASSES };
+    const char *const names[] = { "default", "classes", "compact", "compact+classes" };
+
+    printf("- css classes, test.svg-style scene x %d shapes\n", BENCH_SHAPES);
+    size_t full_size = 0;
+    for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+        srand(42);
+        snl_canvas_t canvas = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .flags = flags[i] });
+        const double t0 = bench_now();
+        bench_draw_scene(&canvas);
+        const double time = bench_now() - t0;
+
+        const size_t size = vt_str_len(canvas.surface);
+        if (i == 0) full_size = size;
+        printf("    %-15s: %10zu bytes (%5.1f%% saved), %10.0f shapes/s\n", names[i], size, 100.0 * (double)(full_size - size) / (double)full_size, BENCH_SHAPES / time);
+
+        snl_canvas_destroy(&canvas);
+    }
+}
+
+void bench_defs(void) {
+    // every panel of a templated report adds the same definitions under its own ids
+    const size_t panels = 1000;
+    snl_canvas_t canvas = snl_canvas_create(4096, 4096);
+    const double t0 = bench_now();
+    for (size_t i = 0; i < panels; i++) {
+        char blur[32], gradient[32];
+        snprintf(blur, sizeof(blur), "panel%zu-blur", i);
+        snprintf(gradient, sizeof(gradient), "panel%zu-bg", i);
+        snl_canvas_add_filter_blur(&canvas, blur, 2, 2);
+        snl_canvas_add_gradient_linear(&canvas, gradient, SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 45);
+        snl_canvas_render_rectangle(&canvas, SNL_POINT(i % 32 * 128, i / 32 * 128), SNL_POINT(120, 120), 4, SNL_APPEARANCE(1, 1, SNL_COLOR_NONE, 1, SNL_COLOR_NONE, blur, gradient));
+    }
+    const double time = bench_now() - t0;
+
+    printf("- definitions, %zu panels with 2 definitions each\n", panels);
+    printf("    definitions   : %10zu bytes\n", vt_str_len(canvas.definitions));
+    printf("    size          : %10zu bytes, %10.0f panels/s\n", vt_str_len(canvas.surface), panels / time);
+
+    snl_canvas_destroy(&canvas);
+
+    // distinct gradients between shapes: the cost of a definition does not grow with what was drawn before it
+    for (size_t n = 2000; n <= 8000; n *= 4) {
+        snl_canvas_t chart = snl_canvas_create(4096, 4096);
+        const double t1 = bench_now();
+        for (size_t i = 0; i < n; i++) {
+            char gradient[32];
+            snprintf(gradient, sizeof(gradient), "g%zu", i);
+            snl_canvas_add_gradient_linear(&chart, gradient, SNL_COLOR((uint8_t)i, (uint8_t)(i >> 8), 0, 255), SNL_COLOR_RED, 0, 100, 1, 1, 0);
+            snl_canvas_render_circle(&chart, SNL_POINT(i % 64 * 64, i / 64 * 32), 16, SNL_APPEARANCE(1, 1, SNL_COLOR_NONE, 1, SNL_COLOR_NONE, NULL, gradient));
+        }
+        printf("    %5zu gradients: %10.0f definitions/s\n", n, n / (bench_now() - t1));
+        snl_canvas_destroy(&chart);
+    }
+}
+
+void bench_raster(void) {
+    srand(42);
+    snl_canvas_t canvas = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+    bench_draw_scene(&canvas);
+
+    // svg serialization
+    double t0 = bench_now();
+    snl_canvas_save(&canvas, "bench_raster.svg");
+    const double svg_time = bench_now() - t0;
+
+    // pixels
+    snl_raster_t raster = snl_raster_create(1024, 1024);
+    snl_raster_clear(&raster, SNL_COLOR_WHITE);
+    t0 = bench_now();
+    snl_canvas_rasterize(&canvas, &raster);
+    const double raster_time = bench_now() - t0;
+
+    t0 = bench_now();
+    snl_raster_save_png(&raster, "bench_raster.png");
+    const double png_time = bench_now() - t0;
+
+    // tiles on all processors
+    snl_raster_t parallel = snl_raster_create(1024, 1024);
+    snl_raster_clear(&parallel, SNL_COLOR_WHITE);
+    t0 = bench_now();
+    snl_canvas_rasterize_parallel(&canvas, &parallel, 0);
+    const double parallel_time = bench_now() - t0;
+    const bool same = memcmp(raster.pixels, parallel.pixels, (size_t)raster.width * raster.height * 4) == 0;
+
+    printf("- rasterizer, test.svg-style scene x %d shapes\n", BENCH_SHAPES);
+    printf("    svg save      : %10.0f shapes/s\n", BENCH_SHAPES / svg_time);
+    printf("    rasterize     : %10.0f shapes/s (1024x1024, %.2fx svg)\n", BENCH_SHAPES / raster_time, raster_time / svg_time);
+    printf("    parallel      : %10.0f shapes/s (%.2fx)\n", BENCH_SHAPES / parallel_time, raster_time / parallel_time);
+    printf("    identical     : %s\n", same ? "yes" : "NO");
+    printf("    png save      : %10.0f pixels/s\n", 1024.0 * 1024.0 / png_time);
+
+    snl_raster_destroy(&raster);
+    snl_raster_destroy(&parallel);
+    snl_canvas_destroy(&canvas);
+    remove("bench_raster.svg");
+    remove("bench_raster.png");
+}
+
+void bench_load(void) {
+    // a large streamed document
+    FILE *fp = fopen("bench_load.svg", "wb");
+    if (!fp) return;
+    srand(42);
+    snl_canvas_t source = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .sink = snl_sink_file(fp) });
+    for (size_t i = 0; i < 2; i++) bench_draw_scene(&source);
+    snl_canvas_finish(&source);
+    const size_t size = source.flushed;
+    snl_canvas_destroy(&source);
+    fclose(fp);
+
+    // map and scan it, draw an overlay and save it back
+    double t0 = bench_now();
+    snl_canvas_t canvas = snl_canvas_load("bench_load.svg");
+    const double load_time = bench_now() - t0;
+    snl_canvas_add_gradient_linear(&canvas, "overlay", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 0);
+    snl_canvas_render_rectangle(&canvas, SNL_POINT(0, 0), SNL_POINT(4096, 64), 0, SNL_APPEARANCE(1, 1, SNL_COLOR_NONE, 1, SNL_COLOR_NONE, NULL, "overlay"));
+    t0 = bench_now();
+    snl_canvas_save(&canvas, "bench_load.svg");
+    const double save_time = bench_now() - t0;
+
+    printf("- load, test.svg-style scene x %d shapes\n", BENCH_SHAPES * 2);
+    printf("    size          : %10zu bytes\n", size);
+    printf("    load          : %10.0f MB/s\n", size / load_time / 1e6);
+    printf("    save          : %10.0f MB/s\n", size / save_time / 1e6);
+    printf("    definitions   : %10zu bytes\n", vt_str_len(canvas.definitions));
+
+    snl_canvas_destroy(&canvas);
+    remove("bench_load.svg");
+}
+
+void bench_append(void) {
+    // a large timeline
+    srand(42);
+    snl_canvas_t source = snl_canvas_create(4096, 4096);
+    bench_draw_scene(&source);
+    snl_canvas_save(&source, "bench_append.svg");
+    const size_t size = vt_str_len(source.surface);
+    snl_canvas_destroy(&source);
+
+    // a few new shapes per update, rewriting the whole file
+    const size_t updates = 100;
+    double t0 = bench_now();
+    for (size_t i = 0; i < updates / 10; i++) {
+        snl_canvas_t canvas = snl_canvas_load("bench_append.svg");
+        for (size_t j = 0; j < 10; j++) snl_canvas_render_circle(&canvas, SNL_POINT(bench_randf(4096), bench_randf(4096)), 8, SNL_APPEARANCE_DEFAULT);
+        snl_canvas_save(&canvas, "bench_append.svg");
+        snl_canvas_destroy(&canvas);
+    }
+    const double rewrite_time = (bench_now() - t0) * 10;
+
+    // the same updates appended in place
+    snl_canvas_t canvas = snl_canvas_append("bench_append.svg");
+    t0 = bench_now();
+    for (size_t i = 0; i < updates; i++) {
+        for (size_t j = 0; j < 10; j++) snl_canvas_render_circle(&canvas, SNL_POINT(bench_randf(4096), bench_randf(4096)), 8, SNL_APPEARANCE_DEFAULT);
+        snl_canvas_sync(&canvas);
+    }
+    const double append_time = bench_now() - t0;
+
+    printf("- append, %zu updates of 10 shapes to a %zu byte file\n", updates, size);
+    printf("    rewrite       : %10.0f updates/s\n", updates / rewrite_time);
+    printf("    append        : %10.0f updates/s (%.2fx, durable)\n", updates / append_time, rewrite_time / append_time);
+
+    snl_canvas_destroy(&canvas);
+    remove("bench_append.svg");
+}
+
+void bench_symbols(void) {
+    // every marker drawn in full
+    srand(42);
+    snl_canvas_t full = snl_canvas_create(4096, 4096);
+    double t0 = bench_now();
+    for (size_t i = 0; i < BENCH_SHAPES; i++) {
+        bench_draw_marker(&full, SNL_POINT(bench_randf(4096), bench_randf(4096)));
+    }
+    const double full_time = bench_now() - t0;
+
+    // one symbol, placed
+    srand(42);
+    snl_canvas_t instanced = snl_canvas_create(4096, 4096);
+    t0 = bench_now();
+    snl_canvas_symbol_begin(&instanced, "marker");
+    bench_draw_marker(&instanced, SNL_POINT(0, 0));
+    snl_canvas_symbol_end(&instanced);
+    for (size_t i = 0; i < BENCH_SHAPES; i++) {
+        snl_canvas_render_instance(&instanced, "marker", SNL_POINT(bench_randf(4096), bench_randf(4096)), 1, 0);
+    }
+    const double instanced_time = bench_now() - t0;
+
+    const size_t full_size = vt_str_len(full.surface);
+    const size_t instanced_size = vt_str_len(instanced.surface);
+    printf("- symbols, %d markers of 4 shapes\n", BENCH_SHAPES);
+    printf("    render calls  : %10zu bytes, %10.0f markers/s\n", full_size, BENCH_SHAPES / full_time);
+    printf("    instances     : %10zu bytes, %10.0f markers/s (%.2fx smaller, %.2fx faster)\n", instanced_size, BENCH_SHAPES / instanced_time, (double)full_size / (double)instanced_size, full_time / instanced_time);
+
+    snl_canvas_destroy(&full);
+    snl_canvas_destroy(&instanced);
+}
+
+void bench_groups(void) {
+    // small multiples: a grid of facets, each a scatter plot in its own coordinates
+    const size_t facets = 100, points = BENCH_SHAPES / 100;
+    const snl_appearance_t dot = SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 0.5, SNL_COLOR_TEAL, NULL, NULL);
+
+    // every point translated and styled on its own
+    srand(42);
+    snl_canvas_t baked = snl_canvas_create(4000, 4000);
+    double t0 = bench_now();
+    for (size_t i = 0; i < facets; i++) {
+        const snl_point_t origin = SNL_POINT((float)(i % 10) * 400, (float)(i / 10) * 400);
+        for (size_t j = 0; j < points; j++) {
+            snl_canvas_render_circle(&baked, SNL_POINT(origin.x + bench_randf(400), origin.y + bench_randf(400)), 2, dot);
+        }
+    }
+    const double baked_time = bench_now() - t0;
+
+    // one translated and styled group per facet
+    srand(42);
+    snl_canvas_t grouped = snl_canvas_create(4000, 4000);
+    t0 = bench_now();
+    for (size_t i = 0; i < facets; i++) {
+        snl_canvas_push_group(&grouped, SNL_TRANSFORM_TRANSLATE((float)(i % 10) * 400, (float)(i / 10) * 400), &dot);
+        for (size_t j = 0; j < points; j++) {
+            snl_canvas_render_circle(&grouped, SNL_POINT(bench_randf(400), bench_randf(400)), 2, dot);
+        }
+        snl_canvas_pop_group(&grouped);
+    }
+    const double grouped_time = bench_now() - t0;
+
+    const size_t baked_size = vt_str_len(baked.surface);
+    const size_t grouped_size = vt_str_len(grouped.surface);
+    printf("- groups, %zu facets of %zu points\n", facets, points);
+    printf("    baked         : %10zu bytes, %10.0f shapes/s\n", baked_size, BENCH_SHAPES / baked_time);
+    printf("    groups        : %10zu bytes, %10.0f shapes/s (%.2fx smaller, %.2fx faster)\n", grouped_size, BENCH_SHAPES / grouped_time, (double)baked_size / (double)grouped_size, baked_time / grouped_time);
+
+    snl_canvas_destroy(&baked);
+    snl_canvas_destroy(&grouped);
+}
+
+void bench_escape(void) {
+    // map labels: plain ascii, markup-heavy and non-ascii
+    const char *const labels[] = {
+        "Main Street Station, Platform 4 (northbound)",
+        "Smith & Sons <wholesale> \"Barrow's\" & Co",
+        "Z\xc3\xbcrich Hauptbahnhof \xe2\x80\x94 \xe6\x9d\xb1\xe4\xba\xac\xe9\xa7\x85"
+    };
+    const char *const names[] = { "ascii", "markup", "utf-8" };
+
+    printf("- text escaping, %d labels\n", BENCH_SHAPES);
+    for (size_t i = 0; i < sizeof(labels) / sizeof(labels[0]); i++) {
+        snl_canvas_t canvas = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT });
+        const double t0 = bench_now();
+        for (size_t j = 0; j < BENCH_SHAPES; j++) {
+            snl_canvas_render_text(&canvas, SNL_POINT(j % 4096, j / 4096), labels[i], 12, SNL_FONT_ARIAL, SNL_COLOR_BLACK);
+        }
+        const double time = bench_now() - t0;
+        printf("    %-13s : %10.0f labels/s, %7.1f MB/s of text\n", names[i], BENCH_SHAPES / time, (double)strlen(labels[i]) * BENCH_SHAPES / time / 1e6);
+
+        snl_canvas_destroy(&canvas);
+    }
+}
+
+void bench_text_measure(void) {
+    const char *const fonts[] = { SNL_FONT_ARIAL, SNL_FONT_VERDANA, SNL_FONT_GEORGIA, SNL_FONT_COMIC_SANS_MS };
+    const char *const labels[] = {
+        "Main Street Station", "Platform 4 (northbound)", "Z\xc3\xbcrich Hauptbahnhof", "\xe6\x9d\xb1\xe4\xba\xac\xe9\xa7\x85"
+    };
+
+    const double t0 = bench_now();
+    double width = 0;
+    for (size_t i = 0; i < BENCH_SHAPES; i++) {
+        const snl_text_style_t style = SNL_TEXT_STYLE(
+            12, 0, fonts[i % 4], i % 3 ? SNL_FONT_WEIGHT_NORMAL : SNL_FONT_WEIGHT_BOLD, SNL_FONT_STYLE_NORMAL, SNL_TEXT_NONE
+        );
+        width += snl_text_measure(labels[(i / 4) % 4], style).width;
+    }
+    const double time = bench_now() - t0;
+
+    printf("- text measuring, %d labels\n", BENCH_SHAPES);
+    printf("    %-13s : %10.0f labels/s, %.0f px of text\n", "measure", BENCH_SHAPES / time, width);
+}
+
+void bench_labels(void) {
+    const size_t candidates = 1000000;
+    const char *const names[] = { "Springfield", "Main Street Station", "Z\xc3\xbcrich", "Oak Hill", "Riverside Park" };
+
+    snl_canvas_t canvas = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT });
+    snl_labels_t labels = snl_labels_create((snl_label_options_t) { .offset = 2, .padding = 1 });
+
+    const double t0 = bench_now();
+    for (size_t i = 0; i < candidates; i++) {
+        snl_labels_add(
+            &labels, SNL_POINT(bench_randf(4096), bench_randf(4096)), names[i % 5], bench_randf(100),
+            SNL_APPEARANCE_DEFAULT, SNL_TEXT_STYLE(10, 0, SNL_FONT_ARIAL, SNL_FONT_WEIGHT_NORMAL, SNL_FONT_STYLE_NORMAL, SNL_TEXT_NONE)
+        );
+    }
+    const double t1 = bench_now();
+    const size_t placed = snl_labels_place(&labels, &canvas);
+    const double t2 = bench_now();
+
+    printf("- label placement, %zu candidates\n", candidates);
+    printf("    %-13s : %8.3f s\n", "add", t1 - t0);
+    printf("    %-13s : %8.3f s, %zu placed\n", "place", t2 - t1, placed);
+
+    snl_labels_destroy(&labels);
+    snl_canvas_destroy(&canvas);
+}
+
+// a zoomed-in map view: a 1024x1024 window panned over a 4096x4096 dataset of points and tracks
+static void bench_draw_view(snl_canvas_t *const canvas, const snl_point_t *const track, const size_t track_len) {
+    const snl_appearance_t dot = SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 0.5, SNL_COLOR_TEAL, NULL, NULL);
+    const snl_appearance_t line = SNL_APPEARANCE(2, 1, SNL_COLOR_CORAL, 1, SNL_COLOR_NONE, NULL, NULL);
+
+    srand(42);
+    snl_canvas_translate(canvas, -1536, -1536);
+    for (size_t i = 0; i < BENCH_SHAPES; i++) {
+        snl_canvas_render_circle(canvas, SNL_POINT(bench_randf(4096), bench_randf(4096)), 3, dot);
+    }
+    for (size_t i = 0; i + 1000 <= track_len; i += 1000) {
+        snl_canvas_render_polyline_points(canvas, track + i, 1000, line);
+    }
+}
+
+void bench_cull(void) {
+    // random walks across the whole dataset
+    const size_t track_len = BENCH_SHAPES * 5;
+    snl_point_t *track = malloc(sizeof(snl_point_t) * track_len);
+    srand(7);
+    float x = 2048, y = 2048;
+    for (size_t i = 0; i < track_len; i++) {
+        x = fminf(fmaxf(x + bench_randf(40) - 20, 0), 4096);
+        y = fminf(fmaxf(y + bench_randf(40) - 20, 0), 4096);
+        track[i] = SNL_POINT(x, y);
+    }
+
+    snl_canvas_t plain = snl_canvas_create_ex(1024, 1024, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT });
+    double t0 = bench_now();
+    bench_draw_view(&plain, track, track_len);
+    const double plain_time = bench_now() - t0;
+
+    snl_canvas_t culled = snl_canvas_create_ex(1024, 1024, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT | SNL_CANVAS_CULL });
+    t0 = bench_now();
+    bench_draw_view(&culled, track, track_len);
+    const double culled_time = bench_now() - t0;
+
+    const size_t plain_size = vt_str_len(plain.surface);
+    const size_t culled_size = vt_str_len(culled.surface);
+    printf("- viewport culling, %d circles and %zu track points, 1/16 of them in view\n", BENCH_SHAPES, track_len);
+    printf("    %-13s : %10zu bytes, %8.3f s\n", "plain", plain_size, plain_time);
+    printf("    %-13s : %10zu bytes, %8.3f s (%.2fx smaller, %.2fx faster)\n", "culled", culled_size, culled_time, (double)plain_size / (double)culled_size, plain_time / culled_time);
+    printf("    %-13s : %10zu shapes, %zu points dropped\n", "skipped", culled.culled, culled.culled_points);
+
+    snl_canvas_destroy(&plain);
+    snl_canvas_destroy(&culled);
+    free(track);
+}
+
+// a dashboard redrawn in place: each refresh fills the background and draws opaque panels with charts on them
+static void bench_draw_dashboard(snl_canvas_t *const canvas, const size_t refreshes) {
+    const snl_appearance_t panel = SNL_APPEARANCE(0, 1, SNL_COLOR_NONE, 1, SNL_COLOR_PALEWHITE, NULL, NULL);
+    const snl_appearance_t bar = SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_TEAL, NULL, NULL);
+    const snl_appearance_t dot = SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 0.5, SNL_COLOR_CORAL, NULL, NULL);
+
+    srand(42);
+    for (size_t r = 0; r < refreshes; r++) {
+        snl_canvas_fill(canvas, SNL_COLOR_WHITE);
+        for (size_t p = 0; p < 16; p++) {
+            const snl_point_t origin = SNL_POINT((float)(p % 4) * 1024 + 16, (float)(p / 4) * 1024 + 16);
+            snl_canvas_render_rectangle(canvas, origin, SNL_POINT(992, 992), 0, panel);
+            for (size_t i = 0; i < BENCH_SHAPES / refreshes / 16; i++) {
+                const snl_point_t q = SNL_POINT(origin.x + bench_randf(960), origin.y + bench_randf(960));
+                if (i % 2) snl_canvas_render_circle(canvas, SNL_POINT(q.x + 16, q.y + 16), 4, dot);
+                else snl_canvas_render_rectangle(canvas, q, SNL_POINT(32, 32), 0, bar);
+            }
+        }
+    }
+}
+
+void bench_occlude(void) {
+    const size_t refreshes = 10;
+
+    printf("- occlusion, %d shapes over %zu refreshes of a dashboard\n", BENCH_SHAPES, refreshes);
+    for (size_t i = 0; i < 2; i++) {
+        const uint32_t flags = SNL_CANVAS_RETAINED | SNL_CANVAS_COMPACT | (i ? SNL_CANVAS_OCCLUDE : 0);
+        snl_canvas_t canvas = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .flags = flags });
+        bench_draw_dashboard(&canvas, refreshes);
+
+        const double t0 = bench_now();
+        snl_canvas_save(&canvas, "bench_occlude.svg");
+        const double time = bench_now() - t0;
+
+        FILE *const file = fopen("bench_occlude.svg", "rb");
+        fseek(file, 0, SEEK_END);
+        const long size = ftell(file);
+        fclose(file);
+        printf("    %-13s : %10ld bytes, %8.3f s to save\n", i ? "occluded" : "plain", size, time);
+
+        snl_canvas_destroy(&canvas);
+    }
+    remove("bench_occlude.svg");
+}
+
+void bench_query(void) {
+    const size_t shapes = BENCH_SHAPES * 5;
+    const size_t queries = 100000;
+
+    // small shapes scattered over a large canvas
+    snl_canvas_t canvas = snl_canvas_create_ex(16384, 16384, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+    srand(7);
+    for (size_t i = 0; i < shapes; i++) {
+        const snl_point_t p = SNL_POINT(bench_randf(16384), bench_randf(16384));
+        if (i % 2) snl_canvas_render_circle(&canvas, p, 2 + bench_randf(10), SNL_APPEARANCE_DEFAULT);
+        else snl_canvas_render_rectangle(&canvas, p, SNL_POINT(4 + bench_randf(20), 4 + bench_randf(20)), 0, SNL_APPEARANCE_DEFAULT);
+    }
+
+    printf("- hit testing, %zu shapes\n", shapes);
+    size_t indices[64];
+    double t0 = bench_now();
+    snl_canvas_query_point(&canvas, SNL_POINT(0, 0), indices, 64);
+    printf("    %-13s : %8.3f s\n", "index build", bench_now() - t0);
+
+    size_t found = 0;
+    t0 = bench_now();
+    for (size_t i = 0; i < queries; i++) {
+        found += snl_canvas_query_point(&canvas, SNL_POINT(bench_randf(16384), bench_randf(16384)), indices, 64);
+    }
+    printf("    %-13s : %8.3f us per query, %zu found\n", "point", (bench_now() - t0) * 1e6 / (double)queries, found);
+
+    found = 0;
+    t0 = bench_now();
+    for (size_t i = 0; i < queries; i++) {
+        const snl_point_t p = SNL_POINT(bench_randf(16384), bench_randf(16384));
+        found += snl_canvas_query_rect(&canvas, p, SNL_POINT(128, 128), indices, 64);
+    }
+    printf("    %-13s : %8.3f us per query, %zu found\n", "128x128 rect", (bench_now() - t0) * 1e6 / (double)queries, found);
+
+    snl_canvas_destroy(&canvas);
+}
+
+void bench_tiles(void) {
+    const size_t shapes = BENCH_SHAPES * 5;
+    const uint32_t tile = 256, levels = 6;
+
+    // small shapes scattered over a large canvas
+    snl_canvas_t canvas = snl_canvas_create_ex(16384, 16384, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED | SNL_CANVAS_COMPACT });
+    srand(11);
+    for (size_t i = 0; i < shapes; i++) {
+        const snl_point_t p = SNL_POINT(bench_randf(16384), bench_randf(16384));
+        if (i % 2) snl_canvas_render_circle(&canvas, p, 2 + bench_randf(10), SNL_APPEARANCE_DEFAULT);
+        else snl_canvas_render_rectangle(&canvas, p, SNL_POINT(4 + bench_randf(20), 4 + bench_randf(20)), 0, SNL_APPEARANCE_DEFAULT);
+    }
+
+    printf("- tiles, %zu shapes, %u levels of %ux%u tiles\n", shapes, levels, tile, tile);
+    double t0 = bench_now();
+    snl_canvas_save(&canvas, "bench_tiles.svg");
+    const double save_time = bench_now() - t0;
+    FILE *file = fopen("bench_tiles.svg", "rb");
+    fseek(file, 0, SEEK_END);
+    printf("    %-13s : %10ld bytes, %8.3f s\n", "single file", ftell(file), save_time);
+    fclose(file);
+    remove("bench_tiles.svg");
+
+    t0 = bench_now();
+    const size_t written = snl_canvas_save_tiles(&canvas, "bench_tiles", tile, tile, levels);
+    const double tiles_time = bench_now() - t0;
+
+    // largest tile of each level, then clean up
+    char path[64];
+    for (uint32_t z = 0; z < levels; z++) {
+        const size_t n = (size_t)16384 / ((size_t)tile << (levels - 1 - z));
+        long largest = 0;
+        for (size_t x = 0; x < n; x++) {
+            for (size_t y = 0; y < n; y++) {
+                snprintf(path, sizeof(path), "bench_tiles/%u/%zu/%zu.svg", z, x, y);
+                if ((file = fopen(path, "rb")) == NULL) continue;
+                fseek(file, 0, SEEK_END);
+                if (ftell(file) > largest) largest = ftell(file);
+                fclose(file);
+                remove(path);
+            }
+            snprintf(path, sizeof(path), "bench_tiles/%u/%zu", z, x);
+            remove(path);
+        }
+        snprintf(path, sizeof(path), "bench_tiles/%u", z);
+        remove(path);
+        printf("    level %-7u : %10ld bytes in the largest of %zu tiles\n", z, largest, n * n);
+    }
+    remove("bench_tiles/tiles.json");
+    remove("bench_tiles");
+    printf("    %-13s : %10zu files, %8.3f s\n", "tiles", written, tiles_time);
+
+    snl_canvas_destroy(&canvas);
+}
@@ -0,0 +1,1369 @@
+#define _XOPEN_SOURCE 700
+
+#include <ftw.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "snail/snail.h"
+
+// fails the running check if cond does not hold
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("  %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        return false; \
+    } \
+} while (0)
+
+// named check
+typedef struct CheckCase {
+    const char *name;
+    bool (*run)(void);
+} check_case_t;
+
+static void check_cleanup(void);
+
+bool check_undo(void);
+bool check_compact(void);
+bool check_classes(void);
+bool check_defs(void);
+bool check_load(void);
+bool check_journal(void);
+bool check_path_data(void);
+bool check_grid(void);
+bool check_escape(void);
+bool check_labels(void);
+bool check_cull(void);
+bool check_occlude(void);
+bool check_query(void);
+bool check_tiles(void);
+
+static const check_case_t gi_checks[] = {
+    { "undo, mark and rollback", check_undo },
+    { "compact profile", check_compact },
+    { "css classes", check_classes },
+    { "definitions", check_defs },
+    { "loader", check_load },
+    { "append journal recovery", check_journal },
+    { "compact path data", check_path_data },
+    { "grid snapping and integer output", check_grid },
+    { "text escaping", check_escape },
+    { "label placement", check_labels },
+    { "viewport culling", check_cull },
+    { "occlusion", check_occlude },
+    { "element queries", check_query },
+    { "tiles", check_tiles },
+};
+
+// scratch directory for the files written by the checks
+static char gi_dir[] = "/tmp/snail-check-XXXXXX";
+
+int main(void) {
+    printf("*** snail checks ***\n");
+    if (mkdtemp(gi_dir) == NULL) {
+        printf("- cannot create a scratch directory\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < sizeof(gi_checks) / sizeof(gi_checks[0]); i++) {
+        const bool passed = gi_checks[i].run();
+        printf("- %s: %s\n", gi_checks[i].name, passed ? "passed" : "FAILED");
+        if (!passed) failed++;
+    }
+    printf("- %s\n", failed ? "FAILED" : "passed");
+    check_cleanup();
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// ------------------------------- HELPERS ------------------------------- //
+
+static float check_randf(unsigned *const state, const float max) {
+    *state = *state * 1103515245u + 12345u;
+    return (float)((*state >> 8) & 0xffff) / 65535.0f * max;
+}
+
+static const char *check_path(const char *const name) {
+    static char path[512];
+    snprintf(path, sizeof(path), "%s/%s", gi_dir, name);
+    return path;
+}
+
+static char *check_read(const char *const filename) {
+    FILE *const fp = fopen(filename, "rb");
+    if (fp == NULL) return NULL;
+
+    fseek(fp, 0, SEEK_END);
+    const long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    char *const data = malloc((size_t)size + 1);
+    const size_t read = fread(data, 1, (size_t)size, fp);
+    data[read] = '\0';
+    fclose(fp);
+
+    return data;
+}
+
+// saves the canvas and returns the file contents
+static char *check_save(snl_canvas_t *const canvas) {
+    snl_canvas_save(canvas, check_path("save.svg"));
+    return check_read(check_path("save.svg"));
+}
+
+static bool check_same_output(snl_canvas_t *const a, snl_canvas_t *const b) {
+    char *const x = check_save(a);
+    char *const y = check_save(b);
+    const bool same = x && y && strcmp(x, y) == 0;
+    free(x);
+    free(y);
+
+    return same;
+}
+
+// draws shapes from..to-1 of a fixed sequence of shapes, each one a single element
+static void check_draw(snl_canvas_t *const canvas, const size_t from, const size_t to) {
+    for (size_t i = from; i < to; i++) {
+        unsigned seed = (unsigned)i + 1;
+        const snl_point_t p = SNL_POINT(check_randf(&seed, 256), check_randf(&seed, 256));
+        const snl_appearance_t appearance = SNL_APPEARANCE(
+            check_randf(&seed, 4), 1, SNL_COLOR((uint8_t)i, 64, 128, 255), 0.5, SNL_COLOR((uint8_t)(i * 7), 0, 0, 255), NULL, NULL
+        );
+        switch (i % 5) {
+            case 0: snl_canvas_render_circle(canvas, p, check_randf(&seed, 32), appearance); break;
+            case 1: snl_canvas_render_rectangle(canvas, p, SNL_POINT(check_randf(&seed, 64), check_randf(&seed, 64)), 2, appearance); break;
+            case 2: snl_canvas_render_line(canvas, p, SNL_POINT(check_randf(&seed, 256), check_randf(&seed, 256)), appearance); break;
+            case 3: snl_canvas_render_text(canvas, p, "snail", 12, SNL_FONT_ARIAL, SNL_COLOR_BLACK); break;
+            default: {
+                const snl_point_t points[] = { p, SNL_POINT(p.x + 10, p.y), SNL_POINT(p.x + 10, p.y + 20) };
+                snl_canvas_render_polyline_points(canvas, points, 3, appearance);
+            }
+        }
+    }
+}
+
+// draws n random shapes of a fixed sequence around and across a 256 x 256 viewBox, some of them in a rotated group
+static void check_scene(snl_canvas_t *const canvas, unsigned seed, const size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (i % 50 == 10) snl_canvas_push_group(canvas, snl_transform_multiply(SNL_TRANSFORM_TRANSLATE(128, -40), snl_transform_rotate(30)), NULL);
+        const snl_point_t p = SNL_POINT(check_randf(&seed, 512) - 128, check_randf(&seed, 512) - 128);
+        const snl_appearance_t appearance = SNL_APPEARANCE(
+            check_randf(&seed, 8), 0.8f, SNL_COLOR((uint8_t)i, 64, 128, 255), i % 3 ? 0.5f : 0, SNL_COLOR((uint8_t)(i * 7), 90, 0, 255), NULL, NULL
+        );
+        switch (i % 6) {
+            case 0: snl_canvas_render_circle(canvas, p, check_randf(&seed, 48), appearance); break;
+            case 1: snl_canvas_render_rectangle(canvas, p, SNL_POINT(check_randf(&seed, 96) - 48, check_randf(&seed, 96) - 48), 0, appearance); break;
+            case 2: snl_canvas_render_ellipse(canvas, p, SNL_POINT(check_randf(&seed, 64), check_randf(&seed, 16)), appearance); break;
+            case 3: snl_canvas_render_line(canvas, p, SNL_POINT(check_randf(&seed, 512) - 128, check_randf(&seed, 512) - 128), appearance); break;
+            default: {
+                // random walks that cross the viewBox edges
+                snl_point_t points[24];
+                for (size_t j = 0; j < 24; j++) {
+                    points[j] = j ? SNL_POINT(points[j - 1].x + check_randf(&seed, 120) - 60, points[j - 1].y + check_randf(&seed, 120) - 60) : p;
+                }
+                if (i % 6 == 4) snl_canvas_render_polyline_points(canvas, points, 24, appearance);
+                else snl_canvas_render_polygon_points(canvas, points, 24, appearance, i % 4 ? SNL_FILL_RULE_NONZERO : SNL_FILL_RULE_EVENODD);
+            }
+        }
+        if (i % 50 == 30) snl_canvas_pop_group(canvas);
+    }
+}
+
+// rasterizes two retained canvases at the size of their viewBox and compares the pixels
+static bool check_same_pixels(const snl_canvas_t *const a, const snl_canvas_t *const b) {
+    snl_raster_t x = snl_raster_create((uint32_t)a->width, (uint32_t)a->height);
+    snl_raster_t y = snl_raster_create((uint32_t)b->width, (uint32_t)b->height);
+    snl_canvas_rasterize(a, &x);
+    snl_canvas_rasterize(b, &y);
+    const bool same = x.width == y.width && x.height == y.height && memcmp(x.pixels, y.pixels, (size_t)x.width * x.height * 4) == 0;
+    snl_raster_destroy(&x);
+    snl_raster_destroy(&y);
+
+    return same;
+}
+
+// draws the shapes of a fixed sequence for which keep is NULL or true, every 12th one an opaque rectangle; each
+// shape has its own stroke color #01xxxx, its index
+static void check_occluded_scene(snl_canvas_t *const canvas, unsigned seed, const size_t n, const bool *const keep) {
+    for (size_t i = 0; i < n; i++) {
+        const snl_point_t p = SNL_POINT(check_randf(&seed, 300) - 20, check_randf(&seed, 300) - 20);
+        const struct SnailColor stroke = SNL_COLOR(0x01, (uint8_t)(i >> 8), (uint8_t)i, 255);
+        const float width = check_randf(&seed, 4), size = check_randf(&seed, 24);
+        if (keep && !keep[i]) continue;
+
+        const snl_appearance_t appearance = SNL_APPEARANCE(width, 0.7f, stroke, 0.6f, SNL_COLOR((uint8_t)(i * 7), 90, 0, 255), NULL, NULL);
+        switch (i % 12) {
+            case 0: snl_canvas_render_rectangle(
+                canvas, p, SNL_POINT(40 + size * 4, 40 + size * 3), 0, SNL_APPEARANCE(width, 1, stroke, 1, SNL_COLOR(0, 120, (uint8_t)i, 255), NULL, NULL)
+            ); break;
+            case 1: case 5: case 9: snl_canvas_render_circle(canvas, p, size, appearance); break;
+            case 2: case 6: snl_canvas_render_rectangle(canvas, p, SNL_POINT(size, size / 2), 2, appearance); break;
+            case 3: case 7: snl_canvas_render_ellipse(canvas, p, SNL_POINT(size, size / 3), appearance); break;
+            case 4: case 10: snl_canvas_render_line(canvas, p, SNL_POINT(p.x + size, p.y - size), appearance); break;
+            default: {
+                const snl_point_t points[] = { p, SNL_POINT(p.x + size, p.y), SNL_POINT(p.x + size / 2, p.y + size) };
+                snl_canvas_render_polygon_points(canvas, points, 3, appearance, SNL_FILL_RULE_DEFAULT);
+            }
+        }
+    }
+}
+
+// draws definitions, a symbol and its instances, a styled group, text and a curve, followed by check_scene()
+static void check_styled_scene(snl_canvas_t *const canvas, unsigned seed, const size_t n) {
+    snl_canvas_add_gradient_linear(canvas, "lg", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 0.5f, 33.5f);
+    snl_canvas_add_gradient_radial_tricolor(canvas, "rg", SNL_COLOR_BLUE, SNL_COLOR_RED, SNL_COLOR_GOLD, 0, 50, 100, 1, 0.5f, 0.25f);
+    snl_canvas_add_filter_blur_hard_edge(canvas, "blur", 2, 3);
+    snl_canvas_add_filter_shadow(canvas, "shadow", 4, 5, 6, true);
+    snl_canvas_symbol_begin(canvas, "dot");
+    snl_canvas_render_circle(canvas, SNL_POINT(0, 0), 5, SNL_APPEARANCE(1, 1, SNL_COLOR_RED, 1, SNL_COLOR_NONE, NULL, NULL));
+    snl_canvas_symbol_end(canvas);
+
+    snl_canvas_fill(canvas, SNL_COLOR_PALEWHITE);
+    snl_canvas_render_rectangle(canvas, SNL_POINT(10, 20), SNL_POINT(30, 40), 3, SNL_APPEARANCE(2, 1, SNL_COLOR_NONE, 1, SNL_COLOR_NONE, "blur", "lg"));
+    snl_canvas_render_ellipse(canvas, SNL_POINT(50, 60), SNL_POINT(7, 8), SNL_APPEARANCE(1, 0.5f, SNL_COLOR(1, 2, 3, 128), 0.3f, SNL_COLOR_GREEN, "shadow", NULL));
+    snl_canvas_push_group(canvas, SNL_TRANSFORM(1.5f, 0, 0.5f, 1.5f, 90, 60), &SNL_APPEARANCE(2, 1, SNL_COLOR_RED, 0.5f, SNL_COLOR_NONE, NULL, "rg"));
+    snl_canvas_render_circle(canvas, SNL_POINT(3, 4), 25, SNL_APPEARANCE(2, 1, SNL_COLOR_RED, 0.5f, SNL_COLOR_GOLD, NULL, NULL));
+    snl_canvas_render_curve(canvas, SNL_POINT(-20, -10), SNL_POINT(40, 30), SNL_APPEARANCE(2, 1, SNL_COLOR_RED, 0.5f, SNL_COLOR_NONE, NULL, "rg"));
+    snl_canvas_pop_group(canvas);
+    const snl_point_t steps[] = { SNL_POINT(123.45f, 67.89f), SNL_POINT(1, 2), SNL_POINT(1, 40), SNL_POINT(30, 40), SNL_POINT(30.5f, 41), SNL_POINT(31.5f, 41), SNL_POINT(31.5f, 43) };
+    snl_canvas_render_polyline_points(canvas, steps, 7, SNL_APPEARANCE(1, 1, SNL_COLOR(18, 52, 86, 255), 1, SNL_COLOR_NONE, NULL, NULL));
+    snl_canvas_render_instance(canvas, "dot", SNL_POINT(120, 30), 2, 45);
+    snl_canvas_render_instance(canvas, "dot", SNL_POINT(140, 30), 1, 0);
+    snl_canvas_render_text_styled(
+        canvas, SNL_POINT(5, 90), "a < b & 'c'", SNL_APPEARANCE(0, 1, SNL_COLOR_NONE, 1, SNL_COLOR_MAROON, NULL, NULL),
+        SNL_TEXT_STYLE(14, 15, SNL_FONT_TIMES_NEW_ROMAN, SNL_FONT_WEIGHT_BOLD, SNL_FONT_STYLE_ITALIC, SNL_TEXT_UNDERLINE)
+    );
+    snl_canvas_render_text(canvas, SNL_POINT(5, 110), "snail", 12, SNL_FONT_ARIAL, SNL_COLOR_BLACK);
+    check_scene(canvas, seed, n);
+}
+
+// element drawn by check_query, with what its box depends on
+typedef struct CheckElement {
+    enum { CHECK_CIRCLE, CHECK_RECT, CHECK_LINE, CHECK_POLYLINE, CHECK_TEXT, CHECK_GROUP, CHECK_GROUP_END } kind;
+    snl_point_t points[5];
+    size_t npoints;
+    float radius, stroke, font_size;
+    snl_point_t size;
+    snl_transform_t transform;
+    size_t end;                     // closing of a group
+    bool removed;
+} check_element_t;
+
+// finds the elements whose box overlaps a query box by testing every one of them, topmost first, leaving out the
+// boxes narrower and lower than min_size
+static size_t check_query_all(const check_element_t *const elements, const size_t n, const float *const q, const float min_size, size_t *const found) {
+    snl_transform_t stack[8], t = SNL_TRANSFORM_IDENTITY;
+    size_t depth = 0, count = 0;
+    for (size_t i = 0; i < n; i++) {
+        const check_element_t *const e = &elements[i];
+        if (e->kind == CHECK_GROUP) {
+            stack[depth++] = t;
+            t = snl_transform_multiply(t, e->transform);
+            continue;
+        }
+        if (e->kind == CHECK_GROUP_END) {
+            t = stack[--depth];
+            continue;
+        }
+        if (e->removed) continue;
+
+        // box in the coordinates of the element, grown by the stroke, twice for point lists, and text by its margin
+        const snl_point_t p = e->points[0];
+        float b[4] = { p.x, p.y, p.x, p.y }, margin = e->stroke;
+        switch (e->kind) {
+            case CHECK_CIRCLE: b[0] = p.x - e->radius; b[1] = p.y - e->radius; b[2] = p.x + e->radius; b[3] = p.y + e->radius; break;
+            case CHECK_RECT:
+                b[0] = fminf(p.x, p.x + e->size.x); b[1] = fminf(p.y, p.y + e->size.y);
+                b[2] = fmaxf(p.x, p.x + e->size.x); b[3] = fmaxf(p.y, p.y + e->size.y);
+                break;
+            case CHECK_TEXT: {
+                const snl_text_box_t m = snl_text_measure("query", SNL_TEXT_STYLE(e->font_size, 0, SNL_FONT_ARIAL, SNL_FONT_WEIGHT_NORMAL, SNL_FONT_STYLE_NORMAL, SNL_TEXT_NONE));
+                b[0] = p.x + m.x; b[1] = p.y + m.y; b[2] = p.x + m.x + m.width; b[3] = p.y + m.y + m.height;
+                margin += SNL_TEXT_MARGIN * e->font_size;
+            } break;
+            default:
+                for (size_t j = 1; j < e->npoints; j++) {
+                    b[0] = fminf(b[0], e->points[j].x); b[1] = fminf(b[1], e->points[j].y);
+                    b[2] = fmaxf(b[2], e->points[j].x); b[3] = fmaxf(b[3], e->points[j].y);
+                }
+                if (e->kind == CHECK_POLYLINE) margin *= 2;
+        }
+        b[0] -= margin; b[1] -= margin; b[2] += margin; b[3] += margin;
+
+        // mapped through the groups
+        if (depth) {
+            const snl_point_t c[4] = {
+                snl_transform_apply(t, SNL_POINT(b[0], b[1])), snl_transform_apply(t, SNL_POINT(b[2], b[1])),
+                snl_transform_apply(t, SNL_POINT(b[0], b[3])), snl_transform_apply(t, SNL_POINT(b[2], b[3]))
+            };
+            b[0] = fminf(fminf(c[0].x, c[1].x), fminf(c[2].x, c[3].x)); b[1] = fminf(fminf(c[0].y, c[1].y), fminf(c[2].y, c[3].y));
+            b[2] = fmaxf(fmaxf(c[0].x, c[1].x), fmaxf(c[2].x, c[3].x)); b[3] = fmaxf(fmaxf(c[0].y, c[1].y), fmaxf(c[2].y, c[3].y));
+        }
+        if (min_size > 0 && b[2] - b[0] < min_size && b[3] - b[1] < min_size) continue;
+        if (b[0] <= q[2] && q[0] <= b[2] && b[1] <= q[3] && q[1] <= b[3]) found[count++] = i;
+    }
+
+    // topmost first
+    for (size_t i = 0; i < count / 2; i++) {
+        const size_t swap = found[i];
+        found[i] = found[count - 1 - i];
+        found[count - 1 - i] = swap;
+    }
+
+    return count;
+}
+
+// draws random circles, rectangles, lines, polylines, text and nested rotated groups up to n elements, recording them
+// in elements from the first one not drawn yet; closes the open groups if asked; returns the number of elements
+static size_t check_elements(snl_canvas_t *const canvas, check_element_t *const elements, size_t n, const size_t to, const bool close, unsigned *const seed) {
+    size_t open = 0;
+    for (size_t i = 0; i < n; i++) open += elements[i].kind == CHECK_GROUP && elements[i].end == 0;
+
+    while (n < to || (close && open > 0)) {
+        check_element_t e = { .points = { SNL_POINT(check_randf(seed, 500), check_randf(seed, 500)) }, .npoints = 1 };
+        e.stroke = (float)(n % 3);
+        const snl_appearance_t appearance = SNL_APPEARANCE(e.stroke, 1, SNL_COLOR((uint8_t)n, (uint8_t)(n >> 8), 0, 255), 1, SNL_COLOR_TEAL, NULL, NULL);
+        switch (n >= to ? 6 : (size_t)check_randf(seed, 6.99f)) {
+            case 0:
+                e.kind = CHECK_CIRCLE;
+                e.radius = check_randf(seed, 20);
+                snl_canvas_render_circle(canvas, e.points[0], e.radius, appearance);
+                break;
+            case 1:
+                e.kind = CHECK_RECT;
+                e.size = SNL_POINT(check_randf(seed, 80) - 40, check_randf(seed, 80) - 40);
+                snl_canvas_render_rectangle(canvas, e.points[0], e.size, 0, appearance);
+                break;
+            case 2:
+                e.kind = CHECK_LINE;
+                e.points[e.npoints++] = SNL_POINT(check_randf(seed, 500), check_randf(seed, 500));
+                snl_canvas_render_line(canvas, e.points[0], e.points[1], appearance);
+                break;
+            case 3:
+                e.kind = CHECK_POLYLINE;
+                while (e.npoints < 5) e.points[e.npoints++] = SNL_POINT(check_randf(seed, 500), check_randf(seed, 500));
+                snl_canvas_render_polyline_points(canvas, e.points, e.npoints, appearance);
+                break;
+            case 4:
+                e.kind = CHECK_TEXT;
+                e.stroke = 0;
+                e.font_size = 8 + (float)(n % 4) * 4;
+                snl_canvas_render_text(canvas, e.points[0], "query", e.font_size, SNL_FONT_ARIAL, SNL_COLOR_BLACK);
+                break;
+            case 5:
+                if (open == 4) continue;
+                e.kind = CHECK_GROUP;
+                e.transform = snl_transform_multiply(SNL_TRANSFORM_TRANSLATE(check_randf(seed, 100), check_randf(seed, 100)), snl_transform_rotate(check_randf(seed, 90)));
+                snl_canvas_push_group(canvas, e.transform, NULL);
+                open++;
+                break;
+            default:
+                if (open == 0) continue;
+                e.kind = CHECK_GROUP_END;
+                snl_canvas_pop_group(canvas);
+                for (size_t i = n; i-- > 0;) {
+                    if (elements[i].kind == CHECK_GROUP && elements[i].end == 0) {
+                        elements[i].end = n;
+                        break;
+                    }
+                }
+                open--;
+        }
+        elements[n++] = e;
+    }
+
+    return n;
+}
+
+// compares random point and rectangle queries with the ones of check_query_all
+static bool check_queries(snl_canvas_t *const canvas, const check_element_t *const elements, const size_t n, unsigned *const seed) {
+    enum { CHECK_FOUND_MAX = 4096 };
+    static size_t got[CHECK_FOUND_MAX], want[CHECK_FOUND_MAX];
+
+    for (size_t k = 0; k < 200; k++) {
+        const snl_point_t pos = SNL_POINT(check_randf(seed, 600) - 50, check_randf(seed, 600) - 50);
+        const snl_point_t size = k % 2 ? SNL_POINT(0, 0) : SNL_POINT(check_randf(seed, 120) - 60, check_randf(seed, 120) - 60);
+        const size_t count = k % 2 ? snl_canvas_query_point(canvas, pos, got, CHECK_FOUND_MAX) : snl_canvas_query_rect(canvas, pos, size, got, CHECK_FOUND_MAX);
+        const float q[4] = { fminf(pos.x, pos.x + size.x), fminf(pos.y, pos.y + size.y), fmaxf(pos.x, pos.x + size.x), fmaxf(pos.y, pos.y + size.y) };
+        if (count != check_query_all(elements, n, q, 0, want) || memcmp(got, want, count * sizeof(size_t)) != 0) return false;
+    }
+
+    return true;
+}
+
+static size_t check_count(const char *z, const char *const what) {
+    size_t count = 0;
+    while ((z = strstr(z, what)) != NULL) {
+        count++;
+        z += strlen(what);
+    }
+    return count;
+}
+
+static size_t check_sink_write(void *user, const char *data, size_t size) {
+    vt_str_append_n((vt_str_t*)user, data, size);
+    return size;
+}
+
+static bool check_write(const char *const filename, const char *const data, const size_t len) {
+    FILE *const fp = fopen(filename, "wb");
+    if (fp == NULL) return false;
+    const bool written = fwrite(data, 1, len, fp) == len;
+    return fclose(fp) == 0 && written;
+}
+
+static bool check_exists(const char *const filename) {
+    FILE *const fp = fopen(filename, "rb");
+    if (fp) fclose(fp);
+    return fp != NULL;
+}
+
+static uint32_t check_crc32(uint32_t crc, const char *const data, const size_t size) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= (uint8_t)data[i];
+        for (int32_t k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// writes the journal of an append of tail at offset; commit: 0 leaves the commit line out, 2 writes a wrong checksum
+static bool check_write_journal(const char *const journal, const size_t offset, const char *const tail, const int32_t commit) {
+    char header[128];
+    const int header_len = snprintf(header, sizeof(header), "snail-journal %zu %zu\n", offset, strlen(tail));
+    uint32_t crc = check_crc32(check_crc32(0, header, (size_t)header_len), tail, strlen(tail));
+    if (commit == 2) crc ^= 1;
+
+    FILE *const fp = fopen(journal, "wb");
+    if (fp == NULL) return false;
+    fputs(header, fp);
+    fputs(tail, fp);
+    if (commit) fprintf(fp, "snail-commit %08x\n", (unsigned)crc);
+    return fclose(fp) == 0;
+}
+
+// reads the numbers of a points='x,y x,y' attribute; returns the number of points
+static size_t check_parse_points(const char *z, double *const xy, const size_t max) {
+    size_t n = 0;
+    while (n < max * 2) {
+        while (*z == ' ' || *z == ',') z++;
+        char *end;
+        const double value = strtod(z, &end);
+        if (end == z) break;
+        xy[n++] = value;
+        z = end;
+    }
+    return n / 2;
+}
+
+// decodes the M/L/H/V/Z commands of a d='...' attribute, absolute or relative; returns the number of points
+static size_t check_parse_path(const char *z, double *const xy, const size_t max, bool *const closed) {
+    size_t n = 0;
+    double x = 0, y = 0;
+    char command = 0;
+    *closed = false;
+    while (*z && *z != '\'') {
+        if (*z == ' ' || *z == ',') {
+            z++;
+            continue;
+        }
+        if (strchr("MLHVZmlhvz", *z)) {
+            command = *z++;
+            if (command == 'Z' || command == 'z') *closed = true;
+            continue;
+        }
+
+        // a number pair or a single number continues the last command; a moveto continues as a lineto
+        char *end;
+        const double a = strtod(z, &end);
+        if (end == z || n >= max) return 0;
+        z = end;
+        const bool relative = command >= 'a';
+        switch (command | 0x20) {
+            case 'h': x = relative ? x + a : a; break;
+            case 'v': y = relative ? y + a : a; break;
+            case 'm': case 'l': {
+                while (*z == ' ' || *z == ',') z++;
+                const double b = strtod(z, &end);
+                if (end == z) return 0;
+                z = end;
+                x = relative ? x + a : a;
+                y = relative ? y + b : b;
+                if (command == 'M') command = 'L';
+                if (command == 'm') command = 'l';
+                break;
+            }
+            default: return 0;
+        }
+        xy[n * 2] = x;
+        xy[n * 2 + 1] = y;
+        n++;
+    }
+    return n;
+}
+
+static int check_remove(const char *path, const struct stat *st, int type, struct FTW *ftw) {
+    (void)st; (void)type; (void)ftw;
+    return remove(path);
+}
+
+static void check_cleanup(void) {
+    nftw(gi_dir, check_remove, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+// ------------------------------- CHECKS ------------------------------- //
+
+bool check_undo(void) {
+    for (size_t retained = 0; retained < 2; retained++) {
+        const snl_canvas_options_t options = { .flags = retained ? SNL_CANVAS_RETAINED : 0 };
+
+        snl_canvas_t expected = snl_canvas_create_ex(256, 256, options);
+        check_draw(&expected, 0, 4);
+
+        // single undo, several undos, a whole group and a rollback all land on the savepoint
+        snl_canvas_t canvas = snl_canvas_create_ex(256, 256, options);
+        check_draw(&canvas, 0, 4);
+        const size_t mark = snl_canvas_mark(&canvas);
+        CHECK(mark == snl_canvas_element_count(&expected));
+
+        check_draw(&canvas, 4, 9);
+        snl_canvas_undo(&canvas);
+        CHECK(snl_canvas_element_count(&canvas) == mark + 4);
+        snl_canvas_undo_n(&canvas, 3);
+        CHECK(snl_canvas_element_count(&canvas) == mark + 1);
+
+        const size_t before_group = snl_canvas_element_count(&canvas);
+        snl_canvas_push_group(&canvas, SNL_TRANSFORM_TRANSLATE(5, 5), NULL);
+        check_draw(&canvas, 10, 13);
+        snl_canvas_pop_group(&canvas);
+        snl_canvas_undo(&canvas);
+        CHECK(snl_canvas_element_count(&canvas) == before_group);
+
+        snl_canvas_rollback(&canvas, mark);
+        CHECK(snl_canvas_element_count(&canvas) == mark);
+        CHECK(check_same_output(&canvas, &expected));
+
+        // drawing after an undo continues from the savepoint
+        check_draw(&canvas, 4, 6);
+        check_draw(&expected, 4, 6);
+        CHECK(check_same_output(&canvas, &expected));
+
+        // undoing more than there is clears the canvas
+        snl_canvas_undo_n(&canvas, 100);
+        snl_canvas_clear(&expected);
+        CHECK(snl_canvas_element_count(&canvas) == 0);
+        CHECK(check_same_output(&canvas, &expected));
+
+        snl_canvas_destroy(&canvas);
+        snl_canvas_destroy(&expected);
+    }
+
+    return true;
+}
+
+bool check_compact(void) {
+    snl_canvas_t canvas = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT });
+    snl_canvas_render_circle(&canvas, SNL_POINT(5, 5), 3, SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_NONE, NULL, NULL));
+    snl_canvas_render_rectangle(
+        &canvas, SNL_POINT(1.5f, 2.25f), SNL_POINT(10, 20), 0,
+        SNL_APPEARANCE(2, 0.5f, SNL_COLOR(0x12, 0x34, 0x56, 255), 1, SNL_COLOR_CORAL, NULL, NULL)
+    );
+    snl_canvas_render_line(&canvas, SNL_POINT(0, 0), SNL_POINT(10.1f, 3), SNL_APPEARANCE_DEFAULT);
+    char *const output = check_save(&canvas);
+    snl_canvas_destroy(&canvas);
+
+    // defaults, the no-op filter and trailing zeros are left out; colors are short or long hex
+    CHECK(output != NULL);
+    CHECK(strstr(output, "__default__") == NULL);
+    CHECK(strstr(output, "\n<circle cx='5' cy='5' r='3' stroke='#000' fill='none'/>\n") != NULL);
+    CHECK(strstr(output, "\n<rect x='1.5' y='2.25' width='10' height='20' stroke='#123456' stroke-width='2' stroke-opacity='0.5' fill='#ff7f50'/>\n") != NULL);
+    CHECK(strstr(output, "\n<line x1='0' y1='0' x2='10.1' y2='3' stroke='#000'/>\n") != NULL);
+    free(output);
+
+    return true;
+}
+
+bool check_classes(void) {
+    const snl_appearance_t a = SNL_APPEARANCE(1, 1, SNL_COLOR_RED, 1, SNL_COLOR_NONE, NULL, NULL);
+    const snl_appearance_t b = SNL_APPEARANCE(2, 1, SNL_COLOR_BLUE, 1, SNL_COLOR_NONE, NULL, NULL);
+    const snl_appearance_t c = SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_NONE, NULL, "lg0");
+
+    for (size_t retained = 0; retained < 2; retained++) {
+        const uint32_t flags = SNL_CANVAS_CLASSES | SNL_CANVAS_COMPACT | (retained ? SNL_CANVAS_RETAINED : 0);
+        snl_canvas_t canvas = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .flags = flags });
+
+        // an undone class is forgotten, a definition added later goes in front of the classes
+        snl_canvas_render_circle(&canvas, SNL_POINT(1, 1), 1, a);
+        snl_canvas_undo(&canvas);
+        snl_canvas_render_circle(&canvas, SNL_POINT(2, 2), 1, b);
+        snl_canvas_add_gradient_linear(&canvas, "lg0", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 0);
+        snl_canvas_render_circle(&canvas, SNL_POINT(3, 3), 1, c);
+        snl_canvas_render_circle(&canvas, SNL_POINT(4, 4), 1, b);
+
+        char *const output = check_save(&canvas);
+        char *const again = check_save(&canvas);
+        snl_canvas_destroy(&canvas);
+
+        // all classes in a single <style> element between the definitions and the shapes
+        CHECK(output != NULL && again != NULL);
+        CHECK(strcmp(output, again) == 0);
+        CHECK(check_count(output, "<style>") == 1);
+        CHECK(strstr(output, "</defs>\n<style>\n.a0{") != NULL);
+        CHECK(strstr(output, "<style>") < strstr(output, "<circle"));
+        CHECK(check_count(output, ".a0{") == 1 && check_count(output, ".a1{") == 1 && check_count(output, ".a2{") == 0);
+        CHECK(strstr(output, ".a0{stroke:#00f;stroke-width:2;fill:none;}") != NULL);
+        CHECK(strstr(output, "stroke:#f00") == NULL);
+        CHECK(check_count(output, "class='a0'") == 2 && check_count(output, "class='a1'") == 1);
+        free(output);
+        free(again);
+    }
+
+    // records are written in chunks of about high_water bytes, and saving leaves the surface as it is
+    snl_canvas_t chunked = snl_canvas_create_ex(1000, 1000, (snl_canvas_options_t) { .flags = SNL_CANVAS_CLASSES | SNL_CANVAS_RETAINED, .high_water = 256 });
+    snl_canvas_t whole = snl_canvas_create_ex(1000, 1000, (snl_canvas_options_t) { .flags = SNL_CANVAS_CLASSES | SNL_CANVAS_RETAINED });
+    check_draw(&chunked, 0, 200);
+    check_draw(&whole, 0, 200);
+    vt_str_t *const surface = vt_str_create_capacity(1024, NULL);
+    vt_str_append_n(surface, vt_str_z(chunked.surface), vt_str_len(chunked.surface));
+    CHECK(check_same_output(&chunked, &whole));
+    CHECK(vt_str_len(surface) == vt_str_len(chunked.surface) && strcmp(vt_str_z(surface), vt_str_z(chunked.surface)) == 0);
+    check_draw(&chunked, 200, 210);
+    check_draw(&whole, 200, 210);
+    CHECK(check_same_output(&chunked, &whole));
+    vt_str_destroy(surface);
+    snl_canvas_destroy(&chunked);
+    snl_canvas_destroy(&whole);
+
+    // streaming: each class is defined right before its first use
+    vt_str_t *const streamed = vt_str_create_capacity(1024, NULL);
+    snl_canvas_t canvas = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) {
+        .sink = SNL_SINK(check_sink_write, streamed), .flags = SNL_CANVAS_CLASSES | SNL_CANVAS_COMPACT
+    });
+    snl_canvas_render_circle(&canvas, SNL_POINT(1, 1), 1, a);
+    snl_canvas_render_circle(&canvas, SNL_POINT(2, 2), 1, b);
+    snl_canvas_render_circle(&canvas, SNL_POINT(3, 3), 1, a);
+    snl_canvas_finish(&canvas);
+    snl_canvas_destroy(&canvas);
+    CHECK(check_count(vt_str_z(streamed), "<style>") == 2);
+    CHECK(strstr(vt_str_z(streamed), "<style>.a1{") < strstr(vt_str_z(streamed), "class='a1'"));
+    vt_str_destroy(streamed);
+
+    return true;
+}
+
+bool check_defs(void) {
+    for (size_t retained = 0; retained < 2; retained++) {
+        snl_canvas_t canvas = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .flags = retained ? SNL_CANVAS_RETAINED : 0 });
+        check_draw(&canvas, 0, 2);
+
+        // definitions are not elements: undo, rollback and clear keep them
+        snl_canvas_add_gradient_linear(&canvas, "lg0", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 0);
+        snl_canvas_add_filter_blur(&canvas, "b0", 1, 1);
+        snl_canvas_symbol_begin(&canvas, "s0");
+        check_draw(&canvas, 0, 1);
+        snl_canvas_symbol_end(&canvas);
+        CHECK(snl_canvas_element_count(&canvas) == 2);
+        snl_canvas_undo(&canvas);
+        snl_canvas_rollback(&canvas, 0);
+        snl_canvas_clear(&canvas);
+
+        // an identical definition under another id is not written again
+        snl_canvas_add_gradient_linear(&canvas, "lg1", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 0);
+        snl_canvas_render_circle(&canvas, SNL_POINT(5, 5), 2, SNL_APPEARANCE(1, 1, SNL_COLOR_NONE, 1, SNL_COLOR_NONE, NULL, "lg1"));
+
+        char *const output = check_save(&canvas);
+        snl_canvas_destroy(&canvas);
+        CHECK(output != NULL);
+        CHECK(check_count(output, "<defs>") == 1);
+        CHECK(check_count(output, "<linearGradient id='lg0'") == 1 && strstr(output, "id='lg1'") == NULL);
+        CHECK(strstr(output, "url(#lg0)") != NULL);
+        CHECK(check_count(output, "<filter id='b0'") == 1);
+        CHECK(check_count(output, "<symbol id='s0'") == 1);
+        free(output);
+    }
+
+    // definitions added after shapes go between the header and the shapes, also on the first flush of a stream;
+    // once the header is out, they are written in place
+    for (size_t streaming = 0; streaming < 2; streaming++) {
+        FILE *const fp = streaming ? fopen(check_path("stream.svg"), "wb") : NULL;
+        CHECK(!streaming || fp != NULL);
+        snl_canvas_t canvas = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .sink = streaming ? snl_sink_file(fp) : SNL_SINK(NULL, NULL) });
+        check_draw(&canvas, 0, 3);
+        snl_canvas_add_gradient_linear(&canvas, "lg0", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 0);
+        if (streaming) {
+            snl_canvas_flush(&canvas);
+            snl_canvas_add_gradient_linear(&canvas, "lg1", SNL_COLOR_RED, SNL_COLOR_BLUE, 0, 100, 1, 1, 0);
+            snl_canvas_finish(&canvas);
+            fclose(fp);
+        } else {
+            check_draw(&canvas, 3, 4);
+            snl_canvas_undo(&canvas);
+            snl_canvas_save(&canvas, check_path("stream.svg"));
+        }
+        snl_canvas_destroy(&canvas);
+
+        char *const output = check_read(check_path("stream.svg"));
+        CHECK(output != NULL);
+        const char *const body = strchr(output, '\n') + 1;
+        CHECK(strncmp(body, "<defs>\n<filter id='__default__'", strlen("<defs>\n<filter id='__default__'")) == 0);
+        CHECK(strstr(body, "<linearGradient id='lg0'") < strstr(body, "</defs>\n"));
+        CHECK(check_count(output, "<defs>") == 1 + streaming);
+        CHECK(!streaming || strstr(output, "<defs><linearGradient id='lg1'") != NULL);
+
+        // undo removes the last shape drawn, not one moved by the definitions
+        snl_canvas_t expected = snl_canvas_create(100, 100);
+        check_draw(&expected, 0, 3);
+        snl_canvas_add_gradient_linear(&expected, "lg0", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 0);
+        char *const reference = check_save(&expected);
+        snl_canvas_destroy(&expected);
+        CHECK(reference != NULL);
+        CHECK(strncmp(output, reference, strlen(reference) - strlen("</svg>")) == 0);
+        free(reference);
+        free(output);
+    }
+
+    return true;
+}
+
+bool check_load(void) {
+    char base_path[512];
+    snprintf(base_path, sizeof(base_path), "%s", check_path("load.svg"));
+
+    // a file written by snail
+    snl_canvas_t original = snl_canvas_create(256, 128);
+    snl_canvas_add_gradient_linear(&original, "lg0", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 0);
+    check_draw(&original, 0, 5);
+    snl_canvas_save(&original, base_path);
+    snl_canvas_destroy(&original);
+    char *const base = check_read(base_path);
+    CHECK(base != NULL);
+    const size_t body_len = strlen(base) - strlen("</svg>");
+
+    // new elements only; an identical gradient refers to the loaded one
+    snl_canvas_t canvas = snl_canvas_load(base_path);
+    CHECK(canvas.width == 256 && canvas.height == 128);
+    CHECK(canvas.flags == 0 && snl_canvas_element_count(&canvas) == 0);
+    snl_canvas_add_gradient_linear(&canvas, "lg1", SNL_COLOR_BLUE, SNL_COLOR_RED, 0, 100, 1, 1, 0);
+    snl_canvas_render_circle(&canvas, SNL_POINT(1, 1), 1, SNL_APPEARANCE_DEFAULT);
+    snl_canvas_undo(&canvas);
+    CHECK(snl_canvas_element_count(&canvas) == 0);
+    snl_canvas_render_rectangle(&canvas, SNL_POINT(1, 2), SNL_POINT(3, 4), 0, SNL_APPEARANCE(1, 1, SNL_COLOR_NONE, 1, SNL_COLOR_NONE, NULL, "lg1"));
+    CHECK(snl_canvas_element_count(&canvas) == 1);
+
+    // the loaded content comes out unchanged, followed by the new element; saving over the mapped file works
+    snl_canvas_save(&canvas, base_path);
+    snl_canvas_destroy(&canvas);
+    char *const output = check_read(base_path);
+    CHECK(output != NULL);
+    CHECK(strncmp(output, base, body_len) == 0);
+    CHECK(strncmp(output + body_len, "<rect ", strlen("<rect ")) == 0);
+    CHECK(strstr(output + body_len, "fill='url(#lg0)'") != NULL);
+    CHECK(strstr(output, "lg1") == NULL && strstr(output, "<circle cx='1.00'") == NULL);
+    CHECK(check_count(output, "</svg>") == 1);
+    free(base);
+    free(output);
+
+    // a rebuilt file gives the same records in every profile, which can be queried, moved and undone
+    const uint32_t profiles[] = { 0, SNL_CANVAS_COMPACT, SNL_CANVAS_CLASSES, SNL_CANVAS_COMPACT | SNL_CANVAS_CLASSES };
+    for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+        const snl_canvas_options_t options = { .flags = SNL_CANVAS_RETAINED | profiles[i] };
+        snl_canvas_t drawn = snl_canvas_create_ex(256, 256, options);
+        check_styled_scene(&drawn, 7, 100);
+        snl_canvas_save(&drawn, base_path);
+        snl_canvas_t rebuilt = snl_canvas_load_ex(base_path, options);
+        CHECK(snl_canvas_element_count(&rebuilt) == snl_canvas_element_count(&drawn));
+        CHECK(check_same_output(&drawn, &rebuilt));
+
+        size_t a[256], b[256];
+        const size_t found = snl_canvas_query_rect(&drawn, SNL_POINT(0, 0), SNL_POINT(128, 128), a, 256);
+        CHECK(found > 0 && found <= 256 && snl_canvas_query_rect(&rebuilt, SNL_POINT(0, 0), SNL_POINT(128, 128), b, 256) == found);
+        CHECK(memcmp(a, b, found * sizeof(size_t)) == 0);
+        snl_canvas_move_elements(&drawn, 1, 4, 8, -8);
+        snl_canvas_move_elements(&rebuilt, 1, 4, 8, -8);
+        snl_canvas_undo_n(&drawn, 10);
+        snl_canvas_undo_n(&rebuilt, 10);
+        CHECK(check_same_output(&drawn, &rebuilt));
+        snl_canvas_destroy(&drawn);
+        snl_canvas_destroy(&rebuilt);
+    }
+
+    // numbers written without rounding give the same pixels
+    snl_canvas_t exact = snl_canvas_create_ex(256, 256, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+    check_styled_scene(&exact, 7, 0);
+    snl_canvas_save(&exact, base_path);
+    snl_canvas_t rasterized = snl_canvas_load_ex(base_path, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+    CHECK(check_same_pixels(&exact, &rasterized));
+    snl_canvas_destroy(&exact);
+    snl_canvas_destroy(&rasterized);
+
+    // streaming output is read back the same way
+    snl_canvas_t streamed = snl_canvas_create_ex(256, 256, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT | SNL_CANVAS_CLASSES });
+    check_styled_scene(&streamed, 9, 60);
+    snl_canvas_save(&streamed, base_path);
+    snl_canvas_t reloaded = snl_canvas_load_ex(base_path, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT | SNL_CANVAS_CLASSES });
+    CHECK(snl_canvas_element_count(&reloaded) == snl_canvas_element_count(&streamed));
+    CHECK(check_same_output(&streamed, &reloaded));
+    snl_canvas_destroy(&streamed);
+    snl_canvas_destroy(&reloaded);
+
+    return true;
+}
+
+bool check_journal(void) {
+    char path[512], journal[520];
+    snprintf(path, sizeof(path), "%s", check_path("append.svg"));
+    snprintf(journal, sizeof(journal), "%s.journal", path);
+
+    snl_canvas_t original = snl_canvas_create(64, 64);
+    check_draw(&original, 0, 3);
+    snl_canvas_save(&original, path);
+    snl_canvas_destroy(&original);
+    char *const base = check_read(path);
+    CHECK(base != NULL);
+    const size_t body_len = strlen(base) - strlen("</svg>");
+
+    // a sync replaces the closing tag and leaves no journal behind
+    snl_canvas_t canvas = snl_canvas_append(path);
+    snl_canvas_render_circle(&canvas, SNL_POINT(1, 2), 3, SNL_APPEARANCE_DEFAULT);
+    snl_canvas_sync(&canvas);
+    snl_canvas_destroy(&canvas);
+    char *const synced = check_read(path);
+    CHECK(synced != NULL && strncmp(synced, base, body_len) == 0);
+    CHECK(strstr(synced + body_len, "<circle cx='1.00' cy='2.00' r='3.00'") != NULL);
+    CHECK(strcmp(synced + strlen(synced) - strlen("</svg>"), "</svg>") == 0);
+    CHECK(!check_exists(journal));
+    free(synced);
+
+    const char *const tail = "<g></g>\n</svg>";
+    const size_t tail_len = strlen(tail);
+    char *const expected = malloc(body_len + tail_len + 1);
+    memcpy(expected, base, body_len);
+    memcpy(expected + body_len, tail, tail_len + 1);
+
+    for (size_t mapped = 0; mapped < 2; mapped++) {
+        // crash while the file was written: a committed journal is replayed by either way of opening the file
+        CHECK(check_write(path, base, body_len + 2));
+        CHECK(check_write_journal(journal, body_len, tail, 1));
+        snl_canvas_t reopened = mapped ? snl_canvas_load(path) : snl_canvas_append(path);
+        snl_canvas_destroy(&reopened);
+        char *const replayed = check_read(path);
+        CHECK(replayed != NULL && strcmp(replayed, expected) == 0);
+        CHECK(!check_exists(journal));
+        free(replayed);
+
+        // crash while the journal was written: without its commit line or with a wrong checksum it is dropped
+        for (int32_t commit = 0; commit <= 2; commit += 2) {
+            CHECK(check_write(path, base, strlen(base)));
+            CHECK(check_write_journal(journal, body_len, tail, commit));
+            snl_canvas_t untouched = mapped ? snl_canvas_load(path) : snl_canvas_append(path);
+            snl_canvas_destroy(&untouched);
+            char *const kept = check_read(path);
+            CHECK(kept != NULL && strcmp(kept, base) == 0);
+            CHECK(!check_exists(journal));
+            free(kept);
+        }
+    }
+    free(expected);
+    free(base);
+
+    return true;
+}
+
+bool check_path_data(void) {
+    enum { CHECK_LISTS = 200, CHECK_POINTS_MAX = 64 };
+    unsigned seed = 17;
+
+    for (size_t trim = 0; trim < 2; trim++) {
+        snl_canvas_t full = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .flags = trim ? SNL_CANVAS_TRIM : 0 });
+        snl_canvas_t compact = snl_canvas_create_ex(4096, 4096, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT });
+        for (size_t i = 0; i < CHECK_LISTS; i++) {
+            // random walks with axis-aligned runs, repeated points, negative and large coordinates
+            snl_point_t points[CHECK_POINTS_MAX];
+            const size_t n = 1 + (size_t)check_randf(&seed, CHECK_POINTS_MAX - 1);
+            snl_point_t p = SNL_POINT(check_randf(&seed, 8192) - 2048, check_randf(&seed, 8192) - 2048);
+            for (size_t j = 0; j < n; j++) {
+                const float step = check_randf(&seed, 1) < 0.1f ? 30000 : 40;
+                switch ((size_t)check_randf(&seed, 4)) {
+                    case 0: p.x += check_randf(&seed, step) - step / 2; break;
+                    case 1: p.y += check_randf(&seed, step) - step / 2; break;
+                    case 2: break;
+                    default: p = SNL_POINT(p.x + check_randf(&seed, 2) - 1, p.y + check_randf(&seed, 0.02f) - 0.01f);
+                }
+                points[j] = p;
+            }
+            if (i % 2) {
+                snl_canvas_render_polygon_points(&full, points, n, SNL_APPEARANCE_DEFAULT, NULL);
+                snl_canvas_render_polygon_points(&compact, points, n, SNL_APPEARANCE_DEFAULT, NULL);
+            } else {
+                snl_canvas_render_polyline_points(&full, points, n, SNL_APPEARANCE_DEFAULT);
+                snl_canvas_render_polyline_points(&compact, points, n, SNL_APPEARANCE_DEFAULT);
+            }
+        }
+        char *const expected = check_save(&full);
+        char *const output = check_save(&compact);
+        snl_canvas_destroy(&full);
+        snl_canvas_destroy(&compact);
+        CHECK(expected != NULL && output != NULL);
+
+        // the path data decodes to the same rounded points as the points attribute
+        const char *e = expected, *o = output;
+        for (size_t i = 0; i < CHECK_LISTS; i++) {
+            e = strstr(e, "points='");
+            o = strstr(o, "<path d='");
+            CHECK(e != NULL && o != NULL);
+            e += strlen("points='");
+            o += strlen("<path d='");
+
+            double want[CHECK_POINTS_MAX * 2], got[CHECK_POINTS_MAX * 2];
+            bool closed = false;
+            const size_t n = check_parse_points(e, want, CHECK_POINTS_MAX);
+            CHECK(check_parse_path(o, got, CHECK_POINTS_MAX, &closed) == n);
+            CHECK(closed == (i % 2 == 1));
+            for (size_t j = 0; j < n * 2; j++) CHECK(fabs(got[j] - want[j]) < 1e-6);
+        }
+        free(expected);
+        free(output);
+    }
+
+    return true;
+}
+
+bool check_grid(void) {
+    const snl_appearance_t a = SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_NONE, NULL, NULL);
+    const float xs[] = { 12.345f, -0.3f }, ys[] = { -0.3f, 7.6f }, rs[] = { 2.6f, 0.4f };
+
+    // coordinates snap to the grid, radii and sizes smaller than the grid do not become 0
+    snl_canvas_t canvas = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .flags = SNL_CANVAS_COMPACT, .grid = 5 });
+    snl_canvas_render_circle(&canvas, SNL_POINT(12.345f, 13), 2.5f, a);
+    snl_canvas_render_rectangle(&canvas, SNL_POINT(1, 4), SNL_POINT(3.25f, 0.5f), 0, a);
+    char *output = check_save(&canvas);
+    snl_canvas_destroy(&canvas);
+    CHECK(output != NULL);
+    CHECK(strstr(output, "\n<circle cx='10' cy='15' r='2.5' stroke='#000' fill='none'/>\n") != NULL);
+    CHECK(strstr(output, "\n<rect x='0' y='5' width='3.25' height='0.5' stroke='#000' fill='none'/>\n") != NULL);
+    free(output);
+
+    // whole numbers rounded to zero are written without a sign, one by one or in a batch
+    snl_canvas_t single = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .precision = SNL_PRECISION_INTEGER });
+    snl_canvas_t batch = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .precision = SNL_PRECISION_INTEGER });
+    for (size_t i = 0; i < 2; i++) snl_canvas_render_circle(&single, SNL_POINT(xs[i], ys[i]), rs[i], a);
+    snl_canvas_render_circles(&batch, xs, ys, rs, 2, a);
+    CHECK(check_same_output(&single, &batch));
+    output = check_save(&single);
+    snl_canvas_destroy(&single);
+    snl_canvas_destroy(&batch);
+    CHECK(output != NULL);
+    CHECK(strstr(output, "'-0'") == NULL);
+    CHECK(strstr(output, "<circle cx='12' cy='0' r='3' ") != NULL);
+    CHECK(strstr(output, "<circle cx='0' cy='8' r='0' ") != NULL);
+    free(output);
+
+    return true;
+}
+
+bool check_escape(void) {
+    const snl_text_style_t style = SNL_TEXT_STYLE(10, 0, "A'<b>", "bold'/><x a='", "<i>&", "x\"/><y/>");
+    const uint32_t flags[] = { 0, SNL_CANVAS_COMPACT, SNL_CANVAS_CLASSES };
+
+    // every style string is escaped, in attributes and in class declarations
+    for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+        snl_canvas_t canvas = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .flags = flags[i] });
+        snl_canvas_render_text_styled(&canvas, SNL_POINT(1, 2), "<a & 'b'>\xff", SNL_APPEARANCE_DEFAULT, style);
+        char *const output = check_save(&canvas);
+        snl_canvas_destroy(&canvas);
+        CHECK(output != NULL);
+        CHECK(strstr(output, "&lt;a &amp; &apos;b&apos;&gt;\xef\xbf\xbd</text>") != NULL);
+        CHECK(strstr(output, "A&apos;&lt;b&gt;") != NULL);
+        CHECK(strstr(output, "bold&apos;/&gt;&lt;x a=&apos;") != NULL);
+        CHECK(strstr(output, "&lt;i&gt;&amp;") != NULL);
+        CHECK(strstr(output, "x&quot;/&gt;&lt;y/&gt;") != NULL);
+        CHECK(strstr(output, "<x") == NULL && strstr(output, "<y") == NULL && strstr(output, "<b") == NULL && strstr(output, "<i") == NULL);
+        free(output);
+    }
+
+    // values that would end a css declaration or rule keep inline attributes instead of a class
+    const snl_text_style_t injected = SNL_TEXT_STYLE(10, 0, "x;}circle{fill:red;display:none}.q{", "bold", "normal", "");
+    const snl_appearance_t filtered = SNL_APPEARANCE(1, 1, SNL_COLOR_BLUE, 1, SNL_COLOR_RED, "f)x;}a{b", NULL);
+    snl_canvas_t canvases[2] = {
+        snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .flags = 0 }),
+        snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .flags = SNL_CANVAS_CLASSES }),
+    };
+    for (size_t i = 0; i < 2; i++) {
+        snl_canvas_add_filter_blur(&canvases[i], "f)x;}a{b", 1, 1);
+        snl_canvas_render_text_styled(&canvases[i], SNL_POINT(1, 2), "a", SNL_APPEARANCE_DEFAULT, injected);
+        snl_canvas_render_circle(&canvases[i], SNL_POINT(5, 5), 2, filtered);
+    }
+    char *const output = check_save(&canvases[1]);
+    CHECK(output != NULL);
+    CHECK(strstr(output, "<style") == NULL && strstr(output, "class=") == NULL);
+    CHECK(strstr(output, "font-family='x;}circle{fill:red;display:none}.q{'") != NULL);
+    CHECK(strstr(output, "filter='url(#f)x;}a{b)'") != NULL);
+    free(output);
+    CHECK(check_same_output(&canvases[0], &canvases[1]));
+    snl_canvas_destroy(&canvases[0]);
+    snl_canvas_destroy(&canvases[1]);
+
+    return true;
+}
+
+bool check_labels(void) {
+    enum { CHECK_LABELS = 600 };
+    static const char *const texts[] = { "a", "Label", "a longer label", "WWW", "gjpqy" };
+    static const float priorities[] = { 0, -0.0f, 1, 2.5f, -3, NAN };
+    // x and y directions of the SNL_LABEL_* positions, in the order they are tried
+    static const int8_t anchors[9][2] = { { 1, -1 }, { 1, 1 }, { -1, -1 }, { -1, 1 }, { 1, 0 }, { -1, 0 }, { 0, -1 }, { 0, 1 }, { 0, 0 } };
+    const snl_label_options_t options[] = {
+        SNL_LABEL_OPTIONS_DEFAULT,
+        { .anchors = SNL_LABEL_AROUND, .offset = 2, .padding = 3 },
+        { .anchors = SNL_LABEL_CENTER | SNL_LABEL_TOP | SNL_LABEL_LEFT, .offset = -1, .padding = 0.5f },
+    };
+    unsigned seed = 21;
+
+    for (size_t o = 0; o < sizeof(options) / sizeof(options[0]); o++) {
+        snl_point_t pos[CHECK_LABELS];
+        float priority[CHECK_LABELS];
+        snl_text_style_t style[CHECK_LABELS];
+        const char *text[CHECK_LABELS];
+        snl_labels_t labels = snl_labels_create(options[o]);
+        for (size_t i = 0; i < CHECK_LABELS; i++) {
+            pos[i] = SNL_POINT(check_randf(&seed, 1000), check_randf(&seed, 1000));
+            if (i % 97 == 5) pos[i].y = NAN;
+            priority[i] = priorities[(size_t)check_randf(&seed, 5.99f)];
+            text[i] = texts[i % 5];
+            style[i] = SNL_TEXT_STYLE(8 + (float)(i % 3) * 4, 0, SNL_FONT_ARIAL, SNL_FONT_WEIGHT_NORMAL, SNL_FONT_STYLE_NORMAL, SNL_TEXT_NONE);
+            snl_labels_add(&labels, pos[i], text[i], priority[i], SNL_APPEARANCE_DEFAULT, style[i]);
+        }
+        snl_canvas_t canvas = snl_canvas_create(1000, 1000);
+        const size_t placed = snl_labels_place(&labels, &canvas);
+        snl_labels_destroy(&labels);
+
+        // brute force: a stable selection by priority, each box tested against every box placed before it
+        const uint32_t mask = options[o].anchors ? options[o].anchors : SNL_LABEL_AROUND;
+        const float offset = options[o].offset, padding = options[o].padding;
+        bool done[CHECK_LABELS] = { false };
+        float boxes[CHECK_LABELS][4];
+        size_t nboxes = 0;
+        snl_canvas_t expected = snl_canvas_create(1000, 1000);
+        for (size_t k = 0; k < CHECK_LABELS; k++) {
+            size_t best = CHECK_LABELS;
+            for (size_t i = 0; i < CHECK_LABELS; i++) {
+                if (done[i] || !isfinite(pos[i].x) || !isfinite(pos[i].y) || !isfinite(priority[i])) continue;
+                if (best == CHECK_LABELS || priority[i] > priority[best]) best = i;
+            }
+            if (best == CHECK_LABELS) break;
+            done[best] = true;
+
+            const snl_text_box_t measured = snl_text_measure(text[best], style[best]);
+            const float width = measured.width, ascent = -measured.y, descent = measured.height + measured.y;
+            const float height = ascent + descent;
+            for (size_t a = 0; a < 9; a++) {
+                if (!(mask & (1u << a))) continue;
+                const int8_t dx = anchors[a][0], dy = anchors[a][1];
+                float box[4];
+                box[0] = dx > 0 ? pos[best].x + offset : dx < 0 ? pos[best].x - offset - width : pos[best].x - width / 2;
+                box[1] = dy > 0 ? pos[best].y + offset : dy < 0 ? pos[best].y - offset - height : pos[best].y - height / 2;
+                box[2] = box[0] + width;
+                box[3] = box[1] + height;
+
+                bool hit = false;
+                for (size_t j = 0; j < nboxes && !hit; j++) {
+                    hit = box[0] - padding < boxes[j][2] && boxes[j][0] < box[2] + padding &&
+                          box[1] - padding < boxes[j][3] && boxes[j][1] < box[3] + padding;
+                }
+                if (hit) continue;
+
+                memcpy(boxes[nboxes++], box, sizeof(box));
+                snl_canvas_render_text_styled(&expected, SNL_POINT(box[0], box[1] + ascent), text[best], SNL_APPEARANCE_DEFAULT, style[best]);
+                break;
+            }
+        }
+
+        // same labels at the same positions in the same order
+        CHECK(placed == nboxes && nboxes > CHECK_LABELS / 10 && nboxes < CHECK_LABELS);
+        CHECK(check_same_output(&canvas, &expected));
+        snl_canvas_destroy(&canvas);
+        snl_canvas_destroy(&expected);
+    }
+
+    return true;
+}
+
+bool check_cull(void) {
+    // culled shapes and collapsed point runs change no pixel
+    for (unsigned seed = 1; seed <= 4; seed++) {
+        snl_canvas_t full = snl_canvas_create_ex(256, 256, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+        snl_canvas_t culled = snl_canvas_create_ex(256, 256, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED | SNL_CANVAS_CULL });
+        check_scene(&full, seed, 600);
+        check_scene(&culled, seed, 600);
+        CHECK(culled.culled > 0 && culled.culled_points > 0);
+        CHECK(snl_canvas_element_count(&culled) + culled.culled == snl_canvas_element_count(&full));
+        CHECK(check_same_pixels(&full, &culled));
+        snl_canvas_destroy(&full);
+        snl_canvas_destroy(&culled);
+    }
+
+    // text is not rasterized: its measured box is kept while it comes within half a font size of the viewBox, and
+    // dropped past that margin scaled by the frobenius norm of the transform, sqrt(2) without one
+    const snl_text_style_t style = SNL_TEXT_STYLE(20, 0, SNL_FONT_ARIAL, SNL_FONT_WEIGHT_NORMAL, SNL_FONT_STYLE_NORMAL, SNL_TEXT_NONE);
+    const snl_appearance_t appearance = SNL_APPEARANCE(0, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_BLACK, NULL, NULL);
+    const snl_text_box_t box = snl_text_measure("Label", style);
+    const float near = SNL_TEXT_MARGIN * 20 * 0.8f, far = SNL_TEXT_MARGIN * 20 * 1.5f;
+    const snl_point_t kept[] = {
+        SNL_POINT(-box.width - near, 50), SNL_POINT(100 + near, 50), SNL_POINT(50, box.y - near), SNL_POINT(50, 100 + box.height + box.y + near)
+    };
+    const snl_point_t dropped[] = {
+        SNL_POINT(-box.width - far, 50), SNL_POINT(100 + far, 50), SNL_POINT(50, box.y - far), SNL_POINT(50, 100 + box.height + box.y + far)
+    };
+    snl_canvas_t canvas = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .flags = SNL_CANVAS_CULL });
+    for (size_t i = 0; i < 4; i++) snl_canvas_render_text_styled(&canvas, kept[i], "Label", appearance, style);
+    for (size_t i = 0; i < 4; i++) snl_canvas_render_text_styled(&canvas, dropped[i], "Label", appearance, style);
+    CHECK(canvas.culled == 4 && snl_canvas_element_count(&canvas) == 4);
+    snl_canvas_destroy(&canvas);
+
+    return true;
+}
+
+bool check_occlude(void) {
+    enum { CHECK_SHAPES = 1200 };
+
+    for (unsigned seed = 1; seed <= 4; seed++) {
+        const snl_canvas_options_t occluding = { .flags = SNL_CANVAS_RETAINED | SNL_CANVAS_COMPACT | SNL_CANVAS_OCCLUDE };
+        const snl_canvas_options_t plain = { .flags = SNL_CANVAS_RETAINED | SNL_CANVAS_COMPACT };
+        snl_canvas_t canvas = snl_canvas_create_ex(256, 256, occluding);
+        check_occluded_scene(&canvas, seed, CHECK_SHAPES, NULL);
+        char *const output = check_save(&canvas);
+        snl_canvas_destroy(&canvas);
+        CHECK(output != NULL);
+
+        // the shapes left in the output, found by their stroke color
+        bool keep[CHECK_SHAPES];
+        size_t hidden = 0;
+        for (size_t i = 0; i < CHECK_SHAPES; i++) {
+            char color[16];
+            snprintf(color, sizeof(color), "'#01%02x%02x'", (unsigned)(i >> 8) & 0xFF, (unsigned)i & 0xFF);
+            keep[i] = strstr(output, color) != NULL;
+            hidden += !keep[i];
+        }
+
+        // the output is the one of a canvas without the hidden shapes, and the hidden shapes change no pixel
+        snl_canvas_t full = snl_canvas_create_ex(256, 256, plain);
+        snl_canvas_t kept = snl_canvas_create_ex(256, 256, plain);
+        check_occluded_scene(&full, seed, CHECK_SHAPES, NULL);
+        check_occluded_scene(&kept, seed, CHECK_SHAPES, keep);
+        char *const expected = check_save(&kept);
+        CHECK(hidden > CHECK_SHAPES / 10 && hidden < CHECK_SHAPES);
+        CHECK(expected != NULL && strcmp(output, expected) == 0);
+        CHECK(check_same_pixels(&full, &kept));
+        free(output);
+        free(expected);
+        snl_canvas_destroy(&full);
+        snl_canvas_destroy(&kept);
+    }
+
+    return true;
+}
+
+bool check_query(void) {
+    enum { CHECK_ELEMENTS = 1500 };
+    static check_element_t elements[CHECK_ELEMENTS + 4];
+
+    for (unsigned seed = 1; seed <= 3; seed++) {
+        snl_canvas_t canvas = snl_canvas_create_ex(500, 500, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+        size_t n = check_elements(&canvas, elements, 0, CHECK_ELEMENTS / 2, false, &seed);
+        CHECK(check_queries(&canvas, elements, n, &seed));
+        n = check_elements(&canvas, elements, n, CHECK_ELEMENTS, true, &seed);
+        CHECK(snl_canvas_element_count(&canvas) == n);
+        CHECK(check_queries(&canvas, elements, n, &seed));
+
+        // undo the trailing shapes
+        size_t undo = 0;
+        while (undo < 5 && elements[n - 1].kind != CHECK_GROUP_END) {
+            undo++;
+            n--;
+        }
+        snl_canvas_undo_n(&canvas, undo);
+        CHECK(check_queries(&canvas, elements, n, &seed));
+
+        // swap and remove shapes outside groups, remove a whole group
+        size_t outside[CHECK_ELEMENTS], noutside = 0;
+        for (size_t i = 0, depth = 0; i < n; i++) {
+            depth += elements[i].kind == CHECK_GROUP;
+            depth -= elements[i].kind == CHECK_GROUP_END;
+            if (depth == 0 && elements[i].kind < CHECK_GROUP) outside[noutside++] = i;
+        }
+        for (size_t k = 0; k < 20; k++) {
+            const size_t a = outside[(size_t)check_randf(&seed, (float)noutside - 0.01f)];
+            const size_t b = outside[(size_t)check_randf(&seed, (float)noutside - 0.01f)];
+            const check_element_t swap = elements[a];
+            elements[a] = elements[b];
+            elements[b] = swap;
+            snl_canvas_swap_elements(&canvas, a, b);
+        }
+        CHECK(check_queries(&canvas, elements, n, &seed));
+        for (size_t k = 0; k < 20; k++) {
+            const size_t a = outside[(size_t)check_randf(&seed, (float)noutside - 0.01f)];
+            if (elements[a].removed) continue;
+            elements[a].removed = true;
+            snl_canvas_remove_element(&canvas, a);
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (elements[i].kind != CHECK_GROUP) continue;
+            for (size_t j = i; j <= elements[i].end; j++) elements[j].removed = true;
+            snl_canvas_remove_element(&canvas, i);
+            break;
+        }
+        CHECK(check_queries(&canvas, elements, n, &seed));
+
+        // move the first half along the canvas axes: closed groups by their translation, the rest point by point,
+        // through the inverse of the groups cut by the range
+        const size_t to = n / 2;
+        snl_transform_t stack[8], t = SNL_TRANSFORM_IDENTITY;
+        size_t depth = 0;
+        snl_point_t offset = SNL_POINT(30, -20);
+        for (size_t i = 0; i < to; i++) {
+            check_element_t *const e = &elements[i];
+            if (e->kind == CHECK_GROUP && e->end < to) {
+                e->transform.e += offset.x;
+                e->transform.f += offset.y;
+                i = e->end;
+                continue;
+            }
+            if (e->kind == CHECK_GROUP || e->kind == CHECK_GROUP_END) {
+                if (e->kind == CHECK_GROUP) stack[depth++] = t;
+                t = e->kind == CHECK_GROUP ? snl_transform_multiply(t, e->transform) : stack[--depth];
+                const float det = t.a * t.d - t.b * t.c;
+                offset = depth ? SNL_POINT((t.d * 30 - t.c * -20) / det, (t.a * -20 - t.b * 30) / det) : SNL_POINT(30, -20);
+                continue;
+            }
+            for (size_t j = 0; j < e->npoints; j++) e->points[j] = SNL_POINT(e->points[j].x + offset.x, e->points[j].y + offset.y);
+        }
+        snl_canvas_move_elements(&canvas, 0, to, 30, -20);
+        CHECK(check_queries(&canvas, elements, n, &seed));
+
+        snl_canvas_destroy(&canvas);
+    }
+
+    // a range inside a rotated and scaled group still moves along the canvas axes
+    snl_canvas_t canvas = snl_canvas_create_ex(100, 100, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+    snl_canvas_push_group(&canvas, snl_transform_multiply(SNL_TRANSFORM_TRANSLATE(50, 50), snl_transform_multiply(snl_transform_rotate(90), SNL_TRANSFORM_SCALE(2, 2))), NULL);
+    snl_canvas_render_circle(&canvas, SNL_POINT(0, 0), 1, SNL_APPEARANCE_DEFAULT);
+    snl_canvas_pop_group(&canvas);
+    snl_canvas_move_elements(&canvas, 1, 2, 20, 0);
+    size_t hit = 0;
+    CHECK(snl_canvas_query_point(&canvas, SNL_POINT(70, 50), &hit, 1) == 1 && hit == 1);
+    CHECK(snl_canvas_query_point(&canvas, SNL_POINT(50, 50), &hit, 1) == 0);
+    snl_canvas_destroy(&canvas);
+
+    return true;
+}
+
+bool check_tiles(void) {
+    enum { CHECK_ELEMENTS = 800, CHECK_LEVELS = 3, CHECK_TILE_W = 128, CHECK_TILE_H = 96 };
+    static check_element_t elements[CHECK_ELEMENTS + 4];
+    static size_t found[CHECK_ELEMENTS + 4];
+    static const char *const tags[] = { "<circle ", "<rect ", "<line ", "<polyline ", "<text " };
+    unsigned seed = 25;
+
+    snl_canvas_t canvas = snl_canvas_create_ex(450, 380, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+    const size_t n = check_elements(&canvas, elements, 0, CHECK_ELEMENTS, true, &seed);
+    char *const full = check_save(&canvas);
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s/tiles", gi_dir);
+    const size_t written = snl_canvas_save_tiles(&canvas, dir, CHECK_TILE_W, CHECK_TILE_H, CHECK_LEVELS);
+    snl_canvas_destroy(&canvas);
+    CHECK(full != NULL);
+
+    size_t tiles = 0;
+    for (size_t z = 0; z < CHECK_LEVELS; z++) {
+        const float scale = ldexpf(1.0f, (int)(CHECK_LEVELS - 1 - z));
+        const size_t columns = (size_t)ceilf(450 / (CHECK_TILE_W * scale)), rows = (size_t)ceilf(380 / (CHECK_TILE_H * scale));
+        for (size_t row = 0; row < rows; row++) {
+            for (size_t column = 0; column < columns; column++) {
+                // the elements over the tile, without the small ones above the last level, by testing every element
+                const float x0 = (float)column * CHECK_TILE_W * scale, y0 = (float)row * CHECK_TILE_H * scale;
+                const float box[4] = { x0, y0, fminf(x0 + CHECK_TILE_W * scale, 450), fminf(y0 + CHECK_TILE_H * scale, 380) };
+                const size_t count = check_query_all(elements, n, box, z + 1 < CHECK_LEVELS ? SNL_TILES_DETAIL * scale : 0, found);
+
+                char path[600];
+                snprintf(path, sizeof(path), "%s/%zu/%zu/%zu.svg", dir, z, column, row);
+                if (count == 0) {
+                    CHECK(!check_exists(path));
+                    continue;
+                }
+                char *const tile = check_read(path);
+                CHECK(tile != NULL);
+                tiles++;
+
+                // after its header, the tile is the full output with elements left out, in the same order
+                const char *t = strchr(tile, '\n'), *f = strchr(full, '\n');
+                size_t shapes = 0;
+                while (t != NULL && *++t != '\0') {
+                    const char *const end = strchr(t, '\n');
+                    const size_t len = end ? (size_t)(end - t) : strlen(t);
+                    while (f != NULL && *f != '\0' && !(strncmp(f + 1, t, len) == 0 && (f[len + 1] == '\n' || f[len + 1] == '\0'))) {
+                        f = strchr(f + 1, '\n');
+                    }
+                    CHECK(f != NULL && *f != '\0');
+                    f += len + 1;
+                    for (size_t k = 0; k < sizeof(tags) / sizeof(tags[0]); k++) shapes += strncmp(t, tags[k], strlen(tags[k])) == 0;
+                    t = end;
+                }
+                free(tile);
+                CHECK(shapes == count);
+            }
+        }
+    }
+    free(full);
+    CHECK(tiles == written && tiles > 0);
+
+    // each tile holds the definitions its elements and symbols refer to, and no other
+    snl_canvas_t defs = snl_canvas_create_ex(200, 100, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+    const char *const gradients[] = { "g0", "g1", "gs", "gu" };
+    for (size_t i = 0; i < 4; i++) {
+        snl_canvas_add_gradient_linear(&defs, gradients[i], SNL_COLOR_BLUE, SNL_COLOR((uint8_t)i, 0, 0, 255), 0, 100, 1, 1, 0);
+    }
+    snl_canvas_add_filter_blur(&defs, "f0", 2, 2);
+    snl_canvas_symbol_begin(&defs, "s1");
+    snl_canvas_render_circle(&defs, SNL_POINT(0, 0), 1, SNL_APPEARANCE_DEFAULT);
+    snl_canvas_symbol_end(&defs);
+    snl_canvas_symbol_begin(&defs, "s0");
+    snl_canvas_render_circle(&defs, SNL_POINT(0, 0), 2, SNL_APPEARANCE(1, 1, SNL_COLOR_NONE, 1, SNL_COLOR_NONE, NULL, "gs"));
+    snl_canvas_render_instance(&defs, "s1", SNL_POINT(1, 1), 1, 0);
+    snl_canvas_symbol_end(&defs);
+    snl_canvas_symbol_begin(&defs, "su");
+    snl_canvas_render_circle(&defs, SNL_POINT(0, 0), 3, SNL_APPEARANCE_DEFAULT);
+    snl_canvas_symbol_end(&defs);
+    snl_canvas_render_circle(&defs, SNL_POINT(20, 20), 5, SNL_APPEARANCE(1, 1, SNL_COLOR_NONE, 1, SNL_COLOR_NONE, NULL, "g0"));
+    const snl_appearance_t filtered = SNL_APPEARANCE(1, 1, SNL_COLOR_BLACK, 1, SNL_COLOR_BLACK, "f0", NULL);
+    snl_canvas_push_group(&defs, SNL_TRANSFORM_TRANSLATE(50, 50), &filtered);
+    snl_canvas_render_circle(&defs, SNL_POINT(0, 0), 5, SNL_APPEARANCE_DEFAULT);
+    snl_canvas_pop_group(&defs);
+    snl_canvas_render_circle(&defs, SNL_POINT(150, 50), 5, SNL_APPEARANCE(1, 1, SNL_COLOR_NONE, 1, SNL_COLOR_NONE, NULL, "g1"));
+    snl_canvas_render_instance(&defs, "s0", SNL_POINT(10, 90), 1, 0);
+    snprintf(dir, sizeof(dir), "%s/tiles-defs", gi_dir);
+    CHECK(snl_canvas_save_tiles(&defs, dir, 100, 100, 1) == 2);
+    snl_canvas_destroy(&defs);
+
+    static const char *const left[] = { "__default__", "g0", "f0", "s0", "s1", "gs" };
+    static const char *const right[] = { "__default__", "g1", "s0", "s1", "gs" };
+    for (size_t column = 0; column < 2; column++) {
+        char path[600];
+        snprintf(path, sizeof(path), "%s/0/%zu/0.svg", dir, column);
+        char *const tile = check_read(path);
+        CHECK(tile != NULL);
+        const char *const *const expected = column ? right : left;
+        const size_t count = column ? sizeof(right) / sizeof(right[0]) : sizeof(left) / sizeof(left[0]);
+        char id[32];
+        for (size_t i = 0; i < count; i++) {
+            snprintf(id, sizeof(id), " id='%s'", expected[i]);
+            CHECK(check_count(tile, id) == 1);
+        }
+        CHECK(check_count(tile, " id='") == count);
+        free(tile);
+    }
+
+    return true;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "snail/snail.h"
+
+#define STRESS_CANVASES 256
+#define STRESS_THREADS 8
+#define STRESS_SHAPES 500
+
+// one canvas rendered into memory
+typedef struct StressJob {
+    size_t id;
+    vt_str_t *output;
+} stress_job_t;
+
+void stress_render(stress_job_t *const job);
+void *stress_worker(void *arg);
+bool stress_raster(void);
+
+static size_t gi_next_job = 0;
+static pthread_mutex_t gi_next_job_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int main(void) {
+    printf("*** snail stress test: %d canvases on %d threads ***\n", STRESS_CANVASES, STRESS_THREADS);
+
+    // single-threaded reference
+    stress_job_t expected[STRESS_CANVASES];
+    for (size_t i = 0; i < STRESS_CANVASES; i++) {
+        expected[i] = (stress_job_t) { .id = i, .output = vt_str_create_capacity(4096, NULL) };
+        stress_render(&expected[i]);
+    }
+
+    // render the same canvases in parallel
+    stress_job_t jobs[STRESS_CANVASES];
+    for (size_t i = 0; i < STRESS_CANVASES; i++) {
+        jobs[i] = (stress_job_t) { .id = i, .output = vt_str_create_capacity(4096, NULL) };
+    }
+    pthread_t threads[STRESS_THREADS];
+    for (size_t i = 0; i < STRESS_THREADS; i++) {
+        pthread_create(&threads[i], NULL, stress_worker, jobs);
+    }
+    for (size_t i = 0; i < STRESS_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // compare
+    size_t failed = 0;
+    for (size_t i = 0; i < STRESS_CANVASES; i++) {
+        if (strcmp(vt_str_z(expected[i].output), vt_str_z(jobs[i].output)) != 0) {
+            printf("- canvas %zu: output differs from the single-threaded result\n", i);
+            failed++;
+        }
+        vt_str_destroy(expected[i].output);
+        vt_str_destroy(jobs[i].output);
+    }
+
+    // tiled rasterization must match the single-threaded pixels
+    if (!stress_raster()) {
+        printf("- parallel rasterization differs from the single-threaded result\n");
+        failed++;
+    }
+    printf("- %s\n", failed ? "FAILED" : "passed");
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// ------------------------------- HELPERS ------------------------------- //
+
+static size_t stress_sink_write(void *user, const char *data, size_t size) {
+    vt_str_append_n((vt_str_t*)user, data, size);
+    return size;
+}
+
+static float stress_randf(unsigned *const state, const float max) {
+    *state = *state * 1103515245u + 12345u;
+    return (float)((*state >> 8) & 0xffff) / 65535.0f * max;
+}
+
+// ------------------------------- STRESS ------------------------------- //
+
+void stress_render(stress_job_t *const job) {
+    unsigned seed = (unsigned)job->id + 1;
+
+    // odd canvases keep records and serialize at the end
+    snl_canvas_t canvas = snl_canvas_create_ex(512, 512, (snl_canvas_options_t) {
+        .sink = SNL_SINK(stress_sink_write, job->output),
+        .high_water = 1024,
+        .flags = job->id % 2 ? SNL_CANVAS_RETAINED : 0
+    });
+
+    for (size_t i = 0; i < STRESS_SHAPES; i++) {
+        const snl_appearance_t appearance = SNL_APPEARANCE(
+            stress_randf(&seed, 5), 1, SNL_COLOR((uint8_t)i, (uint8_t)job->id, 0, 255),
+            0.5, SNL_COLOR_NONE, NULL, NULL
+        );
+
+        // paths depend on per-canvas state across calls
+        snl_canvas_render_path_begin(&canvas);
+        snl_canvas_render_path_line_to(&canvas, SNL_POINT(stress_randf(&seed, 512), stress_randf(&seed, 512)));
+        for (size_t j = 0; j < 8; j++) {
+            snl_canvas_render_path_move_by(&canvas, SNL_POINT(stress_randf(&seed, 20) - 10, stress_randf(&seed, 20) - 10));
+        }
+        snl_canvas_render_path_end(&canvas, appearance);
+
+        snl_canvas_translate(&canvas, stress_randf(&seed, 10), stress_randf(&seed, 10));
+        snl_canvas_render_circle(&canvas, SNL_POINT(stress_randf(&seed, 512), stress_randf(&seed, 512)), stress_randf(&seed, 16), appearance);
+        snl_canvas_render_text(&canvas, SNL_POINT(stress_randf(&seed, 512), stress_randf(&seed, 512)), "snail", 12, SNL_FONT_ARIAL, SNL_COLOR_BLACK);
+        snl_canvas_reset_translation(&canvas);
+    }
+
+    snl_canvas_finish(&canvas);
+    snl_canvas_destroy(&canvas);
+}
+
+void *stress_worker(void *arg) {
+    stress_job_t *const jobs = arg;
+
+    for (;;) {
+        // take the next canvas
+        pthread_mutex_lock(&gi_next_job_lock);
+        const size_t i = gi_next_job++;
+        pthread_mutex_unlock(&gi_next_job_lock);
+        if (i >= STRESS_CANVASES) break;
+
+        stress_render(&jobs[i]);
+    }
+
+    return NULL;
+}
+
+bool stress_raster(void) {
+    unsigned seed = 7;
+    snl_canvas_t canvas = snl_canvas_create_ex(512, 512, (snl_canvas_options_t) { .flags = SNL_CANVAS_RETAINED });
+    snl_canvas_add_gradient_radial(&canvas, "rg0", SNL_COLOR_CORAL, SNL_COLOR_PURPLE, 0, 100, 1, 1);
+    for (size_t i = 0; i < STRESS_SHAPES; i++) {
+        const snl_point_t p = SNL_POINT(stress_randf(&seed, 512), stress_randf(&seed, 512));
+        snl_canvas_render_circle(&canvas, p, stress_randf(&seed, 64), SNL_APPEARANCE(stress_randf(&seed, 5), 1, SNL_COLOR_TEAL, 0.5, SNL_COLOR((uint8_t)i, 0, 0, 255), NULL, NULL));
+        snl_canvas_render_rectangle(&canvas, p, SNL_POINT(stress_randf(&seed, 96), stress_randf(&seed, 96)), 4, SNL_APPEARANCE(1, 1, SNL_COLOR_NONE, 0.8, SNL_COLOR_NONE, NULL, "rg0"));
+    }
+
+    // a size that is not a multiple of the tile size
+    snl_raster_t single = snl_raster_create(1000, 777);
+    snl_raster_t tiled = snl_raster_create(1000, 777);
+    snl_canvas_rasterize(&canvas, &single);
+    snl_canvas_rasterize_parallel(&canvas, &tiled, STRESS_THREADS);
+    const bool same = memcmp(single.pixels, tiled.pixels, (size_t)single.width * single.height * 4) == 0;
+
+    snl_raster_destroy(&single);
+    snl_raster_destroy(&tiled);
+    snl_canvas_destroy(&canvas);
+
+    return same;
+}
+